@@ -49,6 +49,55 @@ AC_DEFUN([T8_CHECK_LIBRARIES],
 [
 ])
 
+dnl T8_CHECK_OPENMP
+dnl Check for --enable-openmp using shell variable T8_ENABLE_OPENMP.
+dnl If enabled, determine the compiler flag for OpenMP, add it to CFLAGS
+dnl and LIBS and define T8_ENABLE_OPENMP.  It is an error if enabled and
+dnl the compiler does not support OpenMP.  Since the threads allocate
+dnl memory through libsc, it is also an error if enabled without
+dnl --enable-pthread, which makes the libsc allocation counters thread-safe.
+dnl Must be called after SC_CHECK_LIBRARIES.
+dnl
+AC_DEFUN([T8_CHECK_OPENMP],
+[
+T8_ARG_ENABLE([openmp], [use OpenMP threads to adapt and create forests], [OPENMP])
+if test "x$T8_ENABLE_OPENMP" != xno ; then
+  if test "x$T8_ENABLE_PTHREAD" = xno || test "x$T8_ENABLE_PTHREAD" = x ; then
+    AC_MSG_ERROR([--enable-openmp requires --enable-pthread for thread-safe libsc allocation])
+  fi
+  AC_LANG_PUSH([C])
+  AC_MSG_CHECKING([for the compiler flag to enable OpenMP])
+  t8_openmp_flag=unsupported
+  t8_openmp_save_CFLAGS="$CFLAGS"
+  for t8_flag in none -fopenmp -qopenmp -openmp -mp -xopenmp ; do
+    if test "x$t8_flag" != xnone ; then
+      CFLAGS="$t8_openmp_save_CFLAGS $t8_flag"
+    fi
+    AC_LINK_IFELSE([AC_LANG_PROGRAM([[
+#ifndef _OPENMP
+#error "OpenMP is not enabled"
+#endif
+#include <omp.h>
+]], [[return omp_get_max_threads () < 1;]])],
+                   [t8_openmp_flag="$t8_flag"])
+    CFLAGS="$t8_openmp_save_CFLAGS"
+    if test "x$t8_openmp_flag" != xunsupported ; then
+      break
+    fi
+  done
+  AC_MSG_RESULT([$t8_openmp_flag])
+  AC_LANG_POP([C])
+  if test "x$t8_openmp_flag" = xunsupported ; then
+    AC_MSG_ERROR([OpenMP is enabled but not supported by $CC])
+  fi
+  if test "x$t8_openmp_flag" != xnone ; then
+    CFLAGS="$CFLAGS $t8_openmp_flag"
+    LIBS="$LIBS $t8_openmp_flag"
+  fi
+  AC_DEFINE([ENABLE_OPENMP], 1, [Define to 1 if we use OpenMP])
+fi
+])
+
 dnl T8_AS_SUBPACKAGE(PREFIX)
 dnl Call from a package that is using T8 as a subpackage.
 dnl Sets PREFIX_DIST_DENY=yes if T8 is make install'd.
@@ -103,7 +103,7 @@ t8_basic_forest_partition ()
   t8_forest_set_level (forest, level);
   t8_forest_commit (forest);
   t8_forest_set_adapt (forest_adapt, forest, t8_basic_adapt, NULL, 1);
-  t8_forest_set_partition (forest_partition, forest_adapt, 0);
+  t8_forest_set_partition (forest_partition, forest_adapt, 0, NULL);
   t8_forest_commit (forest_adapt);
   t8_forest_commit (forest_partition);
   t8_forest_partition_cmesh (forest_partition, comm, 0);
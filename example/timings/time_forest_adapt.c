@@ -0,0 +1,301 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+/* Time the recursive refinement of a uniform forest by several levels in
+ * one adapt step and compare it to refining level by level.
+ * In addition, time the refinement of the forest's elements with the
+ * element stack that recursive adapt uses and with the element list
+ * that it used before, without the rest of adapt. */
+
+#include <sc_flops.h>
+#include <sc_statistics.h>
+#include <sc_options.h>
+#include <t8_cmesh.h>
+#include <t8_forest.h>
+#include <t8_default.h>
+
+/* Refine every element up to the level given in the user data */
+static int
+t8_time_adapt_refine (t8_forest_t forest, t8_locidx_t which_tree,
+                      t8_eclass_scheme_t * ts,
+                      int num_elements, t8_element_t * elements[])
+{
+  int                 max_level;
+
+  max_level = *(int *) t8_forest_get_user_data (forest);
+  if (t8_element_level (ts, elements[0]) < max_level) {
+    return 1;
+  }
+  return 0;
+}
+
+/* Create the default or, if compact is true, the compact scheme */
+static t8_scheme_t *
+t8_time_adapt_new_scheme (int compact)
+{
+  return compact ? t8_scheme_new_compact () : t8_scheme_new_default ();
+}
+
+/* Create a uniform forest of a given level on a hypercube mesh.
+ * This takes ownership of the scheme. */
+static              t8_forest_t
+t8_time_adapt_new_uniform (t8_eclass_t eclass, int level,
+                           t8_scheme_t * scheme)
+{
+  t8_forest_t         forest;
+
+  t8_forest_init (&forest);
+  t8_forest_set_cmesh (forest,
+                       t8_cmesh_new_hypercube (eclass, sc_MPI_COMM_WORLD, 0,
+                                               0), sc_MPI_COMM_WORLD);
+  t8_forest_set_scheme (forest, scheme);
+  t8_forest_set_level (forest, level);
+  t8_forest_commit (forest);
+  return forest;
+}
+
+/* Refine from level to level + num_levels, either recursively in one
+ * step or with num_levels non-recursive steps, and return the runtime. */
+static double
+t8_time_adapt (t8_eclass_t eclass, int level, int num_levels,
+               int recursive, int compact)
+{
+  t8_forest_t         forest, forest_adapt;
+  sc_flopinfo_t       fi, snapshot;
+  int                 max_level, il;
+
+  forest = t8_time_adapt_new_uniform (eclass, level,
+                                      t8_time_adapt_new_scheme (compact));
+
+  sc_flops_start (&fi);
+  sc_flops_snap (&fi, &snapshot);
+  for (il = recursive ? num_levels : 1; il <= num_levels; il++) {
+    max_level = level + il;
+    t8_forest_init (&forest_adapt);
+    t8_forest_set_user_data (forest_adapt, &max_level);
+    t8_forest_set_adapt (forest_adapt, forest, t8_time_adapt_refine, NULL,
+                         recursive);
+    t8_forest_commit (forest_adapt);
+    forest = forest_adapt;
+  }
+  sc_flops_shot (&fi, &snapshot);
+
+  t8_infof ("Refined to %lld local elements\n",
+            (long long) t8_forest_get_num_element (forest));
+  t8_forest_unref (&forest);
+  return snapshot.iwtime;
+}
+
+/* Refine an element recursively up to max_level as recursive adapt did
+ * before it used an element stack: The pending elements are kept in
+ * a list and each child is allocated with t8_element_new.
+ * The leaves are appended to the array leaves.
+ * buffer must provide space for num_children element pointers. */
+static void
+t8_time_refine_list (t8_eclass_scheme_t * ts, const t8_element_t * element,
+                     int max_level, sc_list_t * list, sc_array_t * leaves,
+                     t8_element_t ** buffer)
+{
+  int                 num_children, ci;
+
+  num_children = t8_eclass_num_children[ts->eclass];
+  t8_element_new (ts, 1, buffer);
+  t8_element_copy (ts, element, buffer[0]);
+  (void) sc_list_prepend (list, buffer[0]);
+  while (list->elem_count > 0) {
+    buffer[0] = (t8_element_t *) sc_list_pop (list);
+    if (t8_element_level (ts, buffer[0]) < max_level) {
+      t8_element_new (ts, num_children - 1, buffer + 1);
+      t8_element_children (ts, buffer[0], num_children, buffer);
+      for (ci = num_children - 1; ci >= 0; ci--) {
+        (void) sc_list_prepend (list, buffer[ci]);
+      }
+    }
+    else {
+      t8_element_copy (ts, buffer[0],
+                       (t8_element_t *) sc_array_push (leaves));
+      t8_element_destroy (ts, 1, buffer);
+    }
+  }
+}
+
+/* Refine an element recursively up to max_level as recursive adapt does:
+ * The pending elements are kept in reverse order on a stack of element
+ * storage, whose memory is reused for all elements.
+ * The leaves are appended to the array leaves.
+ * buffer must provide space for num_children element pointers. */
+static void
+t8_time_refine_stack (t8_eclass_scheme_t * ts, const t8_element_t * element,
+                      int max_level, sc_array_t * stack, sc_array_t * leaves,
+                      t8_element_t ** buffer)
+{
+  t8_element_t       *parent;
+  size_t              top;
+  int                 num_children, ci;
+
+  num_children = t8_eclass_num_children[ts->eclass];
+  sc_array_resize (stack, 1);
+  t8_element_copy (ts, element, t8_element_array_index (ts, stack, 0));
+  while (stack->elem_count > 0) {
+    top = stack->elem_count - 1;
+    buffer[0] = t8_element_array_index (ts, stack, top);
+    if (t8_element_level (ts, buffer[0]) < max_level) {
+      /* Keep a copy of the parent behind the space for its children.
+       * The stack never shrinks its memory, thus this only allocates
+       * until the stack has reached its maximum size. */
+      sc_array_resize (stack, top + num_children + 1);
+      parent = t8_element_array_index (ts, stack, top + num_children);
+      t8_element_copy (ts, t8_element_array_index (ts, stack, top), parent);
+      for (ci = 0; ci < num_children; ci++) {
+        buffer[ci] = t8_element_array_index (ts, stack,
+                                             top + num_children - 1 - ci);
+      }
+      t8_element_children (ts, parent, num_children, buffer);
+      stack->elem_count = top + num_children;
+    }
+    else {
+      t8_element_copy (ts, buffer[0],
+                       (t8_element_t *) sc_array_push (leaves));
+      stack->elem_count = top;
+    }
+  }
+}
+
+/* Refine all elements of a uniform forest of level by num_levels levels
+ * with the element list or the element stack and return the runtime. */
+static double
+t8_time_refine_kernel (t8_eclass_t eclass, int level, int num_levels,
+                       int use_list, int compact)
+{
+  t8_forest_t         forest;
+  t8_scheme_t        *scheme;
+  t8_eclass_scheme_t *ts;
+  t8_element_t      **buffer;
+  t8_locidx_t         ielement, num_elements;
+  sc_flopinfo_t       fi, snapshot;
+  sc_array_t          leaves, stack;
+  sc_list_t          *list;
+
+  scheme = t8_time_adapt_new_scheme (compact);
+  t8_scheme_ref (scheme);
+  forest = t8_time_adapt_new_uniform (eclass, level, scheme);
+  ts = scheme->eclass_schemes[eclass];
+  buffer = T8_ALLOC (t8_element_t *, t8_eclass_num_children[eclass]);
+  sc_array_init (&leaves, t8_element_size (ts));
+  sc_array_init (&stack, t8_element_size (ts));
+  list = sc_list_new (NULL);
+  num_elements = t8_forest_get_num_element (forest);
+
+  sc_flops_start (&fi);
+  sc_flops_snap (&fi, &snapshot);
+  for (ielement = 0; ielement < num_elements; ielement++) {
+    if (use_list) {
+      t8_time_refine_list (ts, t8_forest_get_element (forest, ielement,
+                                                      NULL),
+                           level + num_levels, list, &leaves, buffer);
+    }
+    else {
+      t8_time_refine_stack (ts, t8_forest_get_element (forest, ielement,
+                                                       NULL),
+                            level + num_levels, &stack, &leaves, buffer);
+    }
+  }
+  sc_flops_shot (&fi, &snapshot);
+
+  t8_infof ("Refined to %lld local elements\n", (long long) leaves.elem_count);
+  sc_list_destroy (list);
+  sc_array_reset (&stack);
+  sc_array_reset (&leaves);
+  T8_FREE (buffer);
+  t8_forest_unref (&forest);
+  t8_scheme_unref (&scheme);
+  return snapshot.iwtime;
+}
+
+int
+main (int argc, char *argv[])
+{
+  int                 mpiret;
+  int                 first_argc;
+  int                 level, num_levels, eclass_int;
+  int                 help = 0, compact;
+  sc_options_t       *opt;
+  sc_statinfo_t       stats[4];
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_ESSENTIAL);
+  p4est_init (NULL, SC_LP_ESSENTIAL);
+  t8_init (SC_LP_DEFAULT);
+
+  opt = sc_options_new (argv[0]);
+  sc_options_add_switch (opt, 'h', "help", &help,
+                         "Display a short help message.");
+  sc_options_add_int (opt, 'e', "elements", &eclass_int, T8_ECLASS_TRIANGLE,
+                      "The element class of the mesh: 2 quad, 3 triangle, "
+                      "4 hex, 5 tet.");
+  sc_options_add_int (opt, 'l', "level", &level, 2,
+                      "The initial uniform refinement level.");
+  sc_options_add_int (opt, 'r', "rlevel", &num_levels, 4,
+                      "The number of levels to refine.");
+  sc_options_add_switch (opt, 'c', "compact", &compact,
+                         "Store the elements in the compact scheme.");
+
+  first_argc = sc_options_parse (t8_get_package_id (), SC_LP_DEFAULT,
+                                 opt, argc, argv);
+  if (first_argc < 0 || first_argc != argc || level < 0 || num_levels < 1
+      || eclass_int < T8_ECLASS_QUAD || eclass_int > T8_ECLASS_TET) {
+    sc_options_print_usage (t8_get_package_id (), SC_LP_ERROR, opt, NULL);
+    return 1;
+  }
+  if (help) {
+    sc_options_print_usage (t8_get_package_id (), SC_LP_ERROR, opt, NULL);
+  }
+  else {
+    sc_stats_set1 (&stats[0],
+                   t8_time_adapt ((t8_eclass_t) eclass_int, level,
+                                  num_levels, 1, compact),
+                   "Recursive refine");
+    sc_stats_set1 (&stats[1],
+                   t8_time_adapt ((t8_eclass_t) eclass_int, level,
+                                  num_levels, 0, compact),
+                   "Levelwise refine");
+    sc_stats_set1 (&stats[2],
+                   t8_time_refine_kernel ((t8_eclass_t) eclass_int, level,
+                                          num_levels, 0, compact),
+                   "Stack refine kernel");
+    sc_stats_set1 (&stats[3],
+                   t8_time_refine_kernel ((t8_eclass_t) eclass_int, level,
+                                          num_levels, 1, compact),
+                   "List refine kernel");
+    sc_stats_compute (sc_MPI_COMM_WORLD, 4, stats);
+    sc_stats_print (t8_get_package_id (), SC_LP_STATISTICS, 4, stats, 1, 1);
+  }
+
+  sc_options_destroy (opt);
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+  return 0;
+}
@@ -201,7 +201,7 @@ t8_time_forest_cmesh_mshfile (t8_cmesh_t cmesh, const char *vtu_prefix,
     }
     /* partition the adapted forest */
     t8_forest_init (&forest_partition);
-    t8_forest_set_partition (forest_partition, forest_adapt, 0);
+    t8_forest_set_partition (forest_partition, forest_adapt, 0, NULL);
     /* enable profiling for the partitioned forest */
     t8_forest_set_profiling (forest_partition, 1);
     t8_forest_commit (forest_partition);
@@ -0,0 +1,223 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+
+/* Time the computation of the linear id and the comparison of triangles
+ * and tetrahedra and compare it to computing the types of all ancestors one
+ * after another. */
+
+#include <sc_flops.h>
+#include <sc_statistics.h>
+#include <sc_options.h>
+#include <t8_default/t8_dtri_bits.h>
+#include <t8_default/t8_dtri_connectivity.h>
+#include <t8_default/t8_dtet_bits.h>
+#include <t8_default/t8_dtet_connectivity.h>
+
+/* Compute the linear id of a triangle by walking up its ancestors,
+ * where the type of each ancestor depends on the type of its child. */
+static              uint64_t
+t8_time_dtri_linear_id_chain (const t8_dtri_t * t)
+{
+  uint64_t            id = 0;
+  int                 type, cid, i, bit;
+
+  type = t->type;
+  for (i = t->level; i > 0; i--) {
+    bit = T8_DTRI_MAXLEVEL - i;
+    cid = ((t->x >> bit) & 1) | ((t->y >> bit) & 1) << 1;
+    id |= ((uint64_t) t8_dtri_type_cid_to_Iloc[type][cid])
+      << (T8_DTRI_DIM * (t->level - i));
+    type = t8_dtri_cid_type_to_parenttype[cid][type];
+  }
+  return id;
+}
+
+/* The same computation for a tetrahedron */
+static              uint64_t
+t8_time_dtet_linear_id_chain (const t8_dtet_t * t)
+{
+  uint64_t            id = 0;
+  int                 type, cid, i, bit;
+
+  type = t->type;
+  for (i = t->level; i > 0; i--) {
+    bit = T8_DTET_MAXLEVEL - i;
+    cid = ((t->x >> bit) & 1) | ((t->y >> bit) & 1) << 1
+      | ((t->z >> bit) & 1) << 2;
+    id |= ((uint64_t) t8_dtet_type_cid_to_Iloc[type][cid])
+      << (T8_DTET_DIM * (t->level - i));
+    type = t8_dtet_cid_type_to_parenttype[cid][type];
+  }
+  return id;
+}
+
+/* Return a random linear id of an element of a given level */
+static              uint64_t
+t8_time_random_id (int dim, int level)
+{
+  uint64_t            id;
+
+  id = ((uint64_t) rand () << 42) ^ ((uint64_t) rand () << 21) ^ rand ();
+  return level == 0 ? 0 : id & ((((uint64_t) 1) << (dim * level)) - 1);
+}
+
+/* Compute the linear ids of num_elements random elements of a given level
+ * and compare each element to the next one, either with the chained or
+ * with the current algorithm. Return the runtime of both and abort if the
+ * two algorithms disagree. */
+static void
+t8_time_linear_id (int tet, int level, int num_elements, int chain,
+                   double *time_id, double *time_compare)
+{
+  t8_dtri_t          *tris = NULL;
+  t8_dtet_t          *tets = NULL;
+  uint64_t           *ids, id, id_next;
+  sc_flopinfo_t       fi, snapshot;
+  int                 i, cmp;
+
+  srand (level);
+  ids = T8_ALLOC (uint64_t, num_elements);
+  if (tet) {
+    tets = T8_ALLOC (t8_dtet_t, num_elements);
+  }
+  else {
+    tris = T8_ALLOC (t8_dtri_t, num_elements);
+  }
+  for (i = 0; i < num_elements; i++) {
+    ids[i] = t8_time_random_id (tet ? T8_DTET_DIM : T8_DTRI_DIM, level);
+    if (tet) {
+      t8_dtet_init_linear_id (tets + i, ids[i], level);
+    }
+    else {
+      t8_dtri_init_linear_id (tris + i, ids[i], level);
+    }
+  }
+
+  sc_flops_start (&fi);
+  sc_flops_snap (&fi, &snapshot);
+  for (i = 0; i < num_elements; i++) {
+    if (tet) {
+      id = chain ? t8_time_dtet_linear_id_chain (tets + i)
+        : t8_dtet_linear_id (tets + i, level);
+    }
+    else {
+      id = chain ? t8_time_dtri_linear_id_chain (tris + i)
+        : t8_dtri_linear_id (tris + i, level);
+    }
+    SC_CHECK_ABORT (id == ids[i], "Linear id mismatch");
+  }
+  sc_flops_shot (&fi, &snapshot);
+  *time_id = snapshot.iwtime;
+
+  sc_flops_snap (&fi, &snapshot);
+  for (i = 0; i + 1 < num_elements; i++) {
+    if (chain) {
+      /* Compare the elements by their linear ids */
+      if (tet) {
+        id = t8_time_dtet_linear_id_chain (tets + i);
+        id_next = t8_time_dtet_linear_id_chain (tets + i + 1);
+      }
+      else {
+        id = t8_time_dtri_linear_id_chain (tris + i);
+        id_next = t8_time_dtri_linear_id_chain (tris + i + 1);
+      }
+      cmp = id < id_next ? -1 : id != id_next;
+    }
+    else {
+      cmp = tet ? t8_dtet_compare (tets + i, tets + i + 1)
+        : t8_dtri_compare (tris + i, tris + i + 1);
+    }
+    SC_CHECK_ABORT (cmp == (ids[i] < ids[i + 1] ? -1 : ids[i] != ids[i + 1]),
+                    "Compare mismatch");
+  }
+  sc_flops_shot (&fi, &snapshot);
+  *time_compare = snapshot.iwtime;
+
+  T8_FREE (ids);
+  T8_FREE (tris);
+  T8_FREE (tets);
+}
+
+int
+main (int argc, char *argv[])
+{
+  int                 mpiret;
+  int                 first_argc;
+  int                 level, num_elements;
+  int                 help = 0;
+  sc_options_t       *opt;
+  int                 tet, chain, istat;
+  double              time_id, time_compare;
+  sc_statinfo_t       stats[8];
+  const char         *names[8] = {
+    "Triangle chained linear id", "Triangle chained compare",
+    "Triangle linear id", "Triangle compare",
+    "Tetrahedron chained linear id", "Tetrahedron chained compare",
+    "Tetrahedron linear id", "Tetrahedron compare"
+  };
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_ESSENTIAL);
+  p4est_init (NULL, SC_LP_ESSENTIAL);
+  t8_init (SC_LP_DEFAULT);
+
+  opt = sc_options_new (argv[0]);
+  sc_options_add_switch (opt, 'h', "help", &help,
+                         "Display a short help message.");
+  sc_options_add_int (opt, 'l', "level", &level, 15,
+                      "The refinement level of the elements.");
+  sc_options_add_int (opt, 'n', "elements", &num_elements, 1 << 20,
+                      "The number of random elements.");
+
+  first_argc = sc_options_parse (t8_get_package_id (), SC_LP_DEFAULT,
+                                 opt, argc, argv);
+  if (first_argc < 0 || first_argc != argc || level < 0
+      || level > T8_DTET_MAXLEVEL || num_elements < 1) {
+    sc_options_print_usage (t8_get_package_id (), SC_LP_ERROR, opt, NULL);
+    return 1;
+  }
+  if (help) {
+    sc_options_print_usage (t8_get_package_id (), SC_LP_ERROR, opt, NULL);
+  }
+  else {
+    for (tet = 0, istat = 0; tet < 2; tet++) {
+      for (chain = 1; chain >= 0; chain--, istat += 2) {
+        t8_time_linear_id (tet, level, num_elements, chain, &time_id,
+                           &time_compare);
+        sc_stats_set1 (&stats[istat], time_id, names[istat]);
+        sc_stats_set1 (&stats[istat + 1], time_compare, names[istat + 1]);
+      }
+    }
+    sc_stats_compute (sc_MPI_COMM_WORLD, 8, stats);
+    sc_stats_print (t8_get_package_id (), SC_LP_STATISTICS, 8, stats, 1, 1);
+  }
+
+  sc_options_destroy (opt);
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+  return 0;
+}
@@ -103,6 +103,12 @@ typedef enum
   T8_MPI_TAG_FIRST = P4EST_COMM_TAG_FIRST,
   T8_MPI_PARTITION_CMESH = P4EST_COMM_TAG_LAST,
   T8_MPI_PARTITION_FOREST,
+  T8_MPI_GHOST_FOREST,
+  T8_MPI_GHOST_EXC_FOREST,
+  T8_MPI_PARTITION_COARSEN,
+  T8_MPI_PARTITION_DATA,
+  T8_MPI_GHOST_SIZE_FOREST,
+  T8_MPI_PARTITION_ELEMENTS,
   T8_MPI_TAG_LAST
 }
 t8_MPI_tag_t;
@@ -667,7 +667,6 @@ t8_cmesh_bcast (t8_cmesh_t cmesh_in, int root, sc_MPI_Comm comm)
     size_t              stash_elem_counts[3];
 #ifdef T8_ENABLE_DEBUG
     t8_locidx_t         inserted_trees;
-    sc_MPI_Comm         comm;
 #endif
   } dimensions;
 
@@ -728,7 +727,6 @@ t8_cmesh_bcast (t8_cmesh_t cmesh_in, int root, sc_MPI_Comm comm)
     }
 #ifdef T8_ENABLE_DEBUG
     cmesh_in->inserted_trees = dimensions.inserted_trees;
-    T8_ASSERT (dimensions.comm == comm);
 #endif
   }
   /* broadcast all the stashed information about trees/neighbors/attributes */
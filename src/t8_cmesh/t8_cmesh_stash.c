@@ -252,6 +252,8 @@ t8_stash_bcast (t8_stash_t stash, int root, sc_MPI_Comm comm,
                 size_t elem_counts[3])
 {
   int                 mpirank, mpisize, mpiret;
+  size_t              iattr;
+  t8_stash_attribute_struct_t *attr;
   mpiret = sc_MPI_Comm_rank (comm, &mpirank);
   SC_CHECK_MPI (mpiret);
   mpiret = sc_MPI_Comm_size (comm, &mpisize);
@@ -266,20 +268,33 @@ t8_stash_bcast (t8_stash_t stash, int root, sc_MPI_Comm comm,
     mpiret = sc_MPI_Bcast (stash->attributes.array,
                            elem_counts[0] *
                            sizeof (t8_stash_attribute_struct_t), sc_MPI_BYTE,
-                           0, comm);
+                           root, comm);
     SC_CHECK_MPI (mpiret);
+    /* The attribute structs only store pointers to the attributes' data,
+     * thus we broadcast the data of each attribute as well. */
+    for (iattr = 0; iattr < elem_counts[0]; iattr++) {
+      attr = (t8_stash_attribute_struct_t *)
+        sc_array_index (&stash->attributes, iattr);
+      if (mpirank != root) {
+        attr->attr_data = T8_ALLOC (char, attr->attr_size);
+        attr->is_owned = 1;
+      }
+      mpiret = sc_MPI_Bcast (attr->attr_data, attr->attr_size, sc_MPI_BYTE,
+                             root, comm);
+      SC_CHECK_MPI (mpiret);
+    }
   }
   if (elem_counts[1] > 0) {
     mpiret = sc_MPI_Bcast (stash->classes.array,
                            elem_counts[1] * sizeof (t8_stash_class_struct_t),
-                           sc_MPI_BYTE, 0, comm);
+                           sc_MPI_BYTE, root, comm);
     SC_CHECK_MPI (mpiret);
   }
   if (elem_counts[2] > 0) {
     mpiret = sc_MPI_Bcast (stash->joinfaces.array,
                            elem_counts[2] *
                            sizeof (t8_stash_joinface_struct_t), sc_MPI_BYTE,
-                           0, comm);
+                           root, comm);
     SC_CHECK_MPI (mpiret);
   }
   return stash;
@@ -287,19 +287,23 @@ t8_cmesh_trees_set_all_boundary (t8_cmesh_t cmesh, t8_cmesh_trees_t trees)
   t8_ctree_t          tree;
   t8_locidx_t        *face_neighbor;
   t8_gloidx_t        *gface_neighbor;
+  int8_t             *ttf;
   int                 iface;
 
+  /* A boundary face is connected to itself with orientation 0 */
   for (ltree = 0; ltree < cmesh->num_local_trees; ltree++) {
-    tree = t8_cmesh_trees_get_tree_ext (trees, ltree, &face_neighbor, NULL);
+    tree = t8_cmesh_trees_get_tree_ext (trees, ltree, &face_neighbor, &ttf);
     for (iface = 0; iface < t8_eclass_num_faces[tree->eclass]; iface++) {
       face_neighbor[iface] = ltree;
+      ttf[iface] = iface;
     }
   }
   for (lghost = 0; lghost < cmesh->num_ghosts; lghost++) {
     ghost =
-      t8_cmesh_trees_get_ghost_ext (trees, lghost, &gface_neighbor, NULL);
+      t8_cmesh_trees_get_ghost_ext (trees, lghost, &gface_neighbor, &ttf);
     for (iface = 0; iface < t8_eclass_num_faces[ghost->eclass]; iface++) {
       gface_neighbor[iface] = ghost->treeid;
+      ttf[iface] = iface;
     }
   }
 }
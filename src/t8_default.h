@@ -36,6 +36,16 @@ T8_EXTERN_C_BEGIN ();
 /** Return the default element implementation of t8code. */
 t8_scheme_t        *t8_scheme_new_default (void);
 
+/** Return an element implementation that stores each element in 64 bits.
+ * It supports the same element classes as the default implementation and
+ * uses it for all geometric operations.  The elements are ordered the
+ * same way, but the maximum refinement level of triangles and tetrahedra
+ * is lower.  The compact implementation needs less memory for the leaf
+ * arrays of a forest at the cost of decoding elements on demand.
+ * \see t8_default_compact.h
+ */
+t8_scheme_t        *t8_scheme_new_compact (void);
+
 T8_EXTERN_C_END ();
 
 #endif /* !T8_DEFAULT_H */
@@ -27,6 +27,7 @@
 #include "t8_default_hex.h"
 #include "t8_default_tri.h"
 #include "t8_default_tet.h"
+#include "t8_default_compact.h"
 
 t8_scheme_t        *
 t8_scheme_new_default (void)
@@ -43,3 +44,20 @@ t8_scheme_new_default (void)
 
   return s;
 }
+
+t8_scheme_t        *
+t8_scheme_new_compact (void)
+{
+  t8_scheme_t        *s;
+
+  s = T8_ALLOC_ZERO (t8_scheme_t, 1);
+  t8_refcount_init (&s->rc);
+
+  s->eclass_schemes[T8_ECLASS_QUAD] = t8_default_scheme_new_compact_quad ();
+  s->eclass_schemes[T8_ECLASS_HEX] = t8_default_scheme_new_compact_hex ();
+  s->eclass_schemes[T8_ECLASS_TRIANGLE] =
+    t8_default_scheme_new_compact_tri ();
+  s->eclass_schemes[T8_ECLASS_TET] = t8_default_scheme_new_compact_tet ();
+
+  return s;
+}
@@ -0,0 +1,72 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+/** \file t8_default_compact.h
+ * The compact schemes store an element as a single 64-bit integer.
+ * The lowest \ref T8_COMPACT_LEVEL_BITS bits hold the level of the element.
+ * The remaining bits hold the linear id of its first descendant in a uniform
+ * refinement of the compact scheme's maximum level.
+ * Thus, an array of compact elements is an array of integers in SFC order
+ * and two elements are compared by comparing two integers.
+ * The operations that only depend on the linear id, such as computing
+ * parents, successors and descendants, work on the integers directly.
+ * All other operations decode the element into an element of the default
+ * scheme of the same class, call its implementation, and encode the result.
+ * This trades runtime for half or less of the memory of the default
+ * elements.  A compact quadrilateral carries no information about a
+ * surrounding octant.
+ */
+
+#ifndef T8_DEFAULT_COMPACT_H
+#define T8_DEFAULT_COMPACT_H
+
+#include <t8_element.h>
+
+/** The number of bits of a compact element that hold its level. */
+#define T8_COMPACT_LEVEL_BITS 5
+
+/** The maximum level such that the linear ids of a compact element of
+ * dimension \a dim fit into the bits not used by the level. */
+#define T8_COMPACT_MAXLEVEL_DIM(dim) ((64 - T8_COMPACT_LEVEL_BITS) / (dim))
+
+/** The storage of an element in the compact schemes. */
+typedef uint64_t    t8_compact_element_t;
+
+T8_EXTERN_C_BEGIN ();
+
+/** Return the compact scheme for quadrilaterals. */
+t8_eclass_scheme_t *t8_default_scheme_new_compact_quad (void);
+
+/** Return the compact scheme for hexahedra. */
+t8_eclass_scheme_t *t8_default_scheme_new_compact_hex (void);
+
+/** Return the compact scheme for triangles.
+ * Its maximum level is one less than that of the default triangles. */
+t8_eclass_scheme_t *t8_default_scheme_new_compact_tri (void);
+
+/** Return the compact scheme for tetrahedra.
+ * Its maximum level is two less than that of the default tetrahedra. */
+t8_eclass_scheme_t *t8_default_scheme_new_compact_tet (void);
+
+T8_EXTERN_C_END ();
+
+#endif /* !T8_DEFAULT_COMPACT_H */
@@ -0,0 +1,38 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+/* The compact scheme for hexahedra shares its implementation with the
+ * compact quadrilaterals. */
+
+#include "t8_default_hex.h"
+
+#define T8_COMPACT_ECLASS T8_ECLASS_HEX
+#define T8_COMPACT_DIM P8EST_DIM
+#define T8_COMPACT_MAXLEVEL \
+  SC_MIN (P8EST_QMAXLEVEL, T8_COMPACT_MAXLEVEL_DIM (P8EST_DIM))
+#define T8_COMPACT_FACE_CHILDREN P8EST_HALF
+#define T8_COMPACT_MORTON
+#define T8_COMPACT_FULL_NEW t8_default_scheme_new_hex
+#define T8_COMPACT_SCHEME_NEW t8_default_scheme_new_compact_hex
+typedef t8_phex_t   t8_compact_full_t;
+
+#include "t8_default_compact_quad.c"
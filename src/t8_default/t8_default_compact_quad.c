@@ -0,0 +1,668 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+/* This file implements the compact scheme for quadrilaterals.
+ * The compact schemes of the other element classes include it after
+ * defining the macros and types below, similar to t8_dtet_bits.c. */
+
+#include "t8_default_common.h"
+#include "t8_default_compact.h"
+
+#ifndef T8_COMPACT_ECLASS
+#include "t8_default_quad.h"
+/* The element class of this compact scheme */
+#define T8_COMPACT_ECLASS T8_ECLASS_QUAD
+/* The dimension of the element class */
+#define T8_COMPACT_DIM P4EST_DIM
+/* The maximum level of this compact scheme */
+#define T8_COMPACT_MAXLEVEL \
+  SC_MIN (P4EST_QMAXLEVEL, T8_COMPACT_MAXLEVEL_DIM (P4EST_DIM))
+/* The maximum number of children at a face */
+#define T8_COMPACT_FACE_CHILDREN P4EST_HALF
+/* Defined if the child ids of this element class are the local indices
+ * of the children in the space-filling curve */
+#define T8_COMPACT_MORTON
+/* The constructors of the default and the compact scheme */
+#define T8_COMPACT_FULL_NEW t8_default_scheme_new_quad
+#define T8_COMPACT_SCHEME_NEW t8_default_scheme_new_compact_quad
+/* The element of the default scheme that a compact element decodes to */
+typedef t8_pquad_t  t8_compact_full_t;
+#endif
+
+#define T8_COMPACT_CHILDREN (1 << T8_COMPACT_DIM)
+
+/* The level of a compact element */
+#define T8_COMPACT_LEVEL(k) \
+  ((int) ((k) & (((uint64_t) 1 << T8_COMPACT_LEVEL_BITS) - 1)))
+
+/* The linear id on the maximum level of the first descendant of a compact
+ * element, we call it the anchor of the element */
+#define T8_COMPACT_ANCHOR(k) ((k) >> T8_COMPACT_LEVEL_BITS)
+
+/* The compact element of a given anchor and level */
+#define T8_COMPACT_KEY(anchor,level) \
+  ((anchor) << T8_COMPACT_LEVEL_BITS | (uint64_t) (level))
+
+/* The number of elements of maximum level in an element of level l */
+#define T8_COMPACT_LEN(l) \
+  ((uint64_t) 1 << T8_COMPACT_DIM * (T8_COMPACT_MAXLEVEL - (l)))
+
+/* Access the integer of an element */
+#define T8_COMPACT(elem) (*(t8_compact_element_t *) (elem))
+#define T8_COMPACT_CONST(elem) (*(const t8_compact_element_t *) (elem))
+
+/* The default scheme of the same element class, which we use to decode
+ * elements.  All compact schemes of this class share it and we count
+ * them to know when to destroy it. */
+static t8_eclass_scheme_t *t8_compact_full = NULL;
+static int          t8_compact_full_count = 0;
+
+/* Decode a compact element into an element of the default scheme */
+static void
+t8_compact_decode (const t8_element_t * elem, t8_compact_full_t * full)
+{
+  const t8_compact_element_t k = T8_COMPACT_CONST (elem);
+  const int           level = T8_COMPACT_LEVEL (k);
+
+  t8_compact_full->elem_set_linear_id ((t8_element_t *) full, level,
+                                       T8_COMPACT_ANCHOR (k) >>
+                                       T8_COMPACT_DIM * (T8_COMPACT_MAXLEVEL
+                                                         - level));
+}
+
+/* Encode an element of the default scheme as a compact element */
+static void
+t8_compact_encode (const t8_compact_full_t * full, t8_element_t * elem)
+{
+  const t8_element_t *f = (const t8_element_t *) full;
+  const int           level = t8_compact_full->elem_level (f);
+
+  T8_ASSERT (level <= T8_COMPACT_MAXLEVEL);
+  T8_COMPACT (elem) =
+    T8_COMPACT_KEY (t8_compact_full->elem_get_linear_id
+                    (f, T8_COMPACT_MAXLEVEL), level);
+}
+
+static              size_t
+t8_compact_size (void)
+{
+  return sizeof (t8_compact_element_t);
+}
+
+static int
+t8_compact_maxlevel (void)
+{
+  return T8_COMPACT_MAXLEVEL;
+}
+
+static              t8_eclass_t
+t8_compact_child_eclass (int childid)
+{
+  T8_ASSERT (0 <= childid && childid < T8_COMPACT_CHILDREN);
+
+  return T8_COMPACT_ECLASS;
+}
+
+static int
+t8_compact_level (const t8_element_t * elem)
+{
+  return T8_COMPACT_LEVEL (T8_COMPACT_CONST (elem));
+}
+
+static void
+t8_compact_copy (const t8_element_t * source, t8_element_t * dest)
+{
+  T8_COMPACT (dest) = T8_COMPACT_CONST (source);
+}
+
+static int
+t8_compact_compare (const t8_element_t * elem1, const t8_element_t * elem2)
+{
+  const t8_compact_element_t a1 = T8_COMPACT_ANCHOR (T8_COMPACT_CONST (elem1));
+  const t8_compact_element_t a2 = T8_COMPACT_ANCHOR (T8_COMPACT_CONST (elem2));
+
+  /* Comparing the linear ids on the bigger level of the two elements is
+   * the same as comparing their first descendants */
+  return a1 < a2 ? -1 : a1 != a2;
+}
+
+static void
+t8_compact_parent (const t8_element_t * elem, t8_element_t * parent)
+{
+  const t8_compact_element_t k = T8_COMPACT_CONST (elem);
+  const int           level = T8_COMPACT_LEVEL (k);
+
+  T8_ASSERT (level > 0);
+  T8_COMPACT (parent) =
+    T8_COMPACT_KEY (T8_COMPACT_ANCHOR (k) & ~(T8_COMPACT_LEN (level - 1) -
+                                              1), level - 1);
+}
+
+#ifdef T8_COMPACT_MORTON
+
+static void
+t8_compact_sibling (const t8_element_t * elem, int sibid,
+                    t8_element_t * sibling)
+{
+  const t8_compact_element_t k = T8_COMPACT_CONST (elem);
+  const int           level = T8_COMPACT_LEVEL (k);
+
+  T8_ASSERT (level > 0);
+  T8_ASSERT (0 <= sibid && sibid < T8_COMPACT_CHILDREN);
+  T8_COMPACT (sibling) =
+    T8_COMPACT_KEY ((T8_COMPACT_ANCHOR (k) &
+                     ~(T8_COMPACT_LEN (level - 1) - 1)) +
+                    sibid * T8_COMPACT_LEN (level), level);
+}
+
+static void
+t8_compact_child (const t8_element_t * elem, int childid,
+                  t8_element_t * child)
+{
+  const t8_compact_element_t k = T8_COMPACT_CONST (elem);
+  const int           level = T8_COMPACT_LEVEL (k);
+
+  T8_ASSERT (level < T8_COMPACT_MAXLEVEL);
+  T8_ASSERT (0 <= childid && childid < T8_COMPACT_CHILDREN);
+  T8_COMPACT (child) =
+    T8_COMPACT_KEY (T8_COMPACT_ANCHOR (k) +
+                    childid * T8_COMPACT_LEN (level + 1), level + 1);
+}
+
+static void
+t8_compact_children (const t8_element_t * elem, int length,
+                     t8_element_t * c[])
+{
+  int                 ichild;
+
+  T8_ASSERT (length == T8_COMPACT_CHILDREN);
+
+  for (ichild = 0; ichild < T8_COMPACT_CHILDREN; ++ichild) {
+    t8_compact_child (elem, ichild, c[ichild]);
+  }
+}
+
+static int
+t8_compact_child_id (const t8_element_t * elem)
+{
+  const t8_compact_element_t k = T8_COMPACT_CONST (elem);
+  const int           level = T8_COMPACT_LEVEL (k);
+
+  T8_ASSERT (level > 0);
+  return (int) ((T8_COMPACT_ANCHOR (k) / T8_COMPACT_LEN (level)) &
+                (T8_COMPACT_CHILDREN - 1));
+}
+
+static int
+t8_compact_is_family (t8_element_t ** fam)
+{
+  const t8_compact_element_t k = T8_COMPACT (fam[0]);
+  const int           level = T8_COMPACT_LEVEL (k);
+  int                 ichild;
+
+  if (level == 0 || t8_compact_child_id (fam[0]) != 0) {
+    return 0;
+  }
+  for (ichild = 1; ichild < T8_COMPACT_CHILDREN; ++ichild) {
+    if (T8_COMPACT (fam[ichild]) !=
+        k + (ichild * T8_COMPACT_LEN (level) << T8_COMPACT_LEVEL_BITS)) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+#else /* !T8_COMPACT_MORTON */
+
+static void
+t8_compact_sibling (const t8_element_t * elem, int sibid,
+                    t8_element_t * sibling)
+{
+  t8_compact_full_t   full, full_sibling;
+
+  t8_compact_decode (elem, &full);
+  t8_compact_full->elem_sibling ((const t8_element_t *) &full, sibid,
+                                 (t8_element_t *) & full_sibling);
+  t8_compact_encode (&full_sibling, sibling);
+}
+
+static void
+t8_compact_child (const t8_element_t * elem, int childid,
+                  t8_element_t * child)
+{
+  t8_compact_full_t   full, full_child;
+
+  t8_compact_decode (elem, &full);
+  t8_compact_full->elem_child ((const t8_element_t *) &full, childid,
+                               (t8_element_t *) & full_child);
+  t8_compact_encode (&full_child, child);
+}
+
+static void
+t8_compact_children (const t8_element_t * elem, int length,
+                     t8_element_t * c[])
+{
+  t8_compact_full_t   full, full_children[T8_COMPACT_CHILDREN];
+  t8_element_t       *pchildren[T8_COMPACT_CHILDREN];
+  int                 ichild;
+
+  T8_ASSERT (length == T8_COMPACT_CHILDREN);
+
+  t8_compact_decode (elem, &full);
+  for (ichild = 0; ichild < T8_COMPACT_CHILDREN; ++ichild) {
+    pchildren[ichild] = (t8_element_t *) (full_children + ichild);
+  }
+  t8_compact_full->elem_children ((const t8_element_t *) &full, length,
+                                  pchildren);
+  for (ichild = 0; ichild < T8_COMPACT_CHILDREN; ++ichild) {
+    t8_compact_encode (full_children + ichild, c[ichild]);
+  }
+}
+
+static int
+t8_compact_child_id (const t8_element_t * elem)
+{
+  t8_compact_full_t   full;
+
+  t8_compact_decode (elem, &full);
+  return t8_compact_full->elem_child_id ((const t8_element_t *) &full);
+}
+
+static int
+t8_compact_is_family (t8_element_t ** fam)
+{
+  t8_compact_full_t   full_fam[T8_COMPACT_CHILDREN];
+  t8_element_t       *pfam[T8_COMPACT_CHILDREN];
+  int                 ichild;
+
+  for (ichild = 0; ichild < T8_COMPACT_CHILDREN; ++ichild) {
+    t8_compact_decode (fam[ichild], full_fam + ichild);
+    pfam[ichild] = (t8_element_t *) (full_fam + ichild);
+  }
+  return t8_compact_full->elem_is_family (pfam);
+}
+
+#endif /* !T8_COMPACT_MORTON */
+
+static void
+t8_compact_nca (const t8_element_t * elem1, const t8_element_t * elem2,
+                t8_element_t * nca)
+{
+  const t8_compact_element_t k1 = T8_COMPACT_CONST (elem1);
+  const t8_compact_element_t k2 = T8_COMPACT_CONST (elem2);
+  const t8_compact_element_t exclor =
+    T8_COMPACT_ANCHOR (k1) ^ T8_COMPACT_ANCHOR (k2);
+  int                 level;
+
+  /* The ancestors of an element are the prefixes of its anchor, thus the
+   * nearest common ancestor is given by the longest common prefix */
+  level = SC_MIN (T8_COMPACT_LEVEL (k1), T8_COMPACT_LEVEL (k2));
+  while (level > 0 && exclor >= T8_COMPACT_LEN (level)) {
+    --level;
+  }
+  T8_COMPACT (nca) =
+    T8_COMPACT_KEY (T8_COMPACT_ANCHOR (k1) & ~(T8_COMPACT_LEN (level) - 1),
+                    level);
+}
+
+static void
+t8_compact_set_linear_id (t8_element_t * elem, int level, uint64_t id)
+{
+  T8_ASSERT (0 <= level && level <= T8_COMPACT_MAXLEVEL);
+  T8_ASSERT (id < (uint64_t) 1 << T8_COMPACT_DIM * level);
+
+  T8_COMPACT (elem) = T8_COMPACT_KEY (id * T8_COMPACT_LEN (level), level);
+}
+
+static              uint64_t
+t8_compact_get_linear_id (const t8_element_t * elem, int level)
+{
+  T8_ASSERT (0 <= level && level <= T8_COMPACT_MAXLEVEL);
+
+  return T8_COMPACT_ANCHOR (T8_COMPACT_CONST (elem)) / T8_COMPACT_LEN (level);
+}
+
+static void
+t8_compact_first_descendant (const t8_element_t * elem, t8_element_t * desc)
+{
+  T8_COMPACT (desc) =
+    T8_COMPACT_KEY (T8_COMPACT_ANCHOR (T8_COMPACT_CONST (elem)),
+                    T8_COMPACT_MAXLEVEL);
+}
+
+static void
+t8_compact_last_descendant (const t8_element_t * elem, t8_element_t * desc)
+{
+  const t8_compact_element_t k = T8_COMPACT_CONST (elem);
+
+  T8_COMPACT (desc) =
+    T8_COMPACT_KEY (T8_COMPACT_ANCHOR (k) +
+                    T8_COMPACT_LEN (T8_COMPACT_LEVEL (k)) - 1,
+                    T8_COMPACT_MAXLEVEL);
+}
+
+static void
+t8_compact_successor (const t8_element_t * elem1, t8_element_t * elem2,
+                      int level)
+{
+  uint64_t            id;
+
+  T8_ASSERT (1 <= level && level <= T8_COMPACT_LEVEL (T8_COMPACT_CONST
+                                                       (elem1)));
+
+  id = t8_compact_get_linear_id (elem1, level) + 1;
+  t8_compact_set_linear_id (elem2, level, id);
+}
+
+static void
+t8_compact_anchor (const t8_element_t * elem, int anchor[3])
+{
+  t8_compact_full_t   full;
+
+  t8_compact_decode (elem, &full);
+  t8_compact_full->elem_anchor ((const t8_element_t *) &full, anchor);
+}
+
+static int
+t8_compact_root_len (const t8_element_t * elem)
+{
+  t8_compact_full_t   full;
+
+  t8_compact_decode (elem, &full);
+  return t8_compact_full->elem_root_len ((const t8_element_t *) &full);
+}
+
+static int
+t8_compact_num_faces (const t8_element_t * elem)
+{
+  t8_compact_full_t   full;
+
+  t8_compact_decode (elem, &full);
+  return t8_compact_full->elem_num_faces ((const t8_element_t *) &full);
+}
+
+static int
+t8_compact_num_face_children (const t8_element_t * elem, int face)
+{
+  t8_compact_full_t   full;
+
+  t8_compact_decode (elem, &full);
+  return t8_compact_full->elem_num_face_children ((const t8_element_t *)
+                                                  &full, face);
+}
+
+static void
+t8_compact_children_at_face (const t8_element_t * elem, int face,
+                             t8_element_t * children[], int num_children)
+{
+  t8_compact_full_t   full, full_children[T8_COMPACT_FACE_CHILDREN];
+  t8_element_t       *pchildren[T8_COMPACT_FACE_CHILDREN];
+  int                 ichild;
+
+  T8_ASSERT (0 <= num_children && num_children <= T8_COMPACT_FACE_CHILDREN);
+
+  t8_compact_decode (elem, &full);
+  for (ichild = 0; ichild < num_children; ++ichild) {
+    pchildren[ichild] = (t8_element_t *) (full_children + ichild);
+  }
+  t8_compact_full->elem_children_at_face ((const t8_element_t *) &full,
+                                          face, pchildren, num_children);
+  for (ichild = 0; ichild < num_children; ++ichild) {
+    t8_compact_encode (full_children + ichild, children[ichild]);
+  }
+}
+
+static int
+t8_compact_face_child_face (const t8_element_t * elem, int face,
+                            int face_child)
+{
+  t8_compact_full_t   full;
+
+  t8_compact_decode (elem, &full);
+  return t8_compact_full->elem_face_child_face ((const t8_element_t *) &full,
+                                                face, face_child);
+}
+
+static int
+t8_compact_tree_face (const t8_element_t * elem, int face)
+{
+  t8_compact_full_t   full;
+
+  t8_compact_decode (elem, &full);
+  return t8_compact_full->elem_tree_face ((const t8_element_t *) &full,
+                                          face);
+}
+
+static int
+t8_compact_face_neighbor_inside (const t8_element_t * elem,
+                                 t8_element_t * neigh, int face,
+                                 int *neigh_face)
+{
+  t8_compact_full_t   full, full_neigh;
+  int                 is_inside;
+
+  t8_compact_decode (elem, &full);
+  is_inside =
+    t8_compact_full->elem_face_neighbor_inside ((const t8_element_t *)
+                                                &full,
+                                                (t8_element_t *) &
+                                                full_neigh, face,
+                                                neigh_face);
+  /* A neighbor outside of the root element has no linear id and cannot
+   * be encoded.  The callers do not use it in this case. */
+  T8_COMPACT (neigh) = T8_COMPACT_CONST (elem);
+  if (is_inside) {
+    t8_compact_encode (&full_neigh, neigh);
+  }
+  return is_inside;
+}
+
+static int
+t8_compact_tree_face_neighbor (const t8_element_t * elem,
+                               t8_element_t * neigh, int face,
+                               int neigh_tree_face, int orientation,
+                               int is_smaller_face)
+{
+  t8_compact_full_t   full, full_neigh;
+  int                 neigh_face;
+
+  t8_compact_decode (elem, &full);
+  neigh_face =
+    t8_compact_full->elem_tree_face_neighbor ((const t8_element_t *) &full,
+                                              (t8_element_t *) & full_neigh,
+                                              face, neigh_tree_face,
+                                              orientation, is_smaller_face);
+  t8_compact_encode (&full_neigh, neigh);
+  return neigh_face;
+}
+
+static void
+t8_compact_vertex_coords (const t8_element_t * elem, int vertex,
+                          int coords[])
+{
+  t8_compact_full_t   full;
+
+  t8_compact_decode (elem, &full);
+  t8_compact_full->elem_vertex_coords ((const t8_element_t *) &full, vertex,
+                                       coords);
+}
+
+/* The routines on contiguous arrays work on the integers only and are
+ * simple loops that the compiler may vectorize */
+
+static void
+t8_compact_parents (const t8_element_t * elems, size_t count,
+                    t8_element_t * parents)
+{
+  const t8_compact_element_t *k = (const t8_compact_element_t *) elems;
+  t8_compact_element_t *p = (t8_compact_element_t *) parents;
+  size_t              i;
+  int                 level;
+
+  for (i = 0; i < count; ++i) {
+    level = T8_COMPACT_LEVEL (k[i]);
+    T8_ASSERT (level > 0);
+    p[i] = T8_COMPACT_KEY (T8_COMPACT_ANCHOR (k[i]) &
+                           ~(T8_COMPACT_LEN (level - 1) - 1), level - 1);
+  }
+}
+
+static void
+t8_compact_children_array (const t8_element_t * elems, size_t count,
+                           t8_element_t * children)
+{
+  const t8_compact_element_t *k = (const t8_compact_element_t *) elems;
+  t8_compact_element_t *c = (t8_compact_element_t *) children;
+  t8_compact_element_t first;
+  uint64_t            len;
+  size_t              i;
+  int                 ichild, level;
+
+  /* The children in SFC order have consecutive linear ids */
+  for (i = 0; i < count; ++i) {
+    level = T8_COMPACT_LEVEL (k[i]);
+    T8_ASSERT (level < T8_COMPACT_MAXLEVEL);
+    first = T8_COMPACT_KEY (T8_COMPACT_ANCHOR (k[i]), level + 1);
+    len = T8_COMPACT_LEN (level + 1) << T8_COMPACT_LEVEL_BITS;
+    for (ichild = 0; ichild < T8_COMPACT_CHILDREN; ++ichild) {
+      c[i * T8_COMPACT_CHILDREN + ichild] = first + ichild * len;
+    }
+  }
+}
+
+static void
+t8_compact_get_linear_ids (const t8_element_t * elems, size_t count,
+                           int level, uint64_t * ids)
+{
+  const t8_compact_element_t *k = (const t8_compact_element_t *) elems;
+  const int           shift =
+    T8_COMPACT_LEVEL_BITS + T8_COMPACT_DIM * (T8_COMPACT_MAXLEVEL - level);
+  size_t              i;
+
+  T8_ASSERT (0 <= level && level <= T8_COMPACT_MAXLEVEL);
+
+  for (i = 0; i < count; ++i) {
+    ids[i] = k[i] >> shift;
+  }
+}
+
+static void
+t8_compact_linear_range (t8_element_t * elems, int level, uint64_t start,
+                         uint64_t end)
+{
+  t8_compact_element_t *k = (t8_compact_element_t *) elems;
+  const uint64_t      len = T8_COMPACT_LEN (level) << T8_COMPACT_LEVEL_BITS;
+  const t8_compact_element_t first =
+    T8_COMPACT_KEY (start * T8_COMPACT_LEN (level), level);
+  uint64_t            i;
+
+  T8_ASSERT (0 <= level && level <= T8_COMPACT_MAXLEVEL);
+  T8_ASSERT (start <= end && end <= (uint64_t) 1 << T8_COMPACT_DIM * level);
+
+  for (i = 0; i < end - start; ++i) {
+    k[i] = first + i * len;
+  }
+}
+
+static void
+t8_compact_successors (const t8_element_t * elem, size_t count,
+                       t8_element_t * succs, int level)
+{
+  uint64_t            id;
+
+  id = t8_compact_get_linear_id (elem, level) + 1;
+  t8_compact_linear_range (succs, level, id, id + count);
+}
+
+static void
+t8_compact_destroy (t8_eclass_scheme_t * ts)
+{
+  t8_default_scheme_mempool_destroy (ts);
+  T8_ASSERT (t8_compact_full_count > 0);
+  if (--t8_compact_full_count == 0) {
+    t8_eclass_scheme_destroy (t8_compact_full);
+    t8_compact_full = NULL;
+  }
+}
+
+t8_eclass_scheme_t *
+T8_COMPACT_SCHEME_NEW (void)
+{
+  t8_eclass_scheme_t *ts;
+
+  /* The level and the linear id of the first descendant fit in 64 bits */
+  SC_CHECK_ABORT (T8_COMPACT_LEVEL_BITS + T8_COMPACT_DIM *
+                  T8_COMPACT_MAXLEVEL <= 64
+                  && T8_COMPACT_MAXLEVEL < 1 << T8_COMPACT_LEVEL_BITS,
+                  "Compact element does not fit into 64 bits");
+  if (t8_compact_full_count++ == 0) {
+    t8_compact_full = T8_COMPACT_FULL_NEW ();
+  }
+  T8_ASSERT (t8_compact_full->elem_size () <= sizeof (t8_compact_full_t));
+
+  ts = T8_ALLOC_ZERO (t8_eclass_scheme_t, 1);
+  ts->eclass = T8_COMPACT_ECLASS;
+
+  ts->elem_size = t8_compact_size;
+  ts->elem_maxlevel = t8_compact_maxlevel;
+  ts->elem_child_eclass = t8_compact_child_eclass;
+
+  ts->elem_level = t8_compact_level;
+  ts->elem_copy = t8_compact_copy;
+  ts->elem_compare = t8_compact_compare;
+  ts->elem_parent = t8_compact_parent;
+  ts->elem_sibling = t8_compact_sibling;
+  ts->elem_child = t8_compact_child;
+  ts->elem_children = t8_compact_children;
+  ts->elem_child_id = t8_compact_child_id;
+  ts->elem_is_family = t8_compact_is_family;
+  ts->elem_nca = t8_compact_nca;
+  ts->elem_boundary = NULL;
+  ts->elem_set_linear_id = t8_compact_set_linear_id;
+  ts->elem_get_linear_id = t8_compact_get_linear_id;
+  ts->elem_successor = t8_compact_successor;
+  ts->elem_first_desc = t8_compact_first_descendant;
+  ts->elem_last_desc = t8_compact_last_descendant;
+  ts->elem_anchor = t8_compact_anchor;
+  ts->elem_root_len = t8_compact_root_len;
+  ts->elem_num_faces = t8_compact_num_faces;
+  ts->elem_num_face_children = t8_compact_num_face_children;
+  ts->elem_children_at_face = t8_compact_children_at_face;
+  ts->elem_face_child_face = t8_compact_face_child_face;
+  ts->elem_tree_face = t8_compact_tree_face;
+  ts->elem_face_neighbor_inside = t8_compact_face_neighbor_inside;
+  ts->elem_tree_face_neighbor = t8_compact_tree_face_neighbor;
+  ts->elem_vertex_coords = t8_compact_vertex_coords;
+  ts->elem_parents = t8_compact_parents;
+  ts->elem_children_array = t8_compact_children_array;
+  ts->elem_get_linear_ids = t8_compact_get_linear_ids;
+  ts->elem_successors = t8_compact_successors;
+  ts->elem_linear_range = t8_compact_linear_range;
+
+  ts->elem_new = t8_default_mempool_alloc;
+  ts->elem_destroy = t8_default_mempool_free;
+
+  ts->ts_destroy = t8_compact_destroy;
+  ts->ts_context = sc_mempool_new (sizeof (t8_compact_element_t));
+
+  return ts;
+}
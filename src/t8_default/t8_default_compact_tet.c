@@ -0,0 +1,39 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+/* The compact scheme for tetrahedra shares its implementation with the
+ * compact quadrilaterals. */
+
+#include "t8_default_tet.h"
+#include "t8_dtet.h"
+#include "t8_dtet_connectivity.h"
+
+#define T8_COMPACT_ECLASS T8_ECLASS_TET
+#define T8_COMPACT_DIM T8_DTET_DIM
+#define T8_COMPACT_MAXLEVEL \
+  SC_MIN (T8_DTET_MAXLEVEL, T8_COMPACT_MAXLEVEL_DIM (T8_DTET_DIM))
+#define T8_COMPACT_FACE_CHILDREN T8_DTET_FACE_CHILDREN
+#define T8_COMPACT_FULL_NEW t8_default_scheme_new_tet
+#define T8_COMPACT_SCHEME_NEW t8_default_scheme_new_compact_tet
+typedef t8_dtet_t   t8_compact_full_t;
+
+#include "t8_default_compact_quad.c"
@@ -23,11 +23,89 @@
 #include <p8est_bits.h>
 #include "t8_default_common.h"
 #include "t8_default_hex.h"
+#ifdef __BMI2__
+#include <immintrin.h>
+#endif
 
-/* This function is used by other element functions and we thus need to
- * declare it up here */
-static uint64_t     t8_default_hex_get_linear_id (const t8_element_t * elem,
-                                                  int level);
+/* The bits of the x coordinate in a 3D Morton index */
+#define T8_DHEX_MORTON_MASK_X 0x1249249249249249ULL
+
+/* Spread the lower 21 bits of x to every third bit of the result */
+static              uint64_t
+t8_default_hex_morton_spread (uint64_t x)
+{
+#ifdef __BMI2__
+  return _pdep_u64 (x, T8_DHEX_MORTON_MASK_X);
+#else
+  x &= 0x1FFFFFULL;
+  x = (x | x << 32) & 0x001F00000000FFFFULL;
+  x = (x | x << 16) & 0x001F0000FF0000FFULL;
+  x = (x | x << 8) & 0x100F00F00F00F00FULL;
+  x = (x | x << 4) & 0x10C30C30C30C30C3ULL;
+  x = (x | x << 2) & T8_DHEX_MORTON_MASK_X;
+  return x;
+#endif
+}
+
+/* Gather every third bit of x into the lower 21 bits of the result */
+static              uint64_t
+t8_default_hex_morton_compact (uint64_t x)
+{
+#ifdef __BMI2__
+  return _pext_u64 (x, T8_DHEX_MORTON_MASK_X);
+#else
+  x &= T8_DHEX_MORTON_MASK_X;
+  x = (x | x >> 2) & 0x10C30C30C30C30C3ULL;
+  x = (x | x >> 4) & 0x100F00F00F00F00FULL;
+  x = (x | x >> 8) & 0x001F0000FF0000FFULL;
+  x = (x | x >> 16) & 0x001F00000000FFFFULL;
+  x = (x | x >> 32) & 0x1FFFFFULL;
+  return x;
+#endif
+}
+
+/* Compute the Morton index of q at level, equivalent to
+ * p8est_quadrant_linear_id */
+static              uint64_t
+t8_default_hex_morton_id (const p8est_quadrant_t * q, int level)
+{
+  const int           shift = P8EST_MAXLEVEL - level;
+
+  return t8_default_hex_morton_spread ((uint32_t) q->x >> shift) |
+    t8_default_hex_morton_spread ((uint32_t) q->y >> shift) << 1 |
+    t8_default_hex_morton_spread ((uint32_t) q->z >> shift) << 2;
+}
+
+/* Set q from its Morton index at level, equivalent to
+ * p8est_quadrant_set_morton */
+static void
+t8_default_hex_morton_set (p8est_quadrant_t * q, int level, uint64_t id)
+{
+  const int           shift = P8EST_MAXLEVEL - level;
+
+  q->x = (p4est_qcoord_t) (t8_default_hex_morton_compact (id) << shift);
+  q->y = (p4est_qcoord_t) (t8_default_hex_morton_compact (id >> 1) << shift);
+  q->z = (p4est_qcoord_t) (t8_default_hex_morton_compact (id >> 2) << shift);
+  q->level = (int8_t) level;
+}
+
+#ifdef T8_ENABLE_DEBUG
+
+/* Compare two octants by their linear ids at the bigger level */
+static int
+t8_default_hex_compare_linear_id (const p8est_quadrant_t * q,
+                                  const p8est_quadrant_t * r)
+{
+  int                 maxlvl;
+  uint64_t            id1, id2;
+
+  maxlvl = SC_MAX (q->level, r->level);
+  id1 = p8est_quadrant_linear_id (q, maxlvl);
+  id2 = p8est_quadrant_linear_id (r, maxlvl);
+  return id1 < id2 ? -1 : id1 != id2;
+}
+
+#endif /* T8_ENABLE_DEBUG */
 
 static              size_t
 t8_default_hex_size (void)
@@ -65,17 +143,35 @@ static int
 t8_default_hex_compare (const t8_element_t * elem1,
                         const t8_element_t * elem2)
 {
-  int                 maxlvl;
-  u_int64_t           id1, id2;
-
-  /* Compute the bigger level of the two */
-  maxlvl = SC_MAX (t8_default_hex_level (elem1),
-                   t8_default_hex_level (elem2));
-  /* Compute the linear ids of the elements */
-  id1 = t8_default_hex_get_linear_id (elem1, maxlvl);
-  id2 = t8_default_hex_get_linear_id (elem2, maxlvl);
-  /* return negativ if id1 < id2, zero if id1 = id2, positive if id1 > id2 */
-  return id1 < id2 ? -1 : id1 != id2;
+  const p8est_quadrant_t *q = (const p8est_quadrant_t *) elem1;
+  const p8est_quadrant_t *r = (const p8est_quadrant_t *) elem2;
+  uint32_t            exclor, exclorz;
+  int64_t             diff;
+  int                 ret;
+
+  /* Comparing the linear ids at the bigger level of the two is the same as
+   * comparing the coordinates in Morton order.  The order is decided by the
+   * coordinate whose exclusive or has the most significant bit, where
+   * z wins over y and y wins over x in a tie.  The levels are not compared,
+   * thus an ancestor compares equal to its descendants with the same anchor
+   * node and less than all other descendants. */
+  exclor = (uint32_t) q->x ^ (uint32_t) r->x;
+  exclorz = (uint32_t) q->y ^ (uint32_t) r->y;
+  if (exclorz >= exclor || exclorz > (exclor ^ exclorz)) {
+    exclor = exclorz;
+    diff = (int64_t) q->y - (int64_t) r->y;
+  }
+  else {
+    diff = (int64_t) q->x - (int64_t) r->x;
+  }
+  exclorz = (uint32_t) q->z ^ (uint32_t) r->z;
+  if (exclorz >= exclor || exclorz > (exclor ^ exclorz)) {
+    diff = (int64_t) q->z - (int64_t) r->z;
+  }
+  /* return negativ if elem1 < elem2, zero if equal, positive otherwise */
+  ret = diff < 0 ? -1 : diff != 0;
+  T8_ASSERT (ret == t8_default_hex_compare_linear_id (q, r));
+  return ret;
 }
 
 static void
@@ -133,7 +229,7 @@ t8_default_hex_set_linear_id (t8_element_t * elem, int level, uint64_t id)
   T8_ASSERT (0 <= level && level <= P8EST_QMAXLEVEL);
   T8_ASSERT (0 <= id && id < ((uint64_t) 1) << P8EST_DIM * level);
 
-  p8est_quadrant_set_morton ((p8est_quadrant_t *) elem, level, id);
+  t8_default_hex_morton_set ((p8est_quadrant_t *) elem, level, id);
 }
 
 static              uint64_t
@@ -141,7 +237,7 @@ t8_default_hex_get_linear_id (const t8_element_t * elem, int level)
 {
   T8_ASSERT (0 <= level && level <= P8EST_QMAXLEVEL);
 
-  return p8est_quadrant_linear_id ((p8est_quadrant_t *) elem, level);
+  return t8_default_hex_morton_id ((const p8est_quadrant_t *) elem, level);
 }
 
 static void
@@ -168,9 +264,9 @@ t8_default_hex_successor (const t8_element_t * elem1,
   uint64_t            id;
   T8_ASSERT (0 <= level && level <= P8EST_QMAXLEVEL);
 
-  id = p8est_quadrant_linear_id ((const p8est_quadrant_t *) elem1, level);
+  id = t8_default_hex_morton_id ((const p8est_quadrant_t *) elem1, level);
   T8_ASSERT (id + 1 < ((uint64_t) 1) << P8EST_DIM * level);
-  p8est_quadrant_set_morton ((p8est_quadrant_t *) elem2, level, id + 1);
+  t8_default_hex_morton_set ((p8est_quadrant_t *) elem2, level, id + 1);
 }
 
 static void
@@ -190,6 +286,229 @@ t8_default_hex_root_len (const t8_element_t * elem)
   return P8EST_ROOT_LEN;
 }
 
+static int
+t8_default_hex_num_faces (const t8_element_t * elem)
+{
+  return P8EST_FACES;
+}
+
+static int
+t8_default_hex_num_face_children (const t8_element_t * elem, int face)
+{
+  T8_ASSERT (0 <= face && face < P8EST_FACES);
+
+  return P8EST_HALF;
+}
+
+static void
+t8_default_hex_children_at_face (const t8_element_t * elem, int face,
+                                 t8_element_t * children[], int num_children)
+{
+  int                 i;
+
+  T8_ASSERT (0 <= face && face < P8EST_FACES);
+  T8_ASSERT (num_children == P8EST_HALF);
+
+  /* The children at a face are those whose child id is a corner of the face */
+  for (i = 0; i < P8EST_HALF; i++) {
+    t8_default_hex_child (elem, p8est_face_corners[face][i], children[i]);
+  }
+}
+
+static int
+t8_default_hex_face_child_face (const t8_element_t * elem, int face,
+                                int face_child)
+{
+  T8_ASSERT (0 <= face && face < P8EST_FACES);
+  T8_ASSERT (0 <= face_child && face_child < P8EST_HALF);
+
+  /* The children of a hexahedron keep the face numbers of the parent */
+  return face;
+}
+
+static int
+t8_default_hex_tree_face (const t8_element_t * elem, int face)
+{
+  T8_ASSERT (0 <= face && face < P8EST_FACES);
+
+  return face;
+}
+
+static int
+t8_default_hex_face_neighbor_inside (const t8_element_t * elem,
+                                     t8_element_t * neigh, int face,
+                                     int *neigh_face)
+{
+  const p8est_quadrant_t *q = (const p8est_quadrant_t *) elem;
+  p8est_quadrant_t   *r = (p8est_quadrant_t *) neigh;
+
+  T8_ASSERT (0 <= face && face < P8EST_FACES);
+
+  p8est_quadrant_face_neighbor (q, face, r);
+  *neigh_face = face ^ 1;
+  return p8est_quadrant_is_inside_root (r);
+}
+
+/* For each face of the hexahedron, whether its corners as given by
+ * p8est_face_corners span a right-handed system with respect to the
+ * outward normal. */
+static const int    t8_default_hex_face_righthanded[P8EST_FACES] =
+  { 0, 1, 1, 0, 0, 1 };
+
+static int
+t8_default_hex_tree_face_neighbor (const t8_element_t * elem,
+                                   t8_element_t * neigh, int face,
+                                   int neigh_tree_face, int orientation,
+                                   int is_smaller_face)
+{
+  const p8est_quadrant_t *q = (const p8est_quadrant_t *) elem;
+  p8est_quadrant_t   *r = (p8est_quadrant_t *) neigh;
+  const p4est_qcoord_t last = P8EST_LAST_OFFSET (q->level);
+  p4est_qcoord_t      my_coords[3], coords[3], tangent[2], temp;
+  int                 swap, flip[2];
+
+  T8_ASSERT (0 <= face && face < P8EST_FACES);
+  T8_ASSERT (0 <= neigh_tree_face && neigh_tree_face < P8EST_FACES);
+  T8_ASSERT (0 <= orientation && orientation < 4);
+
+  my_coords[0] = q->x;
+  my_coords[1] = q->y;
+  my_coords[2] = q->z;
+  /* The coordinates along the face in the order of the face corners */
+  tangent[0] = my_coords[face < 2 ? 1 : 0];
+  tangent[1] = my_coords[face < 4 ? 2 : 1];
+  /* The face corners of the smaller face map to the other face by first
+   * exchanging the two tangential axes if the map is a reflection and
+   * then reflecting each axis if the corresponding bit of the orientation
+   * is set.  For the other face we apply the inverse. */
+  swap = t8_default_hex_face_righthanded[face]
+    ^ t8_default_hex_face_righthanded[neigh_tree_face]
+    ^ (orientation == 0 || orientation == 3);
+  if (is_smaller_face || !swap) {
+    flip[0] = orientation & 1;
+    flip[1] = orientation >> 1;
+  }
+  else {
+    flip[0] = orientation >> 1;
+    flip[1] = orientation & 1;
+  }
+  if (swap) {
+    temp = tangent[0];
+    tangent[0] = tangent[1];
+    tangent[1] = temp;
+  }
+  coords[neigh_tree_face < 2 ? 1 : 0] = flip[0] ? last - tangent[0]
+    : tangent[0];
+  coords[neigh_tree_face < 4 ? 2 : 1] = flip[1] ? last - tangent[1]
+    : tangent[1];
+  coords[neigh_tree_face / 2] = neigh_tree_face % 2 == 0 ? 0 : last;
+
+  r->x = coords[0];
+  r->y = coords[1];
+  r->z = coords[2];
+  r->level = q->level;
+  T8_ASSERT (p8est_quadrant_is_inside_root (r));
+  return neigh_tree_face;
+}
+
+static void
+t8_default_hex_vertex_coords (const t8_element_t * elem, int vertex,
+                              int coords[])
+{
+  const p8est_quadrant_t *q = (const p8est_quadrant_t *) elem;
+  p4est_qcoord_t      len;
+
+  T8_ASSERT (0 <= vertex && vertex < P8EST_CHILDREN);
+  len = P8EST_QUADRANT_LEN (q->level);
+  coords[0] = q->x + (vertex & 1 ? len : 0);
+  coords[1] = q->y + (vertex & 2 ? len : 0);
+  coords[2] = q->z + (vertex & 4 ? len : 0);
+}
+
+static void
+t8_default_hex_parents (const t8_element_t * elems, size_t count,
+                        t8_element_t * parents)
+{
+  const p8est_quadrant_t *q = (const p8est_quadrant_t *) elems;
+  p8est_quadrant_t   *r = (p8est_quadrant_t *) parents;
+  size_t              i;
+
+  for (i = 0; i < count; ++i) {
+    p8est_quadrant_parent (q + i, r + i);
+  }
+}
+
+static void
+t8_default_hex_children_array (const t8_element_t * elems, size_t count,
+                               t8_element_t * children)
+{
+  const p8est_quadrant_t *q = (const p8est_quadrant_t *) elems;
+  p8est_quadrant_t   *r = (p8est_quadrant_t *) children;
+  p4est_qcoord_t      shift;
+  size_t              i;
+  int                 ichild;
+
+  for (i = 0; i < count; ++i, ++q) {
+    T8_ASSERT (q->level < P8EST_QMAXLEVEL);
+    shift = P8EST_QUADRANT_LEN (q->level + 1);
+    for (ichild = 0; ichild < P8EST_CHILDREN; ++ichild, ++r) {
+      r->x = ichild & 0x01 ? (q->x | shift) : q->x;
+      r->y = ichild & 0x02 ? (q->y | shift) : q->y;
+      r->z = ichild & 0x04 ? (q->z | shift) : q->z;
+      r->level = q->level + 1;
+    }
+  }
+}
+
+static void
+t8_default_hex_get_linear_ids (const t8_element_t * elems, size_t count,
+                               int level, uint64_t * ids)
+{
+  const p8est_quadrant_t *q = (const p8est_quadrant_t *) elems;
+  size_t              i;
+
+  T8_ASSERT (0 <= level && level <= P8EST_QMAXLEVEL);
+
+  for (i = 0; i < count; ++i) {
+    ids[i] = t8_default_hex_morton_id (q + i, level);
+  }
+}
+
+static void
+t8_default_hex_successors (const t8_element_t * elem, size_t count,
+                           t8_element_t * succs, int level)
+{
+  const p8est_quadrant_t *q = (const p8est_quadrant_t *) elem;
+  p8est_quadrant_t   *r = (p8est_quadrant_t *) succs;
+  uint64_t            id;
+  size_t              i;
+
+  T8_ASSERT (0 <= level && level <= P8EST_QMAXLEVEL);
+
+  /* The successors are consecutive in the Morton order */
+  id = t8_default_hex_morton_id (q, level);
+  T8_ASSERT (id + count < ((uint64_t) 1) << P8EST_DIM * level);
+  for (i = 0; i < count; ++i) {
+    t8_default_hex_morton_set (r + i, level, id + 1 + i);
+  }
+}
+
+static void
+t8_default_hex_linear_range (t8_element_t * elems, int level,
+                              uint64_t start, uint64_t end)
+{
+  p8est_quadrant_t   *q = (p8est_quadrant_t *) elems;
+  uint64_t            id;
+
+  T8_ASSERT (0 <= level && level <= P8EST_QMAXLEVEL);
+  T8_ASSERT (start <= end && end <= ((uint64_t) 1) << P8EST_DIM * level);
+
+  /* Decoding a Morton index takes constant time */
+  for (id = start; id < end; ++id, ++q) {
+    t8_default_hex_morton_set (q, level, id);
+  }
+}
+
 t8_eclass_scheme_t *
 t8_default_scheme_new_hex (void)
 {
@@ -220,6 +539,19 @@ t8_default_scheme_new_hex (void)
   ts->elem_successor = t8_default_hex_successor;
   ts->elem_anchor = t8_default_hex_anchor;
   ts->elem_root_len = t8_default_hex_root_len;
+  ts->elem_num_faces = t8_default_hex_num_faces;
+  ts->elem_num_face_children = t8_default_hex_num_face_children;
+  ts->elem_children_at_face = t8_default_hex_children_at_face;
+  ts->elem_face_child_face = t8_default_hex_face_child_face;
+  ts->elem_tree_face = t8_default_hex_tree_face;
+  ts->elem_face_neighbor_inside = t8_default_hex_face_neighbor_inside;
+  ts->elem_tree_face_neighbor = t8_default_hex_tree_face_neighbor;
+  ts->elem_vertex_coords = t8_default_hex_vertex_coords;
+  ts->elem_parents = t8_default_hex_parents;
+  ts->elem_children_array = t8_default_hex_children_array;
+  ts->elem_get_linear_ids = t8_default_hex_get_linear_ids;
+  ts->elem_successors = t8_default_hex_successors;
+  ts->elem_linear_range = t8_default_hex_linear_range;
 
   ts->elem_new = t8_default_mempool_alloc;
   ts->elem_destroy = t8_default_mempool_free;
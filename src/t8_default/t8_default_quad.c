@@ -23,11 +23,69 @@
 #include <p4est_bits.h>
 #include "t8_default_common.h"
 #include "t8_default_quad.h"
+#ifdef __BMI2__
+#include <immintrin.h>
+#endif
+
+/* The bits of the x coordinate in a 2D Morton index */
+#define T8_DQUAD_MORTON_MASK_X 0x5555555555555555ULL
+
+/* Spread the lower 32 bits of x to the even bits of the result */
+static              uint64_t
+t8_default_quad_morton_spread (uint64_t x)
+{
+#ifdef __BMI2__
+  return _pdep_u64 (x, T8_DQUAD_MORTON_MASK_X);
+#else
+  x &= 0xFFFFFFFFULL;
+  x = (x | x << 16) & 0x0000FFFF0000FFFFULL;
+  x = (x | x << 8) & 0x00FF00FF00FF00FFULL;
+  x = (x | x << 4) & 0x0F0F0F0F0F0F0F0FULL;
+  x = (x | x << 2) & 0x3333333333333333ULL;
+  x = (x | x << 1) & T8_DQUAD_MORTON_MASK_X;
+  return x;
+#endif
+}
+
+/* Gather the even bits of x into the lower 32 bits of the result */
+static              uint64_t
+t8_default_quad_morton_compact (uint64_t x)
+{
+#ifdef __BMI2__
+  return _pext_u64 (x, T8_DQUAD_MORTON_MASK_X);
+#else
+  x &= T8_DQUAD_MORTON_MASK_X;
+  x = (x | x >> 1) & 0x3333333333333333ULL;
+  x = (x | x >> 2) & 0x0F0F0F0F0F0F0F0FULL;
+  x = (x | x >> 4) & 0x00FF00FF00FF00FFULL;
+  x = (x | x >> 8) & 0x0000FFFF0000FFFFULL;
+  x = (x | x >> 16) & 0x00000000FFFFFFFFULL;
+  return x;
+#endif
+}
+
+/* Compute the Morton index of q at level, equivalent to
+ * p4est_quadrant_linear_id */
+static              uint64_t
+t8_default_quad_morton_id (const p4est_quadrant_t * q, int level)
+{
+  const int           shift = P4EST_MAXLEVEL - level;
 
-/* This function is used by other element functions and we thus need to
- * declare it up here */
-static uint64_t     t8_default_quad_get_linear_id (const t8_element_t * elem,
-                                                   int level);
+  return t8_default_quad_morton_spread ((uint32_t) q->x >> shift) |
+    t8_default_quad_morton_spread ((uint32_t) q->y >> shift) << 1;
+}
+
+/* Set q from its Morton index at level, equivalent to
+ * p4est_quadrant_set_morton */
+static void
+t8_default_quad_morton_set (p4est_quadrant_t * q, int level, uint64_t id)
+{
+  const int           shift = P4EST_MAXLEVEL - level;
+
+  q->x = (p4est_qcoord_t) (t8_default_quad_morton_compact (id) << shift);
+  q->y = (p4est_qcoord_t) (t8_default_quad_morton_compact (id >> 1) << shift);
+  q->level = (int8_t) level;
+}
 
 #ifdef T8_ENABLE_DEBUG
 
@@ -36,11 +94,25 @@ t8_default_quad_surround_matches (const p4est_quadrant_t * q,
                                   const p4est_quadrant_t * r)
 {
   return T8_QUAD_GET_TDIM (q) == T8_QUAD_GET_TDIM (r) &&
-    (T8_QUAD_GET_TDIM (q) == -1 ||
+    (T8_QUAD_GET_TDIM (q) != 3 ||
      (T8_QUAD_GET_TNORMAL (q) == T8_QUAD_GET_TNORMAL (r) &&
       T8_QUAD_GET_TCOORD (q) == T8_QUAD_GET_TCOORD (r)));
 }
 
+/* Compare two quadrants by their linear ids at the bigger level */
+static int
+t8_default_quad_compare_linear_id (const p4est_quadrant_t * q,
+                                   const p4est_quadrant_t * r)
+{
+  int                 maxlvl;
+  uint64_t            id1, id2;
+
+  maxlvl = SC_MAX (q->level, r->level);
+  id1 = p4est_quadrant_linear_id (q, maxlvl);
+  id2 = p4est_quadrant_linear_id (r, maxlvl);
+  return id1 < id2 ? -1 : id1 != id2;
+}
+
 #endif /* T8_ENABLE_DEBUG */
 
 static              size_t
@@ -94,17 +166,30 @@ static int
 t8_default_quad_compare (const t8_element_t * elem1,
                          const t8_element_t * elem2)
 {
-  int                 maxlvl;
-  u_int64_t           id1, id2;
-
-  /* Compute the bigger level of the two */
-  maxlvl = SC_MAX (t8_default_quad_level (elem1),
-                   t8_default_quad_level (elem2));
-  /* Compute the linear ids of the elements */
-  id1 = t8_default_quad_get_linear_id (elem1, maxlvl);
-  id2 = t8_default_quad_get_linear_id (elem2, maxlvl);
-  /* return negativ if id1 < id2, zero if id1 = id2, positive if id1 > id2 */
-  return id1 < id2 ? -1 : id1 != id2;
+  const p4est_quadrant_t *q = (const p4est_quadrant_t *) elem1;
+  const p4est_quadrant_t *r = (const p4est_quadrant_t *) elem2;
+  uint32_t            exclorx, exclory;
+  int64_t             diff;
+  int                 ret;
+
+  /* Comparing the linear ids at the bigger level of the two is the same as
+   * comparing the coordinates in Morton order.  The order is decided by the
+   * coordinate whose exclusive or has the most significant bit, where
+   * y wins a tie.  The levels are not compared, thus an ancestor compares
+   * equal to its descendants with the same anchor node and less than all
+   * other descendants. */
+  exclorx = (uint32_t) q->x ^ (uint32_t) r->x;
+  exclory = (uint32_t) q->y ^ (uint32_t) r->y;
+  if (exclory >= exclorx || exclory > (exclorx ^ exclory)) {
+    diff = (int64_t) q->y - (int64_t) r->y;
+  }
+  else {
+    diff = (int64_t) q->x - (int64_t) r->x;
+  }
+  /* return negativ if elem1 < elem2, zero if equal, positive otherwise */
+  ret = diff < 0 ? -1 : diff != 0;
+  T8_ASSERT (ret == t8_default_quad_compare_linear_id (q, r));
+  return ret;
 }
 
 static void
@@ -181,7 +266,7 @@ t8_default_quad_set_linear_id (t8_element_t * elem, int level, uint64_t id)
   T8_ASSERT (0 <= level && level <= P4EST_QMAXLEVEL);
   T8_ASSERT (0 <= id && id < ((uint64_t) 1) << P4EST_DIM * level);
 
-  p4est_quadrant_set_morton ((p4est_quadrant_t *) elem, level, id);
+  t8_default_quad_morton_set ((p4est_quadrant_t *) elem, level, id);
   T8_QUAD_SET_TDIM ((p4est_quadrant_t *) elem, 2);
 }
 
@@ -190,7 +275,7 @@ t8_default_quad_get_linear_id (const t8_element_t * elem, int level)
 {
   T8_ASSERT (0 <= level && level <= P4EST_QMAXLEVEL);
 
-  return p4est_quadrant_linear_id ((p4est_quadrant_t *) elem, level);
+  return t8_default_quad_morton_id ((const p4est_quadrant_t *) elem, level);
 }
 
 static void
@@ -217,9 +302,9 @@ t8_default_quad_successor (const t8_element_t * elem1,
   uint64_t            id;
   T8_ASSERT (0 <= level && level <= P4EST_QMAXLEVEL);
 
-  id = p4est_quadrant_linear_id ((const p4est_quadrant_t *) elem1, level);
+  id = t8_default_quad_morton_id ((const p4est_quadrant_t *) elem1, level);
   T8_ASSERT (id + 1 < ((uint64_t) 1) << P4EST_DIM * level);
-  p4est_quadrant_set_morton ((p4est_quadrant_t *) elem2, level, id + 1);
+  t8_default_quad_morton_set ((p4est_quadrant_t *) elem2, level, id + 1);
   t8_default_quad_copy_surround ((const p4est_quadrant_t *) elem1,
                                  (p4est_quadrant_t *) elem2);
 }
@@ -270,6 +355,207 @@ t8_default_quad_root_len (const t8_element_t * elem)
   return P4EST_ROOT_LEN;
 }
 
+static int
+t8_default_quad_num_faces (const t8_element_t * elem)
+{
+  return P4EST_FACES;
+}
+
+static int
+t8_default_quad_num_face_children (const t8_element_t * elem, int face)
+{
+  T8_ASSERT (0 <= face && face < P4EST_FACES);
+
+  return P4EST_HALF;
+}
+
+static void
+t8_default_quad_children_at_face (const t8_element_t * elem, int face,
+                                  t8_element_t * children[],
+                                  int num_children)
+{
+  int                 i;
+
+  T8_ASSERT (0 <= face && face < P4EST_FACES);
+  T8_ASSERT (num_children == P4EST_HALF);
+
+  /* The children at a face are those whose child id is a corner of the face */
+  for (i = 0; i < P4EST_HALF; i++) {
+    t8_default_quad_child (elem, p4est_face_corners[face][i], children[i]);
+  }
+}
+
+static int
+t8_default_quad_face_child_face (const t8_element_t * elem, int face,
+                                 int face_child)
+{
+  T8_ASSERT (0 <= face && face < P4EST_FACES);
+  T8_ASSERT (0 <= face_child && face_child < P4EST_HALF);
+
+  /* The children of a quadrant keep the face numbers of the parent */
+  return face;
+}
+
+static int
+t8_default_quad_tree_face (const t8_element_t * elem, int face)
+{
+  T8_ASSERT (0 <= face && face < P4EST_FACES);
+
+  return face;
+}
+
+static int
+t8_default_quad_face_neighbor_inside (const t8_element_t * elem,
+                                      t8_element_t * neigh, int face,
+                                      int *neigh_face)
+{
+  const p4est_quadrant_t *q = (const p4est_quadrant_t *) elem;
+  p4est_quadrant_t   *r = (p4est_quadrant_t *) neigh;
+
+  T8_ASSERT (0 <= face && face < P4EST_FACES);
+
+  p4est_quadrant_face_neighbor (q, face, r);
+  t8_default_quad_copy_surround (q, r);
+  *neigh_face = face ^ 1;
+  return p4est_quadrant_is_inside_root (r);
+}
+
+static int
+t8_default_quad_tree_face_neighbor (const t8_element_t * elem,
+                                    t8_element_t * neigh, int face,
+                                    int neigh_tree_face, int orientation,
+                                    int is_smaller_face)
+{
+  const p4est_quadrant_t *q = (const p4est_quadrant_t *) elem;
+  p4est_quadrant_t   *r = (p4est_quadrant_t *) neigh;
+  p4est_qcoord_t      tangent, normal;
+
+  T8_ASSERT (0 <= face && face < P4EST_FACES);
+  T8_ASSERT (0 <= neigh_tree_face && neigh_tree_face < P4EST_FACES);
+  T8_ASSERT (orientation == 0 || orientation == 1);
+
+  /* The coordinate along the face. In 2D the map between two faces is
+   * its own inverse, thus we do not need to know which face is smaller. */
+  tangent = face / 2 == 0 ? q->y : q->x;
+  if (orientation) {
+    tangent = P4EST_LAST_OFFSET (q->level) - tangent;
+  }
+  /* The coordinate normal to the face places r at the neighbor tree face */
+  normal = neigh_tree_face % 2 == 0 ? 0 : P4EST_LAST_OFFSET (q->level);
+  if (neigh_tree_face / 2 == 0) {
+    r->x = normal;
+    r->y = tangent;
+  }
+  else {
+    r->x = tangent;
+    r->y = normal;
+  }
+  r->level = q->level;
+  t8_default_quad_copy_surround (q, r);
+  T8_ASSERT (p4est_quadrant_is_inside_root (r));
+  return neigh_tree_face;
+}
+
+static void
+t8_default_quad_vertex_coords (const t8_element_t * elem, int vertex,
+                               int coords[])
+{
+  const p4est_quadrant_t *q = (const p4est_quadrant_t *) elem;
+  p4est_qcoord_t      len;
+
+  T8_ASSERT (0 <= vertex && vertex < P4EST_CHILDREN);
+  len = P4EST_QUADRANT_LEN (q->level);
+  coords[0] = q->x + (vertex & 1 ? len : 0);
+  coords[1] = q->y + (vertex & 2 ? len : 0);
+}
+
+static void
+t8_default_quad_parents (const t8_element_t * elems, size_t count,
+                        t8_element_t * parents)
+{
+  const p4est_quadrant_t *q = (const p4est_quadrant_t *) elems;
+  p4est_quadrant_t   *r = (p4est_quadrant_t *) parents;
+  size_t              i;
+
+  for (i = 0; i < count; ++i) {
+    p4est_quadrant_parent (q + i, r + i);
+    t8_default_quad_copy_surround (q + i, r + i);
+  }
+}
+
+static void
+t8_default_quad_children_array (const t8_element_t * elems, size_t count,
+                               t8_element_t * children)
+{
+  const p4est_quadrant_t *q = (const p4est_quadrant_t *) elems;
+  p4est_quadrant_t   *r = (p4est_quadrant_t *) children;
+  p4est_qcoord_t      shift;
+  size_t              i;
+  int                 ichild;
+
+  for (i = 0; i < count; ++i, ++q) {
+    T8_ASSERT (q->level < P4EST_QMAXLEVEL);
+    shift = P4EST_QUADRANT_LEN (q->level + 1);
+    for (ichild = 0; ichild < P4EST_CHILDREN; ++ichild, ++r) {
+      r->x = ichild & 0x01 ? (q->x | shift) : q->x;
+      r->y = ichild & 0x02 ? (q->y | shift) : q->y;
+      r->level = q->level + 1;
+      t8_default_quad_copy_surround (q, r);
+    }
+  }
+}
+
+static void
+t8_default_quad_get_linear_ids (const t8_element_t * elems, size_t count,
+                               int level, uint64_t * ids)
+{
+  const p4est_quadrant_t *q = (const p4est_quadrant_t *) elems;
+  size_t              i;
+
+  T8_ASSERT (0 <= level && level <= P4EST_QMAXLEVEL);
+
+  for (i = 0; i < count; ++i) {
+    ids[i] = t8_default_quad_morton_id (q + i, level);
+  }
+}
+
+static void
+t8_default_quad_successors (const t8_element_t * elem, size_t count,
+                           t8_element_t * succs, int level)
+{
+  const p4est_quadrant_t *q = (const p4est_quadrant_t *) elem;
+  p4est_quadrant_t   *r = (p4est_quadrant_t *) succs;
+  uint64_t            id;
+  size_t              i;
+
+  T8_ASSERT (0 <= level && level <= P4EST_QMAXLEVEL);
+
+  /* The successors are consecutive in the Morton order */
+  id = t8_default_quad_morton_id (q, level);
+  T8_ASSERT (id + count < ((uint64_t) 1) << P4EST_DIM * level);
+  for (i = 0; i < count; ++i) {
+    t8_default_quad_morton_set (r + i, level, id + 1 + i);
+    t8_default_quad_copy_surround (q, r + i);
+  }
+}
+
+static void
+t8_default_quad_linear_range (t8_element_t * elems, int level,
+                              uint64_t start, uint64_t end)
+{
+  p4est_quadrant_t   *q = (p4est_quadrant_t *) elems;
+  uint64_t            id;
+
+  T8_ASSERT (0 <= level && level <= P4EST_QMAXLEVEL);
+  T8_ASSERT (start <= end && end <= ((uint64_t) 1) << P4EST_DIM * level);
+
+  /* Decoding a Morton index takes constant time */
+  for (id = start; id < end; ++id, ++q) {
+    t8_default_quad_morton_set (q, level, id);
+    T8_QUAD_SET_TDIM (q, 2);
+  }
+}
+
 t8_eclass_scheme_t *
 t8_default_scheme_new_quad (void)
 {
@@ -300,6 +586,19 @@ t8_default_scheme_new_quad (void)
   ts->elem_successor = t8_default_quad_successor;
   ts->elem_anchor = t8_default_quad_anchor;
   ts->elem_root_len = t8_default_quad_root_len;
+  ts->elem_num_faces = t8_default_quad_num_faces;
+  ts->elem_num_face_children = t8_default_quad_num_face_children;
+  ts->elem_children_at_face = t8_default_quad_children_at_face;
+  ts->elem_face_child_face = t8_default_quad_face_child_face;
+  ts->elem_tree_face = t8_default_quad_tree_face;
+  ts->elem_face_neighbor_inside = t8_default_quad_face_neighbor_inside;
+  ts->elem_tree_face_neighbor = t8_default_quad_tree_face_neighbor;
+  ts->elem_vertex_coords = t8_default_quad_vertex_coords;
+  ts->elem_parents = t8_default_quad_parents;
+  ts->elem_children_array = t8_default_quad_children_array;
+  ts->elem_get_linear_ids = t8_default_quad_get_linear_ids;
+  ts->elem_successors = t8_default_quad_successors;
+  ts->elem_linear_range = t8_default_quad_linear_range;
 
   ts->elem_new = t8_default_mempool_alloc;
   ts->elem_destroy = t8_default_mempool_free;
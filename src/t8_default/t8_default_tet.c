@@ -59,17 +59,7 @@ static int
 t8_default_tet_compare (const t8_element_t * elem1,
                         const t8_element_t * elem2)
 {
-  int                 maxlvl;
-  u_int64_t           id1, id2;
-
-  /* Compute the bigger level of the two */
-  maxlvl = SC_MAX (t8_default_tet_level (elem1),
-                   t8_default_tet_level (elem2));
-  /* Compute the linear ids of the elements */
-  id1 = t8_default_tet_get_linear_id (elem1, maxlvl);
-  id2 = t8_default_tet_get_linear_id (elem2, maxlvl);
-  /* return negativ if id1 < id2, zero if id1 = id2, positive if id1 > id2 */
-  return id1 < id2 ? -1 : id1 != id2;
+  return t8_dtet_compare ((const t8_dtet_t *) elem1, (const t8_dtet_t *) elem2);
 }
 
 static void
@@ -190,6 +180,150 @@ t8_default_tet_root_len (const t8_element_t * elem)
   return T8_DTET_ROOT_LEN;
 }
 
+static int
+t8_default_tet_num_faces (const t8_element_t * elem)
+{
+  return T8_DTET_FACES;
+}
+
+static int
+t8_default_tet_num_face_children (const t8_element_t * elem, int face)
+{
+  T8_ASSERT (0 <= face && face < T8_DTET_FACES);
+
+  return T8_DTET_FACE_CHILDREN;
+}
+
+static void
+t8_default_tet_children_at_face (const t8_element_t * elem, int face,
+                                 t8_element_t * children[], int num_children)
+{
+  t8_dtet_children_at_face ((const t8_dtet_t *) elem, face,
+                            (t8_dtet_t **) children, num_children, NULL);
+}
+
+static int
+t8_default_tet_face_child_face (const t8_element_t * elem, int face,
+                                int face_child)
+{
+  return t8_dtet_face_child_face ((const t8_dtet_t *) elem, face,
+                                  face_child);
+}
+
+static int
+t8_default_tet_tree_face (const t8_element_t * elem, int face)
+{
+  return t8_dtet_tree_face ((const t8_dtet_t *) elem, face);
+}
+
+static int
+t8_default_tet_face_neighbor_inside (const t8_element_t * elem,
+                                     t8_element_t * neigh, int face,
+                                     int *neigh_face)
+{
+  t8_dtet_t          *n = (t8_dtet_t *) neigh;
+
+  T8_ASSERT (0 <= face && face < T8_DTET_FACES);
+
+  *neigh_face = t8_dtet_face_neighbour ((const t8_dtet_t *) elem, face, n);
+  return t8_dtet_is_inside_root (n);
+}
+
+static int
+t8_default_tet_tree_face_neighbor (const t8_element_t * elem,
+                                   t8_element_t * neigh, int face,
+                                   int neigh_tree_face, int orientation,
+                                   int is_smaller_face)
+{
+  return t8_dtet_tree_face_neighbour ((const t8_dtet_t *) elem,
+                                      (t8_dtet_t *) neigh, face,
+                                      neigh_tree_face, orientation,
+                                      is_smaller_face);
+}
+
+static void
+t8_default_tet_vertex_coords (const t8_element_t * elem, int vertex,
+                              int coords[])
+{
+  t8_dtet_coord_t     tet_coords[3];
+
+  t8_dtet_compute_coords ((const t8_dtet_t *) elem, vertex, tet_coords);
+  coords[0] = tet_coords[0];
+  coords[1] = tet_coords[1];
+  coords[2] = tet_coords[2];
+}
+
+static void
+t8_default_tet_parents (const t8_element_t * elems, size_t count,
+                        t8_element_t * parents)
+{
+  const t8_default_tet_t *t = (const t8_default_tet_t *) elems;
+  t8_default_tet_t   *p = (t8_default_tet_t *) parents;
+  size_t              i;
+
+  for (i = 0; i < count; ++i) {
+    t8_dtet_parent (t + i, p + i);
+  }
+}
+
+static void
+t8_default_tet_children_array (const t8_element_t * elems, size_t count,
+                               t8_element_t * children)
+{
+  const t8_default_tet_t *t = (const t8_default_tet_t *) elems;
+  t8_default_tet_t   *c[T8_DTET_CHILDREN];
+  size_t              i;
+  int                 ichild;
+
+  for (i = 0; i < count; ++i) {
+    for (ichild = 0; ichild < T8_DTET_CHILDREN; ++ichild) {
+      c[ichild] = (t8_default_tet_t *) children + i * T8_DTET_CHILDREN + ichild;
+    }
+    t8_dtet_childrenpv (t + i, c);
+  }
+}
+
+static void
+t8_default_tet_get_linear_ids (const t8_element_t * elems, size_t count,
+                               int level, uint64_t * ids)
+{
+  const t8_default_tet_t *t = (const t8_default_tet_t *) elems;
+  size_t              i;
+
+  T8_ASSERT (0 <= level && level <= T8_DTET_MAXLEVEL);
+
+  for (i = 0; i < count; ++i) {
+    ids[i] = t8_dtet_linear_id (t + i, level);
+  }
+}
+
+static void
+t8_default_tet_successors (const t8_element_t * elem, size_t count,
+                           t8_element_t * succs, int level)
+{
+  const t8_default_tet_t *t = (const t8_default_tet_t *) elem;
+
+  T8_ASSERT (0 <= level && level <= T8_DTET_MAXLEVEL);
+
+  /* The successors are consecutive in the SFC order */
+  if (count > 0) {
+    t8_dtet_init_linear_id_range ((t8_default_tet_t *) succs,
+                                  t8_dtet_linear_id (t, level) + 1, level,
+                                  count);
+  }
+}
+
+static void
+t8_default_tet_linear_range (t8_element_t * elems, int level,
+                             uint64_t start, uint64_t end)
+{
+  T8_ASSERT (0 <= level && level <= T8_DTET_MAXLEVEL);
+  T8_ASSERT (start <= end);
+
+  t8_dtet_init_linear_id_range ((t8_default_tet_t *) elems, start, level,
+                                end - start);
+}
+
 t8_eclass_scheme_t *
 t8_default_scheme_new_tet (void)
 {
@@ -218,6 +352,19 @@ t8_default_scheme_new_tet (void)
   ts->elem_last_desc = t8_default_tet_last_descendant;
   ts->elem_anchor = t8_default_tet_anchor;
   ts->elem_root_len = t8_default_tet_root_len;
+  ts->elem_num_faces = t8_default_tet_num_faces;
+  ts->elem_num_face_children = t8_default_tet_num_face_children;
+  ts->elem_children_at_face = t8_default_tet_children_at_face;
+  ts->elem_face_child_face = t8_default_tet_face_child_face;
+  ts->elem_tree_face = t8_default_tet_tree_face;
+  ts->elem_face_neighbor_inside = t8_default_tet_face_neighbor_inside;
+  ts->elem_tree_face_neighbor = t8_default_tet_tree_face_neighbor;
+  ts->elem_vertex_coords = t8_default_tet_vertex_coords;
+  ts->elem_parents = t8_default_tet_parents;
+  ts->elem_children_array = t8_default_tet_children_array;
+  ts->elem_get_linear_ids = t8_default_tet_get_linear_ids;
+  ts->elem_successors = t8_default_tet_successors;
+  ts->elem_linear_range = t8_default_tet_linear_range;
 
   ts->elem_new = t8_default_mempool_alloc;
   ts->elem_destroy = t8_default_mempool_free;
@@ -37,6 +37,9 @@ T8_EXTERN_C_BEGIN ();
 /** The number of faces of a triangle. */
 #define T8_DTRI_FACES 3
 
+/** The number of children of a triangle at each face. */
+#define T8_DTRI_FACE_CHILDREN 2
+
 /** The maximum refinement level allowed for a triangle. */
 #define T8_DTRI_MAXLEVEL 30
 
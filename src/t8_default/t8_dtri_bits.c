@@ -57,21 +57,58 @@ compute_cubeid (const t8_dtri_t * t, int level)
   return id;
 }
 
+/* A triangle (tetrahedron) of type b contains exactly those points whose
+ * coordinates relative to its anchor node have the ordering of type b.
+ * Since a triangle lies inside all of its ancestors, the type of an ancestor
+ * is given by comparing the coordinates of the triangle relative to the
+ * anchor node of that ancestor. If two of these coordinates are equal,
+ * the comparison is the same as in the type of the triangle itself.
+ * We encode the outcome of the comparisons x > y, x > z and y > z as the
+ * bits 0, 1 and 2 of an integer.
+ */
+#ifndef T8_DTRI_TO_DTET
+static const int    t8_dtri_type_to_greater[2] = { 1, 0 };
+static const t8_dtri_type_t t8_dtri_greater_to_type[2] = { 1, 0 };
+#else
+static const int    t8_dtri_type_to_greater[6] = { 3, 7, 6, 4, 0, 1 };
+/* The entries 2 and 5 are inconsistent orderings and never occur */
+static const t8_dtri_type_t t8_dtri_greater_to_type[8] =
+  { 4, 5, -1, 0, 3, -1, 2, 1 };
+#endif
+
+#ifdef T8_DTRI_TO_DTET
+/* The local index of a tetrahedron in its parent, given the comparisons of
+ * its coordinates as above in the upper bits and its cube-id in the lower
+ * bits. This combines t8_dtri_greater_to_type and t8_dtri_type_cid_to_Iloc.
+ */
+static const uint8_t t8_dtri_greater_cid_to_Iloc[64] = {
+  0, 2, 2, 6, 3, 5, 5, 7,
+  0, 3, 3, 6, 3, 6, 6, 7,
+  0, 0, 0, 0, 0, 0, 0, 0,
+  0, 1, 1, 4, 1, 4, 4, 7,
+  0, 3, 1, 5, 2, 4, 6, 7,
+  0, 0, 0, 0, 0, 0, 0, 0,
+  0, 2, 3, 4, 1, 6, 5, 7,
+  0, 1, 2, 5, 2, 5, 4, 7
+};
+#endif
+
 /* A routine to compute the type of t's ancestor of level "level".
  * If "level" equals t's level then t's type is returned.
  * It is not allowed to call this function with "level" greater than t->level.
- * This method runs in O(t->level - level).
+ * This method runs in constant time.
  */
 static              t8_dtri_type_t
 compute_type (const t8_dtri_t * t, int level)
 {
-  int8_t              type = t->type;
-  t8_dtri_cube_id_t   cid;
-  int                 tlevel = t->level;
-  int                 i;
+  t8_dtri_coord_t     mask, delta_x, delta_y;
+#ifdef T8_DTRI_TO_DTET
+  t8_dtri_coord_t     delta_z;
+#endif
+  int                 greater;
 
-  T8_ASSERT (0 <= level && level <= tlevel);
-  if (level == tlevel) {
+  T8_ASSERT (0 <= level && level <= t->level);
+  if (level == t->level) {
     return t->type;
   }
   if (level == 0) {
@@ -79,12 +116,70 @@ compute_type (const t8_dtri_t * t, int level)
      *       maybe once we want to allow the root tet to have different types */
     return 0;
   }
-  for (i = tlevel; i < level; i++) {
-    cid = compute_cubeid (t, i);
-    /* compute type as the type of T^{i+1}, that is T's ancestor of level i+1 */
-    type = t8_dtri_cid_type_to_parenttype[cid][type];
+  /* The coordinates of t relative to the anchor node of the ancestor */
+  mask = T8_DTRI_LEN (level) - 1;
+  delta_x = t->x & mask;
+  delta_y = t->y & mask;
+  greater = t8_dtri_type_to_greater[t->type];
+  if (delta_x != delta_y) {
+    greater = (greater & ~0x01) | (delta_x > delta_y);
+  }
+#ifdef T8_DTRI_TO_DTET
+  delta_z = t->z & mask;
+  if (delta_x != delta_z) {
+    greater = (greater & ~0x02) | (delta_x > delta_z) << 1;
+  }
+  if (delta_y != delta_z) {
+    greater = (greater & ~0x04) | (delta_y > delta_z) << 2;
+  }
+#endif
+  T8_ASSERT (t8_dtri_greater_to_type[greater] >= 0);
+  return t8_dtri_greater_to_type[greater];
+}
+
+/* Compare a and b relative to all levels at once.
+ * Bit p of the result is set if the lowest p bits of a form a bigger number
+ * than the lowest p bits of b. If they are equal, bit p is set to def.
+ * This is a segmented prefix scan over the bits of a ^ b and takes a constant
+ * number of word operations. */
+static              uint32_t
+compute_greater_mask (uint32_t a, uint32_t b, int def)
+{
+  uint32_t            known, greater;
+  int                 shift;
+
+  /* Bit p of known is set if a and b differ in one of the bits below p,
+   * then bit p of greater is the bit of a at the highest such position. */
+  known = (a ^ b) << 1;
+  greater = (a & ~b) << 1;
+  for (shift = 1; shift < 32; shift <<= 1) {
+    greater |= (greater << shift) & ~known;
+    known |= known << shift;
   }
-  return type;
+  return def ? greater | ~known : greater;
+}
+
+/* Spread the bits of v such that bit p is moved to bit T8_DTRI_DIM * p */
+static              uint64_t
+spread_bits (uint32_t v)
+{
+  uint64_t            x = v;
+
+#ifndef T8_DTRI_TO_DTET
+  x = (x | (x << 16)) & 0x0000FFFF0000FFFFULL;
+  x = (x | (x << 8)) & 0x00FF00FF00FF00FFULL;
+  x = (x | (x << 4)) & 0x0F0F0F0F0F0F0F0FULL;
+  x = (x | (x << 2)) & 0x3333333333333333ULL;
+  x = (x | (x << 1)) & 0x5555555555555555ULL;
+#else
+  x &= 0x1FFFFF;
+  x = (x | (x << 32)) & 0x001F00000000FFFFULL;
+  x = (x | (x << 16)) & 0x001F0000FF0000FFULL;
+  x = (x | (x << 8)) & 0x100F00F00F00F00FULL;
+  x = (x | (x << 4)) & 0x10C30C30C30C30C3ULL;
+  x = (x | (x << 2)) & 0x1249249249249249ULL;
+#endif
+  return x;
 }
 
 void
@@ -121,129 +216,19 @@ t8_dtri_parent (const t8_dtri_t * t, t8_dtri_t * parent)
 void
 t8_dtri_ancestor (const t8_dtri_t * t, int level, t8_dtri_t * ancestor)
 {
-  /* TODO: find out, at which level difference it is faster to use    *
-   * the arithmetic computation of ancestor type
-   * opposed to iteratively computing the parent type.
-   */
-  t8_dtri_coord_t     delta_x, delta_y, diff_xy;
-#ifdef T8_DTRI_TO_DTET
-  t8_dtri_coord_t     delta_z, diff_xz, diff_yz;
-  t8_dtet_type_t      possible_types[6] = { 1, 1, 1, 1, 1, 1 };
-  int                 i;
-#ifdef T8_ENABLE_DEBUG
-  int                 set_type = 0;
-#endif
-#endif /* T8_DTRI_TO_DTET */
-
-  /* delta_{x,y} = t->{x,y} - ancestor->{x,y}
-   * the difference of the coordinates.
-   * Needed to compute the type of the ancestor. */
-  delta_x = t->x & (T8_DTRI_LEN (level) - 1);
-  delta_y = t->y & (T8_DTRI_LEN (level) - 1);
-#ifdef T8_DTRI_TO_DTET
-  delta_z = t->z & (T8_DTRI_LEN (level) - 1);
-#endif
+  /* The type of the ancestor follows from the coordinates of t relative
+   * to the ancestor. It is necessary to compute it first, since ancestor
+   * and t could point to the same triangle. */
+  ancestor->type = compute_type (t, level);
 
-  /* The coordinates of the ancestor. It is necessary
-   * to compute the delta first, since ancestor and t
-   * could point to the same triangle. */
+  /* The coordinates of the ancestor. */
   ancestor->x = t->x & ~(T8_DTRI_LEN (level) - 1);
   ancestor->y = t->y & ~(T8_DTRI_LEN (level) - 1);
 #ifdef T8_DTRI_TO_DTET
   ancestor->z = t->z & ~(T8_DTRI_LEN (level) - 1);
-#endif
-
-#ifndef T8_DTRI_TO_DTET
-  /* The type of the ancestor depends on delta_x - delta_y */
-  diff_xy = delta_x - delta_y;
-  if (diff_xy > 0) {
-    ancestor->type = 0;
-  }
-  else if (diff_xy < 0) {
-    ancestor->type = 1;
-  }
-  else {
-    T8_ASSERT (diff_xy == 0);
-    ancestor->type = t->type;
-  }
-
-  ancestor->n = t->n;
 #else
-/* The sign of each diff reduces the number of possible types
- * for the ancestor. At the end only one possible type is left,
- * this type's entry in the possible_types array will be positive.
- */
-
-  diff_xy = delta_x - delta_y;
-  diff_xz = delta_x - delta_z;
-  diff_yz = delta_y - delta_z;
-
-/* delta_x - delta_y */
-  if (diff_xy > 0) {
-    possible_types[2] = possible_types[3] = possible_types[4] = 0;
-  }
-  else if (diff_xy < 0) {
-    possible_types[0] = possible_types[1] = possible_types[5] = 0;
-  }
-  else {
-    T8_ASSERT (diff_xy == 0);
-    if (t->type == 0 || t->type == 1 || t->type == 5) {
-      possible_types[2] = possible_types[3] = possible_types[4] = 0;
-    }
-    else {
-      possible_types[0] = possible_types[1] = possible_types[5] = 0;
-    }
-  }
-
-/* delta_x - delta_z */
-  if (diff_xz > 0) {
-    possible_types[3] = possible_types[4] = possible_types[5] = 0;
-  }
-  else if (diff_xz < 0) {
-    possible_types[0] = possible_types[1] = possible_types[2] = 0;
-  }
-  else {
-    T8_ASSERT (diff_xz == 0);
-    if (t->type == 0 || t->type == 1 || t->type == 2) {
-      possible_types[3] = possible_types[4] = possible_types[5] = 0;
-    }
-    else {
-      possible_types[0] = possible_types[1] = possible_types[2] = 0;
-    }
-  }
-
-/* delta_y - delta_z */
-  if (diff_yz > 0) {
-    possible_types[0] = possible_types[4] = possible_types[5] = 0;
-  }
-  else if (diff_yz < 0) {
-    possible_types[1] = possible_types[2] = possible_types[3] = 0;
-  }
-  else {
-    T8_ASSERT (diff_yz == 0);
-    if (t->type == 1 || t->type == 2 || t->type == 3) {
-      possible_types[0] = possible_types[4] = possible_types[5] = 0;
-    }
-    else {
-      possible_types[1] = possible_types[2] = possible_types[3] = 0;
-    }
-  }
-
-  /* Got through possible_types array and find the only entry
-   * that is nonzero
-   */
-  for (i = 0; i < 6; i++) {
-    T8_ASSERT (possible_types[i] == 0 || possible_types[i] == 1);
-    if (possible_types[i] == 1) {
-      ancestor->type = i;
-#ifdef T8_ENABLE_DEBUG
-      T8_ASSERT (set_type != 1);
-      set_type = 1;
+  ancestor->n = t->n;
 #endif
-    }
-  }
-  T8_ASSERT (set_type == 1);
-#endif /* T8_DTRI_TO_DTET */
   ancestor->level = level;
 }
 
@@ -545,6 +530,294 @@ t8_dtri_face_neighbour (const t8_dtri_t * t, int face, t8_dtri_t * n)
   return ret;
 }
 
+/* Return nonzero if a point lies on the face of a triangle given by the
+ * coordinates of its vertices.  All coordinates must be multiples of len,
+ * relative to each other, which keeps the determinant small. */
+static int
+t8_dtri_face_contains_point (t8_dtri_coord_t
+                             vertices[T8_DTRI_FACES][T8_DTRI_DIM], int face,
+                             const t8_dtri_coord_t point[T8_DTRI_DIM],
+                             t8_dtri_coord_t len)
+{
+  int64_t             d[T8_DTRI_FACES - 1][T8_DTRI_DIM];
+  int                 ivertex, idim, k;
+
+  /* The vectors from the point to the face vertices */
+  for (ivertex = 0, k = 0; ivertex < T8_DTRI_FACES; ivertex++) {
+    if (ivertex != face) {
+      for (idim = 0; idim < T8_DTRI_DIM; idim++) {
+        d[k][idim] = (vertices[ivertex][idim] - point[idim]) / len;
+      }
+      k++;
+    }
+  }
+  /* The point lies on the face if these vectors are linearly dependent */
+#ifndef T8_DTRI_TO_DTET
+  return d[0][0] * d[1][1] - d[0][1] * d[1][0] == 0;
+#else
+  return d[0][0] * (d[1][1] * d[2][2] - d[1][2] * d[2][1])
+    - d[0][1] * (d[1][0] * d[2][2] - d[1][2] * d[2][0])
+    + d[0][2] * (d[1][0] * d[2][1] - d[1][1] * d[2][0]) == 0;
+#endif
+}
+
+void
+t8_dtri_children_at_face (const t8_dtri_t * t, int face,
+                          t8_dtri_t * children[], int num_children,
+                          int *child_faces)
+{
+  t8_dtri_t           parent, child;
+  t8_dtri_coord_t     t_coords[T8_DTRI_FACES][T8_DTRI_DIM];
+  t8_dtri_coord_t     c_coords[T8_DTRI_FACES][T8_DTRI_DIM];
+  t8_dtri_coord_t     len;
+  int                 ichild, ivertex, num_on_face, other_vertex;
+  int                 num_found;
+
+  T8_ASSERT (0 <= face && face < T8_DTRI_FACES);
+  T8_ASSERT (num_children == T8_DTRI_FACE_CHILDREN);
+  T8_ASSERT (t->level < T8_DTRI_MAXLEVEL);
+
+  /* t may be one of the children */
+  t8_dtri_copy (t, &parent);
+  t8_dtri_copy (t, &child);
+  t8_dtri_compute_all_coords (&parent, t_coords);
+  len = T8_DTRI_LEN (parent.level + 1);
+  num_found = 0;
+  for (ichild = 0; ichild < T8_DTRI_CHILDREN; ichild++) {
+    t8_dtri_child (&parent, ichild, &child);
+    t8_dtri_compute_all_coords (&child, c_coords);
+    /* A child touches the face if all but one of its vertices lie on it.
+     * The remaining vertex is opposite to the child's face on the face. */
+    num_on_face = 0;
+    other_vertex = -1;
+    for (ivertex = 0; ivertex < T8_DTRI_FACES; ivertex++) {
+      if (t8_dtri_face_contains_point (t_coords, face, c_coords[ivertex],
+                                       len)) {
+        num_on_face++;
+      }
+      else {
+        other_vertex = ivertex;
+      }
+    }
+    if (num_on_face == T8_DTRI_FACES - 1) {
+      T8_ASSERT (num_found < num_children);
+      t8_dtri_copy (&child, children[num_found]);
+      if (child_faces != NULL) {
+        child_faces[num_found] = other_vertex;
+      }
+      num_found++;
+    }
+  }
+  T8_ASSERT (num_found == num_children);
+}
+
+int
+t8_dtri_face_child_face (const t8_dtri_t * t, int face, int face_child)
+{
+#ifdef T8_DTRI_TO_DTET
+  t8_dtri_t           children[T8_DTRI_FACE_CHILDREN];
+  t8_dtri_t          *child_ptrs[T8_DTRI_FACE_CHILDREN];
+  int                 child_faces[T8_DTRI_FACE_CHILDREN];
+  int                 i;
+#endif
+
+  T8_ASSERT (0 <= face && face < T8_DTRI_FACES);
+  T8_ASSERT (0 <= face_child && face_child < T8_DTRI_FACE_CHILDREN);
+#ifndef T8_DTRI_TO_DTET
+  /* The children of a triangle at a face keep its face number */
+  return face;
+#else
+  for (i = 0; i < T8_DTRI_FACE_CHILDREN; i++) {
+    child_ptrs[i] = &children[i];
+  }
+  t8_dtri_children_at_face (t, face, child_ptrs, T8_DTRI_FACE_CHILDREN,
+                            child_faces);
+  return child_faces[face_child];
+#endif
+}
+
+int
+t8_dtri_tree_face (const t8_dtri_t * t, int face)
+{
+  T8_ASSERT (0 <= face && face < T8_DTRI_FACES);
+
+#ifndef T8_DTRI_TO_DTET
+  /* Only triangles of type 0 touch the root boundary and each of their
+   * faces lies on the root face of the same number. */
+  T8_ASSERT (t->type == 0);
+  return face;
+#else
+  /* Faces of type 0 lie on the root face of the same number.
+   * Otherwise only face 0 of type 1, face 2 of type 2, face 1 of type 4
+   * and face 3 of type 5 can lie on the root boundary. */
+  switch (t->type) {
+  case 0:
+    return face;
+  case 1:
+    T8_ASSERT (face == 0);
+    return 0;
+  case 2:
+    T8_ASSERT (face == 2);
+    return 1;
+  case 4:
+    T8_ASSERT (face == 1);
+    return 2;
+  case 5:
+    T8_ASSERT (face == 3);
+    return 3;
+  default:
+    SC_ABORT_NOT_REACHED ();
+  }
+  return -1;
+#endif
+}
+
+int
+t8_dtri_tree_face_neighbour (const t8_dtri_t * t, t8_dtri_t * n, int face,
+                             int neigh_tree_face, int orientation,
+                             int is_smaller_face)
+{
+  const t8_dtri_coord_t h = T8_DTRI_LEN (t->level);
+  const int           tree_face = t8_dtri_tree_face (t, face);
+#ifndef T8_DTRI_TO_DTET
+  t8_dtri_coord_t     s;
+
+  T8_ASSERT (0 <= neigh_tree_face && neigh_tree_face < T8_DTRI_FACES);
+  T8_ASSERT (orientation == 0 || orientation == 1);
+
+  /* The coordinate along the face measured from its first corner.
+   * In 2D the map between two faces is its own inverse. */
+  s = tree_face == 0 ? t->y : t->x;
+  if (orientation) {
+    s = T8_DTRI_ROOT_LEN - h - s;
+  }
+  /* The triangles at the root boundary are of type 0 */
+  switch (neigh_tree_face) {
+  case 0:
+    n->x = T8_DTRI_ROOT_LEN - h;
+    n->y = s;
+    break;
+  case 1:
+    n->x = s;
+    n->y = s;
+    break;
+  default:
+    n->x = s;
+    n->y = 0;
+  }
+  n->type = 0;
+  n->level = t->level;
+  return neigh_tree_face;
+#else
+  t8_dtri_coord_t     u, v, points[3][2], bary[3], uv[2];
+  int                 type, corner_map[3], k, i, num_bottom;
+  int                 neigh_face;
+
+  T8_ASSERT (0 <= neigh_tree_face && neigh_tree_face < T8_DTRI_FACES);
+  T8_ASSERT (0 <= orientation && orientation < 3);
+
+  /* The tetrahedron's face is a triangle of anchor (u, v) and type 0 or 1
+   * in the root triangle spanned by the corners of the tree face */
+  switch (tree_face) {
+  case 0:
+    u = t->z;
+    v = t->y;
+    break;
+  case 1:
+  case 2:
+    u = t->x;
+    v = t->y;
+    break;
+  default:
+    u = t->x;
+    v = t->z;
+  }
+  type = t->type == 0 ? 0 : 1;
+  points[0][0] = u;
+  points[0][1] = v;
+  points[1][0] = type == 0 ? u + h : u;
+  points[1][1] = type == 0 ? v : v + h;
+  points[2][0] = u + h;
+  points[2][1] = v + h;
+
+  /* The corners of the master face map to the corners of the other face
+   * by a rotation if the face numbers differ in parity and by a
+   * reflection otherwise.  Corner 0 of the master face maps to
+   * corner orientation.  For the other face we use the inverse. */
+  for (k = 0; k < 3; k++) {
+    if ((tree_face + neigh_tree_face) % 2 == 0) {
+      corner_map[k] = (orientation - k + 3) % 3;
+    }
+    else if (is_smaller_face) {
+      corner_map[k] = (k + orientation) % 3;
+    }
+    else {
+      corner_map[k] = (k - orientation + 3) % 3;
+    }
+  }
+  /* Map the points via their barycentric coordinates with respect to the
+   * corners (0,0), (R,0), (R,R), scaled by R */
+  for (i = 0; i < 3; i++) {
+    bary[0] = T8_DTRI_ROOT_LEN - points[i][0];
+    bary[1] = points[i][0] - points[i][1];
+    bary[2] = points[i][1];
+    uv[0] = uv[1] = 0;
+    for (k = 0; k < 3; k++) {
+      if (corner_map[k] != 0) {
+        uv[0] += bary[k];
+      }
+      if (corner_map[k] == 2) {
+        uv[1] += bary[k];
+      }
+    }
+    points[i][0] = uv[0];
+    points[i][1] = uv[1];
+  }
+  /* Compute anchor and type of the mapped triangle */
+  u = SC_MIN (SC_MIN (points[0][0], points[1][0]), points[2][0]);
+  v = SC_MIN (SC_MIN (points[0][1], points[1][1]), points[2][1]);
+  num_bottom = 0;
+  for (i = 0; i < 3; i++) {
+    num_bottom += points[i][1] == v;
+  }
+  type = num_bottom == 2 ? 0 : 1;
+
+  /* Extrude the triangle to the tetrahedron at the neighbor tree face */
+  switch (neigh_tree_face) {
+  case 0:
+    n->x = T8_DTRI_ROOT_LEN - h;
+    n->y = v;
+    n->z = u;
+    n->type = type;
+    neigh_face = 0;
+    break;
+  case 1:
+    n->x = u;
+    n->y = v;
+    n->z = u;
+    n->type = type == 0 ? 0 : 2;
+    neigh_face = type == 0 ? 1 : 2;
+    break;
+  case 2:
+    n->x = u;
+    n->y = v;
+    n->z = v;
+    n->type = type == 0 ? 0 : 4;
+    neigh_face = type == 0 ? 2 : 1;
+    break;
+  default:
+    n->x = u;
+    n->y = 0;
+    n->z = v;
+    n->type = type == 0 ? 0 : 5;
+    neigh_face = 3;
+  }
+  n->level = t->level;
+  T8_ASSERT (t8_dtri_tree_face (n, neigh_face) == neigh_tree_face);
+  return neigh_face;
+#endif
+}
+
 void
 t8_dtri_nearest_common_ancestor (const t8_dtri_t * t1,
                                  const t8_dtri_t * t2, t8_dtri_t * r)
@@ -597,8 +870,8 @@ t8_dtri_is_inside_root (t8_dtri_t * t)
 #else
     (t->z - t->x <= 0) &&
     (t->y - t->z <= 0) &&
-    (t->z == t->x ? (3 <= t->type && 5 <= t->type) : 1) &&
-    (t->y == t->x ? (1 <= t->type && 3 <= t->type) : 1) &&
+    (t->z == t->x ? t->type <= 2 : 1) &&
+    (t->y == t->z ? (t->type == 0 || 4 <= t->type) : 1) &&
 #endif
     1;
   return is_inside;
@@ -767,7 +1040,7 @@ t8_dtri_linear_id_last_desc (const t8_dtri_t * t)
    * of t */
   id = (((uint64_t) 1) << T8_DTRI_DIM * exponent) - 1;
   /* Set the first bits of id to the id of t itself */
-  id |= t_id << exponent;
+  id |= t_id << (T8_DTRI_DIM * exponent);
   return id;
 }
 
@@ -775,11 +1048,15 @@ uint64_t
 t8_dtri_linear_id (const t8_dtri_t * t, int level)
 {
   uint64_t            id = 0;
-  int8_t              type_temp = 0;
-  t8_dtri_cube_id_t   cid;
-  int                 i;
+  int                 type_def;
   int                 exponent;
   int                 my_level;
+#ifndef T8_DTRI_TO_DTET
+  uint32_t            greater, both, one;
+#else
+  uint64_t            cids, greater;
+  int                 i;
+#endif
 
   T8_ASSERT (0 <= level && level <= T8_DTRI_MAXLEVEL);
   my_level = t->level;
@@ -790,15 +1067,107 @@ t8_dtri_linear_id (const t8_dtri_t * t, int level)
   if (level > my_level) {
     exponent = (level - my_level) * T8_DTRI_DIM;
   }
-  level = my_level;
-  type_temp = compute_type (t, level);
-  for (i = level; i > 0; i--) {
-    cid = compute_cubeid (t, i);
-    id |= ((uint64_t) t8_dtri_type_cid_to_Iloc[type_temp][cid]) << exponent;
-    exponent += T8_DTRI_DIM;    /* multiply with 4 (2d) resp. 8  (3d) */
-    type_temp = t8_dtri_cid_type_to_parenttype[cid][type_temp];
+  /* We compute the types of all ancestors at once from the coordinate
+   * comparisons, such that there is no dependency between the levels. */
+  type_def = t8_dtri_type_to_greater[t->type];
+#ifndef T8_DTRI_TO_DTET
+  /* The local index is 0 for cube-id 0 and 3 for cube-id 3. For the
+   * cube-ids 1 and 2 it is 1 if the type is 0 and 2 if the type is 1.
+   * Thus we compute the two bits of the local index on all levels at once
+   * and interleave them. */
+  greater = compute_greater_mask ((uint32_t) t->x, (uint32_t) t->y,
+                                  type_def & 0x01);
+  both = (uint32_t) (t->x & t->y);
+  one = (uint32_t) (t->x ^ t->y);
+  id = spread_bits (both | (one & greater))
+    | spread_bits (both | (one & ~greater)) << 1;
+  id >>= T8_DTRI_DIM * (T8_DTRI_MAXLEVEL - my_level);
+#else
+  /* Interleave the coordinates, such that the lowest digit of cids is the
+   * cube-id of t and the next digits are the cube-ids of its ancestors.
+   * In the same way collect the coordinate comparisons. */
+  cids = spread_bits ((uint32_t) t->x) | spread_bits ((uint32_t) t->y) << 1
+    | spread_bits ((uint32_t) t->z) << 2;
+  greater = spread_bits (compute_greater_mask ((uint32_t) t->x,
+                                               (uint32_t) t->y,
+                                               type_def & 0x01))
+    | spread_bits (compute_greater_mask ((uint32_t) t->x, (uint32_t) t->z,
+                                         type_def & 0x02)) << 1
+    | spread_bits (compute_greater_mask ((uint32_t) t->y, (uint32_t) t->z,
+                                         type_def & 0x04)) << 2;
+  cids >>= T8_DTRI_DIM * (T8_DTRI_MAXLEVEL - my_level);
+  greater >>= T8_DTRI_DIM * (T8_DTRI_MAXLEVEL - my_level);
+  for (i = 0; i < my_level; i++) {
+    id |= ((uint64_t) t8_dtri_greater_cid_to_Iloc
+           [(greater & 0x07) << 3 | (cids & 0x07)]) << T8_DTRI_DIM * i;
+    greater >>= T8_DTRI_DIM;
+    cids >>= T8_DTRI_DIM;
   }
-  return id;
+#endif
+  return id << exponent;
+}
+
+int
+t8_dtri_compare (const t8_dtri_t * t1, const t8_dtri_t * t2)
+{
+  const t8_dtri_t    *longer;
+  t8_dtri_coord_t     exclor;
+  int                 min_level, cube_level, level_equal, level_differ;
+  int                 level, id1, id2;
+
+  min_level = SC_MIN (t1->level, t2->level);
+  /* The ancestors of t1 and t2 lie in the same cube up to the level
+   * before cube_level */
+  exclor = (t1->x ^ t2->x) | (t1->y ^ t2->y)
+#ifdef T8_DTRI_TO_DTET
+    | (t1->z ^ t2->z)
+#endif
+    ;
+  cube_level = exclor == 0 ? T8_DTRI_MAXLEVEL + 1
+    : T8_DTRI_MAXLEVEL - SC_LOG2_32 (exclor);
+  /* If two ancestors of the same level have the same cube and type, they
+   * are equal and so are all their ancestors. Thus we can search the first
+   * level on which the types of the ancestors differ by bisection. */
+  level_equal = 0;
+  level_differ = SC_MIN (cube_level - 1, min_level);
+  if (compute_type (t1, level_differ) != compute_type (t2, level_differ)) {
+    while (level_differ - level_equal > 1) {
+      level = (level_equal + level_differ) / 2;
+      if (compute_type (t1, level) == compute_type (t2, level)) {
+        level_equal = level;
+      }
+      else {
+        level_differ = level;
+      }
+    }
+  }
+  else if (cube_level <= min_level) {
+    /* The ancestors are equal up to the level before cube_level */
+    level_differ = cube_level;
+  }
+  else {
+    /* One triangle is an ancestor of the other one. Both have the same
+     * linear id if the other one is a first descendant, that is, if all of
+     * its cube-ids below the ancestor are 0. */
+    if (t1->level == t2->level) {
+      return 0;
+    }
+    longer = t1->level > t2->level ? t1 : t2;
+    if (((longer->x | longer->y
+#ifdef T8_DTRI_TO_DTET
+          | longer->z
+#endif
+         ) & (T8_DTRI_LEN (min_level) - 1)) == 0) {
+      return 0;
+    }
+    return longer == t1 ? 1 : -1;
+  }
+  /* The ancestors of level level_differ are different children of the
+   * same parent, their local indices decide the order */
+  id1 = t8_dtri_ancestor_id (t1, level_differ);
+  id2 = t8_dtri_ancestor_id (t2, level_differ);
+  T8_ASSERT (id1 != id2);
+  return id1 < id2 ? -1 : 1;
 }
 
 void
@@ -839,6 +1208,71 @@ t8_dtri_init_linear_id (t8_dtri_t * t, uint64_t id, int level)
   t->type = type;
 }
 
+void
+t8_dtri_init_linear_id_range (t8_dtri_t * t, uint64_t id, int level,
+                              size_t count)
+{
+  int                 i;
+  size_t              j;
+  const int           children_m1 = T8_DTRI_CHILDREN - 1;
+  int                 local_index[T8_DTRI_MAXLEVEL + 1];
+  t8_dtri_type_t      type[T8_DTRI_MAXLEVEL + 1];
+  t8_dtri_cube_id_t   cid;
+  t8_dtri_coord_t     x, y, bit;
+#ifdef T8_DTRI_TO_DTET
+  t8_dtri_coord_t     z;
+#endif
+
+  T8_ASSERT (0 <= level && level <= T8_DTRI_MAXLEVEL);
+  T8_ASSERT (id + count <= ((uint64_t) 1) << (T8_DTRI_DIM * level));
+
+  if (count == 0) {
+    return;
+  }
+  t8_dtri_init_linear_id (t, id, level);
+  /* Store the local indices and types of all ancestors of the first
+   * triangle.  Type[0] is the type of the root triangle. */
+  type[0] = 0;
+  for (i = 1; i <= level; i++) {
+    local_index[i] = (id >> (T8_DTRI_DIM * (level - i))) & children_m1;
+    type[i] = t8_dtri_parenttype_Iloc_to_type[type[i - 1]][local_index[i]];
+  }
+  x = t->x;
+  y = t->y;
+#ifdef T8_DTRI_TO_DTET
+  z = t->z;
+#endif
+  for (j = 1; j < count; j++) {
+    /* Increment the local index on the finest level, carrying over into
+     * the coarser levels as long as the last child is passed */
+    for (i = level; local_index[i] == children_m1; i--) {
+      T8_ASSERT (i > 1);
+      local_index[i] = 0;
+    }
+    local_index[i]++;
+    /* Only the levels from i downwards change their types and cube-ids */
+    for (; i <= level; i++) {
+      cid = t8_dtri_parenttype_Iloc_to_cid[type[i - 1]][local_index[i]];
+      type[i] = t8_dtri_parenttype_Iloc_to_type[type[i - 1]][local_index[i]];
+      bit = 1 << (T8_DTRI_MAXLEVEL - i);
+      x = cid & 1 ? x | bit : x & ~bit;
+      y = cid & 2 ? y | bit : y & ~bit;
+#ifdef T8_DTRI_TO_DTET
+      z = cid & 4 ? z | bit : z & ~bit;
+#endif
+    }
+    t[j].level = level;
+    t[j].type = type[level];
+    t[j].x = x;
+    t[j].y = y;
+#ifdef T8_DTRI_TO_DTET
+    t[j].z = z;
+#else
+    t[j].n = t->n;
+#endif
+  }
+}
+
 void
 t8_dtri_init_root (t8_dtri_t * t)
 {
@@ -864,7 +1298,7 @@ t8_dtri_succ_pred_recursion (const t8_dtri_t * t, t8_dtri_t * s, int level,
   t8_dtri_type_t      type_level, type_level_p1;
   t8_dtri_cube_id_t   cid;
   int                 local_index;
-  int                 sign;
+  int                 sign, wraps;
 
   /* We exclude the case level = 0, because the root triangle does
    * not have a successor. */
@@ -877,10 +1311,12 @@ t8_dtri_succ_pred_recursion (const t8_dtri_t * t, t8_dtri_t * s, int level,
   }
   cid = compute_cubeid (t, level);
   type_level = compute_type (t, level);
-  local_index = t8_dtri_type_cid_to_Iloc[type_level][cid];
-  local_index =
-    (local_index + T8_DTRI_CHILDREN + increment) % T8_DTRI_CHILDREN;
-  if (local_index == 0) {
+  local_index = t8_dtri_type_cid_to_Iloc[type_level][cid] + increment;
+  /* If the local index leaves the parent, we continue in its successor
+   * or predecessor */
+  wraps = local_index < 0 || local_index >= T8_DTRI_CHILDREN;
+  local_index = (local_index + T8_DTRI_CHILDREN) % T8_DTRI_CHILDREN;
+  if (wraps) {
     sign = increment < 0 ? -1 : increment > 0;
     t8_dtri_succ_pred_recursion (t, s, level - 1, sign);
     type_level_p1 = s->type;    /* We stored the type of s at level-1 in s->type */
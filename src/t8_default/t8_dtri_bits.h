@@ -115,6 +115,58 @@ void                t8_dtri_sibling (const t8_dtri_t * elem,
 int                 t8_dtri_face_neighbour (const t8_dtri_t * t, int face,
                                             t8_dtri_t * n);
 
+/** Compute the children of a triangle that touch a given face.
+ * \param [in]     t      Input triangle.
+ * \param [in]     face   A face of \a t.
+ * \param [in,out] children Array of 2 existing triangles whose data
+ *                        will be filled with the children of \a t at
+ *                        \a face in Morton order.
+ * \param [in]     num_children Must equal 2.
+ * \param [out]    child_faces  If not NULL, an array of 2 integers
+ *                        that will be filled with the face numbers of
+ *                        the children that lie on \a face.
+ */
+void                t8_dtri_children_at_face (const t8_dtri_t * t, int face,
+                                            t8_dtri_t * children[],
+                                            int num_children,
+                                            int *child_faces);
+
+/** Return the face number of a child at a face of a triangle that lies on
+ * this face.
+ * \param [in]     t      Input triangle.
+ * \param [in]     face   A face of \a t.
+ * \param [in]     face_child The number of the child at \a face
+ *                        as in \ref t8_dtri_children_at_face.
+ * \return                The face of the child that is a subface of \a face.
+ */
+int                 t8_dtri_face_child_face (const t8_dtri_t * t, int face,
+                                           int face_child);
+
+/** Given a face of a triangle that lies on the boundary of the root triangle,
+ * return the face number of the root triangle.
+ * \param [in]     t      Input triangle.
+ * \param [in]     face   A face of \a t that lies on the root boundary.
+ * \return                The root face containing \a face.
+ */
+int                 t8_dtri_tree_face (const t8_dtri_t * t, int face);
+
+/** Compute the same-level face neighbour of a triangle across a face of
+ * the root triangle in the coordinates of the neighbouring tree.
+ * \param [in]     t      Input triangle.
+ * \param [in,out] n      Existing triangle whose data will be filled.
+ * \param [in]     face   A face of \a t that lies on the root boundary.
+ * \param [in]     neigh_tree_face The face of the neighbouring tree.
+ * \param [in]     orientation The orientation of the tree connection.
+ * \param [in]     is_smaller_face Nonzero if our tree face is the master
+ *                        face of the connection.
+ * \return                The face of \a n that is shared with \a t.
+ */
+int                 t8_dtri_tree_face_neighbour (const t8_dtri_t * t,
+                                               t8_dtri_t * n, int face,
+                                               int neigh_tree_face,
+                                               int orientation,
+                                               int is_smaller_face);
+
 /** Computes the nearest common ancestor of two triangles in the same tree.
  * \param [in]     t1 First input triangle.
  * \param [in]     t2 Second input triangle.
@@ -171,6 +223,17 @@ int                 t8_dtri_is_ancestor (const t8_dtri_t * t,
  */
 uint64_t            t8_dtri_linear_id (const t8_dtri_t * t, int level);
 
+/** Compare two triangles in the order of the space-filling curve.
+ * This is the same as comparing their linear ids in a uniform grid of the
+ * bigger of both levels, but does not compute these ids.
+ * \param [in] t1 The first triangle.
+ * \param [in] t2 The second triangle.
+ * \return Negative if \a t1 is smaller than \a t2, zero if they have the
+ *         same linear id and positive if \a t1 is bigger than \a t2.
+ */
+int                 t8_dtri_compare (const t8_dtri_t * t1,
+                                    const t8_dtri_t * t2);
+
 /** Initialize a triangle as the triangle with a given global id in a uniform
  *  refinement of a given level. *
  * \param [in,out] t  Existing triangle whose data will be filled.
@@ -180,6 +243,20 @@ uint64_t            t8_dtri_linear_id (const t8_dtri_t * t, int level);
 void                t8_dtri_init_linear_id (t8_dtri_t * t, uint64_t id,
                                             int level);
 
+/** Initialize a contiguous array of triangles as the triangles with
+ * consecutive global ids in a uniform refinement of a given level.
+ * After the first triangle, each triangle is computed from its
+ * predecessor by stepping along the space-filling curve. This takes
+ * constant time on average, independent of \a level.
+ * \param [in,out] t  Array of \a count existing triangles to be filled.
+ * \param [in] id     Index of the first triangle.
+ * \param [in] level  level of uniform grid to be considered.
+ * \param [in] count  The number of triangles, such that \a id + \a count
+ *                    does not exceed the number of triangles on \a level.
+ */
+void                t8_dtri_init_linear_id_range (t8_dtri_t * t, uint64_t id,
+                                                  int level, size_t count);
+
 /** Initialize a triangle as the root triangle (type 0 at level 0)
  * \param [in,out] t Existing triangle whose data will be filled.
  */
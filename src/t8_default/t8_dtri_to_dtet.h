@@ -39,6 +39,7 @@ T8_EXTERN_C_BEGIN ();
 #define T8_DTRI_FACES T8_DTET_FACES
 #define T8_DTRI_DIM T8_DTET_DIM
 #define T8_DTRI_CHILDREN T8_DTET_CHILDREN
+#define T8_DTRI_FACE_CHILDREN T8_DTET_FACE_CHILDREN
 
 /* redefine types */
 #define t8_dtri_coord_t t8_dtet_coord_t
@@ -71,13 +72,19 @@ T8_EXTERN_C_BEGIN ();
 #define t8_dtri_is_familypv t8_dtet_is_familypv
 #define t8_dtri_sibling t8_dtet_sibling
 #define t8_dtri_face_neighbour t8_dtet_face_neighbour
+#define t8_dtri_children_at_face t8_dtet_children_at_face
+#define t8_dtri_face_child_face t8_dtet_face_child_face
+#define t8_dtri_tree_face t8_dtet_tree_face
+#define t8_dtri_tree_face_neighbour t8_dtet_tree_face_neighbour
 #define t8_dtri_nearest_common_ancestor t8_dtet_nearest_common_ancestor
 #define t8_dtri_is_inside_root t8_dtet_is_inside_root
 #define t8_dtri_is_sibling t8_dtet_is_sibling
 #define t8_dtri_is_parent t8_dtet_is_parent
 #define t8_dtri_is_ancestor t8_dtet_is_ancestor
 #define t8_dtri_linear_id t8_dtet_linear_id
+#define t8_dtri_compare t8_dtet_compare
 #define t8_dtri_init_linear_id t8_dtet_init_linear_id
+#define t8_dtri_init_linear_id_range t8_dtet_init_linear_id_range
 #define t8_dtri_init_root t8_dtet_init_root
 #define t8_dtri_successor t8_dtet_successor
 #define t8_dtri_first_descendant t8_dtet_first_descendant
@@ -21,6 +21,13 @@
 */
 
 #include <t8_element.h>
+#ifdef T8_ENABLE_OPENMP
+#include <omp.h>
+#endif
+
+/* A range of linear ids is only split across threads if every thread gets
+ * at least this number of elements. */
+#define T8_ELEMENT_RANGE_MIN_CHUNK 16384
 
 static void
 t8_scheme_destroy (t8_scheme_t * s)
@@ -299,6 +306,77 @@ t8_element_root_len (t8_eclass_scheme_t * ts, const t8_element_t * elem)
   return ts->elem_root_len (elem);
 }
 
+int
+t8_element_num_faces (t8_eclass_scheme_t * ts, const t8_element_t * elem)
+{
+  T8_ASSERT (ts != NULL && ts->elem_num_faces != NULL);
+  return ts->elem_num_faces (elem);
+}
+
+int
+t8_element_num_face_children (t8_eclass_scheme_t * ts,
+                              const t8_element_t * elem, int face)
+{
+  T8_ASSERT (ts != NULL && ts->elem_num_face_children != NULL);
+  return ts->elem_num_face_children (elem, face);
+}
+
+void
+t8_element_children_at_face (t8_eclass_scheme_t * ts,
+                             const t8_element_t * elem, int face,
+                             t8_element_t * children[], int num_children)
+{
+  T8_ASSERT (ts != NULL && ts->elem_children_at_face != NULL);
+  ts->elem_children_at_face (elem, face, children, num_children);
+}
+
+int
+t8_element_face_child_face (t8_eclass_scheme_t * ts,
+                            const t8_element_t * elem, int face,
+                            int face_child)
+{
+  T8_ASSERT (ts != NULL && ts->elem_face_child_face != NULL);
+  return ts->elem_face_child_face (elem, face, face_child);
+}
+
+int
+t8_element_tree_face (t8_eclass_scheme_t * ts, const t8_element_t * elem,
+                      int face)
+{
+  T8_ASSERT (ts != NULL && ts->elem_tree_face != NULL);
+  return ts->elem_tree_face (elem, face);
+}
+
+int
+t8_element_face_neighbor_inside (t8_eclass_scheme_t * ts,
+                                 const t8_element_t * elem,
+                                 t8_element_t * neigh, int face,
+                                 int *neigh_face)
+{
+  T8_ASSERT (ts != NULL && ts->elem_face_neighbor_inside != NULL);
+  return ts->elem_face_neighbor_inside (elem, neigh, face, neigh_face);
+}
+
+int
+t8_element_tree_face_neighbor (t8_eclass_scheme_t * ts,
+                               const t8_element_t * elem,
+                               t8_element_t * neigh, int face,
+                               int neigh_tree_face, int orientation,
+                               int is_smaller_face)
+{
+  T8_ASSERT (ts != NULL && ts->elem_tree_face_neighbor != NULL);
+  return ts->elem_tree_face_neighbor (elem, neigh, face, neigh_tree_face,
+                                      orientation, is_smaller_face);
+}
+
+void
+t8_element_vertex_coords (t8_eclass_scheme_t * ts, const t8_element_t * elem,
+                          int vertex, int coords[])
+{
+  T8_ASSERT (ts != NULL && ts->elem_vertex_coords != NULL);
+  ts->elem_vertex_coords (elem, vertex, coords);
+}
+
 void
 t8_element_new (t8_eclass_scheme_t * ts, int length, t8_element_t ** elems)
 {
@@ -324,3 +402,164 @@ t8_element_array_index (t8_eclass_scheme_t * ts, sc_array_t * array,
 
   return (t8_element_t *) (array->array + array->elem_size * it);
 }
+
+void
+t8_element_parents (t8_eclass_scheme_t * ts, const t8_element_t * elems,
+                    size_t count, t8_element_t * parents)
+{
+  size_t              size, i;
+
+  T8_ASSERT (ts != NULL);
+  T8_ASSERT (count == 0 || (elems != NULL && parents != NULL));
+
+  if (ts->elem_parents != NULL) {
+    ts->elem_parents (elems, count, parents);
+    return;
+  }
+  T8_ASSERT (ts->elem_parent != NULL);
+  size = t8_element_size (ts);
+  for (i = 0; i < count; ++i) {
+    ts->elem_parent ((const t8_element_t *) ((const char *) elems + i * size),
+                     (t8_element_t *) ((char *) parents + i * size));
+  }
+}
+
+void
+t8_element_children_array (t8_eclass_scheme_t * ts,
+                           const t8_element_t * elems, size_t count,
+                           t8_element_t * children)
+{
+  size_t              size, i;
+  int                 num_children, ichild;
+  t8_element_t      **child;
+
+  T8_ASSERT (ts != NULL);
+  T8_ASSERT (count == 0 || (elems != NULL && children != NULL));
+
+  if (ts->elem_children_array != NULL) {
+    ts->elem_children_array (elems, count, children);
+    return;
+  }
+  T8_ASSERT (ts->elem_children != NULL);
+  size = t8_element_size (ts);
+  num_children = t8_eclass_num_children[ts->eclass];
+  /* The children of an element in SFC order may differ from the order of
+   * their child ids, thus we construct them all at once */
+  child = T8_ALLOC (t8_element_t *, num_children);
+  for (i = 0; i < count; ++i) {
+    for (ichild = 0; ichild < num_children; ++ichild) {
+      child[ichild] = (t8_element_t *)
+        ((char *) children + (i * num_children + ichild) * size);
+    }
+    ts->elem_children ((const t8_element_t *)
+                       ((const char *) elems + i * size), num_children,
+                       child);
+  }
+  T8_FREE (child);
+}
+
+void
+t8_element_get_linear_ids (t8_eclass_scheme_t * ts,
+                           const t8_element_t * elems, size_t count,
+                           int level, uint64_t * ids)
+{
+  size_t              size, i;
+
+  T8_ASSERT (ts != NULL);
+  T8_ASSERT (count == 0 || (elems != NULL && ids != NULL));
+
+  if (ts->elem_get_linear_ids != NULL) {
+    ts->elem_get_linear_ids (elems, count, level, ids);
+    return;
+  }
+  T8_ASSERT (ts->elem_get_linear_id != NULL);
+  size = t8_element_size (ts);
+  for (i = 0; i < count; ++i) {
+    ids[i] = ts->elem_get_linear_id ((const t8_element_t *)
+                                     ((const char *) elems + i * size),
+                                     level);
+  }
+}
+
+void
+t8_element_successors (t8_eclass_scheme_t * ts, const t8_element_t * elem,
+                       size_t count, t8_element_t * succs, int level)
+{
+  size_t              size, i;
+  const char         *prev;
+
+  T8_ASSERT (ts != NULL);
+  T8_ASSERT (count == 0 || (elem != NULL && succs != NULL));
+
+  if (ts->elem_successors != NULL) {
+    ts->elem_successors (elem, count, succs, level);
+    return;
+  }
+  T8_ASSERT (ts->elem_successor != NULL);
+  size = t8_element_size (ts);
+  prev = (const char *) elem;
+  for (i = 0; i < count; ++i) {
+    ts->elem_successor ((const t8_element_t *) prev,
+                        (t8_element_t *) ((char *) succs + i * size), level);
+    prev = (const char *) succs + i * size;
+  }
+}
+
+void
+t8_element_linear_range (t8_eclass_scheme_t * ts, int level,
+                         uint64_t start, uint64_t end, t8_element_t * elems)
+{
+  T8_ASSERT (ts != NULL);
+  T8_ASSERT (start <= end);
+  T8_ASSERT (start == end || elems != NULL);
+
+  if (ts->elem_linear_range != NULL) {
+    ts->elem_linear_range (elems, level, start, end);
+    return;
+  }
+  if (start == end) {
+    return;
+  }
+  T8_ASSERT (ts->elem_set_linear_id != NULL);
+  ts->elem_set_linear_id (elems, level, start);
+  t8_element_successors (ts, elems, end - start - 1,
+                         (t8_element_t *) ((char *) elems +
+                                           t8_element_size (ts)), level);
+}
+
+void
+t8_element_linear_range_threaded (t8_eclass_scheme_t * ts, int level,
+                                  uint64_t start, uint64_t end,
+                                  t8_element_t * elems)
+{
+#ifdef T8_ENABLE_OPENMP
+  int                 num_threads, ithread;
+  size_t              size;
+  uint64_t            chunk, chunk_start, chunk_end;
+
+  T8_ASSERT (ts != NULL);
+  T8_ASSERT (start <= end);
+
+  num_threads = omp_get_max_threads ();
+  if (num_threads > 1 && end - start >= 2 * T8_ELEMENT_RANGE_MIN_CHUNK) {
+    num_threads = (int) SC_MIN ((uint64_t) num_threads,
+                                (end - start) / T8_ELEMENT_RANGE_MIN_CHUNK);
+    chunk = (end - start + num_threads - 1) / num_threads;
+    size = t8_element_size (ts);
+#pragma omp parallel for private(chunk_start, chunk_end) \
+  num_threads(num_threads)
+    for (ithread = 0; ithread < num_threads; ++ithread) {
+      /* Each thread initializes its chunk from the chunk's first id */
+      chunk_start = start + ithread * chunk;
+      chunk_end = SC_MIN (chunk_start + chunk, end);
+      if (chunk_start < chunk_end) {
+        t8_element_linear_range (ts, level, chunk_start, chunk_end,
+                                 (t8_element_t *) ((char *) elems + size *
+                                                   (chunk_start - start)));
+      }
+    }
+    return;
+  }
+#endif
+  t8_element_linear_range (ts, level, start, end, elems);
+}
@@ -145,6 +145,93 @@ typedef void        (*t8_element_anchor_t) (const t8_element_t * elem,
  */
 typedef int         (*t8_element_root_len_t) (const t8_element_t * elem);
 
+/** Return the number of faces of an element. */
+typedef int         (*t8_element_num_faces_t) (const t8_element_t * elem);
+
+/** Return the number of children of an element that touch a given face. */
+typedef int         (*t8_element_num_face_children_t) (const t8_element_t *
+                                                       elem, int face);
+
+/** Construct the children of an element that touch a given face,
+ *  in the order of their child ids.
+ */
+typedef void        (*t8_element_children_at_face_t) (const t8_element_t *
+                                                      elem, int face,
+                                                      t8_element_t *
+                                                      children[],
+                                                      int num_children);
+
+/** Return the face number of a child at a face that lies on the parent's face. */
+typedef int         (*t8_element_face_child_face_t) (const t8_element_t *
+                                                     elem, int face,
+                                                     int face_child);
+
+/** Return the tree face number of an element face that lies on the
+ *  tree boundary.
+ */
+typedef int         (*t8_element_tree_face_t) (const t8_element_t * elem,
+                                               int face);
+
+/** Construct the same-level face neighbor of an element in the same tree.
+ *  Return nonzero if the neighbor lies inside the root element.
+ */
+typedef int         (*t8_element_face_neighbor_inside_t) (const t8_element_t
+                                                          * elem,
+                                                          t8_element_t *
+                                                          neigh, int face,
+                                                          int *neigh_face);
+
+/** Construct the same-level face neighbor of an element across a tree face
+ *  in the neighboring tree and return the neighbor's face number.
+ */
+typedef int         (*t8_element_tree_face_neighbor_t) (const t8_element_t *
+                                                        elem,
+                                                        t8_element_t * neigh,
+                                                        int face,
+                                                        int neigh_tree_face,
+                                                        int orientation,
+                                                        int is_smaller_face);
+
+/** Compute the integer coordinates of a vertex of an element
+ *  relative to the root length of its tree.
+ */
+typedef void        (*t8_element_vertex_coords_t) (const t8_element_t * elem,
+                                                   int vertex, int coords[]);
+
+/** Construct the parents of \a count elements stored contiguously.
+ *  The parents are written contiguously to \a parents, which may equal
+ *  \a elems.
+ */
+typedef void        (*t8_element_parents_t) (const t8_element_t * elems,
+                                             size_t count,
+                                             t8_element_t * parents);
+
+/** Construct all children of \a count elements stored contiguously.
+ *  The children of the i-th element are written contiguously to
+ *  \a children, beginning at position i times the number of children.
+ */
+typedef void        (*t8_element_children_array_t) (const t8_element_t *
+                                                    elems, size_t count,
+                                                    t8_element_t * children);
+
+/** Calculate the linear ids of \a count elements stored contiguously. */
+typedef void        (*t8_element_get_linear_ids_t) (const t8_element_t *
+                                                    elems, size_t count,
+                                                    int level,
+                                                    uint64_t * ids);
+
+/** Compute the \a count successors of an element contiguously. */
+typedef void        (*t8_element_successors_t) (const t8_element_t * elem,
+                                                size_t count,
+                                                t8_element_t * succs,
+                                                int level);
+
+/** Initialize the elements with linear ids \a start, ..., \a end - 1 on
+ * \a level contiguously. */
+typedef void        (*t8_element_linear_range_t) (t8_element_t * elems,
+                                                  int level, uint64_t start,
+                                                  uint64_t end);
+
 /** Deallocate space for the codimension-one boundary elements. */
 typedef void        (*t8_element_destroy_t) (void *ts_context,
                                              int length,
@@ -183,6 +270,21 @@ struct t8_eclass_scheme
   t8_element_root_len_t elem_root_len; /**< Compute the root length of a given element */
   t8_element_first_descendant_t elem_first_desc; /**< Compute an element's first descendant */
   t8_element_last_descendant_t elem_last_desc; /**< Compute an element's last descendant */
+  t8_element_num_faces_t elem_num_faces; /**< Return the number of faces of an element. */
+  t8_element_num_face_children_t elem_num_face_children; /**< Return the number of children at a face. */
+  t8_element_children_at_face_t elem_children_at_face; /**< Compute the children at a face. */
+  t8_element_face_child_face_t elem_face_child_face; /**< Return the face of a child at a face. */
+  t8_element_tree_face_t elem_tree_face; /**< Return the tree face of a boundary face. */
+  t8_element_face_neighbor_inside_t elem_face_neighbor_inside; /**< Compute a face neighbor in the same tree. */
+  t8_element_tree_face_neighbor_t elem_tree_face_neighbor; /**< Compute a face neighbor across a tree face. */
+  t8_element_vertex_coords_t elem_vertex_coords; /**< Compute the coordinates of a vertex. */
+  /* these element routines work on contiguous arrays of elements,
+   * if they are NULL we loop over the single element routines */
+  t8_element_parents_t elem_parents;    /**< Compute the parents of many elements. */
+  t8_element_children_array_t elem_children_array; /**< Compute all children of many elements. */
+  t8_element_get_linear_ids_t elem_get_linear_ids; /**< Calculate the linear ids of many elements. */
+  t8_element_successors_t elem_successors; /**< Compute many successors of an element. */
+  t8_element_linear_range_t elem_linear_range; /**< Initialize a range of elements of a uniform refinement. */
   /* these element routines have a context for memory allocation */
   t8_element_new_t    elem_new;         /**< Allocate space for one or more elements. */
   t8_element_destroy_t elem_destroy;    /**< Deallocate space for one or more elements. */
@@ -482,6 +584,122 @@ void                t8_element_anchor (t8_eclass_scheme_t * ts,
 int                 t8_element_root_len (t8_eclass_scheme_t * ts,
                                          const t8_element_t * elem);
 
+/** Return the number of faces of a given element.
+ * \param [in] ts       The virtual table for this element class.
+ * \param [in] elem     The element.
+ * \return              The number of faces of \a elem.
+ */
+int                 t8_element_num_faces (t8_eclass_scheme_t * ts,
+                                          const t8_element_t * elem);
+
+/** Return the number of children of an element that touch a given face.
+ * \param [in] ts       The virtual table for this element class.
+ * \param [in] elem     The element.
+ * \param [in] face     A face of \a elem.
+ * \return              The number of children of \a elem at \a face.
+ */
+int                 t8_element_num_face_children (t8_eclass_scheme_t * ts,
+                                                  const t8_element_t * elem,
+                                                  int face);
+
+/** Construct all children of an element that touch a given face.
+ * \param [in] ts       The virtual table for this element class.
+ * \param [in] elem     This must be a valid element, bigger than maxlevel.
+ * \param [in] face     A face of \a elem.
+ * \param [in,out] children  The storage for these \a num_children elements
+ *                      must exist. On output, the children of \a elem
+ *                      that touch \a face in the order of their child ids.
+ * \param [in] num_children  Must equal \ref t8_element_num_face_children.
+ */
+void                t8_element_children_at_face (t8_eclass_scheme_t * ts,
+                                                 const t8_element_t * elem,
+                                                 int face,
+                                                 t8_element_t * children[],
+                                                 int num_children);
+
+/** Given a face of an element and a child at this face, return the face
+ *  number of the child that lies on the parent's face.
+ * \param [in] ts       The virtual table for this element class.
+ * \param [in] elem     The parent element.
+ * \param [in] face     A face of \a elem.
+ * \param [in] face_child  A number 0 <= \a face_child < num_face_children,
+ *                      specifying a child as computed by
+ *                      \ref t8_element_children_at_face.
+ * \return              The face number of the \a face_child-th child at
+ *                      \a face that is a subface of \a face.
+ */
+int                 t8_element_face_child_face (t8_eclass_scheme_t * ts,
+                                                const t8_element_t * elem,
+                                                int face, int face_child);
+
+/** Given a face of an element that lies on the boundary of the root
+ *  element, return the face number of the root element.
+ * \param [in] ts       The virtual table for this element class.
+ * \param [in] elem     The element.
+ * \param [in] face     A face of \a elem that lies on the root boundary.
+ * \return              The face number of the tree that contains \a face.
+ */
+int                 t8_element_tree_face (t8_eclass_scheme_t * ts,
+                                          const t8_element_t * elem,
+                                          int face);
+
+/** Construct the same-level face neighbor of an element inside its tree.
+ * \param [in] ts       The virtual table for this element class.
+ * \param [in] elem     The element whose neighbor is constructed.
+ * \param [in,out] neigh On output the face neighbor of \a elem across
+ *                      \a face. It may lie outside of the root element.
+ * \param [in] face     A face of \a elem.
+ * \param [out] neigh_face  On output the face of \a neigh that is shared
+ *                      with \a elem.
+ * \return              Nonzero if \a neigh lies inside the root element,
+ *                      zero if \a face lies on the tree boundary.
+ */
+int                 t8_element_face_neighbor_inside (t8_eclass_scheme_t * ts,
+                                                     const t8_element_t *
+                                                     elem,
+                                                     t8_element_t * neigh,
+                                                     int face,
+                                                     int *neigh_face);
+
+/** Construct the same-level face neighbor of an element across a tree face.
+ * The neighbor tree must be of the same element class.
+ * \param [in] ts       The virtual table for this element class.
+ * \param [in] elem     The element whose neighbor is constructed.
+ * \param [in,out] neigh On output the face neighbor of \a elem in the
+ *                      coordinates of the neighbor tree.
+ * \param [in] face     A face of \a elem that lies on the tree boundary.
+ * \param [in] neigh_tree_face  The face number of the neighbor tree
+ *                      that is connected to our tree face.
+ * \param [in] orientation  The orientation of the tree face connection
+ *                      as stored in the coarse mesh.
+ * \param [in] is_smaller_face  Nonzero if our tree face is the master
+ *                      face of the connection, that is, the face whose
+ *                      corner 0 is matched by the \a orientation.
+ * \return              The face number of \a neigh that is shared with
+ *                      \a elem.
+ */
+int                 t8_element_tree_face_neighbor (t8_eclass_scheme_t * ts,
+                                                   const t8_element_t * elem,
+                                                   t8_element_t * neigh,
+                                                   int face,
+                                                   int neigh_tree_face,
+                                                   int orientation,
+                                                   int is_smaller_face);
+
+/** Compute the integer coordinates of a given vertex of an element.
+ * The vertices are numbered in the same way as the corners of the tree and
+ * the coordinates are relative to \ref t8_element_root_len.
+ * \param [in] ts       The virtual table for this element class.
+ * \param [in] elem     The element.
+ * \param [in] vertex   The number of the vertex of \a elem.
+ * \param [out] coords  An array of at least as many integers as the
+ *                      element's dimension, filled with the coordinates
+ *                      of the vertex.
+ */
+void                t8_element_vertex_coords (t8_eclass_scheme_t * ts,
+                                              const t8_element_t * elem,
+                                              int vertex, int coords[]);
+
 /** Allocate memory for an array of elements of a given class.
  * \param [in] ts       The virtual table for this element class.
  * \param [in] length   The number of elements to be allocated.
@@ -513,6 +731,102 @@ void                t8_element_destroy (t8_eclass_scheme_t * ts,
 t8_element_t       *t8_element_array_index (t8_eclass_scheme_t * ts,
                                             sc_array_t * array, size_t it);
 
+/** Construct the parents of a contiguous array of elements.
+ * This saves one indirect function call per element compared to
+ * \ref t8_element_parent.
+ * \param [in] ts       The virtual table for this element class.
+ * \param [in] elems    Array of \a count elements, all of level > 0.
+ * \param [in] count    The number of elements.
+ * \param [in,out] parents  Storage for \a count elements.  On output the
+ *                      i-th element is the parent of the i-th input element.
+ *                      May be the same as \a elems.
+ */
+void                t8_element_parents (t8_eclass_scheme_t * ts,
+                                        const t8_element_t * elems,
+                                        size_t count, t8_element_t * parents);
+
+/** Construct all children of a contiguous array of elements.
+ * \param [in] ts       The virtual table for this element class.
+ * \param [in] elems    Array of \a count elements, all below maxlevel.
+ * \param [in] count    The number of elements.
+ * \param [in,out] children Storage for \a count times the number of children
+ *                      elements.  It must not overlap \a elems.  On output
+ *                      the children of the i-th element are stored in SFC
+ *                      order beginning at position i times the number of
+ *                      children.
+ * \see t8_eclass_num_children
+ */
+void                t8_element_children_array (t8_eclass_scheme_t * ts,
+                                               const t8_element_t * elems,
+                                               size_t count,
+                                               t8_element_t * children);
+
+/** Compute the linear ids of a contiguous array of elements.
+ * \param [in] ts       The virtual table for this element class.
+ * \param [in] elems    Array of \a count elements.
+ * \param [in] count    The number of elements.
+ * \param [in] level    The level of the uniform refinement to consider.
+ * \param [out] ids     On output the linear ids of the \a count elements.
+ */
+void                t8_element_get_linear_ids (t8_eclass_scheme_t * ts,
+                                               const t8_element_t * elems,
+                                               size_t count, int level,
+                                               uint64_t * ids);
+
+/** Construct the next \a count elements after a given element in a uniform
+ * refinement.
+ * \param [in] ts       The virtual table for this element class.
+ * \param [in] elem     The element whose successors should be constructed.
+ *                      It must have at least \a count successors on \a level.
+ * \param [in] count    The number of successors.
+ * \param [in,out] succs Storage for \a count elements that must not overlap
+ *                      \a elem.  On output the successors in SFC order.
+ * \param [in] level    The level of the uniform refinement to consider.
+ */
+void                t8_element_successors (t8_eclass_scheme_t * ts,
+                                           const t8_element_t * elem,
+                                           size_t count,
+                                           t8_element_t * succs, int level);
+
+/** Initialize the elements with the linear ids \a start, ..., \a end - 1
+ * in a uniform refinement.  This is equivalent to setting the first element
+ * by \ref t8_element_set_linear_id and constructing the others as its
+ * successors, but the schemes step along the space-filling curve
+ * incrementally instead of computing each element from scratch.
+ * \param [in] ts       The virtual table for this element class.
+ * \param [in] level    The level of the uniform refinement to consider.
+ * \param [in] start    The linear id of the first element.
+ * \param [in] end      One past the linear id of the last element.
+ *                      It must not exceed the number of elements on \a level.
+ * \param [in,out] elems Storage for \a end - \a start elements.  On output
+ *                      the elements of the range in SFC order.
+ */
+void                t8_element_linear_range (t8_eclass_scheme_t * ts,
+                                             int level, uint64_t start,
+                                             uint64_t end,
+                                             t8_element_t * elems);
+
+/** Initialize the elements with the linear ids \a start, ..., \a end - 1
+ * in a uniform refinement as in \ref t8_element_linear_range.
+ * If t8code is configured with --enable-openmp and the range is large,
+ * it is split into one chunk per thread and the chunks are initialized
+ * concurrently.
+ * The scheme's element routines must not modify their context, which
+ * holds for the default schemes.
+ * \param [in] ts       The virtual table for this element class.
+ * \param [in] level    The level of the uniform refinement to consider.
+ * \param [in] start    The linear id of the first element.
+ * \param [in] end      One past the linear id of the last element.
+ *                      It must not exceed the number of elements on \a level.
+ * \param [in,out] elems Storage for \a end - \a start elements.  On output
+ *                      the elements of the range in SFC order.
+ */
+void                t8_element_linear_range_threaded (t8_eclass_scheme_t *
+                                                      ts, int level,
+                                                      uint64_t start,
+                                                      uint64_t end,
+                                                      t8_element_t * elems);
+
 T8_EXTERN_C_END ();
 
 #endif /* !T8_ELEMENT_H */
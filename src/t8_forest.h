@@ -35,6 +35,8 @@
 /** Opaque pointer to a forest implementation. */
 typedef struct t8_forest *t8_forest_t;
 typedef struct t8_tree *t8_tree_t;
+/** Opaque pointer to the state of a nonblocking ghost data exchange. */
+typedef struct t8_forest_ghost_exchange *t8_forest_ghost_exchange_t;
 
 T8_EXTERN_C_BEGIN ();
 
@@ -94,6 +96,122 @@ typedef int         (*t8_forest_adapt_t) (t8_forest_t forest,
                                           int num_elements,
                                           t8_element_t * elements[]);
 
+/** Callback function prototype to compute the weight of an element
+ * for a weighted partition.
+ * \param [in] forest      the forest that is partitioned
+ * \param [in] which_tree  the local tree containing \a element
+ * \param [in] ts          the eclass scheme of the tree
+ * \param [in] element     a leaf element of \a forest
+ * \return                 the non-negative computational cost of \a element.
+ * \see t8_forest_set_partition
+ */
+typedef double      (*t8_forest_weight_t) (t8_forest_t forest,
+                                           t8_locidx_t which_tree,
+                                           t8_eclass_scheme_t * ts,
+                                           t8_element_t * element);
+
+/** A group of consecutive local elements that is replaced by another
+ * group of consecutive local elements during adaptation or balance.
+ * The indices are local element indices of the old and the new forest.
+ */
+typedef struct t8_forest_element_remap
+{
+  t8_locidx_t         first_old;        /**< The index of the first old element. */
+  t8_locidx_t         num_old;          /**< The number of old elements. */
+  t8_locidx_t         first_new;        /**< The index of the first new element. */
+  t8_locidx_t         num_new;          /**< The number of new elements. */
+}
+t8_forest_element_remap_t;
+
+/** Callback function prototype to interpolate registered element data
+ * after the elements of a forest changed.
+ * It is called once per data field with all changed groups of elements
+ * of this process. The data of unchanged elements is already copied.
+ * \param [in] forest      the forest with the new elements
+ * \param [in] data_size   the number of bytes per element of this field
+ * \param [in] num_remaps  the number of entries in \a remaps
+ * \param [in] remaps      the changed groups of elements, ordered by
+ *                         their element indices. Usually, a group is
+ *                         an element and its children or a family and
+ *                         its parent. On recursive adaptation, a group
+ *                         may also be an element and all leaves of its
+ *                         refinement or all leaves of a coarsened
+ *                         ancestor and this ancestor. A group may have
+ *                         no new elements if they are created on another
+ *                         process.
+ * \param [in] data_old    the field data of the old elements
+ * \param [in,out] data_new the field data of the new elements. Only the
+ *                         entries of the new elements in \a remaps
+ *                         are to be set.
+ * \see t8_forest_register_element_data
+ */
+typedef void        (*t8_forest_interpolate_t) (t8_forest_t forest,
+                                                size_t data_size,
+                                                size_t num_remaps,
+                                                const
+                                                t8_forest_element_remap_t *
+                                                remaps, const void *data_old,
+                                                void *data_new);
+
+/** Callback function prototype for \ref t8_forest_iterate.
+ * It is called for each leaf element of a tree and for each ancestor of
+ * leaf elements, the inner elements, from top to bottom.
+ * \param [in] forest      the forest
+ * \param [in] ltreeid     the local tree containing \a element
+ * \param [in] element     A leaf element or an inner element.
+ * \param [in] is_leaf     True if \a element is a leaf element of \a forest.
+ * \param [in] leaf_elements The leaf elements of the tree that are
+ *                         descendants of \a element, in their order in the tree.
+ *                         If \a is_leaf is true, this is only \a element.
+ * \param [in] tree_leaf_index The index in the tree of the first entry
+ *                         of \a leaf_elements.
+ * \return                 If \a is_leaf is false and the return value is zero,
+ *                         the descendants of \a element are skipped.
+ *                         Otherwise the return value is ignored.
+ */
+typedef int         (*t8_forest_iterate_fn) (t8_forest_t forest,
+                                             t8_locidx_t ltreeid,
+                                             const t8_element_t * element,
+                                             int is_leaf,
+                                             sc_array_t * leaf_elements,
+                                             t8_locidx_t tree_leaf_index);
+
+/** Callback function prototype for the queries of \ref t8_forest_search.
+ * It is called for each query that matched the parent of an element.
+ * \param [in] forest      the forest
+ * \param [in] ltreeid     the local tree containing \a element
+ * \param [in] element     A leaf element or an inner element.
+ * \param [in] is_leaf     True if \a element is a leaf element of \a forest.
+ * \param [in] leaf_elements The leaf elements of the tree that are
+ *                         descendants of \a element.
+ * \param [in] tree_leaf_index The index in the tree of the first entry
+ *                         of \a leaf_elements.
+ * \param [in] query       The query.
+ * \param [in] query_index The index of \a query in the query array.
+ * \return                 Nonzero if \a query may be found inside of
+ *                         \a element. Otherwise, \a query is not passed
+ *                         to the descendants of \a element.
+ */
+typedef int         (*t8_forest_search_query_fn) (t8_forest_t forest,
+                                                  t8_locidx_t ltreeid,
+                                                  const t8_element_t *
+                                                  element, int is_leaf,
+                                                  sc_array_t * leaf_elements,
+                                                  t8_locidx_t
+                                                  tree_leaf_index,
+                                                  void *query,
+                                                  size_t query_index);
+
+/** Callback function prototype to compute the sort key of a query,
+ * for example the Morton index of a point.
+ * \param [in] forest      the forest
+ * \param [in] query       A query.
+ * \return                 The sort key of \a query.
+ * \see t8_forest_search_sort_queries
+ */
+typedef             uint64_t (*t8_forest_search_key_fn) (t8_forest_t forest,
+                                                         const void *query);
+
   /** Create a new forest with reference count one.
  * This forest needs to be specialized with the t8_forest_set_* calls.
  * Currently it is manatory to either call the functions \ref
@@ -185,6 +303,17 @@ void                t8_forest_set_copy (t8_forest_t forest,
  * \param [in] recursive    A flag specifying whether adaptation is to be done recursively6
  *                          or not. If the value is zero, adaptation is not recursive
  *                          and it is recursive otherwise.
+ * If \b forest takes the only reference to \b set_from, the elements of
+ * \b set_from are adapted in place to save memory. In this case,
+ * \b set_from must not be accessed from within \b adapt_fn or \b replace_fn.
+ * If t8code is configured with --enable-openmp and adaptation is not
+ * recursive, the trees and chunks of consecutive elements of large trees
+ * are adapted concurrently. Then \b adapt_fn and \b replace_fn must be
+ * thread-safe. In particular, they must not call \ref t8_element_new,
+ * since the elements of a scheme come from one shared memory pool.
+ * The chunks of a tree are adapted into separate arrays
+ * that are concatenated afterwards, thus they are not adapted in place.
+ * This needs additional memory for the adapted elements of each split tree.
  */
 void                t8_forest_set_adapt (t8_forest_t forest,
                                          const t8_forest_t set_from,
@@ -192,6 +321,58 @@ void                t8_forest_set_adapt (t8_forest_t forest,
                                          t8_forest_replace_t replace_fn,
                                          int recursive);
 
+/** Set a source forest to be adapted on commiting according to a marker
+ * for each of its local elements. This is an alternative to
+ * \ref t8_forest_set_adapt for applications that already know the
+ * adaptation decision of each element, for example from an error estimator.
+ * No adapt or replace function is called and adaptation is not recursive.
+ * Ownership of \b set_from is handled as in \ref t8_forest_set_adapt.
+ * \param [in,out] forest   The forest
+ * \param [in] set_from     The committed source forest from which \b forest
+ *                          will be adapted. We take ownership.
+ * \param [in] markers      An array of int8_t with one entry per local element
+ *                          of \b set_from in local element order.
+ *                          A positive value refines the element once,
+ *                          zero keeps it. A family is coarsened once if all
+ *                          its members are local, consecutive in one tree
+ *                          and marked with a negative value. Otherwise
+ *                          negative markers are treated as zero.
+ *                          The array must stay valid until \b forest is
+ *                          committed. We do not take ownership.
+ */
+void                t8_forest_set_adapt_markers (t8_forest_t forest,
+                                                 const t8_forest_t set_from,
+                                                 const sc_array_t * markers);
+
+/** Set a source forest to be refined uniformly by one level on commiting.
+ * This is equivalent to \ref t8_forest_set_adapt with an adapt function
+ * that refines every element, but no function is called and the new
+ * element arrays are allocated with their final size.
+ * Ownership of \b set_from is handled as in \ref t8_forest_set_adapt.
+ * \param [in,out] forest   The forest
+ * \param [in] set_from     The source forest from which \b forest
+ *                          will be refined. We take ownership.
+ */
+void                t8_forest_set_uniform_refine (t8_forest_t forest,
+                                                  const t8_forest_t set_from);
+
+/** Set a source forest to be coarsened to a given level on commiting.
+ * Each element of a level greater than \b level is replaced by its ancestor
+ * of level \b level. Elements of smaller or equal level are kept.
+ * If the leaves of an ancestor are distributed over several processes,
+ * the ancestor is created on the process that owns its first leaf.
+ * No function is called and the new element arrays are allocated with
+ * their final size.
+ * Ownership of \b set_from is handled as in \ref t8_forest_set_adapt.
+ * \param [in,out] forest   The forest
+ * \param [in] set_from     The source forest from which \b forest
+ *                          will be coarsened. We take ownership.
+ * \param [in] level        The level to coarsen to. Must be non-negative.
+ */
+void                t8_forest_set_uniform_coarsen (t8_forest_t forest,
+                                                   const t8_forest_t set_from,
+                                                   int level);
+
 /** Set the user data of a forest. This can i.e. be used to pass user defined
  * arguments to the adapt routine.
  * \param [in,out] forest   The forest
@@ -202,28 +383,102 @@ void                t8_forest_set_adapt (t8_forest_t forest,
 void                t8_forest_set_user_data (t8_forest_t forest, void *data);
 
 /** Return the user data pointer associated with a forest.
- * \param [in]     forest   The forest.
+ * \param [in]     forest   The forest, initialized or committed.
  * \return                  The user data pointer of \a forest.
  * \see t8_forest_set_user_data
  */
 void               *t8_forest_get_user_data (t8_forest_t forest);
 
-/* TODO: define weight callback function */
+/** Set a source forest to be partitioned on commiting.
+ * By default, the forest takes ownership of the source \b set_from such that it will
+ * be destroyed on calling \ref t8_forest_commit.  To keep ownership of \b
+ * set_from, call \ref t8_forest_ref before passing it into this function.
+ * \param [in,out] forest   The forest
+ * \param [in] set_from     The source forest from which \b forest will be partitioned.
+ *                          We take ownership. This can be prevented by
+ *                          referencing \b set_from.
+ * \param [in] set_for_coarsening Change the partition to allow for one
+ *                          round of coarsening. If true, the partition
+ *                          boundaries are moved such that no family of
+ *                          elements is split between two processes.
+ * \param [in] weight_fn    If NULL, each process receives the same number
+ *                          of elements. Otherwise, this function is called
+ *                          for each element of \b set_from and the partition
+ *                          boundaries are chosen such that each process
+ *                          receives the same total weight, up to the weight
+ *                          of one element.
+ */
 void                t8_forest_set_partition (t8_forest_t forest,
-                                             const t8_forest_t from,
-                                             int set_for_coarsening);
-
+                                             const t8_forest_t set_from,
+                                             int set_for_coarsening,
+                                             t8_forest_weight_t weight_fn);
+
+/** Redistribute per element data from a forest to a repartitioned forest.
+ * The data is given as one fixed size entry for each local element in
+ * the order of the elements. Each process sends the entries of the
+ * elements that it passed to another process in the partition with one
+ * message directly from \a data_in and receives directly into \a data_out.
+ * This function is collective.
+ * \param [in] forest_from  A committed forest.
+ * \param [in] forest_to    A committed forest that was created from
+ *                          \a forest_from with \ref t8_forest_set_partition.
+ *                          \a forest_from must have been referenced
+ *                          before committing \a forest_to.
+ * \param [in] data_in      An array with one entry for each local element
+ *                          of \a forest_from.
+ * \param [in,out] data_out An array with the same element size as
+ *                          \a data_in. On output it is resized to hold one
+ *                          entry for each local element of \a forest_to
+ *                          and stores the transferred data.
+ */
+void                t8_forest_partition_data (t8_forest_t forest_from,
+                                              t8_forest_t forest_to,
+                                              const sc_array_t * data_in,
+                                              sc_array_t * data_out);
+
+/** Enable or disable 2:1 face balance of a forest.
+ * On commit, the elements are refined until the levels of any two leaf
+ * elements sharing a face differ by at most one, also across tree and
+ * process boundaries.
+ * \param [in, out] forest   The forest.
+ * \param [in]      do_balance If non-zero, the forest will be balanced.
+ * \note Balance uses the ghost layer, thus the same restriction as for
+ *       \ref t8_forest_set_ghost applies: The commit aborts if a local
+ *       tree shares a face with a tree of a different element class.
+ */
 void                t8_forest_set_balance (t8_forest_t forest,
                                            int do_balance);
+
+/** Enable or disable the creation of a layer of ghost elements.
+ * On commit, each process receives copies of all remote leaf elements
+ * that share a face with one of its local leaf elements.
+ * \param [in, out] forest   The forest.
+ * \param [in]      do_ghost If non-zero, a ghost layer will be created.
+ * \note Ghosts across trees of different element classes are not
+ *       supported. The commit aborts if a local tree shares a face with
+ *       a tree of a different element class.
+ */
 void                t8_forest_set_ghost (t8_forest_t forest, int do_ghost);
 
-/* TODO: use assertions and document that the forest_set (..., from) and
- *       set_load are mutually exclusive. */
+/** Load the elements of a forest from a file written by \ref t8_forest_save.
+ * The file can be loaded on a different number of processes than it was
+ * saved with. On commit, each process reads an equally sized range of
+ * the elements in the order of the space filling curve.
+ * This is mutually exclusive with \ref t8_forest_set_copy,
+ * \ref t8_forest_set_adapt and \ref t8_forest_set_partition.
+ * \ref t8_forest_set_mpicomm, \ref t8_forest_set_cmesh and
+ * \ref t8_forest_set_scheme must be called with the same coarse mesh and
+ * scheme that the saved forest used.
+ * \param [in, out] forest   The forest.
+ * \param [in]      filename The name of the file.
+ */
 void                t8_forest_set_load (t8_forest_t forest,
                                         const char *filename);
 
 /** Compute the global number of elements in a forest as the sum
  *  of the local element counts.
+ *  The element offsets of all processes and the global index of the
+ *  first local element are computed by the same collective call.
  *  \param [in] forest    The forest.
  */
 void                t8_forest_comm_global_num_elements (t8_forest_t forest);
@@ -237,6 +492,52 @@ void                t8_forest_commit (t8_forest_t forest);
 
 t8_locidx_t         t8_forest_get_num_element (t8_forest_t forest);
 
+/** Return the number of ghost elements of a forest.
+ * \param [in]      forest   A committed forest.
+ * \return                   The number of ghost elements stored in \a forest.
+ *                            0 if no ghost layer was created.
+ * \see t8_forest_set_ghost
+ */
+t8_locidx_t         t8_forest_get_num_ghosts (t8_forest_t forest);
+
+/** Begin to exchange per element data of the ghost elements of a forest.
+ * Each process sends the data of its local elements that are ghosts of
+ * a remote process and receives the data of its own ghost elements.
+ * The data of the local elements is sent directly from \a element_data
+ * and the data of the ghosts is received directly into it, thus no
+ * additional buffers are allocated.
+ * \param [in]      forest   A committed forest with a ghost layer.
+ * \param [in,out]  element_data An array of fixed size entries, one for each
+ *                            local element in the order of the forest's leaves,
+ *                            followed by one for each ghost element.
+ *                            On output of \ref t8_forest_ghost_exchange_end the
+ *                            ghost entries are filled with the remote data.
+ *                            Must not be modified or resized until then.
+ * \return                   The state of the exchange, that must be passed
+ *                            to \ref t8_forest_ghost_exchange_end.
+ */
+t8_forest_ghost_exchange_t t8_forest_ghost_exchange_begin (t8_forest_t
+                                                           forest,
+                                                           sc_array_t *
+                                                           element_data);
+
+/** Complete an exchange of ghost data that was started with
+ * \ref t8_forest_ghost_exchange_begin.
+ * \param [in,out]  pexchange On input the state of the exchange,
+ *                            on output NULL.
+ */
+void                t8_forest_ghost_exchange_end (t8_forest_ghost_exchange_t
+                                                  * pexchange);
+
+/** Exchange per element data of the ghost elements of a forest.
+ * This is the blocking version of \ref t8_forest_ghost_exchange_begin
+ * followed by \ref t8_forest_ghost_exchange_end.
+ * \param [in]      forest   A committed forest with a ghost layer.
+ * \param [in,out]  element_data As in \ref t8_forest_ghost_exchange_begin.
+ */
+void                t8_forest_ghost_exchange_data (t8_forest_t forest,
+                                                   sc_array_t * element_data);
+
 /** Return the element class of a forest local tree.
  *  \param [in] forest    The forest.
  *  \param [in] ltreeid   The local id of a tree in the forest.
@@ -305,6 +606,21 @@ t8_locidx_t         t8_forest_get_num_local_trees (t8_forest_t forest);
 t8_tree_t           t8_forest_get_tree (t8_forest_t forest,
                                         t8_locidx_t ltree_id);
 
+/** Return a local element of a forest by its local index.
+ * The tree of the element is found by a binary search over the tree
+ * offsets. For forests with many small trees, the tree of each element
+ * is stored on commit and the element is found in constant time.
+ * \param [in]      forest      A committed forest.
+ * \param [in]      lelement_id The local index of an element,
+ *                              0 <= \a lelement_id < number of local elements.
+ * \param [out]     ltreeid     If not NULL, the local id of the tree of the
+ *                              element on output.
+ * \return                      A pointer to the element.
+ */
+t8_element_t       *t8_forest_get_element (t8_forest_t forest,
+                                           t8_locidx_t lelement_id,
+                                           t8_locidx_t * ltreeid);
+
 /** Return a cmesh associated to a forest.
  * \param [in]      forest      The forest.
  * \a forest must be committed before calling this function.
@@ -318,20 +634,162 @@ t8_cmesh_t          t8_forest_get_cmesh (t8_forest_t forest);
  */
 t8_locidx_t         t8_forest_get_tree_element_count (t8_tree_t tree);
 
-/** Compute the global index of the first local element of a forest.
- * This function is collective.
- * \param [in]     forest       A committed forest, whose first element's index is computed.
+/** Return the global index of the first local element of a forest.
+ * The index is computed on commit, thus this function does not communicate.
+ * \param [in]     forest       A committed forest.
  * \return         The global index of \a forest's first local element.
- * Forest must be committed when calling this function.
- * This function is collective and must be called on each process.
  */
 t8_gloidx_t         t8_forest_get_first_local_element_id (t8_forest_t forest);
 
-void                t8_forest_save (t8_forest_t forest);
+/** Find the process that owns an element of a forest.
+ * This is a binary search over the element offsets of the processes,
+ * which are computed on commit.
+ * \param [in]     forest       A committed forest.
+ * \param [in]     gelement_id  The global index of an element,
+ *                              0 <= \a gelement_id < global number of elements.
+ * \return         The rank of the process that owns the element.
+ */
+int                 t8_forest_element_find_owner (t8_forest_t forest,
+                                                  t8_gloidx_t gelement_id);
+
+/** Save the elements of a forest to a file.
+ * All processes write their local elements into the same binary file
+ * at the position given by their element offsets, using collective MPI-IO
+ * if available. The forest can be loaded with \ref t8_forest_set_load.
+ * The file format depends on the element implementation and the
+ * endianness of the machine.
+ * This function is collective.
+ * \param [in] forest      A committed forest.
+ * \param [in] filename    The name of the file.
+ * \return                 True on success, false if an error occurred.
+ */
+int                 t8_forest_save (t8_forest_t forest, const char *filename);
+
+/** Register a data field with a fixed number of bytes per local element.
+ * The forest owns the data. When a forest is derived from \a forest by
+ * adaptation or by partition, it gets the same fields.
+ * On adaptation, the data of unchanged elements is copied and
+ * \a interpolate_fn is called for the refined and coarsened elements.
+ * On partition, the data is sent along with the elements.
+ * The data also follows the refinements of a 2:1 balance.
+ * \param [in,out] forest    A committed forest.
+ * \param [in] data_size     The number of bytes per element. Must be positive.
+ * \param [in] interpolate_fn The function that sets the data of new elements.
+ * \return                   The index of the new field. The data is
+ *                           initialized to zero.
+ * \see t8_forest_get_element_data
+ */
+int                 t8_forest_register_element_data (t8_forest_t forest,
+                                                     size_t data_size,
+                                                     t8_forest_interpolate_t
+                                                     interpolate_fn);
+
+/** Return the number of data fields registered with a forest.
+ * \param [in] forest      A committed forest.
+ * \return                 The number of fields.
+ */
+int                 t8_forest_get_num_element_data (t8_forest_t forest);
+
+/** Return the data of a registered field.
+ * \param [in] forest      A committed forest.
+ * \param [in] field       The index of a field returned by
+ *                         \ref t8_forest_register_element_data.
+ * \return                 The data of the local elements, \a data_size
+ *                         bytes per element in local element order.
+ */
+void               *t8_forest_get_element_data (t8_forest_t forest,
+                                                int field);
+
+/** Compute the coordinates of a vertex of an element in a forest.
+ * The coordinates are interpolated from the vertices of the element's tree.
+ * \param [in] forest      A committed forest.
+ * \param [in] ltree_id    The local id of the tree of \a element.
+ * \param [in] element     An element of the tree \a ltree_id.
+ * \param [in] vertices    The vertex coordinates of the tree, as stored
+ *                         in the coarse mesh.
+ * \param [in] corner_number The number of the vertex of \a element.
+ * \param [out] coordinates An array of 3 doubles, filled with the
+ *                         coordinates of the vertex.
+ */
+void                t8_forest_element_coordinate (t8_forest_t forest,
+                                                  t8_locidx_t ltree_id,
+                                                  const t8_element_t *
+                                                  element,
+                                                  const double *vertices,
+                                                  int corner_number,
+                                                  double *coordinates);
+
+/** Write the leaf elements of a forest in the parallel vtu format.
+ * Each process writes the file \a fileprefix_RANK.vtu with its local
+ * elements and process 0 writes the file \a fileprefix.pvtu.
+ * The data is written in binary (base64) format with the level, tree
+ * and process of each element.
+ * This function is collective.
+ * \param [in] forest      A committed forest.
+ * \param [in] filename    The prefix of the output files.
+ * \see t8_forest_write_vtk_ext
+ */
 void                t8_forest_write_vtk (t8_forest_t forest,
                                          const char *filename);
 
-void                t8_forest_iterate (t8_forest_t forest);
+/** Write the leaf elements of a forest in the parallel vtu format.
+ * This function is collective.
+ * \param [in] forest      A committed forest.
+ * \param [in] fileprefix  The prefix of the output files.
+ * \param [in] write_level If true, the level of each element is written.
+ * \param [in] write_tree  If true, the global tree id of each element is written.
+ * \param [in] write_rank  If true, the process of each element is written.
+ * \param [in] do_compress If true, the data is compressed with zlib.
+ *                         If zlib is not available, this is ignored.
+ * \return                 0 on success, nonzero if an error occured.
+ */
+int                 t8_forest_write_vtk_ext (t8_forest_t forest,
+                                             const char *fileprefix,
+                                             int write_level, int write_tree,
+                                             int write_rank, int do_compress);
+
+/** Iterate top-down over the leaf elements of each local tree of a forest.
+ * Starting with the nearest common ancestor of the tree's leaves, the
+ * leaves are recursively split along the space filling curve into the
+ * children of the current element, and \a iterate_fn is called for each
+ * inner element and each leaf. The leaves of each tree are traversed in
+ * memory order and whole subtrees can be skipped.
+ * \param [in] forest      A committed forest.
+ * \param [in] iterate_fn  The callback that is called for each inner and
+ *                         leaf element.
+ */
+void                t8_forest_iterate (t8_forest_t forest,
+                                       t8_forest_iterate_fn iterate_fn);
+
+/** Search a batch of queries in the local trees of a forest.
+ * The elements are traversed top-down as in \ref t8_forest_iterate.
+ * For each element, \a query_fn is called for each query that matched its
+ * parent, and we only descend into elements that match at least one query.
+ * The queries are processed in fixed size batches, which are spatially
+ * coherent if they were sorted with \ref t8_forest_search_sort_queries.
+ * \param [in] forest      A committed forest.
+ * \param [in] search_fn   If not NULL, called for each element before the
+ *                         queries and may skip the element's descendants.
+ * \param [in] query_fn    The callback that matches queries with elements.
+ *                         It is called on the leaves to report results.
+ * \param [in] queries     An array of queries of arbitrary type.
+ */
+void                t8_forest_search (t8_forest_t forest,
+                                      t8_forest_iterate_fn search_fn,
+                                      t8_forest_search_query_fn query_fn,
+                                      sc_array_t * queries);
+
+/** Sort an array of queries by a key, such as the Morton index of points.
+ * Queries with the same key keep their order.
+ * \param [in] forest      A committed forest.
+ * \param [in,out] queries An array of queries of arbitrary type.
+ *                         On output sorted by ascending key.
+ * \param [in] key_fn      Computes the key of a query.
+ */
+void                t8_forest_search_sort_queries (t8_forest_t forest,
+                                                   sc_array_t * queries,
+                                                   t8_forest_search_key_fn
+                                                   key_fn);
 
 /** Increase the reference counter of a forest.
  * \param [in,out] forest       On input, this forest must exist with positive
@@ -25,6 +25,10 @@
 #include <t8_forest.h>
 #include <t8_forest/t8_forest_types.h>
 #include <t8_forest/t8_forest_partition.h>
+#include <t8_forest/t8_forest_ghost.h>
+#include <t8_forest/t8_forest_balance.h>
+#include <t8_forest/t8_forest_save.h>
+#include <t8_forest/t8_forest_data.h>
 #include <t8_cmesh/t8_cmesh_offset.h>
 
 void
@@ -47,6 +51,7 @@ t8_forest_init (t8_forest_t * pforest)
   forest->first_local_tree = -1;
   forest->global_num_elements = -1;
   forest->set_adapt_recursive = -1;
+  forest->set_uniform_coarsen = -1;
 }
 
 int
@@ -159,6 +164,7 @@ t8_forest_set_copy (t8_forest_t forest, const t8_forest_t set_from)
   T8_ASSERT (forest->cmesh == NULL);
   T8_ASSERT (forest->scheme == NULL);
   T8_ASSERT (forest->set_from == NULL);
+  T8_ASSERT (forest->set_load_filename == NULL);
 
   T8_ASSERT (set_from != NULL);
 
@@ -168,7 +174,7 @@ t8_forest_set_copy (t8_forest_t forest, const t8_forest_t set_from)
 
 void
 t8_forest_set_partition (t8_forest_t forest, const t8_forest_t set_from,
-                         int set_for_coarsening)
+                         int set_for_coarsening, t8_forest_weight_t weight_fn)
 {
   T8_ASSERT (forest != NULL);
   T8_ASSERT (forest->rc.refcount > 0);
@@ -177,10 +183,12 @@ t8_forest_set_partition (t8_forest_t forest, const t8_forest_t set_from,
   T8_ASSERT (forest->cmesh == NULL);
   T8_ASSERT (forest->scheme == NULL);
   T8_ASSERT (forest->set_from == NULL);
+  T8_ASSERT (forest->set_load_filename == NULL);
 
   T8_ASSERT (set_from != NULL);
 
   forest->set_for_coarsening = set_for_coarsening;
+  forest->set_weight_fn = weight_fn;
 
   forest->set_from = set_from;
   forest->from_method = T8_FOREST_FROM_PARTITION;
@@ -200,6 +208,8 @@ t8_forest_set_adapt (t8_forest_t forest, const t8_forest_t set_from,
   T8_ASSERT (forest->set_from == NULL);
   T8_ASSERT (forest->set_adapt_fn == NULL);
   T8_ASSERT (forest->set_adapt_recursive == -1);
+  T8_ASSERT (forest->set_adapt_markers == NULL);
+  T8_ASSERT (forest->set_load_filename == NULL);
 
   forest->set_adapt_fn = adapt_fn;
   forest->set_replace_fn = replace_fn;
@@ -208,6 +218,105 @@ t8_forest_set_adapt (t8_forest_t forest, const t8_forest_t set_from,
   forest->from_method = T8_FOREST_FROM_ADAPT;
 }
 
+void
+t8_forest_set_adapt_markers (t8_forest_t forest, const t8_forest_t set_from,
+                             const sc_array_t * markers)
+{
+  T8_ASSERT (forest != NULL);
+  T8_ASSERT (forest->rc.refcount > 0);
+  T8_ASSERT (!forest->committed);
+  T8_ASSERT (forest->mpicomm == sc_MPI_COMM_NULL);
+  T8_ASSERT (forest->cmesh == NULL);
+  T8_ASSERT (forest->scheme == NULL);
+  T8_ASSERT (forest->set_from == NULL);
+  T8_ASSERT (forest->set_adapt_fn == NULL);
+  T8_ASSERT (forest->set_adapt_recursive == -1);
+  T8_ASSERT (forest->set_load_filename == NULL);
+  T8_ASSERT (set_from != NULL && set_from->committed);
+  T8_ASSERT (markers != NULL);
+  T8_ASSERT (markers->elem_size == sizeof (int8_t));
+  T8_ASSERT (markers->elem_count == (size_t) set_from->local_num_elements);
+
+  forest->set_adapt_markers = markers;
+  forest->set_replace_fn = NULL;
+  forest->set_adapt_recursive = 0;
+  forest->set_from = set_from;
+  forest->from_method = T8_FOREST_FROM_ADAPT;
+}
+
+void
+t8_forest_set_uniform_refine (t8_forest_t forest, const t8_forest_t set_from)
+{
+  T8_ASSERT (forest != NULL);
+  T8_ASSERT (forest->rc.refcount > 0);
+  T8_ASSERT (!forest->committed);
+  T8_ASSERT (forest->set_from == NULL);
+  T8_ASSERT (forest->set_adapt_fn == NULL);
+  T8_ASSERT (forest->set_adapt_markers == NULL);
+  T8_ASSERT (forest->set_adapt_recursive == -1);
+  T8_ASSERT (forest->set_load_filename == NULL);
+  T8_ASSERT (set_from != NULL);
+
+  forest->set_uniform_refine = 1;
+  forest->set_replace_fn = NULL;
+  forest->set_adapt_recursive = 0;
+  forest->set_from = set_from;
+  forest->from_method = T8_FOREST_FROM_ADAPT;
+}
+
+void
+t8_forest_set_uniform_coarsen (t8_forest_t forest,
+                               const t8_forest_t set_from, int level)
+{
+  T8_ASSERT (forest != NULL);
+  T8_ASSERT (forest->rc.refcount > 0);
+  T8_ASSERT (!forest->committed);
+  T8_ASSERT (forest->set_from == NULL);
+  T8_ASSERT (forest->set_adapt_fn == NULL);
+  T8_ASSERT (forest->set_adapt_markers == NULL);
+  T8_ASSERT (forest->set_adapt_recursive == -1);
+  T8_ASSERT (forest->set_load_filename == NULL);
+  T8_ASSERT (set_from != NULL);
+  T8_ASSERT (level >= 0);
+
+  forest->set_uniform_coarsen = level;
+  forest->set_replace_fn = NULL;
+  forest->set_adapt_recursive = 0;
+  forest->set_from = set_from;
+  forest->from_method = T8_FOREST_FROM_ADAPT;
+}
+
+void
+t8_forest_set_load (t8_forest_t forest, const char *filename)
+{
+  T8_ASSERT (forest != NULL);
+  T8_ASSERT (forest->rc.refcount > 0);
+  T8_ASSERT (!forest->committed);
+  T8_ASSERT (forest->set_from == NULL);
+  T8_ASSERT (forest->set_load_filename == NULL);
+
+  T8_ASSERT (filename != NULL);
+
+  forest->set_load_filename = T8_ALLOC (char, strlen (filename) + 1);
+  strcpy (forest->set_load_filename, filename);
+}
+
+void
+t8_forest_set_balance (t8_forest_t forest, int do_balance)
+{
+  T8_ASSERT (t8_forest_is_initialized (forest));
+
+  forest->do_balance = do_balance != 0;
+}
+
+void
+t8_forest_set_ghost (t8_forest_t forest, int do_ghost)
+{
+  T8_ASSERT (t8_forest_is_initialized (forest));
+
+  forest->do_ghost = do_ghost != 0;
+}
+
 void
 t8_forest_set_user_data (t8_forest_t forest, void *data)
 {
@@ -218,22 +327,48 @@ t8_forest_set_user_data (t8_forest_t forest, void *data)
 void *
 t8_forest_get_user_data (t8_forest_t forest)
 {
-  T8_ASSERT (t8_forest_is_initialized (forest));
+  /* The iterate and search callbacks read the data of committed forests */
+  T8_ASSERT (t8_forest_is_initialized (forest)
+             || t8_forest_is_committed (forest));
   return forest->user_data;
 }
 
 void
 t8_forest_comm_global_num_elements (t8_forest_t forest)
 {
-  int                 mpiret;
   t8_gloidx_t         local_num_el;
-  t8_gloidx_t         global_num_el;
+  t8_gloidx_t        *offsets;
+  int                 iproc, mpiret;
 
+  if (forest->element_offsets != NULL) {
+    t8_shmem_array_destroy (&forest->element_offsets);
+  }
+  /* Gather the local element counts of all processes and compute their
+   * prefix sum in a local buffer. This gives the element offsets, the
+   * global index of our first element and the global number of elements
+   * at once. The offsets are then copied to the shared array by the
+   * processes that are allowed to write to it. */
+  offsets = T8_ALLOC (t8_gloidx_t, forest->mpisize + 1);
   local_num_el = (t8_gloidx_t) forest->local_num_elements;
-  mpiret = sc_MPI_Allreduce (&local_num_el, &global_num_el, 1,
-                             T8_MPI_GLOIDX, sc_MPI_SUM, forest->mpicomm);
+  mpiret = sc_MPI_Allgather (&local_num_el, 1, T8_MPI_GLOIDX, offsets + 1,
+                             1, T8_MPI_GLOIDX, forest->mpicomm);
   SC_CHECK_MPI (mpiret);
-  forest->global_num_elements = global_num_el;
+  offsets[0] = 0;
+  for (iproc = 1; iproc <= forest->mpisize; iproc++) {
+    offsets[iproc] += offsets[iproc - 1];
+  }
+  forest->global_num_elements = offsets[forest->mpisize];
+  forest->first_local_element = offsets[forest->mpirank];
+
+  sc_shmem_set_type (forest->mpicomm, T8_SHMEM_BEST_TYPE);
+  t8_shmem_array_init (&forest->element_offsets, sizeof (t8_gloidx_t),
+                       forest->mpisize + 1, forest->mpicomm);
+  if (t8_shmem_array_start_writing (forest->element_offsets)) {
+    memcpy (t8_shmem_array_get_gloidx_array (forest->element_offsets),
+            offsets, (forest->mpisize + 1) * sizeof (t8_gloidx_t));
+  }
+  t8_shmem_array_end_writing (forest->element_offsets);
+  T8_FREE (offsets);
 }
 
 /* For each tree in a forest compute its first and last descendant */
@@ -281,9 +416,9 @@ t8_forest_populate (t8_forest_t forest)
   t8_locidx_t         num_tree_elements;
   t8_locidx_t         num_local_trees;
   t8_gloidx_t         jt, first_ctree;
-  t8_gloidx_t         start, end, et;
+  t8_gloidx_t         start, end;
   t8_tree_t           tree;
-  t8_element_t       *element, *element_succ;
+  t8_element_t       *element;
   sc_array_t         *telements;
   t8_eclass_t         tree_class;
   t8_eclass_scheme_t *eclass_scheme;
@@ -338,16 +473,10 @@ t8_forest_populate (t8_forest_t forest)
       sc_array_init_size (telements, t8_element_size (eclass_scheme),
                           num_tree_elements);
       element = (t8_element_t *) t8_sc_array_index_locidx (telements, 0);
-      eclass_scheme->elem_set_linear_id (element, forest->set_level, start);
-      count_elements++;
-      for (et = start + 1; et < end; et++, count_elements++) {
-        element_succ =
-          (t8_element_t *) t8_sc_array_index_locidx (telements, et - start);
-        eclass_scheme->elem_successor (element, element_succ,
-                                       forest->set_level);
-        /* TODO: process elements here */
-        element = element_succ;
-      }
+      /* Construct all elements of this tree in one batch */
+      t8_element_linear_range_threaded (eclass_scheme, forest->set_level,
+                                        start, end, element);
+      count_elements += num_tree_elements;
     }
   }
   forest->local_num_elements = count_elements;
@@ -428,16 +557,18 @@ t8_forest_copy_trees (t8_forest_t forest, t8_forest_t from, int copy_elements)
     tree->eclass = fromtree->eclass;
     eclass_scheme = forest->scheme->eclass_schemes[tree->eclass];
     num_tree_elements = fromtree->elements.elem_count;
-    sc_array_init_size (&tree->elements, t8_element_size (eclass_scheme),
-                        num_tree_elements);
     /* TODO: replace with t8_elem_copy (not existing yet), in order to
      * eventually copy additional pointer data stored in the elements? */
     if (copy_elements) {
+      sc_array_init_size (&tree->elements, t8_element_size (eclass_scheme),
+                          num_tree_elements);
       sc_array_copy (&tree->elements, &fromtree->elements);
       tree->elements_offset = fromtree->elements_offset;
     }
     else {
-      sc_array_truncate (&tree->elements);
+      /* We do not allocate memory here, since the element arrays may be
+       * taken over from the source forest */
+      sc_array_init (&tree->elements, t8_element_size (eclass_scheme));
     }
   }
   forest->first_local_tree = from->first_local_tree;
@@ -452,11 +583,50 @@ t8_forest_copy_trees (t8_forest_t forest, t8_forest_t from, int copy_elements)
   }
 }
 
+/* If the local trees have on average at most this many elements, we
+ * store the tree of each local element to find it in constant time. */
+#define T8_FOREST_ELEMENT_TREE_MAX_AVERAGE 16
+
+/* Store the local tree id of each local element if there are many
+ * small trees. Otherwise, we find the tree by a binary search. */
+static void
+t8_forest_compute_element_tree (t8_forest_t forest)
+{
+  t8_locidx_t         num_trees, itree, ielement, num_elements;
+  t8_tree_t           tree;
+#ifdef T8_ENABLE_DEBUG
+  t8_locidx_t         offset = 0;
+#endif
+
+  T8_ASSERT (forest->element_tree == NULL);
+  num_trees = t8_forest_get_num_local_trees (forest);
+  if (num_trees <= 1 || forest->local_num_elements == 0
+      || forest->local_num_elements >
+      T8_FOREST_ELEMENT_TREE_MAX_AVERAGE * num_trees) {
+    return;
+  }
+  forest->element_tree = T8_ALLOC (t8_locidx_t, forest->local_num_elements);
+  for (itree = 0; itree < num_trees; itree++) {
+    tree = t8_forest_get_tree (forest, itree);
+    num_elements = t8_forest_get_tree_element_count (tree);
+    /* The element offsets must be the running sum of the element counts */
+    T8_ASSERT (tree->elements_offset == offset);
+#ifdef T8_ENABLE_DEBUG
+    offset += num_elements;
+#endif
+    for (ielement = 0; ielement < num_elements; ielement++) {
+      forest->element_tree[tree->elements_offset + ielement] = itree;
+    }
+  }
+  T8_ASSERT (offset == forest->local_num_elements);
+}
+
 void
 t8_forest_commit (t8_forest_t forest)
 {
   int                 mpiret;
   sc_MPI_Comm         comm_dup;
+  t8_forest_t         data_from = NULL;
 
   T8_ASSERT (forest != NULL);
   T8_ASSERT (forest->rc.refcount > 0);
@@ -485,8 +655,14 @@ t8_forest_commit (t8_forest_t forest)
     SC_CHECK_MPI (mpiret);
     mpiret = sc_MPI_Comm_rank (forest->mpicomm, &forest->mpirank);
     SC_CHECK_MPI (mpiret);
-    /* populate a new forest with tree and quadrant objects */
-    t8_forest_populate (forest);
+    if (forest->set_load_filename != NULL) {
+      /* read the elements from a file */
+      t8_forest_load (forest);
+    }
+    else {
+      /* populate a new forest with tree and quadrant objects */
+      t8_forest_populate (forest);
+    }
     forest->global_num_trees = t8_cmesh_get_num_trees (forest->cmesh);
   }
   else {
@@ -527,7 +703,8 @@ t8_forest_commit (t8_forest_t forest)
     /* TODO: currently we can only handle copy, adapt, and partition */
     /* T8_ASSERT (forest->from_method == T8_FOREST_FROM_COPY); */
     if (forest->from_method == T8_FOREST_FROM_ADAPT) {
-      if (forest->set_adapt_fn != NULL) {
+      if (forest->set_adapt_fn != NULL || forest->set_adapt_markers != NULL
+          || forest->set_uniform_refine || forest->set_uniform_coarsen >= 0) {
         t8_forest_copy_trees (forest, forest->set_from, 0);
         t8_forest_adapt (forest);
       }
@@ -538,6 +715,11 @@ t8_forest_commit (t8_forest_t forest)
       forest->trees = sc_array_new (sizeof (t8_tree_struct_t));
       /* partition the forest */
       t8_forest_partition (forest);
+      if (forest->set_from->element_data != NULL) {
+        /* The element data is partitioned once forest is committed */
+        data_from = forest->set_from;
+        t8_forest_ref (data_from);
+      }
     }
 
     /* decrease reference count of input forest, possibly destroying it */
@@ -549,8 +731,34 @@ t8_forest_commit (t8_forest_t forest)
   /* we do not need the set parameters anymore */
   forest->set_level = 0;
   forest->set_for_coarsening = 0;
+  forest->set_weight_fn = NULL;
+  forest->set_adapt_markers = NULL;
+  forest->set_uniform_refine = 0;
+  forest->set_uniform_coarsen = -1;
   forest->set_from = NULL;
+  if (forest->set_load_filename != NULL) {
+    T8_FREE (forest->set_load_filename);
+    forest->set_load_filename = NULL;
+  }
   forest->committed = 1;
+  if (data_from != NULL) {
+    t8_forest_element_data_partition (forest, data_from);
+    t8_forest_unref (&data_from);
+  }
+  if (forest->do_balance) {
+    /* Establish the 2:1 balance, this may already create the ghost layer */
+    t8_forest_balance (forest);
+  }
+  if (forest->do_ghost && forest->ghosts == NULL) {
+    /* Create the ghost layer of the new forest */
+    t8_forest_ghost_create (forest);
+  }
+  if (forest->element_offsets == NULL) {
+    t8_forest_partition_create_offsets (forest);
+  }
+  forest->first_local_element =
+    t8_shmem_array_get_gloidx (forest->element_offsets, forest->mpirank);
+  t8_forest_compute_element_tree (forest);
   t8_debugf ("Committed forest with %li local elements and %lli "
              "global elements.\n\tTree range ist from %lli to %lli.\n",
              (long) forest->local_num_elements,
@@ -570,6 +778,17 @@ t8_forest_get_num_element (t8_forest_t forest)
   return forest->local_num_elements;
 }
 
+t8_locidx_t
+t8_forest_get_num_ghosts (t8_forest_t forest)
+{
+  T8_ASSERT (t8_forest_is_committed (forest));
+
+  if (forest->ghosts == NULL) {
+    return 0;
+  }
+  return forest->ghosts->num_ghosts;
+}
+
 /* Currently this function is not used */
 #if 0
 static t8_element_t *
@@ -661,6 +880,48 @@ t8_forest_get_tree (t8_forest_t forest, t8_locidx_t ltree_id)
   return (t8_tree_t) t8_sc_array_index_locidx (forest->trees, ltree_id);
 }
 
+t8_element_t       *
+t8_forest_get_element (t8_forest_t forest, t8_locidx_t lelement_id,
+                       t8_locidx_t * ltreeid)
+{
+  t8_tree_t           tree;
+  t8_locidx_t         itree, low, high;
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+  T8_ASSERT (0 <= lelement_id && lelement_id < forest->local_num_elements);
+
+  if (forest->element_tree != NULL) {
+    itree = forest->element_tree[lelement_id];
+  }
+  else {
+    /* Find the last tree whose offset is not greater than lelement_id.
+     * Empty trees have the same offset as their successor, thus this
+     * tree is not empty. */
+    low = 0;
+    high = t8_forest_get_num_local_trees (forest) - 1;
+    while (low < high) {
+      itree = low + (high - low + 1) / 2;
+      tree = t8_forest_get_tree (forest, itree);
+      if (tree->elements_offset <= lelement_id) {
+        low = itree;
+      }
+      else {
+        high = itree - 1;
+      }
+    }
+    itree = low;
+  }
+  tree = t8_forest_get_tree (forest, itree);
+  T8_ASSERT (tree->elements_offset <= lelement_id && lelement_id <
+             tree->elements_offset + t8_forest_get_tree_element_count (tree));
+  if (ltreeid != NULL) {
+    *ltreeid = itree;
+  }
+  return (t8_element_t *)
+    t8_sc_array_index_locidx (&tree->elements,
+                              lelement_id - tree->elements_offset);
+}
+
 t8_cmesh_t
 t8_forest_get_cmesh (t8_forest_t forest)
 {
@@ -683,20 +944,38 @@ t8_forest_get_tree_element_count (t8_tree_t tree)
 t8_gloidx_t
 t8_forest_get_first_local_element_id (t8_forest_t forest)
 {
-  t8_gloidx_t         first_element, local_num_elements;
   T8_ASSERT (t8_forest_is_committed (forest));
 
-  /* Convert local_num_elements to t8_gloidx_t */
-  local_num_elements = forest->local_num_elements;
-  /* MPI Scan over local_num_elements lead the global index of the first
-   * local element */
-  sc_MPI_Scan (&local_num_elements, &first_element, 1, T8_MPI_GLOIDX,
-               sc_MPI_SUM, forest->mpicomm);
-  /* MPI_Scan is inklusive, thus it counts our own data.
-   * Therefore, we have to subtract it again */
-  first_element -= local_num_elements;
+  return forest->first_local_element;
+}
+
+int
+t8_forest_element_find_owner (t8_forest_t forest, t8_gloidx_t gelement_id)
+{
+  t8_gloidx_t        *offsets;
+  int                 low, high, mid;
 
-  return first_element;
+  T8_ASSERT (t8_forest_is_committed (forest));
+  T8_ASSERT (forest->element_offsets != NULL);
+  T8_ASSERT (0 <= gelement_id && gelement_id < forest->global_num_elements);
+
+  offsets = t8_shmem_array_get_gloidx_array (forest->element_offsets);
+  /* Find the last process whose offset is not greater than gelement_id.
+   * Empty processes have the same offset as their successor, thus this
+   * process is not empty. */
+  low = 0;
+  high = forest->mpisize - 1;
+  while (low < high) {
+    mid = low + (high - low + 1) / 2;
+    if (offsets[mid] <= gelement_id) {
+      low = mid;
+    }
+    else {
+      high = mid - 1;
+    }
+  }
+  T8_ASSERT (offsets[low] <= gelement_id && gelement_id < offsets[low + 1]);
+  return low;
 }
 
 t8_eclass_t
@@ -717,6 +996,60 @@ t8_forest_ltreeid_to_cmesh_ltreeid (t8_forest_t forest, t8_locidx_t ltreeid)
   return forest->first_local_tree - cmesh_gfirst + ltreeid;
 }
 
+void
+t8_forest_element_coordinate (t8_forest_t forest, t8_locidx_t ltree_id,
+                              const t8_element_t * element,
+                              const double *vertices, int corner_number,
+                              double *coordinates)
+{
+  t8_eclass_t         eclass;
+  t8_eclass_scheme_t *ts;
+  int                 corner_coords[3], i;
+  double              len, x, y, z;
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+  T8_ASSERT (vertices != NULL && coordinates != NULL);
+
+  eclass = t8_forest_get_eclass (forest, ltree_id);
+  ts = forest->scheme->eclass_schemes[eclass];
+  t8_element_vertex_coords (ts, element, corner_number, corner_coords);
+  /* The reference coordinates of the vertex in [0,1]^dim */
+  len = 1. / t8_element_root_len (ts, element);
+  x = corner_coords[0] * len;
+  y = t8_eclass_to_dimension[eclass] > 1 ? corner_coords[1] * len : 0;
+  z = t8_eclass_to_dimension[eclass] > 2 ? corner_coords[2] * len : 0;
+  for (i = 0; i < 3; i++) {
+    switch (eclass) {
+    case T8_ECLASS_TRIANGLE:
+      /* The reference triangle has the vertices (0,0), (1,0), (1,1) */
+      coordinates[i] = vertices[i] + x * (vertices[3 + i] - vertices[i])
+        + y * (vertices[6 + i] - vertices[3 + i]);
+      break;
+    case T8_ECLASS_TET:
+      /* The reference tetrahedron has the vertices
+       * (0,0,0), (1,0,0), (1,0,1), (1,1,1) */
+      coordinates[i] = vertices[i] + x * (vertices[3 + i] - vertices[i])
+        + z * (vertices[6 + i] - vertices[3 + i])
+        + y * (vertices[9 + i] - vertices[6 + i]);
+      break;
+    case T8_ECLASS_QUAD:
+      coordinates[i] = (1 - y) * ((1 - x) * vertices[i] + x * vertices[3 + i])
+        + y * ((1 - x) * vertices[6 + i] + x * vertices[9 + i]);
+      break;
+    case T8_ECLASS_HEX:
+      coordinates[i] =
+        (1 - z) * ((1 - y) * ((1 - x) * vertices[i] + x * vertices[3 + i])
+                   + y * ((1 - x) * vertices[6 + i] + x * vertices[9 + i]))
+        + z * ((1 - y) * ((1 - x) * vertices[12 + i] + x * vertices[15 + i])
+               + y * ((1 - x) * vertices[18 + i] + x * vertices[21 + i]));
+      break;
+    default:
+      SC_ABORT ("Element coordinates are not implemented for this "
+                "element class.\n");
+    }
+  }
+}
+
 void
 t8_forest_set_profiling (t8_forest_t forest, int set_profiling)
 {
@@ -758,6 +1091,16 @@ t8_forest_print_profile (t8_forest_t forest)
                    "forest: Partition runtime.");
     sc_stats_set1 (&stats[5], profile->commit_runtime,
                    "forest: Commit runtime.");
+    sc_stats_set1 (&stats[6], profile->ghosts_bytes_sent,
+                   "forest: Number of bytes sent for ghosts.");
+    sc_stats_set1 (&stats[7], profile->balance_rounds,
+                   "forest: Number of balance rounds.");
+    sc_stats_set1 (&stats[8], profile->balance_bytes_sent,
+                   "forest: Number of bytes sent during balance.");
+    sc_stats_set1 (&stats[9], profile->balance_runtime,
+                   "forest: Balance runtime.");
+    sc_stats_set1 (&stats[10], profile->partition_bytes_local,
+                   "forest: Number of bytes kept local in partition.");
     /* compute stats */
     sc_stats_compute (sc_MPI_COMM_WORLD, T8_PROFILE_NUM_STATS, stats);
     /* print stats */
@@ -770,9 +1113,11 @@ t8_forest_print_profile (t8_forest_t forest)
 void
 t8_forest_write_vtk (t8_forest_t forest, const char *filename)
 {
-  T8_ASSERT (forest != NULL);
-  T8_ASSERT (forest->rc.refcount > 0);
-  T8_ASSERT (forest->committed);
+  T8_ASSERT (t8_forest_is_committed (forest));
+
+  if (t8_forest_write_vtk_ext (forest, filename, 1, 1, 1, 0)) {
+    SC_ABORTF ("Error when writing file %s.pvtu\n", filename);
+  }
 }
 
 /* Iterate through all the trees and free the element memory as well as
@@ -814,9 +1159,13 @@ t8_forest_reset (t8_forest_t * pforest)
       /* in this case we have taken ownership and not released it yet */
       t8_forest_unref (&forest->set_from);
     }
+    if (forest->set_load_filename != NULL) {
+      T8_FREE (forest->set_load_filename);
+    }
   }
   else {
     T8_ASSERT (forest->set_from == NULL);
+    T8_ASSERT (forest->set_load_filename == NULL);
   }
 
   /* undup communicator if necessary */
@@ -840,6 +1189,18 @@ t8_forest_reset (t8_forest_t * pforest)
   if (forest->element_offsets != NULL) {
     t8_shmem_array_destroy (&forest->element_offsets);
   }
+  if (forest->global_first_desc != NULL) {
+    t8_shmem_array_destroy (&forest->global_first_desc);
+  }
+  if (forest->ghosts != NULL) {
+    t8_forest_ghost_destroy (&forest->ghosts);
+  }
+  if (forest->element_data != NULL) {
+    t8_forest_element_data_destroy (&forest->element_data);
+  }
+  if (forest->element_tree != NULL) {
+    T8_FREE (forest->element_tree);
+  }
   if (forest->profile != NULL) {
     T8_FREE (forest->profile);
   }
@@ -23,26 +23,173 @@
 #include <t8_forest/t8_forest_adapt.h>
 #include <t8_forest/t8_forest_types.h>
 #include <t8_forest.h>
+#include <t8_forest/t8_forest_data.h>
+#ifdef T8_ENABLE_OPENMP
+#include <omp.h>
+#endif
+
+/* If we adapt with more than one thread, we split trees with at least
+ * twice this number of elements into chunks that are adapted concurrently. */
+#define T8_FOREST_ADAPT_MIN_CHUNK 4096
+
+/* When refining uniformly in place, the elements are copied in blocks of
+ * this size before their children are computed in one batch. */
+#define T8_FOREST_ADAPT_REFINE_BLOCK 256
+
+/* A tree or a chunk of consecutive elements of a tree to be adapted */
+typedef struct
+{
+  t8_locidx_t         ltreeid;          /* The local tree */
+  t8_locidx_t         first;            /* The index of the first element in the tree */
+  t8_locidx_t         count;            /* The number of elements */
+  int                 is_chunk;         /* True if this is not the whole tree */
+  sc_array_t          output;           /* The adapted elements of a chunk */
+  t8_locidx_t         num_new;          /* The number of adapted elements */
+  t8_locidx_t         offset;           /* The position of the adapted elements in the tree */
+  sc_array_t          remaps;           /* If there is element data, the changed groups of elements
+                                           with indices relative to the task */
+}
+t8_forest_adapt_task_t;
+
+/* The elements of the adapted tree are written to an output array with
+ * write position el_inserted. The entries of the array behind el_inserted
+ * are unused storage.
+ * If the adapt is carried out in place, the array also holds the elements of
+ * the source tree that were not considered yet at its end. The source element
+ * with index i is then stored at position i + shift. Since we never write to
+ * a position of an unconsidered source element, the gap between el_inserted
+ * and the first unconsidered source element is enlarged if needed. */
+typedef struct
+{
+  sc_array_t         *telements;        /* The output array */
+  sc_array_t         *telements_from;   /* The source array, equals telements if in place */
+  t8_locidx_t         num_el_from;      /* The number of source elements */
+  t8_locidx_t         shift;            /* Offset of the source elements in telements */
+  int                 in_place;         /* True if we adapt in place */
+}
+t8_forest_adapt_array_t;
+
+/* Return a pointer to the source element with index el_from. */
+static t8_element_t *
+t8_forest_adapt_array_from (t8_eclass_scheme_t * ts,
+                            t8_forest_adapt_array_t * array,
+                            t8_locidx_t el_from)
+{
+  return t8_element_array_index (ts, array->telements_from,
+                                 el_from + array->shift);
+}
+
+/* Ensure that num_new elements can be written to the output array at
+ * position el_inserted. In place, we must not overwrite the source
+ * elements with index el_considered or larger. If consume_current is true,
+ * the source element el_considered may be overwritten.
+ * This may invalidate all pointers to elements in the array. */
+static void
+t8_forest_adapt_array_reserve (t8_forest_adapt_array_t * array,
+                               t8_locidx_t el_inserted,
+                               t8_locidx_t el_considered,
+                               t8_locidx_t num_new, int consume_current)
+{
+  sc_array_t         *telements = array->telements;
+  t8_locidx_t         gap, grow, num_unread, old_count;
+
+  if (!array->in_place) {
+    if ((size_t) (el_inserted + num_new) > telements->elem_count) {
+      sc_array_resize (telements, el_inserted + num_new);
+    }
+    return;
+  }
+  gap = el_considered + array->shift - el_inserted + (consume_current != 0);
+  if (gap >= num_new) {
+    return;
+  }
+  /* We enlarge the array and move the unconsidered source elements to its
+   * end. We grow by at least a quarter of the array to amortize the moves. */
+  old_count = (t8_locidx_t) telements->elem_count;
+  grow = SC_MAX (num_new - gap, old_count / 4 + 1);
+  num_unread = array->num_el_from - el_considered;
+  sc_array_resize (telements, old_count + grow);
+  memmove (sc_array_index (telements, el_considered + array->shift + grow),
+           sc_array_index (telements, el_considered + array->shift),
+           num_unread * telements->elem_size);
+  array->shift += grow;
+}
+
+/* If remaps is not NULL, record that num_old elements starting at first_old
+ * are replaced by num_new elements starting at first_new. */
+static void
+t8_forest_adapt_push_remap (sc_array_t * remaps, t8_locidx_t first_old,
+                            t8_locidx_t num_old, t8_locidx_t first_new,
+                            t8_locidx_t num_new)
+{
+  t8_forest_element_remap_t *remap;
+
+  if (remaps != NULL) {
+    remap = (t8_forest_element_remap_t *) sc_array_push (remaps);
+    remap->first_old = first_old;
+    remap->num_old = num_old;
+    remap->first_new = first_new;
+    remap->num_new = num_new;
+  }
+}
 
-/* The last inserted element must be the last element of a family. */
+/* If remaps is not NULL, record that the new elements from first_new to
+ * el_new_end - 1 are coarsened recursively into one element. They stem
+ * from the old elements that end before el_old_end and the range must
+ * consist of whole groups of remaps and unchanged elements. The remaps of
+ * these groups are merged into one. */
+static void
+t8_forest_adapt_merge_remaps (sc_array_t * remaps, t8_locidx_t first_new,
+                              t8_locidx_t el_new_end, t8_locidx_t el_old_end)
+{
+  t8_forest_element_remap_t *remap;
+  t8_locidx_t         el_old, el_new;
+  size_t              count;
+
+  if (remaps == NULL) {
+    return;
+  }
+  /* Walk back over the remaps in the range to find the first old element */
+  el_old = el_old_end;
+  el_new = el_new_end;
+  for (count = remaps->elem_count; count > 0; count--) {
+    remap = (t8_forest_element_remap_t *) sc_array_index (remaps, count - 1);
+    if (remap->first_new + remap->num_new <= first_new) {
+      break;
+    }
+    T8_ASSERT (remap->first_new >= first_new);
+    el_old = remap->first_old;
+    el_new = remap->first_new;
+  }
+  el_old -= el_new - first_new;
+  sc_array_resize (remaps, count);
+  t8_forest_adapt_push_remap (remaps, el_old, el_old_end - el_old,
+                              first_new, 1);
+}
+
+/* The last inserted element must be the last element of a family.
+ * The inserted elements stem from the source elements before el_old_end.
+ * If remaps is not NULL, each coarsening is recorded in it. */
 static void
 t8_forest_adapt_coarsen_recursive (t8_forest_t forest, t8_locidx_t ltreeid,
                                    t8_eclass_scheme_t * ts,
                                    sc_array_t * telement,
                                    t8_locidx_t el_coarsen,
                                    t8_locidx_t * el_inserted,
-                                   t8_element_t ** el_buffer)
+                                   t8_element_t ** el_buffer,
+                                   t8_locidx_t el_old_end,
+                                   sc_array_t * remaps)
 {
   t8_element_t       *element;
   t8_element_t       *replace;
   t8_element_t      **fam;
   t8_locidx_t         pos;
   int                 num_children, i, isfamily;
-  /* el_inserted is the index of the last element in telement plus one.
-   * el_coarsen is the index of the first element which could possibly
+  /* el_inserted is the index of the last inserted element in telement plus
+   * one. el_coarsen is the index of the first element which could possibly
    * be coarsened. */
 
-  T8_ASSERT (*el_inserted == (t8_locidx_t) telement->elem_count);
+  T8_ASSERT (*el_inserted <= (t8_locidx_t) telement->elem_count);
   T8_ASSERT (el_coarsen >= 0);
   element = t8_element_array_index (ts, telement, *el_inserted - 1);
   num_children = t8_eclass_num_children[ts->eclass];
@@ -67,8 +214,8 @@ t8_forest_adapt_coarsen_recursive (t8_forest_t forest, t8_locidx_t ltreeid,
     T8_ASSERT (!isfamily || t8_element_is_family (ts, fam));
     if (isfamily && forest->set_adapt_fn (forest, ltreeid, ts, num_children,
                                           fam) < 0) {
+      t8_forest_adapt_merge_remaps (remaps, pos, *el_inserted, el_old_end);
       *el_inserted -= num_children - 1;
-      telement->elem_count = *el_inserted;
       if (forest->set_replace_fn != NULL) {
         t8_element_parent (ts, fam[0], replace);
       }
@@ -94,71 +241,292 @@ t8_forest_adapt_coarsen_recursive (t8_forest_t forest, t8_locidx_t ltreeid,
   }
 }
 
+/* Set the number of elements on the refinement stack. Other than
+ * sc_array_resize, this never shrinks the allocated memory. */
+static void
+t8_forest_adapt_stack_resize (sc_array_t * stack, size_t new_count)
+{
+  if (new_count * stack->elem_size > (size_t) stack->byte_alloc) {
+    sc_array_resize (stack, new_count);
+  }
+  else {
+    stack->elem_count = new_count;
+  }
+}
+
+/* Refine the elements on a stack recursively and append the resulting
+ * leaves to telements. The stack holds elements in reverse SFC order,
+ * such that its last element is the next one to be considered.
+ * A refined element is replaced on the stack by its children, which are
+ * computed directly into the stack storage. Thus, no element is allocated
+ * separately and the stack memory is reused for all refinements of a tree.
+ * el_buffer must provide space for num_children element pointers.
+ */
 static void
 t8_forest_adapt_refine_recursive (t8_forest_t forest, t8_locidx_t ltreeid,
                                   t8_eclass_scheme_t * ts,
-                                  sc_list_t * elem_list,
+                                  sc_array_t * stack,
                                   sc_array_t * telements,
                                   t8_locidx_t * num_inserted,
                                   t8_element_t ** el_buffer)
 {
   t8_element_t       *insert_el;
-  t8_element_t       *el_pop;
+  t8_element_t       *parent;
+  size_t              top;
   int                 num_children;
   int                 ci;
 
-  if (elem_list->elem_count <= 0) {
-    return;
-  }
   num_children = t8_eclass_num_children[ts->eclass];
-  if (forest->set_replace_fn != NULL) {
-    t8_element_new (ts, 1, &el_pop);
-  }
-  while (elem_list->elem_count > 0) {
-    el_buffer[0] = (t8_element_t *) sc_list_pop (elem_list);
+  while (stack->elem_count > 0) {
+    top = stack->elem_count - 1;
+    el_buffer[0] = t8_element_array_index (ts, stack, top);
     if (forest->set_adapt_fn (forest, ltreeid, ts, 1, el_buffer) > 0) {
-      t8_element_new (ts, num_children - 1, el_buffer + 1);
-      if (forest->set_replace_fn != NULL) {
-        t8_element_copy (ts, el_buffer[0], el_pop);
+      /* Keep a copy of the parent behind the space for its children */
+      t8_forest_adapt_stack_resize (stack, top + num_children + 1);
+      parent = t8_element_array_index (ts, stack, top + num_children);
+      t8_element_copy (ts, t8_element_array_index (ts, stack, top), parent);
+      for (ci = 0; ci < num_children; ci++) {
+        el_buffer[ci] = t8_element_array_index (ts, stack,
+                                                top + num_children - 1 - ci);
       }
-      t8_element_children (ts, el_buffer[0], num_children, el_buffer);
+      t8_element_children (ts, parent, num_children, el_buffer);
       if (forest->set_replace_fn != NULL) {
         forest->set_replace_fn (forest, ltreeid, ts, 1,
-                                &el_pop, num_children, el_buffer);
-      }
-      for (ci = num_children - 1; ci >= 0; ci--) {
-        (void) sc_list_prepend (elem_list, el_buffer[ci]);
+                                &parent, num_children, el_buffer);
       }
+      t8_forest_adapt_stack_resize (stack, top + num_children);
     }
     else {
       insert_el = (t8_element_t *) sc_array_push (telements);
       t8_element_copy (ts, el_buffer[0], insert_el);
-      t8_element_destroy (ts, 1, el_buffer);
+      t8_forest_adapt_stack_resize (stack, top);
       (*num_inserted)++;
     }
   }
-  if (forest->set_replace_fn != NULL) {
-    t8_element_destroy (ts, 1, &el_pop);
+}
+
+/* Return the adaptation decision for the source element with index
+ * el_considered from the markers. A negative value is only returned if
+ * the next elements form a family that is completely marked for coarsening.
+ */
+static int
+t8_forest_adapt_marker (t8_eclass_scheme_t * ts,
+                        t8_forest_adapt_array_t * array,
+                        const int8_t * markers, t8_locidx_t el_considered,
+                        size_t num_children)
+{
+  t8_element_t       *element;
+  size_t              zz;
+
+  if (markers[el_considered] >= 0) {
+    return markers[el_considered] > 0;
+  }
+  if (el_considered + (t8_locidx_t) num_children > array->num_el_from) {
+    return 0;
   }
+  for (zz = 0; zz < num_children; zz++) {
+    if (markers[el_considered + zz] >= 0) {
+      return 0;
+    }
+    element = t8_forest_adapt_array_from (ts, array, el_considered + zz);
+    if ((size_t) t8_element_child_id (ts, element) != zz) {
+      return 0;
+    }
+  }
+  return -1;
 }
 
-/* TODO: optimize this when we own forest_from */
-void
-t8_forest_adapt (t8_forest_t forest)
+/* Return true if element is the first leaf of its ancestor of the given
+ * level, i.e. if it and all of its ancestors of a finer level than \a level
+ * have child id zero. In this case, ancestor is set to this ancestor.
+ * Otherwise, ancestor is undefined on output. ancestor may equal element.
+ */
+static int
+t8_forest_adapt_first_in_ancestor (t8_eclass_scheme_t * ts,
+                                   const t8_element_t * element, int level,
+                                   t8_element_t * ancestor)
 {
-  t8_forest_t         forest_from;
-  sc_list_t          *refine_list = NULL;       /* This is only needed when we adapt recursively */
-  sc_array_t         *telements, *telements_from;
-  size_t              tt;
+  T8_ASSERT (t8_element_level (ts, element) > level);
+
+  if (t8_element_child_id (ts, element) != 0) {
+    return 0;
+  }
+  t8_element_parent (ts, element, ancestor);
+  while (t8_element_level (ts, ancestor) > level) {
+    if (t8_element_child_id (ts, ancestor) != 0) {
+      return 0;
+    }
+    t8_element_parent (ts, ancestor, ancestor);
+  }
+  return 1;
+}
+
+/* Refine each element of telements_from once and write the children to
+ * telements, which is resized exactly once. If in_place is true, both
+ * arrays must be the same. Return the number of new elements. */
+static              t8_locidx_t
+t8_forest_adapt_uniform_refine (t8_eclass_scheme_t * ts,
+                                sc_array_t * telements,
+                                sc_array_t * telements_from, int in_place,
+                                sc_array_t * remaps)
+{
+  sc_array_t          scratch;
+  t8_locidx_t         num_el_from, iel, block_first, block_count;
+  int                 num_children;
+
+  T8_ASSERT (!in_place || telements == telements_from);
+
+  num_el_from = (t8_locidx_t) telements_from->elem_count;
+  num_children = t8_eclass_num_children[ts->eclass];
+  sc_array_resize (telements, num_el_from * num_children);
+  if (!in_place) {
+    t8_element_children_array (ts, (t8_element_t *) telements_from->array,
+                               num_el_from, (t8_element_t *)
+                               telements->array);
+  }
+  else {
+    /* We go backwards in blocks, such that the children of a block never
+     * overwrite an element of a smaller block. Since the children of a
+     * block may overwrite the block itself, we refine a copy of it. */
+    sc_array_init_size (&scratch, telements->elem_size,
+                        SC_MIN (num_el_from, T8_FOREST_ADAPT_REFINE_BLOCK));
+    for (block_first = num_el_from; block_first > 0;) {
+      block_count = SC_MIN (block_first, T8_FOREST_ADAPT_REFINE_BLOCK);
+      block_first -= block_count;
+      memcpy (scratch.array,
+              t8_element_array_index (ts, telements_from, block_first),
+              block_count * telements->elem_size);
+      t8_element_children_array (ts, (t8_element_t *) scratch.array,
+                                 block_count,
+                                 t8_element_array_index (ts, telements,
+                                                         block_first *
+                                                         num_children));
+    }
+    sc_array_reset (&scratch);
+  }
+  if (remaps != NULL) {
+    for (iel = 0; iel < num_el_from; iel++) {
+      t8_forest_adapt_push_remap (remaps, iel, 1, iel * num_children,
+                                  num_children);
+    }
+  }
+  return num_el_from * num_children;
+}
+
+/* Replace each element of telements_from that has a level greater than
+ * level by its ancestor of this level and write the result to telements.
+ * An ancestor is only created from its first leaf. If in_place is true,
+ * both arrays must be the same. Otherwise, the new elements are counted
+ * first to allocate telements exactly. Return the number of new elements.
+ */
+static              t8_locidx_t
+t8_forest_adapt_uniform_coarsen (t8_eclass_scheme_t * ts,
+                                 sc_array_t * telements,
+                                 sc_array_t * telements_from, int in_place,
+                                 int level, sc_array_t * remaps)
+{
+  sc_array_t          scratch;
+  t8_element_t       *element, *ancestor;
+  t8_locidx_t         num_el_from, iel, el_inserted;
+  t8_forest_element_remap_t *remap;
+  int                 in_group;
+
+  T8_ASSERT (!in_place || telements == telements_from);
+
+  num_el_from = (t8_locidx_t) telements_from->elem_count;
+  /* The ancestor is computed into a separate element, since it is
+   * undefined if the element is not the first leaf of its ancestor.
+   * This may run in several threads, thus we do not use t8_element_new. */
+  sc_array_init_size (&scratch, telements->elem_size, 1);
+  ancestor = (t8_element_t *) scratch.array;
+  if (!in_place) {
+    el_inserted = 0;
+    for (iel = 0; iel < num_el_from; iel++) {
+      element = t8_element_array_index (ts, telements_from, iel);
+      if (t8_element_level (ts, element) <= level
+          || t8_forest_adapt_first_in_ancestor (ts, element, level,
+                                                ancestor)) {
+        el_inserted++;
+      }
+    }
+    sc_array_resize (telements, el_inserted);
+  }
+  el_inserted = 0;
+  /* True if the previous element was coarsened */
+  in_group = 0;
+  for (iel = 0; iel < num_el_from; iel++) {
+    element = t8_element_array_index (ts, telements_from, iel);
+    /* If in place, we have el_inserted <= iel and thus never overwrite
+     * an element that was not considered yet */
+    if (t8_element_level (ts, element) <= level) {
+      if (!in_place || el_inserted != iel) {
+        t8_element_copy (ts, element,
+                         t8_element_array_index (ts, telements,
+                                                 el_inserted));
+      }
+      el_inserted++;
+      in_group = 0;
+    }
+    else if (t8_forest_adapt_first_in_ancestor (ts, element, level,
+                                                ancestor)) {
+      t8_element_copy (ts, ancestor,
+                       t8_element_array_index (ts, telements, el_inserted));
+      t8_forest_adapt_push_remap (remaps, iel, 1, el_inserted, 1);
+      el_inserted++;
+      in_group = 1;
+    }
+    else if (remaps != NULL) {
+      /* The element belongs to the ancestor of the previous element
+       * or, if there is none, to an ancestor created elsewhere */
+      if (in_group) {
+        remap = (t8_forest_element_remap_t *)
+          sc_array_index (remaps, remaps->elem_count - 1);
+        remap->num_old++;
+      }
+      else {
+        t8_forest_adapt_push_remap (remaps, iel, 1, el_inserted, 0);
+      }
+      in_group = 1;
+    }
+  }
+  sc_array_reset (&scratch);
+  if (in_place) {
+    sc_array_resize (telements, el_inserted);
+  }
+  T8_ASSERT ((size_t) el_inserted == telements->elem_count);
+  return el_inserted;
+}
+
+/* Adapt the elements of telements_from and write the new elements to
+ * telements. If in_place is true, both arrays must be the same.
+ * The elements belong to the local tree ltreeid with scheme tscheme.
+ * If markers is not NULL, it holds one marker per element of
+ * telements_from and replaces the adapt function.
+ * If the forest is to be refined or coarsened uniformly, the
+ * corresponding fast path is used instead.
+ * If remaps is not NULL, the refined and coarsened groups of elements
+ * are recorded in it.
+ * Return the number of new elements. On output, telements holds exactly
+ * these elements. */
+static              t8_locidx_t
+t8_forest_adapt_elements (t8_forest_t forest, t8_locidx_t ltreeid,
+                          t8_eclass_scheme_t * tscheme,
+                          sc_array_t * telements,
+                          sc_array_t * telements_from, int in_place,
+                          const int8_t * markers, sc_array_t * remaps)
+{
+  sc_array_t         *refine_stack = NULL;      /* This is only needed when we adapt recursively */
+  sc_array_t         *refine_scratch = NULL;    /* Recursive refinement output if in place */
+  t8_forest_adapt_array_t array;
   t8_locidx_t         el_considered;
   t8_locidx_t         el_inserted;
   t8_locidx_t         el_coarsen;
   t8_locidx_t         num_el_from;
-  t8_locidx_t         el_offset;
+  t8_locidx_t         num_refined;
+  t8_locidx_t         first_new;
   size_t              num_children, zz;
-  t8_tree_t           tree, tree_from;
-  t8_eclass_scheme_t *tscheme;
-  t8_element_t      **elements, **elements_from, *elpop;
+  t8_element_t       *elements[T8_ECLASS_MAX_CHILDREN];
+  t8_element_t       *elements_from[T8_ECLASS_MAX_CHILDREN];
   int                 refine;
   int                 ci;
   int                 num_elements;
@@ -166,48 +534,56 @@ t8_forest_adapt (t8_forest_t forest)
   int                 is_family;
 #endif
 
-  T8_ASSERT (forest != NULL);
-  T8_ASSERT (forest->set_from != NULL);
-  T8_ASSERT (forest->set_adapt_recursive != -1);
-  T8_ASSERT (forest->from_method == T8_FOREST_FROM_ADAPT);
-
-  forest_from = forest->set_from;
-  t8_global_productionf ("Into t8_forest_adapt from %lld total elements\n",
-                         (long long) forest_from->global_num_elements);
-
-  /* TODO: Allocate memory for the trees of forest.
-   * Will we do this here or in an extra function? */
-  T8_ASSERT (forest->trees->elem_count == forest_from->trees->elem_count);
-
+  if (forest->set_uniform_refine) {
+    return t8_forest_adapt_uniform_refine (tscheme, telements,
+                                           telements_from, in_place, remaps);
+  }
+  if (forest->set_uniform_coarsen >= 0) {
+    return t8_forest_adapt_uniform_coarsen (tscheme, telements,
+                                            telements_from, in_place,
+                                            forest->set_uniform_coarsen,
+                                            remaps);
+  }
   if (forest->set_adapt_recursive) {
-    refine_list = sc_list_new (NULL);
+    refine_stack = sc_array_new (telements->elem_size);
   }
-  forest->local_num_elements = 0;
-  el_offset = 0;
-  for (tt = 0; tt < forest->trees->elem_count; tt++) {
-    tree = (t8_tree_t) t8_sc_array_index_topidx (forest->trees, tt);
-    tree_from = (t8_tree_t) t8_sc_array_index_topidx (forest_from->trees, tt);
-    telements = &tree->elements;
-    telements_from = &tree_from->elements;
-    num_el_from = (t8_locidx_t) telements_from->elem_count;
-    tscheme = forest->scheme->eclass_schemes[tree->eclass];
-    el_considered = 0;
-    el_inserted = 0;
-    el_coarsen = 0;
-    /* TODO: this will generate problems with pyramidal elements */
-    num_children = t8_eclass_num_children[tree->eclass];
-    elements = T8_ALLOC (t8_element_t *, num_children);
-    elements_from = T8_ALLOC (t8_element_t *, num_children);
-    while (el_considered < num_el_from) {
+  num_el_from = (t8_locidx_t) telements_from->elem_count;
+  if (in_place) {
+    T8_ASSERT (telements == telements_from);
+    if (forest->set_adapt_recursive) {
+      refine_scratch = sc_array_new (telements->elem_size);
+    }
+  }
+  else {
+    sc_array_resize (telements, num_el_from);
+  }
+  array.telements = telements;
+  array.telements_from = telements_from;
+  array.num_el_from = num_el_from;
+  array.shift = 0;
+  array.in_place = in_place;
+  el_considered = 0;
+  el_inserted = 0;
+  el_coarsen = 0;
+  /* TODO: this will generate problems with pyramidal elements */
+  num_children = t8_eclass_num_children[tscheme->eclass];
+  T8_ASSERT (num_children <= T8_ECLASS_MAX_CHILDREN);
+  while (el_considered < num_el_from) {
+    if (markers != NULL) {
+      refine = t8_forest_adapt_marker (tscheme, &array, markers,
+                                       el_considered, num_children);
+    }
+    else {
 #ifdef T8_ENABLE_DEBUG
       is_family = 1;
 #endif
       num_elements = num_children;
       for (zz = 0; zz < num_children &&
            el_considered + (t8_locidx_t) zz < num_el_from; zz++) {
-        elements_from[zz] = t8_element_array_index (tscheme, telements_from,
-                                                    el_considered + zz);
-        if ((size_t) t8_element_child_id (tscheme, elements_from[zz]) != zz) {
+        elements_from[zz] = t8_forest_adapt_array_from (tscheme, &array,
+                                                        el_considered + zz);
+        if ((size_t) t8_element_child_id (tscheme, elements_from[zz])
+            != zz) {
           break;
         }
       }
@@ -218,105 +594,379 @@ t8_forest_adapt (t8_forest_t forest)
 #endif
       }
       T8_ASSERT (!is_family || t8_element_is_family (tscheme, elements_from));
-      refine = forest->set_adapt_fn (forest, tt, tscheme, num_elements,
+      refine = forest->set_adapt_fn (forest, ltreeid, tscheme, num_elements,
                                      elements_from);
       T8_ASSERT (is_family || refine >= 0);
-      if (refine > 0) {
-        /* The first element is to be refined */
-        if (forest->set_adapt_recursive) {
-          /* el_coarsen is the index of the first element in the new element
-           * array which could be coarsened recursively.
-           * We can set this here, since a family that emerges from a refinement will never be coarsened */
-          el_coarsen = el_inserted + num_children;
-          t8_element_new (tscheme, num_children, elements);
-          t8_element_children (tscheme, elements_from[0], num_children,
-                               elements);
-          for (ci = num_children - 1; ci >= 0; ci--) {
-            (void) sc_list_prepend (refine_list, elements[ci]);
-          }
-          if (forest->set_replace_fn) {
-            forest->set_replace_fn (forest, tt, tscheme, 1,
-                                    elements_from, num_children, elements);
-          }
-          t8_forest_adapt_refine_recursive (forest, tt, tscheme,
-                                            refine_list,
-                                            telements, &el_inserted,
-                                            elements);
+    }
+    if (refine > 0) {
+      /* The first element is to be refined */
+      if (forest->set_adapt_recursive) {
+        /* el_coarsen is the index of the first element in the new element
+         * array which could be coarsened recursively.
+         * We can set this here, since a family that emerges from a refinement will never be coarsened */
+        el_coarsen = el_inserted + num_children;
+        t8_forest_adapt_stack_resize (refine_stack, num_children);
+        for (ci = 0; ci < (int) num_children; ci++) {
+          elements[ci] = t8_element_array_index (tscheme, refine_stack,
+                                                 num_children - 1 - ci);
+        }
+        t8_element_children (tscheme, elements_from[0], num_children,
+                             elements);
+        if (forest->set_replace_fn) {
+          forest->set_replace_fn (forest, ltreeid, tscheme, 1,
+                                  elements_from, num_children, elements);
+        }
+        first_new = el_inserted;
+        if (in_place) {
+          /* The number of new elements is not known in advance, thus
+           * we collect them in a scratch array first */
+          num_refined = 0;
+          sc_array_truncate (refine_scratch);
+          t8_forest_adapt_refine_recursive (forest, ltreeid, tscheme,
+                                            refine_stack, refine_scratch,
+                                            &num_refined, elements);
+          t8_forest_adapt_array_reserve (&array, el_inserted,
+                                         el_considered, num_refined, 1);
+          memcpy (sc_array_index (telements, el_inserted),
+                  refine_scratch->array,
+                  num_refined * telements->elem_size);
+          el_inserted += num_refined;
         }
         else {
-          /* add the children to the element array of the current tree */
-          (void) sc_array_push_count (telements, num_children);
-          for (zz = 0; zz < num_children; zz++) {
-            elements[zz] = t8_element_array_index (tscheme, telements,
-                                                   el_inserted + zz);
-          }
-          t8_element_children (tscheme, elements_from[0], num_children,
-                               elements);
-          if (forest->set_replace_fn) {
-            forest->set_replace_fn (forest, tt, tscheme, 1,
-                                    elements_from, num_children, elements);
-          }
-          el_inserted += num_children;
+          telements->elem_count = el_inserted;
+          t8_forest_adapt_refine_recursive (forest, ltreeid, tscheme,
+                                            refine_stack,
+                                            telements, &el_inserted,
+                                            elements);
         }
-        el_considered++;
+        t8_forest_adapt_push_remap (remaps, el_considered, 1, first_new,
+                                    el_inserted - first_new);
       }
-      else if (refine < 0) {
-        /* The elements form a family and are to be coarsened */
-        elements[0] = (t8_element_t *) sc_array_push (telements);
-        t8_element_parent (tscheme, elements_from[0], elements[0]);
-        if (forest->set_replace_fn) {
-          forest->set_replace_fn (forest, tt, tscheme, num_children,
-                                  elements_from, 1, elements);
+      else {
+        /* add the children to the element array of the current tree */
+        t8_forest_adapt_array_reserve (&array, el_inserted, el_considered,
+                                       num_children, 0);
+        elements_from[0] = t8_forest_adapt_array_from (tscheme, &array,
+                                                       el_considered);
+        for (zz = 0; zz < num_children; zz++) {
+          elements[zz] = t8_element_array_index (tscheme, telements,
+                                                 el_inserted + zz);
         }
-        el_inserted++;
-        if (forest->set_adapt_recursive) {
-          if ((size_t) t8_element_child_id (tscheme, elements[0])
-              == num_children - 1) {
-            t8_forest_adapt_coarsen_recursive (forest, tt, tscheme,
-                                               telements, el_coarsen,
-                                               &el_inserted, elements);
-          }
+        t8_element_children (tscheme, elements_from[0], num_children,
+                             elements);
+        if (forest->set_replace_fn) {
+          forest->set_replace_fn (forest, ltreeid, tscheme, 1,
+                                  elements_from, num_children, elements);
         }
-        el_considered += num_children;
+        t8_forest_adapt_push_remap (remaps, el_considered, 1, el_inserted,
+                                    num_children);
+        el_inserted += num_children;
       }
-      else {
-        /* The considered elements are neither to be coarsened nor is the first
-         * one to be refined */
-        T8_ASSERT (refine == 0);
-        elements[0] = (t8_element_t *) sc_array_push (telements);
-        t8_element_copy (tscheme, elements_from[0], elements[0]);
-        el_inserted++;
-        if (forest->set_adapt_recursive &&
-            (size_t) t8_element_child_id (tscheme, elements[0])
+      el_considered++;
+    }
+    else if (refine < 0) {
+      /* The elements form a family and are to be coarsened.
+       * We may overwrite the first family member in place, unless the
+       * replace function needs to see it. */
+      t8_forest_adapt_array_reserve (&array, el_inserted, el_considered, 1,
+                                     forest->set_replace_fn == NULL);
+      for (zz = 0; zz < num_children; zz++) {
+        elements_from[zz] = t8_forest_adapt_array_from (tscheme, &array,
+                                                        el_considered + zz);
+      }
+      elements[0] = t8_element_array_index (tscheme, telements,
+                                            el_inserted);
+      t8_element_parent (tscheme, elements_from[0], elements[0]);
+      if (forest->set_replace_fn) {
+        forest->set_replace_fn (forest, ltreeid, tscheme, num_children,
+                                elements_from, 1, elements);
+      }
+      t8_forest_adapt_push_remap (remaps, el_considered, num_children,
+                                  el_inserted, 1);
+      el_inserted++;
+      if (forest->set_adapt_recursive) {
+        if ((size_t) t8_element_child_id (tscheme, elements[0])
             == num_children - 1) {
-          t8_forest_adapt_coarsen_recursive (forest, tt, tscheme,
+          t8_forest_adapt_coarsen_recursive (forest, ltreeid, tscheme,
                                              telements, el_coarsen,
-                                             &el_inserted, elements);
+                                             &el_inserted, elements,
+                                             el_considered + num_children,
+                                             remaps);
         }
-        el_considered++;
       }
+      el_considered += num_children;
     }
-    if (forest->set_adapt_recursive) {
-      while (refine_list->elem_count > 0) {
-        SC_ABORT_NOT_REACHED ();
-        elpop = (t8_element_t *) sc_list_pop (refine_list);
-        elements[0] = (t8_element_t *) sc_array_push (telements);
-        t8_element_copy (tscheme, elpop, elements[0]);
-        t8_element_destroy (tscheme, 1, &elpop);
-        el_inserted++;
+    else {
+      /* The considered elements are neither to be coarsened nor is the first
+       * one to be refined */
+      T8_ASSERT (refine == 0);
+      t8_forest_adapt_array_reserve (&array, el_inserted, el_considered, 1,
+                                     1);
+      elements_from[0] = t8_forest_adapt_array_from (tscheme, &array,
+                                                     el_considered);
+      elements[0] = t8_element_array_index (tscheme, telements,
+                                            el_inserted);
+      if (elements[0] != elements_from[0]) {
+        t8_element_copy (tscheme, elements_from[0], elements[0]);
+      }
+      el_inserted++;
+      if (forest->set_adapt_recursive &&
+          (size_t) t8_element_child_id (tscheme, elements[0])
+          == num_children - 1) {
+        t8_forest_adapt_coarsen_recursive (forest, ltreeid, tscheme,
+                                           telements, el_coarsen,
+                                           &el_inserted, elements,
+                                           el_considered + 1, remaps);
+      }
+      el_considered++;
+    }
+  }
+  sc_array_resize (telements, el_inserted);
+
+  if (refine_stack != NULL) {
+    sc_array_destroy (refine_stack);
+  }
+  if (refine_scratch != NULL) {
+    sc_array_destroy (refine_scratch);
+  }
+  return el_inserted;
+}
+
+void
+t8_forest_adapt (t8_forest_t forest)
+{
+  t8_forest_t         forest_from;
+  sc_array_t          tasks, view, remaps, *task_remaps;
+  t8_forest_adapt_task_t *task;
+  t8_forest_element_remap_t *remap;
+  t8_tree_t           tree, tree_from;
+  t8_eclass_scheme_t *tscheme;
+  t8_locidx_t         ltreeid, num_trees, num_el_from, el_offset;
+  t8_locidx_t         chunk_size, chunk_first, chunk_end;
+  t8_element_t       *element, *ancestor = NULL;
+  const int8_t       *markers;
+  size_t              iremap;
+  int                 in_place, num_threads, num_tasks, itask;
+  int                 with_data;
+
+  T8_ASSERT (forest != NULL);
+  T8_ASSERT (forest->set_from != NULL);
+  T8_ASSERT (forest->set_adapt_recursive != -1);
+  T8_ASSERT (forest->from_method == T8_FOREST_FROM_ADAPT);
+
+  forest_from = forest->set_from;
+  t8_global_productionf ("Into t8_forest_adapt from %lld total elements\n",
+                         (long long) forest_from->global_num_elements);
+
+  /* TODO: Allocate memory for the trees of forest.
+   * Will we do this here or in an extra function? */
+  T8_ASSERT (forest->trees->elem_count == forest_from->trees->elem_count);
+
+  /* If we hold the only reference to forest_from, it is destroyed after
+   * adaptation and we take over its element arrays instead of allocating
+   * new ones. */
+  in_place = forest_from->rc.refcount == 1;
+  with_data = forest_from->element_data != NULL;
+  num_threads = 1;
+#ifdef T8_ENABLE_OPENMP
+  /* Recursive adaptation allocates elements from the scheme's memory pools,
+   * which are not thread-safe. */
+  if (!forest->set_adapt_recursive) {
+    num_threads = omp_get_max_threads ();
+  }
+#endif
+
+  /* Create the tasks. Each tree is one task, unless it is large and we
+   * use more than one thread. Then we split it into chunks of consecutive
+   * elements. A chunk starts at an element with child id zero, such that
+   * no family is split between two chunks. If we coarsen uniformly,
+   * a chunk starts at the first leaf of an ancestor of the target level. */
+  sc_array_init (&tasks, sizeof (t8_forest_adapt_task_t));
+  num_trees = (t8_locidx_t) forest->trees->elem_count;
+  for (ltreeid = 0; ltreeid < num_trees; ltreeid++) {
+    tree_from = t8_forest_get_tree (forest_from, ltreeid);
+    num_el_from = (t8_locidx_t) tree_from->elements.elem_count;
+    tscheme = forest->scheme->eclass_schemes[tree_from->eclass];
+    chunk_size = num_el_from;
+    if (num_threads > 1 && num_el_from >= 2 * T8_FOREST_ADAPT_MIN_CHUNK) {
+      chunk_size = SC_MAX (T8_FOREST_ADAPT_MIN_CHUNK,
+                           (num_el_from + num_threads - 1) / num_threads);
+      if (forest->set_uniform_coarsen >= 0) {
+        t8_element_new (tscheme, 1, &ancestor);
       }
     }
+    chunk_first = 0;
+    do {
+      chunk_end = SC_MIN (chunk_first + chunk_size, num_el_from);
+      while (chunk_end < num_el_from) {
+        element = t8_element_array_index (tscheme, &tree_from->elements,
+                                          chunk_end);
+        if (forest->set_uniform_coarsen >= 0) {
+          if (t8_element_level (tscheme, element) <=
+              forest->set_uniform_coarsen
+              || t8_forest_adapt_first_in_ancestor (tscheme, element,
+                                                    forest->set_uniform_coarsen,
+                                                    ancestor)) {
+            break;
+          }
+        }
+        else if (t8_element_level (tscheme, element) == 0
+                 || t8_element_child_id (tscheme, element) == 0) {
+          break;
+        }
+        chunk_end++;
+      }
+      task = (t8_forest_adapt_task_t *) sc_array_push (&tasks);
+      task->ltreeid = ltreeid;
+      task->first = chunk_first;
+      task->count = chunk_end - chunk_first;
+      task->is_chunk = chunk_first > 0 || chunk_end < num_el_from;
+      task->offset = 0;
+      /* The arrays of the tasks are created here and not by the threads.
+       * A chunk's output is allocated to hold its unchanged elements. */
+      if (task->is_chunk) {
+        sc_array_init_size (&task->output, tree_from->elements.elem_size,
+                            task->count);
+      }
+      if (with_data) {
+        sc_array_init (&task->remaps, sizeof (t8_forest_element_remap_t));
+      }
+      chunk_first = chunk_end;
+    } while (chunk_first < num_el_from);
+    if (ancestor != NULL) {
+      t8_element_destroy (tscheme, 1, &ancestor);
+      ancestor = NULL;
+    }
+  }
+  num_tasks = (int) tasks.elem_count;
+
+  /* Adapt the elements of each task.
+   * A tree that is not split is adapted into its element array,
+   * a chunk into its own output array. The arrays still grow if elements
+   * are refined, which allocates through libsc. Thus configure requires
+   * libsc with thread-safe allocation (--enable-pthread) for OpenMP. */
+#ifdef T8_ENABLE_OPENMP
+#pragma omp parallel for private(task, tree, tree_from, tscheme, view, \
+                                 markers, task_remaps) \
+  schedule(dynamic) if (num_threads > 1)
+#endif
+  for (itask = 0; itask < num_tasks; itask++) {
+    task = (t8_forest_adapt_task_t *) sc_array_index_int (&tasks, itask);
+    tree = t8_forest_get_tree (forest, task->ltreeid);
+    tree_from = t8_forest_get_tree (forest_from, task->ltreeid);
+    tscheme = forest->scheme->eclass_schemes[tree->eclass];
+    markers = NULL;
+    if (forest->set_adapt_markers != NULL) {
+      markers = (const int8_t *) forest->set_adapt_markers->array
+        + tree_from->elements_offset + task->first;
+    }
+    task_remaps = with_data ? &task->remaps : NULL;
+    if (task->is_chunk) {
+      sc_array_init_view (&view, &tree_from->elements, task->first,
+                          task->count);
+      task->num_new =
+        t8_forest_adapt_elements (forest, task->ltreeid, tscheme,
+                                  &task->output, &view, 0, markers,
+                                  task_remaps);
+    }
+    else if (in_place) {
+      /* Take over the element array of the source tree */
+      sc_array_reset (&tree->elements);
+      tree->elements = tree_from->elements;
+      sc_array_init (&tree_from->elements, tree->elements.elem_size);
+      task->num_new =
+        t8_forest_adapt_elements (forest, task->ltreeid, tscheme,
+                                  &tree->elements, &tree->elements, 1,
+                                  markers, task_remaps);
+    }
+    else {
+      task->num_new =
+        t8_forest_adapt_elements (forest, task->ltreeid, tscheme,
+                                  &tree->elements, &tree_from->elements, 0,
+                                  markers, task_remaps);
+    }
+  }
+
+  /* Compute the position of each chunk in its tree by a prefix sum over
+   * the chunk counts and allocate the element arrays of split trees.
+   * All chunks of a tree have been adapted into their own output arrays,
+   * thus we may reuse the source tree's array if we adapt in place. */
+  for (itask = 0; itask < num_tasks; itask++) {
+    task = (t8_forest_adapt_task_t *) sc_array_index_int (&tasks, itask);
+    if (task->is_chunk) {
+      tree = t8_forest_get_tree (forest, task->ltreeid);
+      if (task->first == 0) {
+        if (in_place) {
+          tree_from = t8_forest_get_tree (forest_from, task->ltreeid);
+          sc_array_reset (&tree->elements);
+          tree->elements = tree_from->elements;
+          sc_array_init (&tree_from->elements, tree->elements.elem_size);
+        }
+        sc_array_truncate (&tree->elements);
+      }
+      task->offset = (t8_locidx_t) tree->elements.elem_count;
+      sc_array_resize (&tree->elements, task->offset + task->num_new);
+    }
+  }
+  /* Concatenate the chunks */
+#ifdef T8_ENABLE_OPENMP
+#pragma omp parallel for private(task, tree) if (num_threads > 1)
+#endif
+  for (itask = 0; itask < num_tasks; itask++) {
+    task = (t8_forest_adapt_task_t *) sc_array_index_int (&tasks, itask);
+    if (task->is_chunk) {
+      tree = t8_forest_get_tree (forest, task->ltreeid);
+      if (task->num_new > 0) {
+        memcpy (sc_array_index (&tree->elements, task->offset),
+                task->output.array,
+                task->num_new * tree->elements.elem_size);
+      }
+      sc_array_reset (&task->output);
+    }
+  }
+
+  /* Compute the element offsets of the trees */
+  el_offset = 0;
+  for (ltreeid = 0; ltreeid < num_trees; ltreeid++) {
+    tree = t8_forest_get_tree (forest, ltreeid);
     tree->elements_offset = el_offset;
-    el_offset += el_inserted;
-    forest->local_num_elements += el_inserted;
-    sc_array_resize (telements, el_inserted);
+    el_offset += (t8_locidx_t) tree->elements.elem_count;
+  }
+  forest->local_num_elements = el_offset;
 
-    T8_FREE (elements);
-    T8_FREE (elements_from);
-    /* TODO: compute tree->element_offset */
+  if (with_data) {
+    /* Translate the remaps of the tasks to local element indices and
+     * carry the element data over to the new elements */
+    sc_array_init (&remaps, sizeof (t8_forest_element_remap_t));
+    for (itask = 0; itask < num_tasks; itask++) {
+      task = (t8_forest_adapt_task_t *) sc_array_index_int (&tasks, itask);
+      tree = t8_forest_get_tree (forest, task->ltreeid);
+      tree_from = t8_forest_get_tree (forest_from, task->ltreeid);
+      for (iremap = 0; iremap < task->remaps.elem_count; iremap++) {
+        remap = (t8_forest_element_remap_t *) sc_array_push (&remaps);
+        *remap = *(t8_forest_element_remap_t *)
+          sc_array_index (&task->remaps, iremap);
+        remap->first_old += tree_from->elements_offset + task->first;
+        remap->first_new += tree->elements_offset + task->offset;
+      }
+      sc_array_reset (&task->remaps);
+    }
+    t8_forest_element_data_remap (forest, forest_from->element_data,
+                                  forest_from->local_num_elements, &remaps);
+    sc_array_reset (&remaps);
   }
-  if (forest->set_adapt_recursive) {
-    sc_list_destroy (refine_list);
+  sc_array_reset (&tasks);
+  if (forest->set_uniform_coarsen >= 0 && num_trees > 0
+      && t8_forest_get_tree (forest, 0)->elements.elem_count == 0) {
+    /* All leaves of the first tree belong to ancestors whose first leaf is
+     * on a previous process. We remove the empty tree. */
+    tree = t8_forest_get_tree (forest, 0);
+    sc_array_reset (&tree->elements);
+    memmove (sc_array_index (forest->trees, 0),
+             sc_array_index (forest->trees, 1),
+             (num_trees - 1) * forest->trees->elem_size);
+    sc_array_resize (forest->trees, num_trees - 1);
+    forest->first_local_tree++;
   }
   t8_forest_comm_global_num_elements (forest);
   t8_global_productionf ("Done t8_forest_adapt with %lld total elements\n",
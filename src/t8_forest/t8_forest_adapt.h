@@ -32,7 +32,12 @@
 #include <t8.h>
 #include <t8_forest.h>
 
-/* TODO: comment */
+/** Create the elements of \a forest by adapting the elements of
+ * forest->set_from with forest->set_adapt_fn or forest->set_adapt_markers.
+ * If \a forest holds the only reference to forest->set_from, the element
+ * arrays of forest->set_from are taken over and adapted in place.
+ * \param [in,out] forest  The forest that is currently committed.
+ */
 void                t8_forest_adapt (t8_forest_t forest);
 
 #endif /* !T8_FOREST_ADAPT_H! */
@@ -0,0 +1,425 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <t8_forest/t8_forest_balance.h>
+#include <t8_forest/t8_forest_ghost.h>
+#include <t8_forest/t8_forest_data.h>
+#include <t8_forest/t8_forest_types.h>
+#include <t8_forest.h>
+
+/* Compare two ghost trees by their global id */
+static int
+t8_forest_balance_ghost_tree_compare (const void *a, const void *b)
+{
+  t8_gloidx_t         id_a = (*(t8_ghost_tree_t **) a)->global_id;
+  t8_gloidx_t         id_b = (*(t8_ghost_tree_t **) b)->global_id;
+
+  return id_a < id_b ? -1 : id_a != id_b;
+}
+
+/* Fill an array with pointers to all ghost trees of the forest,
+ * sorted by their global id. Since a tree may have ghosts from different
+ * processes, the same global id can occur several times. */
+static void
+t8_forest_balance_sort_ghost_trees (t8_forest_t forest,
+                                    sc_array_t * ghost_trees)
+{
+  t8_ghost_remote_t  *remote;
+  size_t              iremote, itree;
+
+  sc_array_truncate (ghost_trees);
+  for (iremote = 0; iremote < forest->ghosts->remotes.elem_count; iremote++) {
+    remote = (t8_ghost_remote_t *)
+      sc_array_index (&forest->ghosts->remotes, iremote);
+    for (itree = 0; itree < remote->ghost_trees.elem_count; itree++) {
+      *(t8_ghost_tree_t **) sc_array_push (ghost_trees) =
+        (t8_ghost_tree_t *) sc_array_index (&remote->ghost_trees, itree);
+    }
+  }
+  sc_array_sort (ghost_trees, t8_forest_balance_ghost_tree_compare);
+}
+
+/* Return the linear id of the first descendant of an element at maxlevel.
+ * desc is an allocated element that we use as temporary storage. */
+static              uint64_t
+t8_forest_balance_first_id (t8_eclass_scheme_t * ts,
+                            const t8_element_t * element, t8_element_t * desc)
+{
+  t8_element_first_descendant (ts, element, desc);
+  return t8_element_get_linear_id (ts, desc, t8_element_maxlevel (ts));
+}
+
+/* Return true if an array of leaf elements contains an element of at least
+ * the level of element that lies inside of element.
+ * Since the leaves do not overlap, it suffices to check the first leaf
+ * whose first descendant is not smaller than the one of element. */
+static int
+t8_forest_balance_array_has_leaf_inside (t8_eclass_scheme_t * ts,
+                                         sc_array_t * leaves,
+                                         const t8_element_t * element,
+                                         uint64_t first_id,
+                                         uint64_t last_id,
+                                         t8_element_t * desc)
+{
+  t8_element_t       *leaf;
+  size_t              low, high, mid;
+
+  /* Binary search for the first leaf with first descendant >= first_id */
+  low = 0;
+  high = leaves->elem_count;
+  while (low < high) {
+    mid = low + (high - low) / 2;
+    leaf = t8_element_array_index (ts, leaves, mid);
+    if (t8_forest_balance_first_id (ts, leaf, desc) < first_id) {
+      low = mid + 1;
+    }
+    else {
+      high = mid;
+    }
+  }
+  if (low == leaves->elem_count) {
+    return 0;
+  }
+  leaf = t8_element_array_index (ts, leaves, low);
+  return t8_forest_balance_first_id (ts, leaf, desc) <= last_id
+    && t8_element_level (ts, leaf) >= t8_element_level (ts, element);
+}
+
+/* Return true if a local or ghost leaf element of at least the level of
+ * element lies inside of element. element belongs to the tree gtreeid. */
+static int
+t8_forest_balance_has_leaf_inside (t8_forest_t forest, t8_gloidx_t gtreeid,
+                                   t8_eclass_scheme_t * ts,
+                                   const t8_element_t * element,
+                                   sc_array_t * ghost_trees,
+                                   t8_element_t * desc)
+{
+  t8_ghost_tree_t    *ghost_tree;
+  uint64_t            first_id, last_id;
+  size_t              low, high, mid;
+
+  first_id = t8_forest_balance_first_id (ts, element, desc);
+  t8_element_last_descendant (ts, element, desc);
+  last_id = t8_element_get_linear_id (ts, desc, t8_element_maxlevel (ts));
+
+  if (forest->first_local_tree <= gtreeid
+      && gtreeid <= forest->last_local_tree) {
+    /* Search the local leaves of this tree */
+    if (t8_forest_balance_array_has_leaf_inside
+        (ts, &t8_forest_get_tree (forest,
+                                  gtreeid - forest->first_local_tree)->
+         elements, element, first_id, last_id, desc)) {
+      return 1;
+    }
+  }
+  /* Binary search for the first ghost tree with id gtreeid */
+  low = 0;
+  high = ghost_trees->elem_count;
+  while (low < high) {
+    mid = low + (high - low) / 2;
+    ghost_tree = *(t8_ghost_tree_t **) sc_array_index (ghost_trees, mid);
+    if (ghost_tree->global_id < gtreeid) {
+      low = mid + 1;
+    }
+    else {
+      high = mid;
+    }
+  }
+  /* Search the ghost leaves of all ghost trees with id gtreeid */
+  for (; low < ghost_trees->elem_count; low++) {
+    ghost_tree = *(t8_ghost_tree_t **) sc_array_index (ghost_trees, low);
+    if (ghost_tree->global_id != gtreeid) {
+      break;
+    }
+    if (t8_forest_balance_array_has_leaf_inside (ts, &ghost_tree->elements,
+                                                 element, first_id, last_id,
+                                                 desc)) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+/* Return true if a local element must be refined, since a leaf of
+ * its level plus two or finer touches one of its faces.
+ * Such a leaf touches the element if and only if it lies inside one of the
+ * grandchildren of the face neighbor that touch the element's face.
+ * neigh, children and grandchildren are allocated elements of which we need
+ * at most the number of face children. */
+static int
+t8_forest_balance_element_unbalanced (t8_forest_t forest, t8_locidx_t ltreeid,
+                                      t8_eclass_scheme_t * ts,
+                                      const t8_element_t * element,
+                                      sc_array_t * ghost_trees,
+                                      t8_element_t * neigh,
+                                      t8_element_t ** children,
+                                      t8_element_t ** grandchildren,
+                                      t8_element_t * desc)
+{
+  t8_gloidx_t         neigh_gtreeid;
+  int                 iface, num_faces, neigh_face, child_face;
+  int                 ichild, num_children, igrand, num_grandchildren;
+
+  if (t8_element_level (ts, element) + 2 > t8_element_maxlevel (ts)) {
+    /* There are no leaves that are two levels finer */
+    return 0;
+  }
+  num_faces = t8_element_num_faces (ts, element);
+  for (iface = 0; iface < num_faces; iface++) {
+    if (!t8_forest_element_face_neighbor (forest, ltreeid, element, iface,
+                                          neigh, &neigh_face,
+                                          &neigh_gtreeid)) {
+      continue;
+    }
+    num_children = t8_element_num_face_children (ts, neigh, neigh_face);
+    t8_element_children_at_face (ts, neigh, neigh_face, children,
+                                 num_children);
+    for (ichild = 0; ichild < num_children; ichild++) {
+      child_face = t8_element_face_child_face (ts, neigh, neigh_face, ichild);
+      num_grandchildren = t8_element_num_face_children (ts, children[ichild],
+                                                        child_face);
+      t8_element_children_at_face (ts, children[ichild], child_face,
+                                   grandchildren, num_grandchildren);
+      for (igrand = 0; igrand < num_grandchildren; igrand++) {
+        if (t8_forest_balance_has_leaf_inside (forest, neigh_gtreeid, ts,
+                                               grandchildren[igrand],
+                                               ghost_trees, desc)) {
+          return 1;
+        }
+      }
+    }
+  }
+  return 0;
+}
+
+/* Refine each local element once that violates the 2:1 balance condition
+ * with respect to the current local and ghost leaves.
+ * new_index has one more entry than the forest has local elements. On
+ * output it holds the new local index of each element or of its first
+ * child, followed by the new number of local elements.
+ * Return the number of refined elements. */
+static t8_locidx_t
+t8_forest_balance_refine_once (t8_forest_t forest, sc_array_t * ghost_trees,
+                               t8_locidx_t * new_index)
+{
+  t8_locidx_t         itree, num_trees, ielement, num_elements;
+  t8_locidx_t         num_refined, el_offset;
+  t8_forest_element_remap_t *remap;
+  t8_tree_t           tree;
+  t8_eclass_scheme_t *ts;
+  t8_element_t       *element, *neigh, *desc;
+  t8_element_t      **children, **grandchildren, **new_elements;
+  sc_array_t          refine, new_leaves, remaps;
+  int                 num_children, max_face_children, ichild;
+
+  num_refined = 0;
+  el_offset = 0;
+  sc_array_init (&refine, sizeof (int8_t));
+  /* If the forest has element data, we record the refined elements */
+  sc_array_init (&remaps, sizeof (t8_forest_element_remap_t));
+  num_trees = t8_forest_get_num_local_trees (forest);
+  for (itree = 0; itree < num_trees; itree++) {
+    tree = t8_forest_get_tree (forest, itree);
+    ts = forest->scheme->eclass_schemes[tree->eclass];
+    num_elements = t8_forest_get_tree_element_count (tree);
+    num_children = t8_eclass_num_children[tree->eclass];
+    /* A face has at most as many children as the element itself */
+    max_face_children = num_children;
+    children = T8_ALLOC (t8_element_t *, max_face_children);
+    grandchildren = T8_ALLOC (t8_element_t *, max_face_children);
+    new_elements = T8_ALLOC (t8_element_t *, num_children);
+    t8_element_new (ts, max_face_children, children);
+    t8_element_new (ts, max_face_children, grandchildren);
+    t8_element_new (ts, 1, &neigh);
+    t8_element_new (ts, 1, &desc);
+
+    /* Decide which elements to refine. We must not change the leaves
+     * of the tree while we are searching them. */
+    sc_array_resize (&refine, num_elements);
+    for (ielement = 0; ielement < num_elements; ielement++) {
+      element = t8_element_array_index (ts, &tree->elements, ielement);
+      *(int8_t *) sc_array_index (&refine, ielement) =
+        t8_forest_balance_element_unbalanced (forest, itree, ts, element,
+                                              ghost_trees, neigh, children,
+                                              grandchildren, desc);
+    }
+
+    /* Build the new leaves of the tree */
+    sc_array_init (&new_leaves, tree->elements.elem_size);
+    for (ielement = 0; ielement < num_elements; ielement++) {
+      element = t8_element_array_index (ts, &tree->elements, ielement);
+      new_index[tree->elements_offset + ielement] =
+        el_offset + (t8_locidx_t) new_leaves.elem_count;
+      if (*(int8_t *) sc_array_index (&refine, ielement)) {
+        (void) sc_array_push_count (&new_leaves, num_children);
+        for (ichild = 0; ichild < num_children; ichild++) {
+          new_elements[ichild] =
+            t8_element_array_index (ts, &new_leaves,
+                                    new_leaves.elem_count - num_children +
+                                    ichild);
+        }
+        t8_element_children (ts, element, num_children, new_elements);
+        if (forest->element_data != NULL) {
+          remap = (t8_forest_element_remap_t *) sc_array_push (&remaps);
+          remap->first_old = tree->elements_offset + ielement;
+          remap->num_old = 1;
+          remap->first_new = el_offset + (t8_locidx_t) new_leaves.elem_count
+            - num_children;
+          remap->num_new = num_children;
+        }
+        num_refined++;
+      }
+      else {
+        t8_element_copy (ts, element,
+                         (t8_element_t *) sc_array_push (&new_leaves));
+      }
+    }
+    sc_array_reset (&tree->elements);
+    tree->elements = new_leaves;
+    tree->elements_offset = el_offset;
+    el_offset += t8_forest_get_tree_element_count (tree);
+
+    t8_element_destroy (ts, max_face_children, children);
+    t8_element_destroy (ts, max_face_children, grandchildren);
+    t8_element_destroy (ts, 1, &neigh);
+    t8_element_destroy (ts, 1, &desc);
+    T8_FREE (children);
+    T8_FREE (grandchildren);
+    T8_FREE (new_elements);
+  }
+  sc_array_reset (&refine);
+  new_index[forest->local_num_elements] = el_offset;
+  if (remaps.elem_count > 0) {
+    num_elements = forest->local_num_elements;
+    forest->local_num_elements = el_offset;
+    t8_forest_element_data_remap (forest, forest->element_data,
+                                  num_elements, &remaps);
+  }
+  sc_array_reset (&remaps);
+  forest->local_num_elements = el_offset;
+  return num_refined;
+}
+
+void
+t8_forest_balance (t8_forest_t forest)
+{
+  sc_array_t          ghost_trees, round_index, step_index;
+  t8_locidx_t         num_refined, *pround, *pstep;
+  t8_locidx_t         ielement, num_elements;
+  int                 local_changed, global_changed, any_changed;
+  int                 ghosts_changed;
+  int                 rounds;
+  size_t              bytes_sent;
+  double              balance_runtime = 0;
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+  T8_ASSERT (forest->ghosts == NULL);
+
+  t8_global_productionf ("Into t8_forest_balance with %lli global elements\n",
+                         (long long) forest->global_num_elements);
+  if (forest->profile != NULL) {
+    balance_runtime = -sc_MPI_Wtime ();
+  }
+
+  /* Refining does not change the first descendants of the processes'
+   * first elements. Thus, we create the ghost layer once and afterwards
+   * only send the new ghosts to the neighboring processes. */
+  t8_forest_ghost_create (forest);
+  bytes_sent = 0;
+  if (forest->profile != NULL) {
+    bytes_sent += forest->profile->ghosts_bytes_sent;
+  }
+  /* The ghost trees stay the same, only their elements change */
+  sc_array_init (&ghost_trees, sizeof (t8_ghost_tree_t *));
+  t8_forest_balance_sort_ghost_trees (forest, &ghost_trees);
+
+  sc_array_init (&round_index, sizeof (t8_locidx_t));
+  sc_array_init (&step_index, sizeof (t8_locidx_t));
+  rounds = 0;
+  any_changed = 0;
+  ghosts_changed = 1;
+  do {
+    /* Ripple the refinement through the local elements until they are
+     * balanced with respect to each other and to the ghosts. If neither
+     * the local elements nor the ghosts changed since the last round,
+     * the local elements are still balanced. */
+    local_changed = 0;
+    if (ghosts_changed) {
+      num_elements = forest->local_num_elements;
+      do {
+        sc_array_resize (&step_index, forest->local_num_elements + 1);
+        pstep = (t8_locidx_t *) step_index.array;
+        num_refined = t8_forest_balance_refine_once (forest, &ghost_trees,
+                                                     pstep);
+        if (num_refined > 0) {
+          /* Map the elements at the start of the round to their first
+           * descendants now */
+          if (!local_changed) {
+            sc_array_copy (&round_index, &step_index);
+          }
+          else {
+            pround = (t8_locidx_t *) round_index.array;
+            for (ielement = 0; ielement <= num_elements; ielement++) {
+              pround[ielement] = pstep[pround[ielement]];
+            }
+          }
+          local_changed = 1;
+        }
+      } while (num_refined > 0);
+    }
+
+    /* Send the new ghosts to the neighboring processes. Whether any
+     * process refined is computed along with this exchange. */
+    ghosts_changed =
+      t8_forest_ghost_update (forest, local_changed ?
+                              (t8_locidx_t *) round_index.array : NULL,
+                              local_changed, &global_changed);
+    if (forest->profile != NULL) {
+      bytes_sent += forest->profile->ghosts_bytes_sent;
+    }
+    any_changed = any_changed || global_changed;
+    rounds++;
+    t8_debugf ("Finished balance round %i\n", rounds);
+  } while (global_changed);
+  sc_array_reset (&ghost_trees);
+  sc_array_reset (&round_index);
+  sc_array_reset (&step_index);
+
+  if (!forest->do_ghost) {
+    t8_forest_ghost_destroy (&forest->ghosts);
+  }
+  if (any_changed) {
+    /* The element offsets of a previous partition are not valid anymore */
+    if (forest->element_offsets != NULL) {
+      t8_shmem_array_destroy (&forest->element_offsets);
+    }
+    t8_forest_comm_global_num_elements (forest);
+  }
+  if (forest->profile != NULL) {
+    forest->profile->balance_rounds = rounds;
+    forest->profile->balance_bytes_sent = bytes_sent;
+    forest->profile->balance_runtime = balance_runtime + sc_MPI_Wtime ();
+  }
+  t8_global_productionf ("Done t8_forest_balance with %lli global elements "
+                         "in %i rounds\n",
+                         (long long) forest->global_num_elements, rounds);
+}
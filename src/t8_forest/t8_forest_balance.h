@@ -0,0 +1,50 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+/** \file t8_forest_balance.h
+ * We define the routine to establish a 2:1 face balance in a forest of trees.
+ */
+
+#ifndef T8_FOREST_BALANCE_H
+#define T8_FOREST_BALANCE_H
+
+#include <t8.h>
+#include <t8_forest.h>
+
+T8_EXTERN_C_BEGIN ();
+
+/** Refine the elements of a committed forest until it is 2:1 face balanced,
+ * i.e. the levels of two leaf elements sharing a face differ by at most one.
+ * This holds across tree and process boundaries.
+ * The ghost layer is created once. In each round we refine locally until
+ * the local elements are balanced and then send only the changed ghosts
+ * to the neighboring processes, see \ref t8_forest_ghost_update.
+ * This function is collective.
+ * \param [in,out] forest  A committed forest without ghost layer.
+ *                         On output the balanced forest with a valid ghost
+ *                         layer if forest->do_ghost is true.
+ */
+void                t8_forest_balance (t8_forest_t forest);
+
+T8_EXTERN_C_END ();
+
+#endif /* !T8_FOREST_BALANCE_H! */
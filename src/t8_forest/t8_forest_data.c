@@ -0,0 +1,180 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+/** \file t8_forest_data.c
+ *
+ * We define the routines that manage the registered element data of a
+ * forest and carry it over to forests with changed elements.
+ */
+
+#include <t8_forest/t8_forest_types.h>
+#include <t8_forest/t8_forest_data.h>
+
+int
+t8_forest_register_element_data (t8_forest_t forest, size_t data_size,
+                                 t8_forest_interpolate_t interpolate_fn)
+{
+  t8_forest_element_data_t *field;
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+  T8_ASSERT (data_size > 0);
+  T8_ASSERT (interpolate_fn != NULL);
+
+  if (forest->element_data == NULL) {
+    forest->element_data = sc_array_new (sizeof (t8_forest_element_data_t));
+  }
+  field = (t8_forest_element_data_t *) sc_array_push (forest->element_data);
+  field->data_size = data_size;
+  field->interpolate_fn = interpolate_fn;
+  sc_array_init_size (&field->data, data_size, forest->local_num_elements);
+  if (forest->local_num_elements > 0) {
+    memset (field->data.array, 0, forest->local_num_elements * data_size);
+  }
+  return (int) forest->element_data->elem_count - 1;
+}
+
+int
+t8_forest_get_num_element_data (t8_forest_t forest)
+{
+  T8_ASSERT (t8_forest_is_committed (forest));
+
+  if (forest->element_data == NULL) {
+    return 0;
+  }
+  return (int) forest->element_data->elem_count;
+}
+
+void               *
+t8_forest_get_element_data (t8_forest_t forest, int field)
+{
+  T8_ASSERT (t8_forest_is_committed (forest));
+  T8_ASSERT (0 <= field && field < t8_forest_get_num_element_data (forest));
+
+  return ((t8_forest_element_data_t *)
+          sc_array_index_int (forest->element_data, field))->data.array;
+}
+
+void
+t8_forest_element_data_remap (t8_forest_t forest, sc_array_t * fields_from,
+                              t8_locidx_t num_old, const sc_array_t * remaps)
+{
+  sc_array_t         *fields;
+  t8_forest_element_data_t *field, *field_from;
+  const t8_forest_element_remap_t *remap;
+  t8_locidx_t         el_old, el_new, num_copy;
+  size_t              ifield, iremap;
+
+  T8_ASSERT (fields_from != NULL);
+  T8_ASSERT (remaps->elem_size == sizeof (t8_forest_element_remap_t));
+
+  fields = sc_array_new_size (sizeof (t8_forest_element_data_t),
+                              fields_from->elem_count);
+  for (ifield = 0; ifield < fields_from->elem_count; ifield++) {
+    field_from = (t8_forest_element_data_t *)
+      sc_array_index (fields_from, ifield);
+    field = (t8_forest_element_data_t *) sc_array_index (fields, ifield);
+    field->data_size = field_from->data_size;
+    field->interpolate_fn = field_from->interpolate_fn;
+    sc_array_init_size (&field->data, field->data_size,
+                        forest->local_num_elements);
+    /* Copy the data of the unchanged elements between the remaps.
+     * Since they are unchanged, these ranges have the same length in
+     * the old and in the new elements. */
+    el_old = el_new = 0;
+    for (iremap = 0; iremap <= remaps->elem_count; iremap++) {
+      if (iremap < remaps->elem_count) {
+        remap = (const t8_forest_element_remap_t *) remaps->array + iremap;
+        num_copy = remap->first_old - el_old;
+        T8_ASSERT (remap->first_new - el_new == num_copy);
+      }
+      else {
+        remap = NULL;
+        num_copy = num_old - el_old;
+        T8_ASSERT (forest->local_num_elements - el_new == num_copy);
+      }
+      T8_ASSERT (num_copy >= 0);
+      if (num_copy > 0) {
+        memcpy (sc_array_index (&field->data, el_new),
+                sc_array_index (&field_from->data, el_old),
+                num_copy * field->data_size);
+      }
+      if (remap != NULL) {
+        el_old = remap->first_old + remap->num_old;
+        el_new = remap->first_new + remap->num_new;
+      }
+    }
+    if (remaps->elem_count > 0) {
+      field->interpolate_fn (forest, field->data_size, remaps->elem_count,
+                             (const t8_forest_element_remap_t *)
+                             remaps->array, field_from->data.array,
+                             field->data.array);
+    }
+  }
+  if (forest->element_data == fields_from) {
+    t8_forest_element_data_destroy (&forest->element_data);
+  }
+  T8_ASSERT (forest->element_data == NULL);
+  forest->element_data = fields;
+}
+
+void
+t8_forest_element_data_partition (t8_forest_t forest,
+                                  t8_forest_t forest_from)
+{
+  t8_forest_element_data_t *field, *field_from;
+  size_t              ifield;
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+  T8_ASSERT (forest->element_data == NULL);
+  T8_ASSERT (forest_from->element_data != NULL);
+
+  forest->element_data =
+    sc_array_new_size (sizeof (t8_forest_element_data_t),
+                       forest_from->element_data->elem_count);
+  for (ifield = 0; ifield < forest_from->element_data->elem_count; ifield++) {
+    field_from = (t8_forest_element_data_t *)
+      sc_array_index (forest_from->element_data, ifield);
+    field = (t8_forest_element_data_t *)
+      sc_array_index (forest->element_data, ifield);
+    field->data_size = field_from->data_size;
+    field->interpolate_fn = field_from->interpolate_fn;
+    sc_array_init (&field->data, field->data_size);
+    t8_forest_partition_data (forest_from, forest, &field_from->data,
+                              &field->data);
+  }
+}
+
+void
+t8_forest_element_data_destroy (sc_array_t ** pfields)
+{
+  sc_array_t         *fields;
+  size_t              ifield;
+
+  T8_ASSERT (pfields != NULL && *pfields != NULL);
+  fields = *pfields;
+  for (ifield = 0; ifield < fields->elem_count; ifield++) {
+    sc_array_reset (&((t8_forest_element_data_t *)
+                      sc_array_index (fields, ifield))->data);
+  }
+  sc_array_destroy (fields);
+  *pfields = NULL;
+}
@@ -0,0 +1,70 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+/** \file t8_forest_data.h
+ * We define routines to carry the registered element data of a forest
+ * over to a new forest when the elements change.
+ */
+
+#ifndef T8_FOREST_DATA_H
+#define T8_FOREST_DATA_H
+
+#include <t8.h>
+#include <t8_forest.h>
+
+T8_EXTERN_C_BEGIN ();
+
+/** Create the element data of a forest from the data of the elements it
+ * was derived from. The data of elements that are not part of a remap is
+ * copied and the interpolation function of each field is called for the
+ * remaps.
+ * \param [in,out] forest   The forest with the new elements. Its
+ *                          local_num_elements entry must be set.
+ * \param [in] fields_from  The fields of the old elements. This may be
+ *                          the element_data of \a forest itself. In this
+ *                          case, the old fields are destroyed.
+ * \param [in] num_old      The number of old elements.
+ * \param [in] remaps       The changed groups of elements of type
+ *                          \ref t8_forest_element_remap_t, ordered by
+ *                          their element indices.
+ */
+void                t8_forest_element_data_remap (t8_forest_t forest,
+                                                  sc_array_t * fields_from,
+                                                  t8_locidx_t num_old,
+                                                  const sc_array_t * remaps);
+
+/** Transfer the element data of a forest to its repartition.
+ * \param [in,out] forest   The committed partitioned forest.
+ * \param [in] forest_from  The forest that \a forest was partitioned from.
+ */
+void                t8_forest_element_data_partition (t8_forest_t forest,
+                                                      t8_forest_t
+                                                      forest_from);
+
+/** Free the element data fields of a forest.
+ * \param [in,out] pfields  The fields. Set to NULL on output.
+ */
+void                t8_forest_element_data_destroy (sc_array_t ** pfields);
+
+T8_EXTERN_C_END ();
+
+#endif /* !T8_FOREST_DATA_H */
@@ -0,0 +1,1078 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <t8_forest/t8_forest_ghost.h>
+#include <t8_forest/t8_forest_types.h>
+#include <t8_forest/t8_forest_partition.h>
+#include <t8_cmesh/t8_cmesh_trees.h>
+#include <t8_cmesh/t8_cmesh_types.h>
+#include <t8_forest.h>
+
+/* For each tree that we send ghost elements from to another
+ * process, we send this information in front of the elements */
+typedef struct
+{
+  t8_gloidx_t         gtree_id; /* The global id of that tree */
+  t8_eclass_t         eclass;   /* The element class of that tree */
+  t8_locidx_t         num_elements;     /* The number of elements from this tree that were sent */
+} t8_forest_ghost_tree_info_t;
+
+/* A local element that is a ghost element of a remote process */
+typedef struct
+{
+  int                 rank;     /* The remote process */
+  t8_locidx_t         ltree_id; /* The local tree of the element */
+  t8_locidx_t         element_index;    /* The index of the element in its tree */
+} t8_forest_ghost_mirror_t;
+
+/* Compare two mirror entries by rank, tree and element index */
+static int
+t8_forest_ghost_mirror_compare (const void *a, const void *b)
+{
+  const t8_forest_ghost_mirror_t *mirror_a = (const t8_forest_ghost_mirror_t *) a;
+  const t8_forest_ghost_mirror_t *mirror_b = (const t8_forest_ghost_mirror_t *) b;
+
+  if (mirror_a->rank != mirror_b->rank) {
+    return mirror_a->rank < mirror_b->rank ? -1 : 1;
+  }
+  if (mirror_a->ltree_id != mirror_b->ltree_id) {
+    return mirror_a->ltree_id < mirror_b->ltree_id ? -1 : 1;
+  }
+  return mirror_a->element_index < mirror_b->element_index ? -1 :
+    mirror_a->element_index != mirror_b->element_index;
+}
+
+/* Add the owners of all leaf elements that touch a given face of an element
+ * to an array of ranks. The element does not need to be a leaf itself.
+ * Since we add the owners in the order of the space filling curve, the
+ * array stays sorted and we only need to check its last entry for
+ * duplicates.
+ * desc is an allocated element that we use as temporary storage. */
+static void
+t8_forest_ghost_face_owners (t8_forest_t forest, t8_gloidx_t gtreeid,
+                             t8_eclass_scheme_t * ts,
+                             const t8_element_t * element, int face,
+                             t8_element_t * desc, sc_array_t * owners)
+{
+  t8_element_t      **children;
+  uint64_t            desc_id;
+  int                 maxlevel, owner_first, owner_last;
+  int                 num_children, ichild, child_face;
+
+  maxlevel = t8_element_maxlevel (ts);
+  /* Compute the owners of the first and last descendant of element */
+  t8_element_first_descendant (ts, element, desc);
+  desc_id = t8_element_get_linear_id (ts, desc, maxlevel);
+  owner_first = t8_forest_partition_find_owner (forest, gtreeid, desc_id);
+  t8_element_last_descendant (ts, element, desc);
+  desc_id = t8_element_get_linear_id (ts, desc, maxlevel);
+  owner_last = t8_forest_partition_find_owner (forest, gtreeid, desc_id);
+
+  if (owner_first == owner_last) {
+    /* All leaves inside of element belong to the same process */
+    if (owners->elem_count == 0 ||
+        *(int *) sc_array_index (owners, owners->elem_count - 1)
+        != owner_first) {
+      *(int *) sc_array_push (owners) = owner_first;
+    }
+    return;
+  }
+  /* The leaves inside of element are distributed among several processes.
+   * We continue with the children of element at the face. */
+  T8_ASSERT (t8_element_level (ts, element) < maxlevel);
+  num_children = t8_element_num_face_children (ts, element, face);
+  children = T8_ALLOC (t8_element_t *, num_children);
+  t8_element_new (ts, num_children, children);
+  t8_element_children_at_face (ts, element, face, children, num_children);
+  for (ichild = 0; ichild < num_children; ichild++) {
+    child_face = t8_element_face_child_face (ts, element, face, ichild);
+    t8_forest_ghost_face_owners (forest, gtreeid, ts, children[ichild],
+                                 child_face, desc, owners);
+  }
+  t8_element_destroy (ts, num_children, children);
+  T8_FREE (children);
+}
+
+/* Return the element class of a local or ghost tree of a cmesh */
+static              t8_eclass_t
+t8_forest_ghost_cmesh_tree_class (t8_cmesh_t cmesh, t8_locidx_t ctreeid)
+{
+  if (ctreeid < cmesh->num_local_trees) {
+    return t8_cmesh_get_tree_class (cmesh, ctreeid);
+  }
+  return t8_cmesh_get_ghost_class (cmesh, ctreeid - cmesh->num_local_trees);
+}
+
+/* Abort if a local tree of the forest shares a face with a tree of a
+ * different element class. The face neighbors of such a face are elements
+ * of another scheme, which the ghost layer does not support. */
+static void
+t8_forest_ghost_check_eclasses (t8_forest_t forest)
+{
+  t8_cmesh_t          cmesh = forest->cmesh;
+  t8_locidx_t         itree, num_trees, cmesh_ltreeid;
+  t8_locidx_t        *face_neighbor;
+  t8_eclass_t         eclass;
+  int8_t             *ttf;
+  int                 iface;
+
+  num_trees = t8_forest_get_num_local_trees (forest);
+  for (itree = 0; itree < num_trees; itree++) {
+    eclass = t8_forest_get_eclass (forest, itree);
+    cmesh_ltreeid = t8_forest_ltreeid_to_cmesh_ltreeid (forest, itree);
+    (void) t8_cmesh_trees_get_tree_ext (cmesh->trees, cmesh_ltreeid,
+                                        &face_neighbor, &ttf);
+    for (iface = 0; iface < t8_eclass_num_faces[eclass]; iface++) {
+      SC_CHECK_ABORT (t8_forest_ghost_cmesh_tree_class
+                      (cmesh, face_neighbor[iface]) == eclass,
+                      "Ghosts across trees of different element classes "
+                      "are not supported");
+    }
+  }
+}
+
+/* Compute the same-level face neighbor of an element across a tree face.
+ * Return 0 if the face lies on the domain boundary. Otherwise, return 1,
+ * the neighbor in neigh, its face in neigh_face and the global id of its
+ * tree in neigh_gtreeid. The neighbor tree must be of the same element
+ * class, see t8_forest_ghost_check_eclasses. */
+static int
+t8_forest_ghost_tree_face_neighbor (t8_forest_t forest, t8_locidx_t ltreeid,
+                                    t8_eclass_scheme_t * ts,
+                                    const t8_element_t * element, int face,
+                                    t8_element_t * neigh, int *neigh_face,
+                                    t8_gloidx_t * neigh_gtreeid)
+{
+  t8_cmesh_t          cmesh = forest->cmesh;
+  t8_locidx_t         cmesh_ltreeid, neigh_ctreeid;
+  t8_locidx_t        *face_neighbor;
+  int8_t             *ttf;
+  int                 tree_face, neigh_tree_face, orientation;
+  int                 num_faces;
+
+  cmesh_ltreeid = t8_forest_ltreeid_to_cmesh_ltreeid (forest, ltreeid);
+  (void) t8_cmesh_trees_get_tree_ext (cmesh->trees, cmesh_ltreeid,
+                                      &face_neighbor, &ttf);
+  tree_face = t8_element_tree_face (ts, element, face);
+  num_faces = t8_eclass_max_num_faces[cmesh->dimension];
+  neigh_ctreeid = face_neighbor[tree_face];
+  neigh_tree_face = ttf[tree_face] % num_faces;
+  orientation = ttf[tree_face] / num_faces;
+  if (neigh_ctreeid == cmesh_ltreeid && neigh_tree_face == tree_face) {
+    /* This face is a domain boundary */
+    return 0;
+  }
+  T8_ASSERT (t8_forest_ghost_cmesh_tree_class (cmesh, neigh_ctreeid)
+             == ts->eclass);
+  *neigh_gtreeid = t8_cmesh_get_global_id (cmesh, neigh_ctreeid);
+  *neigh_face =
+    t8_element_tree_face_neighbor (ts, element, neigh, face, neigh_tree_face,
+                                   orientation, tree_face <= neigh_tree_face);
+  return 1;
+}
+
+int
+t8_forest_element_face_neighbor (t8_forest_t forest, t8_locidx_t ltreeid,
+                                 const t8_element_t * element, int face,
+                                 t8_element_t * neigh, int *neigh_face,
+                                 t8_gloidx_t * neigh_gtreeid)
+{
+  t8_eclass_scheme_t *ts;
+
+  ts = forest->scheme->eclass_schemes[t8_forest_get_eclass (forest, ltreeid)];
+  if (t8_element_face_neighbor_inside (ts, element, neigh, face, neigh_face)) {
+    /* The neighbor lies in the same tree */
+    *neigh_gtreeid = forest->first_local_tree + ltreeid;
+    return 1;
+  }
+  return t8_forest_ghost_tree_face_neighbor (forest, ltreeid, ts, element,
+                                             face, neigh, neigh_face,
+                                             neigh_gtreeid);
+}
+
+/* Fill owners with the owners of all leaf elements that touch a face of
+ * a local element. The array may contain the same rank several times.
+ * neigh and desc are allocated elements that we use as temporary storage. */
+static void
+t8_forest_ghost_element_owners (t8_forest_t forest, t8_locidx_t ltreeid,
+                                t8_eclass_scheme_t * ts,
+                                const t8_element_t * element,
+                                t8_element_t * neigh, t8_element_t * desc,
+                                sc_array_t * owners)
+{
+  t8_gloidx_t         neigh_gtreeid;
+  int                 iface, num_faces, neigh_face;
+
+  sc_array_truncate (owners);
+  num_faces = t8_element_num_faces (ts, element);
+  for (iface = 0; iface < num_faces; iface++) {
+    if (!t8_forest_element_face_neighbor (forest, ltreeid, element, iface,
+                                          neigh, &neigh_face,
+                                          &neigh_gtreeid)) {
+      /* There is no neighbor across this face */
+      continue;
+    }
+    t8_forest_ghost_face_owners (forest, neigh_gtreeid, ts, neigh,
+                                 neigh_face, desc, owners);
+  }
+}
+
+/* Find all pairs of a local leaf element and a remote process such that
+ * the element touches a leaf element of that process across a face.
+ * The pairs are stored sorted and without duplicates in mirrors. */
+static void
+t8_forest_ghost_fill_mirrors (t8_forest_t forest, sc_array_t * mirrors)
+{
+  t8_locidx_t         itree, ielement, num_trees, num_elements;
+  t8_tree_t           tree;
+  t8_eclass_scheme_t *ts;
+  t8_element_t       *element, *neigh, *desc;
+  t8_forest_ghost_mirror_t *mirror, *last;
+  sc_array_t          owners;
+  size_t              iowner, imirror;
+  int                 owner;
+
+  sc_array_init (&owners, sizeof (int));
+  num_trees = t8_forest_get_num_local_trees (forest);
+  for (itree = 0; itree < num_trees; itree++) {
+    tree = t8_forest_get_tree (forest, itree);
+    ts = forest->scheme->eclass_schemes[tree->eclass];
+    t8_element_new (ts, 1, &neigh);
+    t8_element_new (ts, 1, &desc);
+    num_elements = t8_forest_get_tree_element_count (tree);
+    for (ielement = 0; ielement < num_elements; ielement++) {
+      element = t8_element_array_index (ts, &tree->elements, ielement);
+      t8_forest_ghost_element_owners (forest, itree, ts, element, neigh,
+                                      desc, &owners);
+      /* Each remote owner needs element as a ghost */
+      for (iowner = 0; iowner < owners.elem_count; iowner++) {
+        owner = *(int *) sc_array_index (&owners, iowner);
+        if (owner != forest->mpirank) {
+          mirror = (t8_forest_ghost_mirror_t *) sc_array_push (mirrors);
+          mirror->rank = owner;
+          mirror->ltree_id = itree;
+          mirror->element_index = ielement;
+        }
+      }
+    }
+    t8_element_destroy (ts, 1, &neigh);
+    t8_element_destroy (ts, 1, &desc);
+  }
+  sc_array_reset (&owners);
+
+  /* Sort the mirrors by rank and remove duplicates, which occur if an
+   * element touches the same process across different faces */
+  sc_array_sort (mirrors, t8_forest_ghost_mirror_compare);
+  for (imirror = 0, last = NULL; imirror < mirrors->elem_count; imirror++) {
+    mirror = (t8_forest_ghost_mirror_t *) sc_array_index (mirrors, imirror);
+    if (last == NULL || t8_forest_ghost_mirror_compare (last, mirror) != 0) {
+      last = last == NULL ? (t8_forest_ghost_mirror_t *)
+        sc_array_index (mirrors, 0) : last + 1;
+      *last = *mirror;
+    }
+  }
+  sc_array_resize (mirrors, last == NULL ? 0 :
+                   (size_t) (last - (t8_forest_ghost_mirror_t *)
+                             sc_array_index (mirrors, 0)) + 1);
+}
+
+/* Create one remote entry for each rank in the sorted mirror array
+ * and fill its array of local mirror element ids */
+static void
+t8_forest_ghost_init_remotes (t8_forest_t forest, sc_array_t * mirrors)
+{
+  t8_forest_ghost_t   ghost = forest->ghosts;
+  t8_forest_ghost_mirror_t *mirror;
+  t8_ghost_remote_t  *remote = NULL;
+  t8_tree_t           tree;
+  size_t              imirror;
+
+  for (imirror = 0; imirror < mirrors->elem_count; imirror++) {
+    mirror = (t8_forest_ghost_mirror_t *) sc_array_index (mirrors, imirror);
+    if (remote == NULL || remote->remote_rank != mirror->rank) {
+      remote = (t8_ghost_remote_t *) sc_array_push (&ghost->remotes);
+      remote->remote_rank = mirror->rank;
+      remote->first_ghost = 0;
+      remote->num_ghosts = 0;
+      sc_array_init (&remote->ghost_trees, sizeof (t8_ghost_tree_t));
+      sc_array_init (&remote->mirrors, sizeof (t8_locidx_t));
+    }
+    tree = t8_forest_get_tree (forest, mirror->ltree_id);
+    *(t8_locidx_t *) sc_array_push (&remote->mirrors) =
+      tree->elements_offset + mirror->element_index;
+  }
+  ghost->num_mirrors = mirrors->elem_count;
+}
+
+/* Update the mirrors of all remotes after local elements were refined.
+ * A refined mirror is replaced by those of its descendants that still
+ * touch a leaf of the remote process. These descendants are the new ghosts
+ * of the remote process and we collect them in updates, sorted by rank,
+ * tree and element index.
+ * new_index maps the local element ids at the last update to the local
+ * id of their first descendant, see t8_forest_ghost_update. */
+static void
+t8_forest_ghost_update_mirrors (t8_forest_t forest,
+                                const t8_locidx_t * new_index,
+                                sc_array_t * updates)
+{
+  t8_forest_ghost_t   ghost = forest->ghosts;
+  t8_ghost_remote_t  *remote;
+  t8_forest_ghost_mirror_t *update;
+  t8_tree_t           tree;
+  t8_eclass_scheme_t *ts;
+  t8_element_t       *element;
+  t8_element_t       *neigh[T8_ECLASS_COUNT], *desc[T8_ECLASS_COUNT];
+  t8_locidx_t         old_id, new_id, ltreeid;
+  sc_array_t          new_mirrors, owners;
+  size_t              iremote, imirror, iowner;
+  int                 eclass;
+
+  /* The scratch elements are allocated once for each element class */
+  for (eclass = T8_ECLASS_ZERO; eclass < T8_ECLASS_COUNT; eclass++) {
+    neigh[eclass] = desc[eclass] = NULL;
+  }
+  sc_array_init (&owners, sizeof (int));
+  ghost->num_mirrors = 0;
+  for (iremote = 0; iremote < ghost->remotes.elem_count; iremote++) {
+    remote = (t8_ghost_remote_t *) sc_array_index (&ghost->remotes, iremote);
+    sc_array_init (&new_mirrors, sizeof (t8_locidx_t));
+    ltreeid = 0;
+    for (imirror = 0; imirror < remote->mirrors.elem_count; imirror++) {
+      old_id = *(t8_locidx_t *) sc_array_index (&remote->mirrors, imirror);
+      if (new_index[old_id + 1] - new_index[old_id] == 1) {
+        /* This mirror was not refined */
+        *(t8_locidx_t *) sc_array_push (&new_mirrors) = new_index[old_id];
+        continue;
+      }
+      for (new_id = new_index[old_id]; new_id < new_index[old_id + 1];
+           new_id++) {
+        /* The ids increase, thus we find the tree of new_id by advancing
+         * from the tree of the previous one */
+        tree = t8_forest_get_tree (forest, ltreeid);
+        while (new_id >= tree->elements_offset +
+               t8_forest_get_tree_element_count (tree)) {
+          tree = t8_forest_get_tree (forest, ++ltreeid);
+        }
+        ts = forest->scheme->eclass_schemes[tree->eclass];
+        element = t8_element_array_index (ts, &tree->elements,
+                                          new_id - tree->elements_offset);
+        if (neigh[tree->eclass] == NULL) {
+          t8_element_new (ts, 1, neigh + tree->eclass);
+          t8_element_new (ts, 1, desc + tree->eclass);
+        }
+        t8_forest_ghost_element_owners (forest, ltreeid, ts, element,
+                                        neigh[tree->eclass],
+                                        desc[tree->eclass], &owners);
+        for (iowner = 0; iowner < owners.elem_count; iowner++) {
+          if (*(int *) sc_array_index (&owners, iowner) ==
+              remote->remote_rank) {
+            /* This descendant is a new ghost of the remote process */
+            *(t8_locidx_t *) sc_array_push (&new_mirrors) = new_id;
+            update = (t8_forest_ghost_mirror_t *) sc_array_push (updates);
+            update->rank = remote->remote_rank;
+            update->ltree_id = ltreeid;
+            update->element_index = new_id - tree->elements_offset;
+            break;
+          }
+        }
+      }
+    }
+    sc_array_reset (&remote->mirrors);
+    remote->mirrors = new_mirrors;
+    ghost->num_mirrors += new_mirrors.elem_count;
+  }
+  sc_array_reset (&owners);
+  for (eclass = T8_ECLASS_ZERO; eclass < T8_ECLASS_COUNT; eclass++) {
+    if (neigh[eclass] != NULL) {
+      ts = forest->scheme->eclass_schemes[eclass];
+      t8_element_destroy (ts, 1, neigh + eclass);
+      t8_element_destroy (ts, 1, desc + eclass);
+    }
+  }
+}
+
+/* Pack the mirror elements of one remote process into a new buffer.
+ * The mirrors of this process are the entries first to last of the
+ * mirror array. For each tree we store the tree info followed by the
+ * elements, both padded. */
+static char        *
+t8_forest_ghost_fill_buffer (t8_forest_t forest, sc_array_t * mirrors,
+                             size_t first, size_t last, size_t * buffer_size)
+{
+  t8_forest_ghost_mirror_t *mirror;
+  t8_forest_ghost_tree_info_t *tree_info;
+  t8_tree_t           tree;
+  t8_eclass_scheme_t *ts;
+  size_t              imirror, tree_first, elem_size, byte_count;
+  size_t              info_size, pos;
+  char               *buffer;
+
+  info_size = sizeof (t8_forest_ghost_tree_info_t);
+  info_size += T8_ADD_PADDING (info_size);
+  /* Compute the size of the buffer */
+  byte_count = 0;
+  for (imirror = first; imirror <= last; imirror = tree_first) {
+    mirror = (t8_forest_ghost_mirror_t *) sc_array_index (mirrors, imirror);
+    tree = t8_forest_get_tree (forest, mirror->ltree_id);
+    elem_size = tree->elements.elem_size;
+    /* Count the mirrors of this tree */
+    for (tree_first = imirror; tree_first <= last &&
+         ((t8_forest_ghost_mirror_t *)
+          sc_array_index (mirrors, tree_first))->ltree_id == mirror->ltree_id;
+         tree_first++) {
+    }
+    byte_count += info_size + (tree_first - imirror) * elem_size;
+    byte_count += T8_ADD_PADDING (byte_count);
+  }
+
+  /* Fill the buffer */
+  buffer = T8_ALLOC_ZERO (char, byte_count);
+  pos = 0;
+  for (imirror = first; imirror <= last;) {
+    mirror = (t8_forest_ghost_mirror_t *) sc_array_index (mirrors, imirror);
+    tree = t8_forest_get_tree (forest, mirror->ltree_id);
+    ts = forest->scheme->eclass_schemes[tree->eclass];
+    elem_size = tree->elements.elem_size;
+    tree_info = (t8_forest_ghost_tree_info_t *) (buffer + pos);
+    tree_info->gtree_id = forest->first_local_tree + mirror->ltree_id;
+    tree_info->eclass = tree->eclass;
+    tree_info->num_elements = 0;
+    pos += info_size;
+    for (; imirror <= last && ((t8_forest_ghost_mirror_t *)
+                               sc_array_index (mirrors, imirror))->ltree_id
+         == tree_info->gtree_id - forest->first_local_tree; imirror++) {
+      mirror = (t8_forest_ghost_mirror_t *) sc_array_index (mirrors,
+                                                             imirror);
+      memcpy (buffer + pos,
+              t8_element_array_index (ts, &tree->elements,
+                                      mirror->element_index), elem_size);
+      pos += elem_size;
+      tree_info->num_elements++;
+    }
+    pos += T8_ADD_PADDING (pos);
+  }
+  T8_ASSERT (pos == byte_count);
+  *buffer_size = byte_count;
+  return buffer;
+}
+
+/* Unpack a received message into the ghost trees of a remote process */
+static void
+t8_forest_ghost_unpack_buffer (t8_forest_t forest, t8_ghost_remote_t * remote,
+                               char *buffer, size_t buffer_size)
+{
+  t8_forest_ghost_tree_info_t *tree_info;
+  t8_ghost_tree_t    *ghost_tree;
+  t8_eclass_scheme_t *ts;
+  size_t              info_size, elem_size, pos;
+
+  info_size = sizeof (t8_forest_ghost_tree_info_t);
+  info_size += T8_ADD_PADDING (info_size);
+  pos = 0;
+  while (pos < buffer_size) {
+    tree_info = (t8_forest_ghost_tree_info_t *) (buffer + pos);
+    pos += info_size;
+    ts = forest->scheme->eclass_schemes[tree_info->eclass];
+    elem_size = t8_element_size (ts);
+    ghost_tree = (t8_ghost_tree_t *) sc_array_push (&remote->ghost_trees);
+    ghost_tree->global_id = tree_info->gtree_id;
+    ghost_tree->eclass = tree_info->eclass;
+    ghost_tree->element_offset = 0;
+    sc_array_init_size (&ghost_tree->elements, elem_size,
+                        tree_info->num_elements);
+    memcpy (ghost_tree->elements.array, buffer + pos,
+            tree_info->num_elements * elem_size);
+    pos += tree_info->num_elements * elem_size;
+    pos += T8_ADD_PADDING (pos);
+  }
+  T8_ASSERT (pos == buffer_size);
+}
+
+/* Unpack a received update into the existing ghost trees of a remote
+ * process. Each received element replaces the ghost element that is its
+ * ancestor. Since the ghosts and the received elements of a tree are both
+ * sorted and do not overlap, we merge them in one pass. */
+static void
+t8_forest_ghost_merge_buffer (t8_forest_t forest, t8_ghost_remote_t * remote,
+                              char *buffer, size_t buffer_size)
+{
+  t8_forest_ghost_tree_info_t *tree_info;
+  t8_ghost_tree_t    *ghost_tree;
+  t8_eclass_scheme_t *ts;
+  t8_element_t       *ghost_element, *recv_element, *desc;
+  sc_array_t          new_elements;
+  size_t              info_size, elem_size, pos, itree, ighost;
+  t8_locidx_t         irecv, num_replaced;
+  uint64_t            last_id;
+  int                 maxlevel;
+
+  info_size = sizeof (t8_forest_ghost_tree_info_t);
+  info_size += T8_ADD_PADDING (info_size);
+  pos = 0;
+  itree = 0;
+  while (pos < buffer_size) {
+    tree_info = (t8_forest_ghost_tree_info_t *) (buffer + pos);
+    pos += info_size;
+    /* Find the ghost tree. The trees of an update are a subset of the
+     * ghost trees and come in the same order. */
+    for (; itree < remote->ghost_trees.elem_count; itree++) {
+      ghost_tree = (t8_ghost_tree_t *) sc_array_index (&remote->ghost_trees,
+                                                       itree);
+      if (ghost_tree->global_id == tree_info->gtree_id) {
+        break;
+      }
+    }
+    T8_ASSERT (itree < remote->ghost_trees.elem_count);
+    T8_ASSERT (ghost_tree->eclass == tree_info->eclass);
+    ts = forest->scheme->eclass_schemes[tree_info->eclass];
+    elem_size = t8_element_size (ts);
+    maxlevel = t8_element_maxlevel (ts);
+    t8_element_new (ts, 1, &desc);
+    sc_array_init (&new_elements, elem_size);
+    irecv = 0;
+    for (ighost = 0; ighost < ghost_tree->elements.elem_count; ighost++) {
+      ghost_element = t8_element_array_index (ts, &ghost_tree->elements,
+                                              ighost);
+      t8_element_last_descendant (ts, ghost_element, desc);
+      last_id = t8_element_get_linear_id (ts, desc, maxlevel);
+      /* Copy all received elements that lie inside of the ghost */
+      num_replaced = 0;
+      for (; irecv < tree_info->num_elements; irecv++, num_replaced++) {
+        recv_element = (t8_element_t *) (buffer + pos + irecv * elem_size);
+        t8_element_first_descendant (ts, recv_element, desc);
+        if (t8_element_get_linear_id (ts, desc, maxlevel) > last_id) {
+          break;
+        }
+        T8_ASSERT (t8_element_level (ts, recv_element) >
+                   t8_element_level (ts, ghost_element));
+        t8_element_copy (ts, recv_element,
+                         (t8_element_t *) sc_array_push (&new_elements));
+      }
+      if (num_replaced == 0) {
+        /* The ghost was not refined */
+        t8_element_copy (ts, ghost_element,
+                         (t8_element_t *) sc_array_push (&new_elements));
+      }
+    }
+    T8_ASSERT (irecv == tree_info->num_elements);
+    t8_element_destroy (ts, 1, &desc);
+    sc_array_reset (&ghost_tree->elements);
+    ghost_tree->elements = new_elements;
+    pos += tree_info->num_elements * elem_size;
+    pos += T8_ADD_PADDING (pos);
+  }
+  T8_ASSERT (pos == buffer_size);
+}
+
+/* Number the ghost elements consecutively and count the ghosts of each
+ * remote process */
+static void
+t8_forest_ghost_number (t8_forest_ghost_t ghost)
+{
+  t8_ghost_remote_t  *remote;
+  t8_ghost_tree_t    *ghost_tree;
+  t8_locidx_t         ghost_offset;
+  size_t              iremote, itree;
+
+  ghost_offset = 0;
+  for (iremote = 0; iremote < ghost->remotes.elem_count; iremote++) {
+    remote = (t8_ghost_remote_t *) sc_array_index (&ghost->remotes, iremote);
+    remote->first_ghost = ghost_offset;
+    for (itree = 0; itree < remote->ghost_trees.elem_count; itree++) {
+      ghost_tree = (t8_ghost_tree_t *) sc_array_index (&remote->ghost_trees,
+                                                       itree);
+      ghost_tree->element_offset = ghost_offset;
+      ghost_offset += ghost_tree->elements.elem_count;
+    }
+    remote->num_ghosts = ghost_offset - remote->first_ghost;
+  }
+  ghost->num_ghosts = ghost_offset;
+}
+
+/* Send the mirror elements to all remote processes and receive
+ * their ghost elements. Since the face neighbor relation is symmetric,
+ * we receive exactly one message from each process that we send to.
+ * Each message is preceded by its size, such that we can post the receives
+ * of all messages in advance and unpack them in the order they arrive.
+ * If update is false, mirrors contains all mirror elements and we create
+ * the ghost trees. If update is true, mirrors contains the new mirror
+ * elements of t8_forest_ghost_update_mirrors, which replace their
+ * ancestors among the existing ghosts. Messages without elements are not
+ * sent, only their size 0.
+ * Return true if we received any elements. */
+static int
+t8_forest_ghost_exchange (t8_forest_t forest, sc_array_t * mirrors,
+                          int update)
+{
+  t8_forest_ghost_t   ghost = forest->ghosts;
+  t8_ghost_remote_t  *remote;
+  sc_MPI_Request     *send_requests, *recv_requests;
+  sc_MPI_Status      *status;
+  char              **send_buffers, **recv_buffers;
+  size_t              first, last, buffer_size, bytes_sent;
+  int                *send_sizes, *recv_sizes, *completed;
+  int                 num_remotes, iremote, icompleted, num_completed;
+  int                 num_pending, mpiret, received;
+
+  num_remotes = ghost->remotes.elem_count;
+  send_requests = T8_ALLOC (sc_MPI_Request, 2 * num_remotes);
+  recv_requests = T8_ALLOC (sc_MPI_Request, 2 * num_remotes);
+  status = T8_ALLOC (sc_MPI_Status, 2 * num_remotes);
+  completed = T8_ALLOC (int, 2 * num_remotes);
+  send_buffers = T8_ALLOC_ZERO (char *, num_remotes);
+  recv_buffers = T8_ALLOC_ZERO (char *, num_remotes);
+  send_sizes = T8_ALLOC (int, num_remotes);
+  recv_sizes = T8_ALLOC (int, num_remotes);
+
+  /* Post the receives of the message sizes. The first half of
+   * recv_requests is for the sizes, the second half for the messages. */
+  for (iremote = 0; iremote < num_remotes; iremote++) {
+    remote = (t8_ghost_remote_t *) sc_array_index_int (&ghost->remotes,
+                                                       iremote);
+    mpiret = sc_MPI_Irecv (recv_sizes + iremote, 1, sc_MPI_INT,
+                           remote->remote_rank, T8_MPI_GHOST_SIZE_FOREST,
+                           forest->mpicomm, recv_requests + iremote);
+    SC_CHECK_MPI (mpiret);
+    recv_requests[num_remotes + iremote] = sc_MPI_REQUEST_NULL;
+  }
+
+  /* Send the mirrors to each remote process */
+  bytes_sent = 0;
+  for (iremote = 0, first = 0; iremote < num_remotes; iremote++) {
+    remote = (t8_ghost_remote_t *) sc_array_index_int (&ghost->remotes,
+                                                       iremote);
+    /* The mirrors are sorted by rank, find the last one of this remote */
+    for (last = first; last < mirrors->elem_count &&
+         ((t8_forest_ghost_mirror_t *) sc_array_index (mirrors, last))->rank
+         == remote->remote_rank; last++) {
+    }
+    buffer_size = 0;
+    if (last > first) {
+      send_buffers[iremote] =
+        t8_forest_ghost_fill_buffer (forest, mirrors, first, last - 1,
+                                     &buffer_size);
+    }
+    send_sizes[iremote] = (int) buffer_size;
+    t8_debugf ("Sending %zd ghost elements (%zd bytes) to %i\n",
+               last - first, buffer_size, remote->remote_rank);
+    mpiret = sc_MPI_Isend (send_sizes + iremote, 1, sc_MPI_INT,
+                           remote->remote_rank, T8_MPI_GHOST_SIZE_FOREST,
+                           forest->mpicomm, send_requests + iremote);
+    SC_CHECK_MPI (mpiret);
+    send_requests[num_remotes + iremote] = sc_MPI_REQUEST_NULL;
+    if (buffer_size > 0) {
+      mpiret = sc_MPI_Isend (send_buffers[iremote], send_sizes[iremote],
+                             sc_MPI_BYTE, remote->remote_rank,
+                             T8_MPI_GHOST_FOREST, forest->mpicomm,
+                             send_requests + num_remotes + iremote);
+      SC_CHECK_MPI (mpiret);
+    }
+    bytes_sent += buffer_size;
+    first = last;
+  }
+  T8_ASSERT (first == mirrors->elem_count);
+  if (forest->profile != NULL) {
+    forest->profile->ghosts_bytes_sent = bytes_sent;
+  }
+
+  /* Whenever the size of a message arrives, post its receive.
+   * Whenever a message arrives, unpack it into the ghosts of its process. */
+  received = 0;
+  num_pending = 2 * num_remotes;
+  while (num_pending > 0) {
+    mpiret = sc_MPI_Waitsome (2 * num_remotes, recv_requests, &num_completed,
+                              completed, status);
+    SC_CHECK_MPI (mpiret);
+    T8_ASSERT (num_completed != sc_MPI_UNDEFINED && num_completed > 0);
+    for (icompleted = 0; icompleted < num_completed; icompleted++) {
+      iremote = completed[icompleted] % num_remotes;
+      remote = (t8_ghost_remote_t *) sc_array_index_int (&ghost->remotes,
+                                                         iremote);
+      T8_ASSERT (status[icompleted].MPI_SOURCE == remote->remote_rank);
+      if (completed[icompleted] < num_remotes) {
+        /* The size arrived */
+        if (recv_sizes[iremote] == 0) {
+          /* There is no message to wait for */
+          T8_ASSERT (update);
+          num_pending--;
+        }
+        else {
+          recv_buffers[iremote] = T8_ALLOC (char, recv_sizes[iremote]);
+          mpiret = sc_MPI_Irecv (recv_buffers[iremote], recv_sizes[iremote],
+                                 sc_MPI_BYTE, remote->remote_rank,
+                                 T8_MPI_GHOST_FOREST, forest->mpicomm,
+                                 recv_requests + num_remotes + iremote);
+          SC_CHECK_MPI (mpiret);
+        }
+      }
+      else {
+        /* The ghosts arrived */
+        if (update) {
+          t8_forest_ghost_merge_buffer (forest, remote, recv_buffers[iremote],
+                                        recv_sizes[iremote]);
+        }
+        else {
+          t8_forest_ghost_unpack_buffer (forest, remote,
+                                         recv_buffers[iremote],
+                                         recv_sizes[iremote]);
+        }
+        T8_FREE (recv_buffers[iremote]);
+        received = 1;
+      }
+      num_pending--;
+    }
+  }
+  t8_forest_ghost_number (ghost);
+
+  mpiret = sc_MPI_Waitall (2 * num_remotes, send_requests,
+                           sc_MPI_STATUSES_IGNORE);
+  SC_CHECK_MPI (mpiret);
+  for (iremote = 0; iremote < num_remotes; iremote++) {
+    T8_FREE (send_buffers[iremote]);
+  }
+  T8_FREE (send_buffers);
+  T8_FREE (recv_buffers);
+  T8_FREE (send_sizes);
+  T8_FREE (recv_sizes);
+  T8_FREE (completed);
+  T8_FREE (status);
+  T8_FREE (send_requests);
+  T8_FREE (recv_requests);
+  return received;
+}
+
+/* Free the cached mirror datatypes of a ghost layer */
+static void
+t8_forest_ghost_free_send_types (t8_forest_ghost_t ghost)
+{
+#ifdef T8_ENABLE_MPI
+  size_t              iremote;
+  int                 mpiret;
+
+  if (ghost->send_types == NULL) {
+    return;
+  }
+  for (iremote = 0; iremote < ghost->remotes.elem_count; iremote++) {
+    mpiret = MPI_Type_free (ghost->send_types + iremote);
+    SC_CHECK_MPI (mpiret);
+  }
+#endif
+  T8_FREE (ghost->send_types);
+  ghost->send_types = NULL;
+}
+
+void
+t8_forest_ghost_create (t8_forest_t forest)
+{
+  sc_array_t          mirrors;
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+  T8_ASSERT (forest->ghosts == NULL);
+
+  t8_global_productionf ("Into t8_forest_ghost_create\n");
+  forest->ghosts = T8_ALLOC_ZERO (t8_forest_ghost_struct_t, 1);
+  sc_array_init (&forest->ghosts->remotes, sizeof (t8_ghost_remote_t));
+
+  if (forest->global_first_desc == NULL) {
+    /* We need to know the partition of the elements to find the owners
+     * of neighbor elements */
+    t8_forest_partition_create_first_desc (forest);
+  }
+  t8_forest_ghost_check_eclasses (forest);
+  sc_array_init (&mirrors, sizeof (t8_forest_ghost_mirror_t));
+  t8_forest_ghost_fill_mirrors (forest, &mirrors);
+  t8_forest_ghost_init_remotes (forest, &mirrors);
+  (void) t8_forest_ghost_exchange (forest, &mirrors, 0);
+  sc_array_reset (&mirrors);
+
+  t8_global_productionf ("Done t8_forest_ghost_create with %lli local "
+                         "ghosts from %i processes\n",
+                         (long long) forest->ghosts->num_ghosts,
+                         (int) forest->ghosts->remotes.elem_count);
+}
+
+int
+t8_forest_ghost_update (t8_forest_t forest, const t8_locidx_t * new_index,
+                        int local_changed, int *global_changed)
+{
+  sc_array_t          updates;
+  int                 ghosts_changed;
+#ifdef T8_ENABLE_MPI
+  sc_MPI_Request      request;
+  int                 mpiret;
+#endif
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+  T8_ASSERT (forest->ghosts != NULL);
+  T8_ASSERT (!local_changed || new_index != NULL);
+
+  /* Start the reduction of the changed flags. It does not block and
+   * completes while we exchange the updates. */
+#ifdef T8_ENABLE_MPI
+  mpiret = MPI_Iallreduce (&local_changed, global_changed, 1, sc_MPI_INT,
+                           sc_MPI_LOR, forest->mpicomm, &request);
+  SC_CHECK_MPI (mpiret);
+#else
+  *global_changed = local_changed;
+#endif
+
+  /* The mirrors and remotes change, thus the datatypes of the ghost data
+   * exchange have to be rebuilt */
+  t8_forest_ghost_free_send_types (forest->ghosts);
+  sc_array_init (&updates, sizeof (t8_forest_ghost_mirror_t));
+  if (local_changed) {
+    t8_forest_ghost_update_mirrors (forest, new_index, &updates);
+  }
+  ghosts_changed = t8_forest_ghost_exchange (forest, &updates, 1);
+  sc_array_reset (&updates);
+
+#ifdef T8_ENABLE_MPI
+  mpiret = sc_MPI_Wait (&request, sc_MPI_STATUS_IGNORE);
+  SC_CHECK_MPI (mpiret);
+#endif
+  return ghosts_changed;
+}
+
+void
+t8_forest_ghost_destroy (t8_forest_ghost_t * pghost)
+{
+  t8_forest_ghost_t   ghost;
+  t8_ghost_remote_t  *remote;
+  t8_ghost_tree_t    *ghost_tree;
+  size_t              iremote, itree;
+
+  T8_ASSERT (pghost != NULL && *pghost != NULL);
+  ghost = *pghost;
+  for (iremote = 0; iremote < ghost->remotes.elem_count; iremote++) {
+    remote = (t8_ghost_remote_t *) sc_array_index (&ghost->remotes, iremote);
+    for (itree = 0; itree < remote->ghost_trees.elem_count; itree++) {
+      ghost_tree = (t8_ghost_tree_t *) sc_array_index (&remote->ghost_trees,
+                                                       itree);
+      sc_array_reset (&ghost_tree->elements);
+    }
+    sc_array_reset (&remote->ghost_trees);
+    sc_array_reset (&remote->mirrors);
+  }
+  t8_forest_ghost_free_send_types (ghost);
+  sc_array_reset (&ghost->remotes);
+  T8_FREE (ghost);
+  *pghost = NULL;
+}
+
+int
+t8_forest_ghost_num_remotes (t8_forest_ghost_t ghost)
+{
+  T8_ASSERT (ghost != NULL);
+  return ghost->remotes.elem_count;
+}
+
+t8_ghost_remote_t  *
+t8_forest_ghost_get_remote (t8_forest_ghost_t ghost, int remote)
+{
+  T8_ASSERT (ghost != NULL);
+  T8_ASSERT (0 <= remote && remote < (int) ghost->remotes.elem_count);
+  return (t8_ghost_remote_t *) sc_array_index_int (&ghost->remotes, remote);
+}
+
+t8_element_t       *
+t8_forest_ghost_get_element (t8_forest_t forest, t8_locidx_t ghost_index,
+                             t8_gloidx_t * gtreeid, t8_eclass_t * eclass)
+{
+  t8_forest_ghost_t   ghost;
+  t8_ghost_remote_t  *remote;
+  t8_ghost_tree_t    *ghost_tree;
+  int                 low, high, mid;
+  size_t              itree;
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+  ghost = forest->ghosts;
+  T8_ASSERT (ghost != NULL);
+  T8_ASSERT (0 <= ghost_index && ghost_index < ghost->num_ghosts);
+
+  /* Binary search for the remote process holding this ghost */
+  low = 0;
+  high = ghost->remotes.elem_count - 1;
+  while (low < high) {
+    mid = (low + high + 1) / 2;
+    remote = (t8_ghost_remote_t *) sc_array_index_int (&ghost->remotes, mid);
+    if (remote->first_ghost <= ghost_index) {
+      low = mid;
+    }
+    else {
+      high = mid - 1;
+    }
+  }
+  remote = (t8_ghost_remote_t *) sc_array_index_int (&ghost->remotes, low);
+  T8_ASSERT (remote->first_ghost <= ghost_index &&
+             ghost_index < remote->first_ghost + remote->num_ghosts);
+  /* Find the tree of this ghost */
+  for (itree = remote->ghost_trees.elem_count - 1;; itree--) {
+    ghost_tree = (t8_ghost_tree_t *) sc_array_index (&remote->ghost_trees,
+                                                     itree);
+    if (ghost_tree->element_offset <= ghost_index) {
+      break;
+    }
+    T8_ASSERT (itree > 0);
+  }
+  if (gtreeid != NULL) {
+    *gtreeid = ghost_tree->global_id;
+  }
+  if (eclass != NULL) {
+    *eclass = ghost_tree->eclass;
+  }
+  return t8_element_array_index (forest->scheme->eclass_schemes
+                                 [ghost_tree->eclass], &ghost_tree->elements,
+                                 ghost_index - ghost_tree->element_offset);
+}
+
+#ifdef T8_ENABLE_MPI
+/* Create an MPI datatype that describes the data of all mirror elements
+ * of one remote process inside of an element data array with entries
+ * of data_size bytes */
+static              sc_MPI_Datatype
+t8_forest_ghost_mirror_datatype (t8_ghost_remote_t * remote, size_t data_size)
+{
+  sc_MPI_Datatype     entry_type, mirror_type;
+  int                *displacements;
+  int                 num_mirrors, imirror, mpiret;
+
+  num_mirrors = remote->mirrors.elem_count;
+  displacements = T8_ALLOC (int, num_mirrors);
+  for (imirror = 0; imirror < num_mirrors; imirror++) {
+    displacements[imirror] =
+      *(t8_locidx_t *) sc_array_index_int (&remote->mirrors, imirror);
+  }
+  mpiret = MPI_Type_contiguous (data_size, sc_MPI_BYTE, &entry_type);
+  SC_CHECK_MPI (mpiret);
+  mpiret = MPI_Type_create_indexed_block (num_mirrors, 1, displacements,
+                                          entry_type, &mirror_type);
+  SC_CHECK_MPI (mpiret);
+  mpiret = MPI_Type_commit (&mirror_type);
+  SC_CHECK_MPI (mpiret);
+  mpiret = MPI_Type_free (&entry_type);
+  SC_CHECK_MPI (mpiret);
+  T8_FREE (displacements);
+  return mirror_type;
+}
+#endif
+
+t8_forest_ghost_exchange_t
+t8_forest_ghost_exchange_begin (t8_forest_t forest, sc_array_t * element_data)
+{
+  t8_forest_ghost_exchange_t exchange;
+  t8_forest_ghost_t   ghost;
+  size_t              data_size;
+  int                 num_remotes;
+#ifdef T8_ENABLE_MPI
+  t8_ghost_remote_t  *remote;
+  char               *recv_data;
+  int                 iremote, mpiret;
+#endif
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+  T8_ASSERT (forest->ghosts != NULL);
+  T8_ASSERT (element_data != NULL);
+  ghost = forest->ghosts;
+  T8_ASSERT (element_data->elem_count ==
+             (size_t) (forest->local_num_elements + ghost->num_ghosts));
+
+  num_remotes = ghost->remotes.elem_count;
+  data_size = element_data->elem_size;
+  exchange = T8_ALLOC (t8_forest_ghost_exchange_struct_t, 1);
+  exchange->forest = forest;
+  exchange->element_data = element_data;
+  exchange->num_remotes = num_remotes;
+  exchange->requests = T8_ALLOC (sc_MPI_Request, 2 * num_remotes);
+  t8_forest_ref (forest);
+
+#ifdef T8_ENABLE_MPI
+  if (ghost->send_types == NULL || ghost->send_types_size != data_size) {
+    /* The datatypes selecting the mirror data are built once per ghost
+     * layer and entry size. MPI keeps a freed datatype alive until the
+     * pending sends that use it are complete. */
+    t8_forest_ghost_free_send_types (ghost);
+    ghost->send_types = T8_ALLOC (sc_MPI_Datatype, num_remotes);
+    ghost->send_types_size = data_size;
+    for (iremote = 0; iremote < num_remotes; iremote++) {
+      remote = (t8_ghost_remote_t *) sc_array_index_int (&ghost->remotes,
+                                                         iremote);
+      ghost->send_types[iremote] =
+        t8_forest_ghost_mirror_datatype (remote, data_size);
+    }
+  }
+  for (iremote = 0; iremote < num_remotes; iremote++) {
+    remote = (t8_ghost_remote_t *) sc_array_index_int (&ghost->remotes,
+                                                       iremote);
+    /* Receive the ghost data directly into element_data */
+    recv_data = element_data->array +
+      (forest->local_num_elements + remote->first_ghost) * data_size;
+    mpiret = sc_MPI_Irecv (recv_data, remote->num_ghosts * data_size,
+                           sc_MPI_BYTE, remote->remote_rank,
+                           T8_MPI_GHOST_EXC_FOREST, forest->mpicomm,
+                           exchange->requests + num_remotes + iremote);
+    SC_CHECK_MPI (mpiret);
+  }
+  for (iremote = 0; iremote < num_remotes; iremote++) {
+    remote = (t8_ghost_remote_t *) sc_array_index_int (&ghost->remotes,
+                                                       iremote);
+    /* Send the mirror data directly from element_data, the datatype
+     * selects the entries of the mirror elements */
+    mpiret = sc_MPI_Isend (element_data->array, 1,
+                           ghost->send_types[iremote],
+                           remote->remote_rank, T8_MPI_GHOST_EXC_FOREST,
+                           forest->mpicomm, exchange->requests + iremote);
+    SC_CHECK_MPI (mpiret);
+  }
+#else
+  /* Without MPI there is only one process and thus no ghosts */
+  T8_ASSERT (num_remotes == 0);
+#endif
+  return exchange;
+}
+
+void
+t8_forest_ghost_exchange_end (t8_forest_ghost_exchange_t * pexchange)
+{
+  t8_forest_ghost_exchange_t exchange;
+  int                 mpiret;
+
+  T8_ASSERT (pexchange != NULL && *pexchange != NULL);
+  exchange = *pexchange;
+
+  mpiret = sc_MPI_Waitall (2 * exchange->num_remotes, exchange->requests,
+                           sc_MPI_STATUSES_IGNORE);
+  SC_CHECK_MPI (mpiret);
+  t8_forest_unref (&exchange->forest);
+  T8_FREE (exchange->requests);
+  T8_FREE (exchange);
+  *pexchange = NULL;
+}
+
+void
+t8_forest_ghost_exchange_data (t8_forest_t forest, sc_array_t * element_data)
+{
+  t8_forest_ghost_exchange_t exchange;
+
+  exchange = t8_forest_ghost_exchange_begin (forest, element_data);
+  t8_forest_ghost_exchange_end (&exchange);
+}
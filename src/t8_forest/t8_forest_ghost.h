@@ -0,0 +1,137 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+/** \file t8_forest_ghost.h
+ * We define the ghost layer of a forest of trees in this file.
+ */
+
+#ifndef T8_FOREST_GHOST_H
+#define T8_FOREST_GHOST_H
+
+#include <t8.h>
+#include <t8_forest.h>
+#include <t8_forest/t8_forest_types.h>
+
+T8_EXTERN_C_BEGIN ();
+
+/** Create the face ghost layer of a committed forest.
+ * The ghost elements are the remote leaf elements that share a face with a
+ * local leaf element, also across tree boundaries.
+ * The result is stored in forest->ghosts.
+ * This function is collective. It aborts if a local tree shares a face
+ * with a tree of a different element class.
+ * \param [in,out] forest  A committed forest without ghost layer.
+ */
+void                t8_forest_ghost_create (t8_forest_t forest);
+
+/** Update the ghost layer of a forest after local elements were refined.
+ * Instead of creating the ghost layer anew, each process only sends those
+ * descendants of its refined mirror elements that touch the remote
+ * process. On the remote process they replace their ancestor ghosts.
+ * Since refining does not change the partition, the remote processes stay
+ * the same and each process receives one size message from each of them.
+ * A size of zero means that the remote process did not change any of our
+ * ghosts.
+ * Along with the updates we compute whether any process refined. This
+ * reduction does not block, it completes during the exchange.
+ * This function is collective.
+ * \param [in,out] forest  A committed forest with ghost layer. Its local
+ *                      elements may only have been refined since the ghost
+ *                      layer was created or last updated.
+ * \param [in] new_index For each local element at the last update, the
+ *                      local index of its first descendant now, followed
+ *                      by the current number of local elements.
+ *                      May be NULL if \a local_changed is false.
+ * \param [in] local_changed True if a local element was refined.
+ * \param [out] global_changed On output true if an element was refined on
+ *                      any process.
+ * \return              True if a ghost element of this process changed.
+ */
+int                 t8_forest_ghost_update (t8_forest_t forest,
+                                            const t8_locidx_t * new_index,
+                                            int local_changed,
+                                            int *global_changed);
+
+/** Destroy a ghost layer and free all its memory.
+ * \param [in,out] pghost  On input a ghost layer, on output NULL.
+ */
+void                t8_forest_ghost_destroy (t8_forest_ghost_t * pghost);
+
+/** Return the number of remote processes of a ghost layer.
+ * \param [in] ghost    A ghost layer.
+ * \return              The number of processes that we receive ghosts from.
+ *                      This is also the number of processes that our
+ *                      mirror elements are ghosts of.
+ */
+int                 t8_forest_ghost_num_remotes (t8_forest_ghost_t ghost);
+
+/** Return the ghosts and mirrors of one remote process.
+ * \param [in] ghost    A ghost layer.
+ * \param [in] remote   The index of a remote process,
+ *                      0 <= \a remote < \ref t8_forest_ghost_num_remotes.
+ * \return              The ghost and mirror data of this process.
+ */
+t8_ghost_remote_t  *t8_forest_ghost_get_remote (t8_forest_ghost_t ghost,
+                                                int remote);
+
+/** Return a ghost element given by its ghost index.
+ * \param [in] forest   A committed forest with ghost layer.
+ * \param [in] ghost_index  The index of the ghost element,
+ *                      0 <= \a ghost_index < number of ghosts.
+ * \param [out] gtreeid If not NULL, the global id of the ghost's tree.
+ * \param [out] eclass  If not NULL, the element class of the ghost's tree.
+ * \return              A pointer to the ghost element.
+ */
+t8_element_t       *t8_forest_ghost_get_element (t8_forest_t forest,
+                                                 t8_locidx_t ghost_index,
+                                                 t8_gloidx_t * gtreeid,
+                                                 t8_eclass_t * eclass);
+
+/** Compute the same-level face neighbor of a local element,
+ * also across tree boundaries.
+ * \param [in] forest   A committed forest.
+ * \param [in] ltreeid  The local id of the tree of \a element.
+ * \param [in] element  An element of the tree \a ltreeid.
+ * \param [in] face     A face of \a element.
+ * \param [out] neigh   On output the face neighbor of \a element across
+ *                      \a face, if it exists. Must be allocated with the
+ *                      scheme of the tree \a ltreeid.
+ * \param [out] neigh_face On output the face of \a neigh that touches
+ *                      \a element.
+ * \param [out] neigh_gtreeid On output the global id of the tree of \a neigh.
+ * \return              True if the neighbor exists. False if \a face lies on
+ *                      the domain boundary.
+ * \note The tree across \a face must be of the same element class as the
+ *       tree \a ltreeid.
+ */
+int                 t8_forest_element_face_neighbor (t8_forest_t forest,
+                                                     t8_locidx_t ltreeid,
+                                                     const t8_element_t *
+                                                     element, int face,
+                                                     t8_element_t * neigh,
+                                                     int *neigh_face,
+                                                     t8_gloidx_t *
+                                                     neigh_gtreeid);
+
+T8_EXTERN_C_END ();
+
+#endif /* !T8_FOREST_GHOST_H! */
@@ -0,0 +1,363 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <t8_forest/t8_forest_types.h>
+#include <t8_forest.h>
+
+/* The number of queries that we pass through the trees of a forest at once
+ * in t8_forest_search. This bounds the memory of the active query lists and,
+ * if the queries are sorted, keeps the accessed leaves local. */
+#define T8_FOREST_SEARCH_BATCH_SIZE 65536
+
+/* The data that stays the same during the recursion over one tree */
+typedef struct
+{
+  t8_forest_t         forest;   /* The forest */
+  t8_locidx_t         ltreeid;  /* The local id of the current tree */
+  t8_eclass_scheme_t *ts;       /* The scheme of the current tree */
+  t8_forest_iterate_fn iterate_fn;      /* The user callback for elements, may be NULL */
+  t8_forest_search_query_fn query_fn;   /* The user callback for queries, may be NULL */
+  sc_array_t         *queries;  /* The queries, if query_fn is not NULL */
+  int                 num_children;     /* The number of children of an element */
+  int                 maxlevel; /* The maximum level of the current tree's scheme */
+  t8_element_t     ***children; /* For each level the children of the current
+                                   element of this level, allocated on demand */
+  size_t            **offsets;  /* For each level the split offsets of the
+                                   leaves of the current element of this level */
+  sc_array_t         *active;   /* For each level the indices of the queries
+                                   that match the current element of this level */
+  t8_element_t       *last_desc;        /* Storage for a last descendant */
+} t8_forest_iterate_context_t;
+
+/* A query index together with its sort key */
+typedef struct
+{
+  uint64_t            key;      /* The key of the query */
+  size_t              index;    /* The index of the query */
+} t8_forest_search_key_t;
+
+/* Split an array of leaves that are descendants of element into the
+ * ranges of leaves of the children of element.
+ * On output, offsets[i] is the index of the first leaf inside the i-th
+ * child and offsets[num_children] is the number of leaves. */
+static void
+t8_forest_iterate_split (t8_forest_iterate_context_t * context,
+                         t8_element_t ** children, sc_array_t * leaves,
+                         size_t * offsets)
+{
+  t8_eclass_scheme_t *ts = context->ts;
+  size_t              low, high, mid;
+  int                 ichild;
+
+  offsets[0] = 0;
+  for (ichild = 0; ichild < context->num_children - 1; ichild++) {
+    /* The leaves of this child are the ones not greater than its last
+     * descendant. Since the leaves are sorted, we search for the first
+     * leaf that is greater. */
+    t8_element_last_descendant (ts, children[ichild], context->last_desc);
+    low = offsets[ichild];
+    high = leaves->elem_count;
+    while (low < high) {
+      mid = low + (high - low) / 2;
+      if (t8_element_compare (ts, t8_element_array_index (ts, leaves, mid),
+                              context->last_desc) <= 0) {
+        low = mid + 1;
+      }
+      else {
+        high = mid;
+      }
+    }
+    offsets[ichild + 1] = low;
+  }
+  offsets[context->num_children] = leaves->elem_count;
+}
+
+/* Call the callbacks for element and recurse into its children.
+ * leaves are the leaf elements inside of element and must not be empty.
+ * If queries are searched, active are the indices of the queries that
+ * matched the parent of element. */
+static void
+t8_forest_iterate_recursion (t8_forest_iterate_context_t * context,
+                             const t8_element_t * element,
+                             sc_array_t * leaves, t8_locidx_t first_index,
+                             sc_array_t * active)
+{
+  t8_eclass_scheme_t *ts = context->ts;
+  t8_element_t      **children;
+  sc_array_t          child_leaves, *matches = NULL;
+  size_t             *offsets, iquery, query_index;
+  int                 level, ichild, is_leaf;
+
+  T8_ASSERT (leaves->elem_count > 0);
+  level = t8_element_level (ts, element);
+  is_leaf = leaves->elem_count == 1 &&
+    t8_element_level (ts, t8_element_array_index (ts, leaves, 0)) == level;
+  if (context->iterate_fn != NULL &&
+      !context->iterate_fn (context->forest, context->ltreeid, element,
+                            is_leaf, leaves, first_index) && !is_leaf) {
+    /* The user does not want to visit the descendants of element */
+    return;
+  }
+  if (context->query_fn != NULL) {
+    /* Keep only the queries that match element */
+    matches = context->active + level;
+    sc_array_truncate (matches);
+    for (iquery = 0; iquery < active->elem_count; iquery++) {
+      query_index = *(size_t *) sc_array_index (active, iquery);
+      if (context->query_fn (context->forest, context->ltreeid, element,
+                             is_leaf, leaves, first_index,
+                             sc_array_index (context->queries, query_index),
+                             query_index)) {
+        *(size_t *) sc_array_push (matches) = query_index;
+      }
+    }
+    if (matches->elem_count == 0) {
+      /* No query can be found inside of element */
+      return;
+    }
+  }
+  if (is_leaf) {
+    return;
+  }
+
+  /* Compute the children of element */
+  if (context->children[level] == NULL) {
+    context->children[level] = T8_ALLOC (t8_element_t *,
+                                         context->num_children);
+    t8_element_new (ts, context->num_children, context->children[level]);
+    context->offsets[level] = T8_ALLOC (size_t, context->num_children + 1);
+  }
+  children = context->children[level];
+  offsets = context->offsets[level];
+  t8_element_children (ts, element, context->num_children, children);
+
+  /* Split the leaves among the children and recurse */
+  t8_forest_iterate_split (context, children, leaves, offsets);
+  for (ichild = 0; ichild < context->num_children; ichild++) {
+    if (offsets[ichild + 1] > offsets[ichild]) {
+      sc_array_init_view (&child_leaves, leaves, offsets[ichild],
+                          offsets[ichild + 1] - offsets[ichild]);
+      t8_forest_iterate_recursion (context, children[ichild], &child_leaves,
+                                   first_index + offsets[ichild], matches);
+    }
+  }
+}
+
+/* Allocate the recursion data of a context for a tree */
+static void
+t8_forest_iterate_context_init (t8_forest_iterate_context_t * context,
+                                t8_locidx_t ltreeid, t8_tree_t tree)
+{
+  int                 level;
+
+  context->ltreeid = ltreeid;
+  context->ts = context->forest->scheme->eclass_schemes[tree->eclass];
+  context->num_children = t8_eclass_num_children[tree->eclass];
+  context->maxlevel = t8_element_maxlevel (context->ts);
+  context->children = T8_ALLOC_ZERO (t8_element_t **, context->maxlevel + 1);
+  context->offsets = T8_ALLOC_ZERO (size_t *, context->maxlevel + 1);
+  context->active = NULL;
+  if (context->query_fn != NULL) {
+    context->active = T8_ALLOC (sc_array_t, context->maxlevel + 1);
+    for (level = 0; level <= context->maxlevel; level++) {
+      sc_array_init (context->active + level, sizeof (size_t));
+    }
+  }
+  t8_element_new (context->ts, 1, &context->last_desc);
+}
+
+/* Free the recursion data of a context */
+static void
+t8_forest_iterate_context_reset (t8_forest_iterate_context_t * context)
+{
+  int                 level;
+
+  t8_element_destroy (context->ts, 1, &context->last_desc);
+  for (level = 0; level <= context->maxlevel; level++) {
+    if (context->children[level] != NULL) {
+      t8_element_destroy (context->ts, context->num_children,
+                          context->children[level]);
+      T8_FREE (context->children[level]);
+      T8_FREE (context->offsets[level]);
+    }
+    if (context->active != NULL) {
+      sc_array_reset (context->active + level);
+    }
+  }
+  T8_FREE (context->children);
+  T8_FREE (context->offsets);
+  if (context->active != NULL) {
+    T8_FREE (context->active);
+  }
+}
+
+/* Start the recursion over the leaves of a tree with the smallest
+ * element that contains all of them */
+static void
+t8_forest_iterate_tree (t8_forest_iterate_context_t * context,
+                        t8_tree_t tree, sc_array_t * active)
+{
+  t8_eclass_scheme_t *ts = context->ts;
+  t8_element_t       *nca, *first, *last;
+  t8_locidx_t         num_elements;
+  int                 level;
+
+  num_elements = t8_forest_get_tree_element_count (tree);
+  T8_ASSERT (num_elements > 0);
+  first = t8_element_array_index (ts, &tree->elements, 0);
+  last = t8_element_array_index (ts, &tree->elements, num_elements - 1);
+  t8_element_new (ts, 1, &nca);
+  t8_element_nca (ts, first, last, nca);
+  /* The simplices compute the nca at the level of the smallest common
+   * cube, where it may have another type than the common ancestor. Thus
+   * we search the ancestor of the first leaf of at most this level that
+   * also contains the last leaf. */
+  level = t8_element_level (ts, nca);
+  t8_element_copy (ts, first, nca);
+  while (t8_element_level (ts, nca) > level) {
+    t8_element_parent (ts, nca, nca);
+  }
+  t8_element_last_descendant (ts, nca, context->last_desc);
+  while (t8_element_compare (ts, last, context->last_desc) > 0) {
+    t8_element_parent (ts, nca, nca);
+    t8_element_last_descendant (ts, nca, context->last_desc);
+  }
+  t8_forest_iterate_recursion (context, nca, &tree->elements, 0, active);
+  t8_element_destroy (ts, 1, &nca);
+}
+
+void
+t8_forest_iterate (t8_forest_t forest, t8_forest_iterate_fn iterate_fn)
+{
+  t8_forest_iterate_context_t context;
+  t8_locidx_t         itree, num_trees;
+  t8_tree_t           tree;
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+  T8_ASSERT (iterate_fn != NULL);
+
+  context.forest = forest;
+  context.iterate_fn = iterate_fn;
+  context.query_fn = NULL;
+  context.queries = NULL;
+  num_trees = t8_forest_get_num_local_trees (forest);
+  for (itree = 0; itree < num_trees; itree++) {
+    tree = t8_forest_get_tree (forest, itree);
+    if (t8_forest_get_tree_element_count (tree) == 0) {
+      continue;
+    }
+    t8_forest_iterate_context_init (&context, itree, tree);
+    t8_forest_iterate_tree (&context, tree, NULL);
+    t8_forest_iterate_context_reset (&context);
+  }
+}
+
+void
+t8_forest_search (t8_forest_t forest, t8_forest_iterate_fn search_fn,
+                  t8_forest_search_query_fn query_fn, sc_array_t * queries)
+{
+  t8_forest_iterate_context_t context;
+  t8_locidx_t         itree, num_trees;
+  t8_tree_t           tree;
+  sc_array_t          active;
+  size_t              first, iquery, batch_size;
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+  T8_ASSERT (query_fn != NULL);
+  T8_ASSERT (queries != NULL);
+
+  context.forest = forest;
+  context.iterate_fn = search_fn;
+  context.query_fn = query_fn;
+  context.queries = queries;
+  sc_array_init (&active, sizeof (size_t));
+  num_trees = t8_forest_get_num_local_trees (forest);
+  for (itree = 0; itree < num_trees; itree++) {
+    tree = t8_forest_get_tree (forest, itree);
+    if (t8_forest_get_tree_element_count (tree) == 0) {
+      continue;
+    }
+    t8_forest_iterate_context_init (&context, itree, tree);
+    /* Pass the queries through the tree in batches */
+    for (first = 0; first < queries->elem_count; first += batch_size) {
+      batch_size = SC_MIN (T8_FOREST_SEARCH_BATCH_SIZE,
+                           queries->elem_count - first);
+      sc_array_resize (&active, batch_size);
+      for (iquery = 0; iquery < batch_size; iquery++) {
+        *(size_t *) sc_array_index (&active, iquery) = first + iquery;
+      }
+      t8_forest_iterate_tree (&context, tree, &active);
+    }
+    t8_forest_iterate_context_reset (&context);
+  }
+  sc_array_reset (&active);
+}
+
+/* Compare two query keys */
+static int
+t8_forest_search_key_compare (const void *a, const void *b)
+{
+  const t8_forest_search_key_t *key_a = (const t8_forest_search_key_t *) a;
+  const t8_forest_search_key_t *key_b = (const t8_forest_search_key_t *) b;
+
+  if (key_a->key != key_b->key) {
+    return key_a->key < key_b->key ? -1 : 1;
+  }
+  /* Keep the order of queries with the same key */
+  return key_a->index < key_b->index ? -1 : key_a->index != key_b->index;
+}
+
+void
+t8_forest_search_sort_queries (t8_forest_t forest, sc_array_t * queries,
+                               t8_forest_search_key_fn key_fn)
+{
+  sc_array_t          keys;
+  t8_forest_search_key_t *key;
+  char               *sorted;
+  size_t              iquery, query_size;
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+  T8_ASSERT (queries != NULL);
+  T8_ASSERT (key_fn != NULL);
+
+  /* Compute and sort the keys of all queries */
+  sc_array_init_size (&keys, sizeof (t8_forest_search_key_t),
+                      queries->elem_count);
+  for (iquery = 0; iquery < queries->elem_count; iquery++) {
+    key = (t8_forest_search_key_t *) sc_array_index (&keys, iquery);
+    key->key = key_fn (forest, sc_array_index (queries, iquery));
+    key->index = iquery;
+  }
+  sc_array_sort (&keys, t8_forest_search_key_compare);
+
+  /* Permute the queries accordingly */
+  query_size = queries->elem_size;
+  sorted = T8_ALLOC (char, queries->elem_count * query_size);
+  for (iquery = 0; iquery < queries->elem_count; iquery++) {
+    key = (t8_forest_search_key_t *) sc_array_index (&keys, iquery);
+    memcpy (sorted + iquery * query_size,
+            sc_array_index (queries, key->index), query_size);
+  }
+  memcpy (queries->array, sorted, queries->elem_count * query_size);
+  T8_FREE (sorted);
+  sc_array_reset (&keys);
+}
@@ -63,33 +63,143 @@ t8_forest_partition_empty (t8_gloidx_t * offset, int rank)
   return 0;
 }
 
+/* Create forest->element_offsets from the global index of the first
+ * element of each process, given by first_element on this process.
+ * The last entry is set to the global number of elements. */
+static void
+t8_forest_partition_gather_offsets (t8_forest_t forest,
+                                    t8_gloidx_t first_element)
+{
+  T8_ASSERT (forest->element_offsets == NULL);
+
+  /* Set the shmem array type of comm */
+  sc_shmem_set_type (forest->mpicomm, T8_SHMEM_BEST_TYPE);
+  /* Initialize the offset array as a shmem array
+   * holding mpisize+1 many t8_gloidx_t */
+  t8_shmem_array_init (&forest->element_offsets, sizeof (t8_gloidx_t),
+                       forest->mpisize + 1, forest->mpicomm);
+  /* Collect all first global indices in the array */
+  t8_shmem_array_allgather (&first_element, 1, T8_MPI_GLOIDX,
+                            forest->element_offsets, 1, T8_MPI_GLOIDX);
+  if (t8_shmem_array_start_writing (forest->element_offsets)) {
+    t8_shmem_array_set_gloidx (forest->element_offsets, forest->mpisize,
+                               forest->global_num_elements);
+  }
+  t8_shmem_array_end_writing (forest->element_offsets);
+}
+
 /* For a committed forest create the array of element_offsets
  * and store it in forest->element_offsets
  */
-static void
+void
 t8_forest_partition_create_offsets (t8_forest_t forest)
 {
-  sc_MPI_Comm         comm;
-  t8_gloidx_t         first_local_element;
+  t8_gloidx_t         first_local_element, local_num_elements;
+  int                 mpiret;
 
   T8_ASSERT (t8_forest_is_committed (forest));
 
   T8_ASSERT (forest->element_offsets == NULL);
   t8_debugf ("Building offsets for forest %p\n", forest);
+  /* Calculate the global index of the first local element.
+   * MPI_Scan is inclusive, thus we subtract our own count again. */
+  local_num_elements = forest->local_num_elements;
+  mpiret = sc_MPI_Scan (&local_num_elements, &first_local_element, 1,
+                        T8_MPI_GLOIDX, sc_MPI_SUM, forest->mpicomm);
+  SC_CHECK_MPI (mpiret);
+  first_local_element -= local_num_elements;
+  t8_forest_partition_gather_offsets (forest, first_local_element);
+}
+
+void
+t8_forest_partition_create_first_desc (t8_forest_t forest)
+{
+  sc_MPI_Comm         comm;
+  t8_gloidx_t         local_first_desc[2];
+  t8_tree_t           tree;
+  t8_eclass_scheme_t *ts;
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+
+  T8_ASSERT (forest->global_first_desc == NULL);
+  t8_debugf ("Building global first descendants for forest %p\n", forest);
   comm = forest->mpicomm;
+  if (forest->local_num_elements > 0) {
+    /* The position of our first local element is given by its
+     * first descendant at the maximum level */
+    tree = t8_forest_get_tree (forest, 0);
+    ts = forest->scheme->eclass_schemes[tree->eclass];
+    local_first_desc[0] = forest->first_local_tree;
+    local_first_desc[1] = (t8_gloidx_t)
+      t8_element_get_linear_id (ts, tree->first_desc,
+                                t8_element_maxlevel (ts));
+  }
+  else {
+    /* This process is empty */
+    local_first_desc[0] = local_first_desc[1] = -1;
+  }
   /* Set the shmem array type of comm */
   sc_shmem_set_type (comm, T8_SHMEM_BEST_TYPE);
-  /* Initialize the offset array as a shmem array
-   * holding mpisize+1 many t8_gloidx_t */
-  t8_shmem_array_init (&forest->element_offsets, sizeof (t8_gloidx_t),
-                       forest->mpisize + 1, comm);
-  /* Calculate the global index of the first local element */
-  first_local_element = t8_forest_get_first_local_element_id (forest);
-  /* Collect all first global indices in the array */
-  t8_shmem_array_allgather (&first_local_element, 1, T8_MPI_GLOIDX,
-                            forest->element_offsets, 1, T8_MPI_GLOIDX);
-  t8_shmem_array_set_gloidx (forest->element_offsets, forest->mpisize,
-                             forest->global_num_elements);
+  /* Initialize the array as a shmem array holding two
+   * t8_gloidx_t for each process */
+  t8_shmem_array_init (&forest->global_first_desc, sizeof (t8_gloidx_t),
+                       2 * forest->mpisize, comm);
+  t8_shmem_array_allgather (local_first_desc, 2, T8_MPI_GLOIDX,
+                            forest->global_first_desc, 2, T8_MPI_GLOIDX);
+}
+
+/* Compare a position given by a tree id and a linear descendant id to
+ * the first position of a nonempty process */
+static int
+t8_forest_partition_compare_position (t8_gloidx_t * first_desc, int rank,
+                                      t8_gloidx_t gtreeid, uint64_t desc_id)
+{
+  T8_ASSERT (first_desc[2 * rank] >= 0);
+  if (gtreeid != first_desc[2 * rank]) {
+    return gtreeid < first_desc[2 * rank] ? -1 : 1;
+  }
+  if (desc_id != (uint64_t) first_desc[2 * rank + 1]) {
+    return desc_id < (uint64_t) first_desc[2 * rank + 1] ? -1 : 1;
+  }
+  return 0;
+}
+
+int
+t8_forest_partition_find_owner (t8_forest_t forest, t8_gloidx_t gtreeid,
+                                uint64_t desc_id)
+{
+  t8_gloidx_t        *first_desc;
+  int                 low, high, mid, probe, owner;
+
+  T8_ASSERT (forest->global_first_desc != NULL);
+  T8_ASSERT (0 <= gtreeid && gtreeid < forest->global_num_trees);
+
+  first_desc = t8_shmem_array_get_gloidx_array (forest->global_first_desc);
+  /* We look for the largest nonempty process whose first position is
+   * smaller or equal to the given position.  Empty processes are skipped
+   * by probing the next nonempty process in the search range. */
+  low = 0;
+  high = forest->mpisize - 1;
+  owner = -1;
+  while (low <= high) {
+    mid = (low + high) / 2;
+    for (probe = mid; probe <= high && first_desc[2 * probe] < 0; probe++) {
+    }
+    if (probe > high) {
+      /* All processes from mid to high are empty */
+      high = mid - 1;
+    }
+    else if (t8_forest_partition_compare_position (first_desc, probe,
+                                                   gtreeid, desc_id) >= 0) {
+      owner = probe;
+      low = probe + 1;
+    }
+    else {
+      high = mid - 1;
+    }
+  }
+  T8_ASSERT (0 <= owner && owner < forest->mpisize);
+  return owner;
 }
 
 /* Calculate the new element_offset for forest from
@@ -133,6 +243,208 @@ t8_forest_partition_compute_new_offset (t8_forest_t forest)
                              forest->global_num_elements);
 }
 
+/* Calculate the new element_offset for forest from the elements in
+ * forest->set_from, such that the weights given by forest->set_weight_fn
+ * are distributed evenly.
+ * Process p starts at the first element whose exclusive prefix sum of
+ * weights is not smaller than p * W / P, where W is the total weight.
+ * Thus, the first element of p is the number of elements with a prefix
+ * sum smaller than this bound, which each process counts for its local
+ * elements and which we sum up over all processes. */
+static void
+t8_forest_partition_compute_new_offset_weighted (t8_forest_t forest)
+{
+  t8_forest_t         forest_from;
+  sc_MPI_Comm         comm;
+  t8_locidx_t         itree, num_trees, ielem, num_elems;
+  t8_tree_t           tree;
+  t8_eclass_scheme_t *ts;
+  t8_element_t       *element;
+  double             *weights;
+  double              local_weight, prefix_weight, global_weight, bound;
+  t8_gloidx_t        *local_count, *global_count;
+  t8_locidx_t         ilocal;
+  int                 iproc, mpiret, mpisize;
+
+  T8_ASSERT (t8_forest_is_initialized (forest));
+  T8_ASSERT (forest->set_from != NULL);
+  T8_ASSERT (forest->set_weight_fn != NULL);
+
+  forest_from = forest->set_from;
+  comm = forest->mpicomm;
+  mpisize = forest->mpisize;
+
+  /* Compute the weights of the local elements */
+  num_elems = forest_from->local_num_elements;
+  weights = T8_ALLOC (double, SC_MAX (1, num_elems));
+  local_weight = 0;
+  num_trees = t8_forest_get_num_local_trees (forest_from);
+  for (itree = 0, ilocal = 0; itree < num_trees; itree++) {
+    tree = t8_forest_get_tree (forest_from, itree);
+    ts = forest_from->scheme->eclass_schemes[tree->eclass];
+    for (ielem = 0; ielem < (t8_locidx_t) tree->elements.elem_count;
+         ielem++, ilocal++) {
+      element = (t8_element_t *)
+        t8_sc_array_index_locidx (&tree->elements, ielem);
+      weights[ilocal] = forest->set_weight_fn (forest_from, itree, ts,
+                                               element);
+      T8_ASSERT (weights[ilocal] >= 0);
+      local_weight += weights[ilocal];
+    }
+  }
+  T8_ASSERT (ilocal == num_elems);
+
+  /* Compute the weight of all elements on lower processes */
+  mpiret = sc_MPI_Scan (&local_weight, &prefix_weight, 1, sc_MPI_DOUBLE,
+                        sc_MPI_SUM, comm);
+  SC_CHECK_MPI (mpiret);
+  prefix_weight -= local_weight;
+  mpiret = sc_MPI_Allreduce (&local_weight, &global_weight, 1,
+                             sc_MPI_DOUBLE, sc_MPI_SUM, comm);
+  SC_CHECK_MPI (mpiret);
+  if (global_weight <= 0) {
+    /* There is nothing to balance, we distribute the elements evenly */
+    T8_FREE (weights);
+    t8_forest_partition_compute_new_offset (forest);
+    return;
+  }
+
+  /* For each process count the local elements with a smaller prefix sum
+   * than its lower bound. Since the bounds and the prefix sums increase,
+   * we traverse both in one pass. */
+  local_count = T8_ALLOC_ZERO (t8_gloidx_t, mpisize);
+  global_count = T8_ALLOC (t8_gloidx_t, mpisize);
+  ilocal = 0;
+  for (iproc = 1; iproc < mpisize; iproc++) {
+    bound = global_weight * iproc / mpisize;
+    while (ilocal < num_elems && prefix_weight < bound) {
+      prefix_weight += weights[ilocal++];
+    }
+    local_count[iproc] = ilocal;
+  }
+  T8_FREE (weights);
+  mpiret = sc_MPI_Allreduce (local_count, global_count, mpisize,
+                             T8_MPI_GLOIDX, sc_MPI_SUM, comm);
+  SC_CHECK_MPI (mpiret);
+
+  /* Set the shmem array type to comm */
+  sc_shmem_set_type (comm, T8_SHMEM_BEST_TYPE);
+  /* Initialize the shmem array */
+  t8_shmem_array_init (&forest->element_offsets, sizeof (t8_gloidx_t),
+                       forest->mpisize + 1, comm);
+  if (t8_shmem_array_start_writing (forest->element_offsets)) {
+    for (iproc = 0; iproc < mpisize; iproc++) {
+      T8_ASSERT (0 <= global_count[iproc] &&
+                 global_count[iproc] <= forest_from->global_num_elements);
+      T8_ASSERT (iproc == 0
+                 || global_count[iproc - 1] <= global_count[iproc]);
+      t8_shmem_array_set_gloidx (forest->element_offsets, iproc,
+                                 global_count[iproc]);
+    }
+    t8_shmem_array_set_gloidx (forest->element_offsets, forest->mpisize,
+                               forest->global_num_elements);
+  }
+  t8_shmem_array_end_writing (forest->element_offsets);
+  T8_FREE (local_count);
+  T8_FREE (global_count);
+}
+
+/* The elements that a process can access when it adapts the partition
+ * boundaries for coarsening: its local elements and the elements that it
+ * received from its neighbor processes.
+ * Each received element is stored in a record consisting of its global
+ * tree id and the element bytes. */
+typedef struct
+{
+  t8_gloidx_t         first_local;      /* global index of the first local element */
+  t8_locidx_t         num_local;        /* number of local elements */
+  size_t              record_size;      /* size of one record in bytes */
+  int                 num_prev;         /* number of records from the lower neighbor */
+  int                 num_next;         /* number of records from the upper neighbor */
+  char               *prev;             /* the last elements of the lower neighbor */
+  char               *next;             /* the first elements of the upper neighbor */
+} t8_forest_partition_window_t;
+
+/* Return the global tree id and a pointer to the element with global index
+ * gelement of forest, if it is contained in the window.
+ * Return false if it is not. */
+static int
+t8_forest_partition_window_get (t8_forest_t forest,
+                                t8_forest_partition_window_t * window,
+                                t8_gloidx_t gelement, t8_gloidx_t * gtreeid,
+                                t8_element_t ** element)
+{
+  t8_gloidx_t         index;
+  t8_locidx_t         low, high, mid;
+  t8_tree_t           tree;
+  char               *record;
+  int64_t             record_tree;
+
+  index = gelement - window->first_local;
+  if (index < -window->num_prev
+      || index >= window->num_local + window->num_next) {
+    return 0;
+  }
+  if (index < 0 || index >= window->num_local) {
+    /* The element is stored in a received record */
+    record = index < 0 ? window->prev + (window->num_prev + index) *
+      window->record_size : window->next + (index - window->num_local) *
+      window->record_size;
+    memcpy (&record_tree, record, sizeof (int64_t));
+    *gtreeid = record_tree;
+    *element = (t8_element_t *) (record + sizeof (int64_t));
+    return 1;
+  }
+  /* The element is local, we search its tree */
+  low = 0;
+  high = t8_forest_get_num_local_trees (forest) - 1;
+  while (low < high) {
+    mid = (low + high + 1) / 2;
+    tree = t8_forest_get_tree (forest, mid);
+    if (tree->elements_offset <= index) {
+      low = mid;
+    }
+    else {
+      high = mid - 1;
+    }
+  }
+  tree = t8_forest_get_tree (forest, low);
+  T8_ASSERT (tree->elements_offset <= index && index <
+             tree->elements_offset + (t8_locidx_t) tree->elements.elem_count);
+  *gtreeid = forest->first_local_tree + low;
+  *element = (t8_element_t *)
+    t8_sc_array_index_locidx (&tree->elements,
+                              (t8_locidx_t) index - tree->elements_offset);
+  return 1;
+}
+
+/* Pack the local elements with indices first to first + count - 1
+ * into records. */
+static void
+t8_forest_partition_window_pack (t8_forest_t forest,
+                                 t8_forest_partition_window_t * window,
+                                 t8_locidx_t first, int count, char *buffer)
+{
+  t8_gloidx_t         gtreeid;
+  t8_element_t       *element;
+  t8_tree_t           tree;
+  int64_t             record_tree;
+  int                 i;
+
+  for (i = 0; i < count; i++) {
+    if (!t8_forest_partition_window_get (forest, window,
+                                         window->first_local + first + i,
+                                         &gtreeid, &element)) {
+      SC_ABORT_NOT_REACHED ();
+    }
+    tree = t8_forest_get_tree (forest, gtreeid - forest->first_local_tree);
+    record_tree = gtreeid;
+    memcpy (buffer, &record_tree, sizeof (int64_t));
+    memcpy (buffer + sizeof (int64_t), element, tree->elements.elem_size);
+    buffer += window->record_size;
+  }
+}
+
 /* Find the owner of a given element.
  */
 static int
@@ -145,17 +457,222 @@ t8_forest_partition_owner_of_element (int mpisize, t8_gloidx_t gelement,
   return t8_offset_any_owner_of_tree (mpisize, gelement, offset);
 }
 
-/* Compute the first and last rank that we need to receive elements from */
+/* Change the new element offsets of forest, such that no family of
+ * elements of forest->set_from is split between two processes.
+ * The first element of a process is part of a family that is split by
+ * the boundary, if its child id is not zero. Since a family has at most
+ * max_children members, each process exchanges its first and last
+ * max_children - 1 elements with its neighbor processes. Afterwards, the
+ * process that owns the first element of a new partition checks whether
+ * it belongs to a complete family and sends the shift of the boundary to
+ * the nearest end of the family to the process that starts there.
+ * Each process thus receives at most one shift and the new offsets are
+ * gathered again.
+ * If an old process is empty, families that straddle it are not found. */
+static void
+t8_forest_partition_for_coarsening (t8_forest_t forest)
+{
+  t8_forest_t         forest_from;
+  sc_MPI_Comm         comm;
+  sc_MPI_Request      requests[4];
+  sc_MPI_Status       status[4];
+  t8_forest_partition_window_t window;
+  t8_eclass_scheme_t *ts;
+  t8_element_t       *element, *fam[T8_ECLASS_MAX_CORNERS];
+  sc_MPI_Request     *requests_shift;
+  t8_gloidx_t        *offset_new, *offset_old, *shift;
+  t8_gloidx_t         gelement, gtreeid, family_tree, family_first;
+  t8_gloidx_t         my_first, my_shift;
+  size_t              max_size;
+  char               *send_prev, *send_next;
+  int                 max_children, num_send, num_requests;
+  int                 iproc, ichild, num_children, child_id, is_family;
+  int                 recv_count, mpiret, eclass, low, high, ishift;
+
+  T8_ASSERT (forest->set_from != NULL);
+  T8_ASSERT (forest->element_offsets != NULL);
+
+  forest_from = forest->set_from;
+  comm = forest->mpicomm;
+
+  /* Compute the maximum number of children and the record size */
+  max_children = 1;
+  max_size = 0;
+  for (eclass = T8_ECLASS_ZERO; eclass < T8_ECLASS_COUNT; eclass++) {
+    ts = forest_from->scheme->eclass_schemes[eclass];
+    if (ts != NULL) {
+      max_children = SC_MAX (max_children, t8_eclass_num_children[eclass]);
+      max_size = SC_MAX (max_size, t8_element_size (ts));
+    }
+  }
+  T8_ASSERT (max_children <= T8_ECLASS_MAX_CORNERS);
+  window.record_size = sizeof (int64_t) + max_size;
+  window.record_size += T8_ADD_PADDING (window.record_size);
+  window.first_local = t8_shmem_array_get_gloidx (forest_from->element_offsets,
+                                                  forest->mpirank);
+  window.num_local = forest_from->local_num_elements;
+  window.num_prev = window.num_next = 0;
+
+  /* Exchange the first and last elements with the neighbor processes */
+  num_send = SC_MIN (max_children - 1, window.num_local);
+  window.prev = T8_ALLOC (char, (max_children - 1) * window.record_size);
+  window.next = T8_ALLOC (char, (max_children - 1) * window.record_size);
+  send_prev = T8_ALLOC (char, SC_MAX (1, num_send) * window.record_size);
+  send_next = T8_ALLOC (char, SC_MAX (1, num_send) * window.record_size);
+  num_requests = 0;
+  if (forest->mpirank > 0) {
+    mpiret = sc_MPI_Irecv (window.prev, (max_children - 1) *
+                           window.record_size, sc_MPI_BYTE,
+                           forest->mpirank - 1, T8_MPI_PARTITION_COARSEN,
+                           comm, requests + num_requests++);
+    SC_CHECK_MPI (mpiret);
+    t8_forest_partition_window_pack (forest_from, &window, 0, num_send,
+                                     send_prev);
+    mpiret = sc_MPI_Isend (send_prev, num_send * window.record_size,
+                           sc_MPI_BYTE, forest->mpirank - 1,
+                           T8_MPI_PARTITION_COARSEN, comm,
+                           requests + num_requests++);
+    SC_CHECK_MPI (mpiret);
+  }
+  if (forest->mpirank < forest->mpisize - 1) {
+    mpiret = sc_MPI_Irecv (window.next, (max_children - 1) *
+                           window.record_size, sc_MPI_BYTE,
+                           forest->mpirank + 1, T8_MPI_PARTITION_COARSEN,
+                           comm, requests + num_requests++);
+    SC_CHECK_MPI (mpiret);
+    t8_forest_partition_window_pack (forest_from, &window,
+                                     window.num_local - num_send, num_send,
+                                     send_next);
+    mpiret = sc_MPI_Isend (send_next, num_send * window.record_size,
+                           sc_MPI_BYTE, forest->mpirank + 1,
+                           T8_MPI_PARTITION_COARSEN, comm,
+                           requests + num_requests++);
+    SC_CHECK_MPI (mpiret);
+  }
+  mpiret = sc_MPI_Waitall (num_requests, requests, status);
+  SC_CHECK_MPI (mpiret);
+  num_requests = 0;
+  if (forest->mpirank > 0) {
+    mpiret = sc_MPI_Get_count (status, sc_MPI_BYTE, &recv_count);
+    SC_CHECK_MPI (mpiret);
+    window.num_prev = recv_count / window.record_size;
+    num_requests = 2;
+  }
+  if (forest->mpirank < forest->mpisize - 1) {
+    mpiret = sc_MPI_Get_count (status + num_requests, sc_MPI_BYTE,
+                               &recv_count);
+    SC_CHECK_MPI (mpiret);
+    window.num_next = recv_count / window.record_size;
+  }
+  T8_FREE (send_prev);
+  T8_FREE (send_next);
+
+  /* Check the new partition boundaries that lie in our range.
+   * We find the first process whose new first element is not smaller than
+   * our first element by binary search. */
+  offset_new = t8_shmem_array_get_gloidx_array (forest->element_offsets);
+  offset_old = t8_shmem_array_get_gloidx_array (forest_from->element_offsets);
+  low = 1;
+  high = forest->mpisize;
+  while (low < high) {
+    iproc = (low + high) / 2;
+    if (offset_new[iproc] < window.first_local) {
+      low = iproc + 1;
+    }
+    else {
+      high = iproc;
+    }
+  }
+  num_send = 0;
+  for (iproc = low; iproc < forest->mpisize &&
+       offset_new[iproc] < window.first_local + window.num_local; iproc++) {
+    num_send++;
+  }
+  shift = T8_ALLOC_ZERO (t8_gloidx_t, SC_MAX (1, num_send));
+  for (ishift = 0; ishift < num_send; ishift++) {
+    gelement = offset_new[low + ishift];
+    t8_forest_partition_window_get (forest_from, &window, gelement,
+                                    &family_tree, &element);
+    ts = forest_from->scheme->eclass_schemes
+      [t8_forest_get_tree (forest_from, family_tree -
+                           forest_from->first_local_tree)->eclass];
+    if (t8_element_level (ts, element) == 0
+        || (child_id = t8_element_child_id (ts, element)) == 0) {
+      /* The boundary does not split a family */
+      continue;
+    }
+    /* Collect the possible siblings of the element */
+    num_children = t8_eclass_num_children[ts->eclass];
+    family_first = gelement - child_id;
+    for (ichild = 0, is_family = 1; ichild < num_children && is_family;
+         ichild++) {
+      is_family =
+        t8_forest_partition_window_get (forest_from, &window,
+                                        family_first + ichild, &gtreeid,
+                                        fam + ichild)
+        && gtreeid == family_tree
+        && t8_element_child_id (ts, fam[ichild]) == ichild;
+    }
+    if (is_family && t8_element_is_family (ts, fam)) {
+      /* Move the boundary to the nearest end of the family */
+      shift[ishift] = child_id < num_children - child_id ? -child_id
+        : num_children - child_id;
+    }
+  }
+  T8_FREE (window.prev);
+  T8_FREE (window.next);
+
+  /* Each shift is only needed by the process whose first element is moved.
+   * We send it to this process and receive the shift of our own first
+   * element from the old owner of this element. */
+  requests_shift = T8_ALLOC (sc_MPI_Request, SC_MAX (1, num_send));
+  my_shift = 0;
+  num_requests = 0;
+  for (ishift = 0; ishift < num_send; ishift++) {
+    if (low + ishift == forest->mpirank) {
+      my_shift = shift[ishift];
+      continue;
+    }
+    mpiret = sc_MPI_Isend (shift + ishift, 1, T8_MPI_GLOIDX, low + ishift,
+                           T8_MPI_PARTITION_COARSEN, comm,
+                           requests_shift + num_requests++);
+    SC_CHECK_MPI (mpiret);
+  }
+  my_first = offset_new[forest->mpirank];
+  if (forest->mpirank > 0 && my_first < forest->global_num_elements) {
+    iproc = t8_forest_partition_owner_of_element (forest->mpisize, my_first,
+                                                  offset_old);
+    if (iproc != forest->mpirank) {
+      mpiret = sc_MPI_Recv (&my_shift, 1, T8_MPI_GLOIDX, iproc,
+                            T8_MPI_PARTITION_COARSEN, comm,
+                            sc_MPI_STATUS_IGNORE);
+      SC_CHECK_MPI (mpiret);
+    }
+  }
+  my_first += my_shift;
+  mpiret = sc_MPI_Waitall (num_requests, requests_shift,
+                           sc_MPI_STATUSES_IGNORE);
+  SC_CHECK_MPI (mpiret);
+  T8_FREE (requests_shift);
+  T8_FREE (shift);
+
+  /* Rebuild the offset array from the new first elements. Since the other
+   * processes may still read the old array, we do not overwrite it. */
+  t8_shmem_array_destroy (&forest->element_offsets);
+  t8_forest_partition_gather_offsets (forest, my_first);
+}
+
+/* Compute the first and last rank that we need to receive elements from,
+ * when forest is partitioned from forest_from */
 static void
-t8_forest_partition_recvrange (t8_forest_t forest, int *recv_first,
-                               int *recv_last)
+t8_forest_partition_recvrange (t8_forest_t forest, t8_forest_t forest_from,
+                               int *recv_first, int *recv_last)
 {
   t8_gloidx_t         first_element, last_element;
   t8_gloidx_t        *offset_old, *offset_new;
 
   /* Get the old element offset array */
-  offset_old =
-    t8_shmem_array_get_gloidx_array (forest->set_from->element_offsets);
+  offset_old = t8_shmem_array_get_gloidx_array (forest_from->element_offsets);
   /* Get the new element offset array */
   offset_new = t8_shmem_array_get_gloidx_array (forest->element_offsets);
   /* Compute new first and last element on this process from offset array */
@@ -179,26 +696,26 @@ t8_forest_partition_recvrange (t8_forest_t forest, int *recv_first,
                                                      offset_old);
 }
 
-/* Compute the first and last rank that we need to send elements to */
+/* Compute the first and last rank that we need to send elements to,
+ * when forest is partitioned from forest_from */
 static void
-t8_forest_partition_sendrange (t8_forest_t forest, int *send_first,
-                               int *send_last)
+t8_forest_partition_sendrange (t8_forest_t forest, t8_forest_t forest_from,
+                               int *send_first, int *send_last)
 {
   t8_gloidx_t         first_element, last_element;
   t8_gloidx_t        *offset_old, *offset_new;
 
   t8_debugf ("Calculate sendrange\n");
-  if (forest->set_from->local_num_elements == 0) {
+  if (forest_from->local_num_elements == 0) {
     /* There are no elements to send */
     *send_first = 0;
     *send_last = -1;
     return;
   }
   /* Get the old element offset array */
-  offset_old =
-    t8_shmem_array_get_gloidx_array (forest->set_from->element_offsets);
+  offset_old = t8_shmem_array_get_gloidx_array (forest_from->element_offsets);
   t8_debugf ("Partition forest from:\n");
-  t8_offset_print (forest->set_from->element_offsets, forest->mpicomm);
+  t8_offset_print (forest_from->element_offsets, forest->mpicomm);
   /* Get the new element offset array */
   offset_new = t8_shmem_array_get_gloidx_array (forest->element_offsets);
   t8_debugf ("Partition forest to:\n");
@@ -257,6 +774,23 @@ t8_forest_partition_tree_first_last_el (t8_tree_t tree,
   return 0;
 }
 
+/* Return the number of bytes of the tree infos at the beginning of a
+ * send buffer with \a num_trees trees, including the number of trees
+ * and the padding after it. */
+static              size_t
+t8_forest_partition_header_bytes (t8_locidx_t num_trees)
+{
+  size_t              bytes;
+
+  /* The number of trees, ... */
+  bytes = sizeof (t8_locidx_t);
+  /* padding, ... */
+  bytes += T8_ADD_PADDING (bytes);
+  /* and an info struct for each tree */
+  bytes += num_trees * sizeof (t8_forest_partition_tree_info_t);
+  return bytes;
+}
+
 /* Fill the send buffers for one send operation.
  * \param [in]  forest_from     The original forest
  * \param [in]  send_buffer     Unallocated send_buffer
@@ -269,6 +803,9 @@ t8_forest_partition_tree_first_last_el (t8_tree_t tree,
 /* The send buffer will look like this:
  *
  * | number of trees | padding | tree_1 info | ... | tree_n info | tree_1 elements | ... | tree_n elements |
+ *
+ * It is sent in two messages. The first one ends after the tree infos,
+ * such that the receiver knows where the elements go before they arrive.
  */
 static void
 t8_forest_partition_fill_buffer (t8_forest_t forest_from,
@@ -309,22 +846,17 @@ t8_forest_partition_fill_buffer (t8_forest_t forest_from,
     num_elements_send = last_tree_element - first_tree_element + 1;
     T8_ASSERT (num_elements_send > 0);
     element_alloc += num_elements_send * tree->elements.elem_size;
-    current_element += last_tree_element + 1;
+    current_element += num_elements_send;
     num_trees_send++;
     tree_id++;
   }
   /* We calculate the total number of bytes that we need to allocate
    * and allocate the buffer */
-  /* The buffer consists of the number of trees, ... */
-  byte_alloc = sizeof (t8_locidx_t);
-  /* padding, ... */
-  byte_alloc += T8_ADD_PADDING (byte_alloc);
-  /* Store the position of the first tree info struct in the buffer */
-  tree_info_pos = byte_alloc;
+  /* The buffer consists of the number of trees, padding, ... */
+  tree_info_pos = t8_forest_partition_header_bytes (0);
   /* an info struct for each tree, ... */
-  byte_alloc += num_trees_send * sizeof (t8_forest_partition_tree_info_t);
-  /* Store the position of the first element in the buffer */
-  element_pos = byte_alloc;
+  element_pos = t8_forest_partition_header_bytes (num_trees_send);
+  byte_alloc = element_pos;
   /* and the bytes for each tree's elements */
   byte_alloc += element_alloc;
   /* Note, that we do not add padding after the info structs and
@@ -370,22 +902,28 @@ t8_forest_partition_fill_buffer (t8_forest_t forest_from,
   t8_debugf ("Post send of %i trees\n", num_trees_send);
 }
 
-/* Carry out all sending of elements */
+/* Carry out all sending of elements.
+ * The elements that stay on this process are not sent. Instead, we store
+ * the local indices of the first and last of them in self_first and
+ * self_last. If no element stays, self_last < self_first. */
 static void
 t8_forest_partition_sendloop (t8_forest_t forest, int send_first,
                               int send_last, sc_MPI_Request ** requests,
-                              int *num_request_alloc, char ***send_buffer)
+                              int *num_request_alloc, char ***send_buffer,
+                              t8_locidx_t * self_first,
+                              t8_locidx_t * self_last)
 {
   int                 iproc, mpiret;
   t8_gloidx_t         gfirst_element_send, glast_element_send;
   t8_gloidx_t         gfirst_local_element;
   t8_locidx_t         first_element_send, last_element_send;
   t8_locidx_t         current_tree;
-  t8_locidx_t         num_elements_send;
+  t8_locidx_t         num_elements_send, num_trees;
   t8_gloidx_t        *offset_to, *offset_from;
   t8_forest_t         forest_from;
+  t8_tree_t           tree;
   char              **buffer;
-  int                 buffer_alloc;
+  int                 buffer_alloc, header_bytes, num_procs;
   sc_MPI_Comm         comm;
 
   t8_debugf ("Start send loop\n");
@@ -394,15 +932,19 @@ t8_forest_partition_sendloop (t8_forest_t forest, int send_first,
   T8_ASSERT (t8_forest_is_committed (forest_from));
 
   comm = forest->mpicomm;
-  /* Determine the number of requests for MPI communication. */
-  /* TODO: Currently we also send to ourselves via MPI. We can optimize this. */
-  *num_request_alloc = send_last - send_first + 1;
-  if (*num_request_alloc < 0) {
+  *self_first = 0;
+  *self_last = -1;
+  /* Determine the number of requests for MPI communication.
+   * We need two requests for each process, one for the tree infos and
+   * one for the elements. The requests to ourselves stay unused. */
+  num_procs = send_last - send_first + 1;
+  if (num_procs < 0) {
     /* If there are no processes to send to, this value could get
      * negative */
-    *num_request_alloc = 0;
+    num_procs = 0;
     T8_ASSERT (send_last - send_first + 1 == 0);
   }
+  *num_request_alloc = 2 * num_procs;
   *requests = T8_ALLOC (sc_MPI_Request, *num_request_alloc);
 
   /* Allocate memory for pointers to the send buffers */
@@ -453,30 +995,54 @@ t8_forest_partition_sendloop (t8_forest_t forest, int send_first,
     /* We now know the local indices of the first and last element that
      * we send to proc. */
     buffer = *send_buffer + iproc - send_first;
-    if (num_elements_send > 0) {
+    if (num_elements_send > 0 && iproc == forest->mpirank) {
+      /* These elements stay on this process, they are copied in
+       * the receive loop */
+      *self_first = first_element_send;
+      *self_last = last_element_send;
+      *(*requests + iproc - send_first) = sc_MPI_REQUEST_NULL;
+      *(*requests + num_procs + iproc - send_first) = sc_MPI_REQUEST_NULL;
+      /* Advance to the tree containing the next element that we send */
+      num_trees = t8_forest_get_num_local_trees (forest_from);
+      while (current_tree < num_trees) {
+        tree = t8_forest_get_tree (forest_from, current_tree);
+        if (tree->elements_offset + (t8_locidx_t) tree->elements.elem_count
+            > last_element_send + 1) {
+          break;
+        }
+        current_tree++;
+      }
+      t8_debugf ("Keep %li elements on this process\n",
+                 (long) num_elements_send);
+    }
+    else if (num_elements_send > 0) {
       /* Fill the buffer with the elements on the current tree */
       t8_forest_partition_fill_buffer (forest_from,
                                        buffer, &buffer_alloc,
                                        &current_tree, first_element_send,
                                        last_element_send);
-      /* Post the MPI Send.
-       * TODO: This will also send to ourselves if proc==mpirank */
+      /* Post the MPI Sends of the tree infos and of the elements. */
       t8_debugf ("Post send of %li elements (%i bytes) to process %i\n",
                  (long) num_elements_send, buffer_alloc, iproc);
-      mpiret = sc_MPI_Isend (*buffer, buffer_alloc, sc_MPI_BYTE, iproc,
+      header_bytes = (int)
+        t8_forest_partition_header_bytes (*(t8_locidx_t *) * buffer);
+      mpiret = sc_MPI_Isend (*buffer, header_bytes, sc_MPI_BYTE, iproc,
                              T8_MPI_PARTITION_FOREST, comm,
                              *requests + iproc - send_first);
       SC_CHECK_MPI (mpiret);
+      mpiret = sc_MPI_Isend (*buffer + header_bytes,
+                             buffer_alloc - header_bytes, sc_MPI_BYTE, iproc,
+                             T8_MPI_PARTITION_ELEMENTS, comm,
+                             *requests + num_procs + iproc - send_first);
+      SC_CHECK_MPI (mpiret);
       if (forest->profile != NULL) {
-        if (iproc != forest->mpirank) {
-          /* If profiling is enabled we count the number of elements sent to
-           * other processes */
-          forest->profile->partition_elements_shipped += num_elements_send;
-          /* The number of procs we send to */
-          forest->profile->partition_procs_sent += 1;
-          /* The number of bytes that we send */
-          forest->profile->partition_bytes_sent += buffer_alloc;
-        }
+        /* If profiling is enabled we count the number of elements sent to
+         * other processes */
+        forest->profile->partition_elements_shipped += num_elements_send;
+        /* The number of procs we send to */
+        forest->profile->partition_procs_sent += 1;
+        /* The number of bytes that we send */
+        forest->profile->partition_bytes_sent += buffer_alloc;
       }
     }
     else {
@@ -484,176 +1050,234 @@ t8_forest_partition_sendloop (t8_forest_t forest, int send_first,
       /* Set the request to NULL, such that it is ignored when we wait for
        * the requests to complete */
       *(*requests + iproc - send_first) = sc_MPI_REQUEST_NULL;
+      *(*requests + num_procs + iproc - send_first) = sc_MPI_REQUEST_NULL;
     }
   }
   t8_debugf ("End send loop\n");
 }
 
-/* Receive a message send in sendloop to this rank.
- * \param [in]  forest      The new forest.
- * \param [in]  comm        The MPI communicator.
- * \param [in]  proc        The rank from which we receive.
- * \param [in]  status      MPI status with which we probed for the message.
- * \param [in]  prev_recvd  The count of messages that we already received.
- * It is important, that we receive the messages in order to properly fill the
- * forest->trees array.
+/* Add a piece of consecutive elements of one tree to the layout of the
+ * new forest. The pieces must be added in the order of the elements.
+ * A new tree is pushed to forest->trees if the piece does not continue
+ * the last tree. Its elements array is not allocated, since the number
+ * of elements of the tree is only known when all pieces are added.
+ * forest->local_num_elements counts the elements of all added pieces.
+ * \param [in,out] forest   The new forest.
+ * \param [in]     info     The tree and number of elements of the piece.
+ * \param [out]    ltreeid  The local id of the tree of the piece.
+ * \param [out]    position The position of the piece's first element in
+ *                          its tree.
  */
 static void
-t8_forest_partition_recv_message (t8_forest_t forest, sc_MPI_Comm comm,
-                                  int proc, sc_MPI_Status * status,
-                                  int prev_recvd)
+t8_forest_partition_add_piece (t8_forest_t forest,
+                               const t8_forest_partition_tree_info_t * info,
+                               t8_locidx_t * ltreeid, t8_locidx_t * position)
 {
-  int                 mpiret;
-  int                 recv_bytes;
-  char               *recv_buffer;
-  t8_locidx_t         num_trees, itree;
-  t8_locidx_t         num_elements_recv;
-  t8_locidx_t         old_num_elements, new_num_elements;
-  size_t              tree_cursor, element_cursor;
-  t8_forest_partition_tree_info_t *tree_info;
-  t8_tree_t           tree, last_tree;
-  size_t              element_size;
-  void               *first_new_element;
-
-  T8_ASSERT (proc == status->MPI_SOURCE);
-  T8_ASSERT (status->MPI_TAG == T8_MPI_PARTITION_FOREST);
+  t8_tree_t           tree;
 
-  /* Get the number of bytes to receive */
-  mpiret = sc_MPI_Get_count (status, sc_MPI_BYTE, &recv_bytes);
-  SC_CHECK_MPI (mpiret);
-  t8_debugf ("Receiving message of %i bytes from process %i\n", recv_bytes,
-             proc);
-  /* allocate the receive buffer */
-  recv_buffer = T8_ALLOC (char, recv_bytes);
-  /* receive the message */
-  mpiret = sc_MPI_Recv (recv_buffer, recv_bytes, sc_MPI_BYTE, proc,
-                        T8_MPI_PARTITION_FOREST, comm, sc_MPI_STATUS_IGNORE);
-  SC_CHECK_MPI (mpiret);
-  /* Read the number of trees, it is the first locidx_t in recv_buffer */
-  num_trees = *(t8_locidx_t *) recv_buffer;
-  /* Set the tree cursor to the first tree info entry in recv_buffer */
-  tree_cursor = sizeof (t8_locidx_t) + T8_ADD_PADDING (sizeof (t8_locidx_t));
-  /* Set the element cursor to the first element entry in recv_buffer */
-  element_cursor = tree_cursor +
-    num_trees * sizeof (t8_forest_partition_tree_info_t);
-  /* Get the information for the first tree */
-  tree_info = (t8_forest_partition_tree_info_t *) (recv_buffer + tree_cursor);
-  if (prev_recvd == 0) {
+  if (forest->trees->elem_count == 0) {
     /* This is the first tree ever that we receive */
-    /* We set the forests first local tree id */
-    forest->first_local_tree = tree_info->gtree_id;
-    /* In last_local_tree we keep track of the latest tree we received */
-    forest->last_local_tree = tree_info->gtree_id - 1;
+    forest->first_local_tree = info->gtree_id;
+    forest->last_local_tree = info->gtree_id - 1;
+  }
+  T8_ASSERT (info->gtree_id >= forest->last_local_tree);
+  if (info->gtree_id > forest->last_local_tree) {
+    /* The piece starts a new tree. Its element offset is the number of
+     * elements of all previous pieces. */
+    tree = (t8_tree_t) sc_array_push (forest->trees);
+    tree->eclass = info->eclass;
+    tree->elements_offset = forest->local_num_elements;
+    forest->last_local_tree = info->gtree_id;
+  }
+  *ltreeid = (t8_locidx_t) forest->trees->elem_count - 1;
+  tree = t8_forest_get_tree (forest, *ltreeid);
+  T8_ASSERT (tree->eclass == info->eclass);
+  *position = forest->local_num_elements - tree->elements_offset;
+  forest->local_num_elements += info->num_elements;
+}
+
+/* Return the number of elements of a new tree, while the trees of the
+ * new forest are built up and their elements are not yet allocated.
+ * It is the difference of the tree's element offset and the offset of
+ * the next tree, or the number of local elements for the last tree. */
+static              t8_locidx_t
+t8_forest_partition_new_tree_count (t8_forest_t forest, t8_locidx_t ltreeid)
+{
+  t8_locidx_t         next_offset;
+
+  if (ltreeid + 1 < t8_forest_get_num_local_trees (forest)) {
+    next_offset = t8_forest_get_tree (forest, ltreeid + 1)->elements_offset;
+  }
+  else {
+    next_offset = forest->local_num_elements;
+  }
+  return next_offset - t8_forest_get_tree (forest, ltreeid)->elements_offset;
+}
+
+/* Copy the elements of consecutive tree pieces to their place in the
+ * trees of the new forest.
+ * \param [in,out] forest   The new forest with allocated trees.
+ * \param [in]     num_pieces The number of pieces.
+ * \param [in]     infos    The tree info of each piece.
+ * \param [in]     ltreeid  The local tree of the first piece.
+ *                          Each further piece starts a new tree.
+ * \param [in]     position The position of the first piece in its tree.
+ * \param [in]     elements The elements of all pieces, one after another.
+ */
+static void
+t8_forest_partition_place_pieces (t8_forest_t forest, t8_locidx_t num_pieces,
+                                  const t8_forest_partition_tree_info_t *
+                                  infos, t8_locidx_t ltreeid,
+                                  t8_locidx_t position, const char *elements)
+{
+  t8_locidx_t         ipiece;
+  t8_tree_t           tree;
+  size_t              bytes;
+
+  for (ipiece = 0; ipiece < num_pieces; ipiece++) {
+    tree = t8_forest_get_tree (forest, ltreeid + ipiece);
+    T8_ASSERT (tree->eclass == infos[ipiece].eclass);
+    T8_ASSERT (ipiece == 0 || position == 0);
+    T8_ASSERT (position + infos[ipiece].num_elements <=
+               t8_forest_get_tree_element_count (tree));
+    bytes = infos[ipiece].num_elements * tree->elements.elem_size;
+    memcpy (t8_sc_array_index_locidx (&tree->elements, position), elements,
+            bytes);
+    elements += bytes;
+    position = 0;
   }
-  num_elements_recv = 0;
+}
+
+/* Compute the tree pieces of the elements of forest->set_from with local
+ * indices self_first to self_last, that stay on this process.
+ * \param [in]  forest_from The forest that is partitioned.
+ * \param [out] infos       An initialized array of
+ *                          t8_forest_partition_tree_info_t. On output,
+ *                          it holds one entry for each piece.
+ */
+static void
+t8_forest_partition_self_pieces (t8_forest_t forest_from,
+                                 t8_locidx_t self_first,
+                                 t8_locidx_t self_last, sc_array_t * infos)
+{
+  t8_tree_t           tree_from;
+  t8_locidx_t         itree, num_trees, first_tree_el, last_tree_el;
+  t8_forest_partition_tree_info_t *info;
+
+  T8_ASSERT (0 <= self_first && self_first <= self_last);
+  T8_ASSERT (self_last < forest_from->local_num_elements);
+  num_trees = t8_forest_get_num_local_trees (forest_from);
   for (itree = 0; itree < num_trees; itree++) {
-    num_elements_recv += tree_info->num_elements;
-    T8_ASSERT (tree_info->gtree_id >= forest->last_local_tree);
-    if (tree_info->gtree_id > forest->last_local_tree) {
-      /* We will insert a new tree in the forest */
-      tree = (t8_tree_t) sc_array_push (forest->trees);
-      tree->eclass = tree_info->eclass;
-      /* Calculate the element offset of the new tree */
-      if (forest->last_local_tree >= forest->first_local_tree) {
-        /* If there is a previous tree, we read it */
-        last_tree =
-          (t8_tree_t) t8_sc_array_index_locidx (forest->trees,
-                                                forest->trees->elem_count -
-                                                1);
-        /* The element offset is the offset of the previous tree plus the number of
-         * elements in the previous tree */
-        tree->elements_offset = last_tree->elements_offset +
-          t8_forest_get_tree_element_count (last_tree);
-      }
-      else {
-        /* This is the first tree, the element offset is thus zero */
-        tree->elements_offset = 0;
-      }
-      /* Done calculating the element offset */
-      /* Get the size of an element of the tree */
-      element_size =
-        t8_element_size (forest->scheme->eclass_schemes[tree->eclass]);
-      /* initialize the elements array */
-      sc_array_init_size (&tree->elements, element_size,
-                          tree_info->num_elements);
-#if 0
-      /* Debugging output */
-      t8_debugf ("receive %li elements for tree %lli\n",
-                 (long) tree_info->num_elements,
-                 (long long) tree_info->gtree_id);
-#endif
-      /* Copy the elements from the receive buffer to the elements array */
-      T8_ASSERT (element_cursor + tree_info->num_elements * element_size <=
-                 (size_t) recv_bytes);
-      memcpy (tree->elements.array, recv_buffer + element_cursor,
-              tree_info->num_elements * element_size);
+    tree_from = t8_forest_get_tree (forest_from, itree);
+    if (tree_from->elements_offset > self_last) {
+      break;
+    }
+    if (tree_from->elements_offset +
+        (t8_locidx_t) tree_from->elements.elem_count <= self_first) {
+      continue;
+    }
+    /* Compute the range of elements of this tree that stay */
+    first_tree_el = SC_MAX (self_first - tree_from->elements_offset, 0);
+    last_tree_el = SC_MIN (self_last - tree_from->elements_offset,
+                           (t8_locidx_t) tree_from->elements.elem_count -
+                           1);
+    info = (t8_forest_partition_tree_info_t *) sc_array_push (infos);
+    info->gtree_id = forest_from->first_local_tree + itree;
+    info->eclass = tree_from->eclass;
+    info->num_elements = last_tree_el - first_tree_el + 1;
+  }
+}
+
+/* Move the elements of forest->set_from with local indices self_first to
+ * self_last, that stay on this process, to their place in the new forest.
+ * \param [in,out] forest   The new forest.
+ * \param [in]     infos    The pieces computed by
+ *                          \ref t8_forest_partition_self_pieces.
+ * \param [in]     ltreeid  The local tree of the first piece.
+ * \param [in]     position The position of the first piece in its tree.
+ * \param [in]     first_adopt The pieces with this and larger indices
+ *                          start a new tree with the first element of an
+ *                          old tree. Their new trees take over the element
+ *                          array of the old tree and must not be allocated.
+ *                          The elements of the other pieces are copied.
+ */
+static void
+t8_forest_partition_place_self (t8_forest_t forest, t8_locidx_t self_first,
+                                sc_array_t * infos,
+                                t8_locidx_t ltreeid, t8_locidx_t position,
+                                size_t first_adopt)
+{
+  t8_forest_t         forest_from;
+  t8_forest_partition_tree_info_t *info;
+  t8_tree_t           tree, tree_from;
+  t8_locidx_t         first_tree_el;
+  size_t              ipiece, element_size;
+
+  forest_from = forest->set_from;
+  for (ipiece = 0; ipiece < infos->elem_count; ipiece++) {
+    info = (t8_forest_partition_tree_info_t *) sc_array_index (infos, ipiece);
+    tree = t8_forest_get_tree (forest, ltreeid + ipiece);
+    tree_from = t8_forest_get_tree (forest_from, info->gtree_id -
+                                    forest_from->first_local_tree);
+    element_size = tree_from->elements.elem_size;
+    first_tree_el = SC_MAX (self_first - tree_from->elements_offset, 0);
+    if (ipiece >= first_adopt) {
+      /* Take over the element array of the old tree and cut it to the
+       * size of the new tree */
+      T8_ASSERT (first_tree_el == 0 && position == 0);
+      tree->elements = tree_from->elements;
+      sc_array_init (&tree_from->elements, element_size);
+      sc_array_resize (&tree->elements,
+                       t8_forest_partition_new_tree_count (forest,
+                                                           ltreeid +
+                                                           ipiece));
     }
     else {
-      T8_ASSERT (itree == 0);   /* This situation only happens for the first tree */
-      /* The tree is already present in the forest and we need to add elements
-       * to it */
-      T8_ASSERT (forest->last_local_tree == tree_info->gtree_id);
-      /* Get a pointer to the tree */
-      tree = t8_forest_get_tree (forest, forest->last_local_tree
-                                 - forest->first_local_tree);
-      /* assert for correctness */
-      T8_ASSERT (tree->eclass == tree_info->eclass);
-      /* Get the old number of elements in the tree and calculate the new number */
-      old_num_elements = t8_forest_get_tree_element_count (tree);
-      new_num_elements = old_num_elements + tree_info->num_elements;
-      /* Enlarge the elements array */
-      sc_array_resize (&tree->elements, new_num_elements);
-      first_new_element = t8_sc_array_index_locidx (&tree->elements,
-                                                    old_num_elements);
-#if 0
-      /* Debugging output */
-      t8_debugf ("receive %li elements for tree %lli\n",
-                 (long) tree_info->num_elements,
-                 (long long) tree_info->gtree_id);
-#endif
-      /* Get the size of an element of the tree */
-      element_size =
-        t8_element_size (forest->scheme->eclass_schemes[tree->eclass]);
-      T8_ASSERT (element_size == tree->elements.elem_size);
-      /* Copy the elements from the receive buffer to the elements array */
-      memcpy (first_new_element, recv_buffer + element_cursor,
-              tree_info->num_elements * element_size);
-    }
-
-    /* compute the new number of local elements */
-    forest->local_num_elements += tree_info->num_elements;
-    /* Set the new last local tree */
-    forest->last_local_tree = tree_info->gtree_id;
-    /* advance the element cursor */
-    element_cursor += element_size * tree_info->num_elements;
-    /* Advance to the next tree_info entry in the recv buffer */
-    tree_cursor += sizeof (t8_forest_partition_tree_info_t);
-    tree_info += 1;
-  }
-  T8_FREE (recv_buffer);
-  if (forest->profile != NULL) {
-    if (proc != forest->mpirank) {
-      /* If profiling is enabled we count the number of elements received from
-       * other processes */
-      forest->profile->partition_elements_recv += num_elements_recv;
+      memcpy (t8_sc_array_index_locidx (&tree->elements, position),
+              t8_sc_array_index_locidx (&tree_from->elements, first_tree_el),
+              info->num_elements * element_size);
+    }
+    position = 0;
+    if (forest->profile != NULL) {
+      /* If profiling is enabled we count the bytes that we did not send */
+      forest->profile->partition_bytes_local +=
+        info->num_elements * element_size;
     }
   }
 }
 
 /* Receive the elements from all processes, we receive from.
- * The message are received in order of the sending rank,
- * since then we can easily build up the new trees array.
+ * Each process sends us the tree infos of its elements and the elements
+ * themselves in two messages. We post all receives at once and handle
+ * the messages in the order in which they arrive. The tree infos are
+ * added to the trees of the new forest in rank order as soon as they are
+ * available, since the local tree ids and positions of a process depend
+ * on the pieces of all lower processes. A tree is complete as soon as a
+ * later piece starts a new tree, then its element array is allocated with
+ * its final size. The elements of a process are copied to their place
+ * once they have arrived and all of their trees are complete.
  */
 static void
 t8_forest_partition_recvloop (t8_forest_t forest, int recv_first,
-                              int recv_last)
+                              int recv_last, t8_locidx_t self_first,
+                              t8_locidx_t self_last)
 {
-  int                 iproc, num_receive, prev_recvd;
+  int                 iproc, num_procs, i, j, num_completed;
+  int                 mpiret, eclass, self, next_layout, num_placed;
+  int                *completed, *pending;
   t8_forest_t         forest_from;
-  t8_gloidx_t        *offset_from;
-  int                 mpiret;
+  t8_gloidx_t        *offset_from, *offset_to;
+  t8_gloidx_t         num_elements_recv, max_trees;
+  t8_locidx_t        *first_ltreeid, *first_position, *num_pieces;
+  t8_locidx_t         ipiece, num_complete, num_alloc;
+  t8_locidx_t         ltreeid, position;
+  size_t              max_element_size, header_bytes, first_adopt;
+  t8_forest_partition_tree_info_t *infos;
+  t8_tree_t           tree;
+  sc_array_t          self_infos;
   sc_MPI_Comm         comm;
-  sc_MPI_Status       status;
+  sc_MPI_Request     *requests;
+  char              **header_buffer, **element_buffer;
 
   /* Initial checks and inits */
   T8_ASSERT (t8_forest_is_initialized (forest));
@@ -661,32 +1285,199 @@ t8_forest_partition_recvloop (t8_forest_t forest, int recv_first,
   T8_ASSERT (t8_forest_is_committed (forest_from));
   offset_from =
     t8_shmem_array_get_gloidx_array (forest_from->element_offsets);
+  offset_to = t8_shmem_array_get_gloidx_array (forest->element_offsets);
   comm = forest->mpicomm;
+  num_procs = SC_MAX (0, recv_last - recv_first + 1);
+  self = forest->mpirank - recv_first;
+
+  /* The maximum size of an element */
+  max_element_size = 0;
+  for (eclass = T8_ECLASS_ZERO; eclass < T8_ECLASS_COUNT; eclass++) {
+    if (forest->scheme->eclass_schemes[eclass] != NULL) {
+      max_element_size = SC_MAX (max_element_size,
+                                 t8_element_size (forest->scheme->
+                                                  eclass_schemes[eclass]));
+    }
+  }
 
   /****     Actual communication    ****/
 
-  /* In order of their ranks, receive the trees and elements from
-   * the other processes. */
+  /* The first num_procs requests are for the tree infos,
+   * the second num_procs requests for the elements */
+  requests = T8_ALLOC (sc_MPI_Request, 2 * num_procs);
+  header_buffer = T8_ALLOC_ZERO (char *, num_procs);
+  element_buffer = T8_ALLOC_ZERO (char *, num_procs);
+  /* For each process, bit 1 is set while its tree infos are pending and
+   * bit 2 while its elements are pending. Once its elements are placed,
+   * it is set to -1. */
+  pending = T8_ALLOC_ZERO (int, num_procs);
+  for (i = 0; i < num_procs; i++) {
+    iproc = recv_first + i;
+    requests[i] = requests[num_procs + i] = sc_MPI_REQUEST_NULL;
+    if (i == self || t8_forest_partition_empty (offset_from, iproc)) {
+      /* Our own elements are not sent and empty processes send nothing */
+      continue;
+    }
+    /* The number of elements that we receive from iproc */
+    num_elements_recv =
+      SC_MIN (offset_from[iproc + 1], offset_to[forest->mpirank + 1]) -
+      SC_MAX (offset_from[iproc], offset_to[forest->mpirank]);
+    T8_ASSERT (num_elements_recv > 0);
+    /* The message contains at most one tree info per element */
+    max_trees = SC_MIN (num_elements_recv, forest->global_num_trees);
+    header_bytes = t8_forest_partition_header_bytes (max_trees);
+    header_buffer[i] = T8_ALLOC (char, header_bytes);
+    mpiret = sc_MPI_Irecv (header_buffer[i], (int) header_bytes, sc_MPI_BYTE,
+                           iproc, T8_MPI_PARTITION_FOREST, comm,
+                           requests + i);
+    SC_CHECK_MPI (mpiret);
+    element_buffer[i] = T8_ALLOC (char, num_elements_recv * max_element_size);
+    mpiret = sc_MPI_Irecv (element_buffer[i],
+                           (int) (num_elements_recv * max_element_size),
+                           sc_MPI_BYTE, iproc, T8_MPI_PARTITION_ELEMENTS,
+                           comm, requests + num_procs + i);
+    SC_CHECK_MPI (mpiret);
+    pending[i] = 1 | 2;
+  }
+
+  /* The pieces of the elements that stay on this process */
+  sc_array_init (&self_infos, sizeof (t8_forest_partition_tree_info_t));
+  if (self_first <= self_last) {
+    t8_forest_partition_self_pieces (forest_from, self_first, self_last,
+                                     &self_infos);
+  }
+  first_adopt = self_infos.elem_count;
 
-  num_receive = 0;
-  prev_recvd = 0;
+  first_ltreeid = T8_ALLOC_ZERO (t8_locidx_t, num_procs);
+  first_position = T8_ALLOC_ZERO (t8_locidx_t, num_procs);
+  num_pieces = T8_ALLOC_ZERO (t8_locidx_t, num_procs);
+  completed = T8_ALLOC (int, SC_MAX (2 * num_procs, 1));
   forest->local_num_elements = 0;
-  for (iproc = recv_first; iproc <= recv_last; iproc++) {
-    if (!t8_forest_partition_empty (offset_from, iproc)) {
-      /* We receive from each nonempty rank between recv_first and recv_last */
-      num_receive++;
-      /* Probe for the message */
-      mpiret = sc_MPI_Probe (iproc, T8_MPI_PARTITION_FOREST, comm, &status);
-      SC_CHECK_MPI (mpiret);
-      /* Consistency checks */
-      T8_ASSERT (iproc == status.MPI_SOURCE);
-      T8_ASSERT (status.MPI_TAG == T8_MPI_PARTITION_FOREST);
-      /* Receive the actual message */
-      t8_forest_partition_recv_message (forest, comm, iproc, &status,
-                                        prev_recvd);
-      prev_recvd++;
+  /* A process that receives no piece has no local trees */
+  forest->first_local_tree = 0;
+  forest->last_local_tree = -1;
+  next_layout = num_placed = 0;
+  num_alloc = 0;
+  for (;;) {
+    /* Add the pieces of all processes whose tree infos are available
+     * to the trees of the new forest, in rank order */
+    while (next_layout < num_procs && !(pending[next_layout] & 1)) {
+      i = next_layout++;
+      infos = NULL;
+      if (i == self) {
+        num_pieces[i] = (t8_locidx_t) self_infos.elem_count;
+        infos = (t8_forest_partition_tree_info_t *) self_infos.array;
+      }
+      else if (header_buffer[i] != NULL) {
+        num_pieces[i] = *(t8_locidx_t *) header_buffer[i];
+        infos = (t8_forest_partition_tree_info_t *)
+          (header_buffer[i] + t8_forest_partition_header_bytes (0));
+      }
+      for (ipiece = 0; ipiece < num_pieces[i]; ipiece++) {
+        t8_forest_partition_add_piece (forest, infos + ipiece, &ltreeid,
+                                       &position);
+        if (ipiece == 0) {
+          first_ltreeid[i] = ltreeid;
+          first_position[i] = position;
+        }
+      }
+      if (i == self && num_pieces[i] > 0 && forest_from->rc.refcount == 1) {
+        /* forest_from is destroyed right after partition if we hold the
+         * only reference to it. Then the new trees that start with the
+         * first element of an old tree that stays on this process take
+         * over its array. */
+        tree = t8_forest_get_tree (forest_from, infos->gtree_id -
+                                   forest_from->first_local_tree);
+        first_adopt = first_position[self] == 0
+          && tree->elements_offset == self_first ? 0 : 1;
+      }
+    }
+    /* All trees but the last one are complete. Once all pieces are
+     * added, the last one is complete, too. */
+    num_complete = t8_forest_get_num_local_trees (forest);
+    if (next_layout < num_procs && num_complete > 0) {
+      num_complete--;
+    }
+    /* Allocate the element arrays of the complete trees. The trees that
+     * take over an old array are not allocated. */
+    for (; num_alloc < num_complete; num_alloc++) {
+      if (0 <= self && self < next_layout && num_pieces[self] > 0
+          && num_alloc >= first_ltreeid[self] + (t8_locidx_t) first_adopt
+          && num_alloc < first_ltreeid[self] + num_pieces[self]) {
+        continue;
+      }
+      tree = t8_forest_get_tree (forest, num_alloc);
+      sc_array_init_size (&tree->elements,
+                          t8_element_size (forest->scheme->eclass_schemes
+                                           [tree->eclass]),
+                          t8_forest_partition_new_tree_count (forest,
+                                                              num_alloc));
+    }
+    /* Copy the elements of all processes whose messages have arrived and
+     * whose trees are complete to their place */
+    for (i = num_placed; i < next_layout; i++) {
+      if (pending[i] != 0 || first_ltreeid[i] + num_pieces[i] > num_alloc) {
+        continue;
+      }
+      if (i == self) {
+        t8_forest_partition_place_self (forest, self_first, &self_infos,
+                                        first_ltreeid[self],
+                                        first_position[self], first_adopt);
+      }
+      else if (header_buffer[i] != NULL) {
+        infos = (t8_forest_partition_tree_info_t *)
+          (header_buffer[i] + t8_forest_partition_header_bytes (0));
+        t8_forest_partition_place_pieces (forest, num_pieces[i], infos,
+                                          first_ltreeid[i],
+                                          first_position[i],
+                                          element_buffer[i]);
+        if (forest->profile != NULL) {
+          /* If profiling is enabled we count the number of elements
+           * received from other processes */
+          iproc = recv_first + i;
+          forest->profile->partition_elements_recv +=
+            SC_MIN (offset_from[iproc + 1], offset_to[forest->mpirank + 1])
+            - SC_MAX (offset_from[iproc], offset_to[forest->mpirank]);
+        }
+        T8_FREE (header_buffer[i]);
+        T8_FREE (element_buffer[i]);
+        header_buffer[i] = element_buffer[i] = NULL;
+      }
+      pending[i] = -1;
+    }
+    while (num_placed < num_procs && pending[num_placed] == -1) {
+      num_placed++;
+    }
+    if (num_placed == num_procs) {
+      break;
+    }
+    /* Wait for the next messages */
+    mpiret = sc_MPI_Waitsome (2 * num_procs, requests, &num_completed,
+                              completed, sc_MPI_STATUSES_IGNORE);
+    SC_CHECK_MPI (mpiret);
+    T8_ASSERT (num_completed != sc_MPI_UNDEFINED);
+    for (j = 0; j < num_completed; j++) {
+      if (completed[j] < num_procs) {
+        pending[completed[j]] &= ~1;
+      }
+      else {
+        pending[completed[j] - num_procs] &= ~2;
+      }
     }
   }
+  T8_ASSERT ((t8_gloidx_t) forest->local_num_elements ==
+             offset_to[forest->mpirank + 1] - offset_to[forest->mpirank]);
+  T8_ASSERT (num_alloc == t8_forest_get_num_local_trees (forest));
+
+  sc_array_reset (&self_infos);
+  T8_FREE (completed);
+  T8_FREE (pending);
+  T8_FREE (first_ltreeid);
+  T8_FREE (first_position);
+  T8_FREE (num_pieces);
+  T8_FREE (requests);
+  T8_FREE (header_buffer);
+  T8_FREE (element_buffer);
 }
 
 /* Partition a forest from forest->set_from and the element offsets
@@ -699,6 +1490,7 @@ t8_forest_partition_given (t8_forest_t forest)
   sc_MPI_Request     *requests = NULL;
   int                 num_request_alloc;        /* The count of elements in the request array */
   char              **send_buffer;
+  t8_locidx_t         self_first, self_last;
   int                 mpiret, i;
 
   t8_debugf ("Start partition_given\n");
@@ -706,23 +1498,28 @@ t8_forest_partition_given (t8_forest_t forest)
   T8_ASSERT (forest->set_from != NULL);
   T8_ASSERT (t8_forest_is_committed (forest->set_from));
   /* Compute the first and last rank that we send to */
-  t8_forest_partition_sendrange (forest, &send_first, &send_last);
+  t8_forest_partition_sendrange (forest, forest->set_from, &send_first,
+                                 &send_last);
   t8_debugf ("send_first = %i\n", send_first);
   t8_debugf ("send_last = %i\n", send_last);
 
   /* Send all elements to other ranks */
   t8_forest_partition_sendloop (forest, send_first, send_last, &requests,
-                                &num_request_alloc, &send_buffer);
+                                &num_request_alloc, &send_buffer,
+                                &self_first, &self_last);
 
   /* Receive all element from other ranks */
-  t8_forest_partition_recvrange (forest, &recv_first, &recv_last);
-  t8_forest_partition_recvloop (forest, recv_first, recv_last);
+  t8_forest_partition_recvrange (forest, forest->set_from, &recv_first,
+                                 &recv_last);
+  t8_forest_partition_recvloop (forest, recv_first, recv_last, self_first,
+                                self_last);
   /* Wait for all sends to complete */
   mpiret =
     sc_MPI_Waitall (num_request_alloc, requests, sc_MPI_STATUSES_IGNORE);
   SC_CHECK_MPI (mpiret);
   T8_FREE (requests);
-  for (i = 0; i < num_request_alloc; i++) {
+  /* There are two requests per process and one buffer */
+  for (i = 0; i < num_request_alloc / 2; i++) {
     T8_FREE (send_buffer[i]);
   }
   T8_FREE (send_buffer);
@@ -732,8 +1529,8 @@ t8_forest_partition_given (t8_forest_t forest)
 
 /* Populate a forest with the partitioned elements of
  * forest->set_from.
- * Currently the elements are distributed evenly (each element
- * has the same weight).
+ * If no weight function is set, the elements are distributed evenly
+ * (each element has the same weight).
  */
 void
 t8_forest_partition (t8_forest_t forest)
@@ -757,7 +1554,16 @@ t8_forest_partition (t8_forest_t forest)
   /* TODO: if offsets already exist on forest_from, check it for consistency */
 
   /* We now calculate the new element offsets */
-  t8_forest_partition_compute_new_offset (forest);
+  if (forest->set_weight_fn != NULL) {
+    t8_forest_partition_compute_new_offset_weighted (forest);
+  }
+  else {
+    t8_forest_partition_compute_new_offset (forest);
+  }
+  if (forest->set_for_coarsening) {
+    /* Do not split families between processes */
+    t8_forest_partition_for_coarsening (forest);
+  }
   t8_forest_partition_given (forest);
 
   if (forest->profile != NULL) {
@@ -768,3 +1574,94 @@ t8_forest_partition (t8_forest_t forest)
 
   t8_debugf ("Done forest partition\n");
 }
+
+void
+t8_forest_partition_data (t8_forest_t forest_from, t8_forest_t forest_to,
+                          const sc_array_t * data_in, sc_array_t * data_out)
+{
+  int                 send_first, send_last, recv_first, recv_last;
+  int                 iproc, num_requests, mpiret;
+  t8_gloidx_t        *offset_from, *offset_to;
+  t8_gloidx_t         first, last;
+  size_t              data_size;
+  sc_MPI_Request     *requests;
+  sc_MPI_Comm         comm;
+
+  T8_ASSERT (t8_forest_is_committed (forest_from));
+  T8_ASSERT (t8_forest_is_committed (forest_to));
+  T8_ASSERT (forest_from->global_num_elements ==
+             forest_to->global_num_elements);
+  T8_ASSERT (data_in != NULL && data_out != NULL);
+  T8_ASSERT (data_in->elem_size == data_out->elem_size);
+  T8_ASSERT (data_in->elem_count ==
+             (size_t) forest_from->local_num_elements);
+
+  t8_debugf ("Start partition_data\n");
+  if (forest_from->element_offsets == NULL) {
+    t8_forest_partition_create_offsets (forest_from);
+  }
+  if (forest_to->element_offsets == NULL) {
+    t8_forest_partition_create_offsets (forest_to);
+  }
+  comm = forest_to->mpicomm;
+  data_size = data_in->elem_size;
+  sc_array_resize (data_out, forest_to->local_num_elements);
+  offset_from = t8_shmem_array_get_gloidx_array (forest_from->element_offsets);
+  offset_to = t8_shmem_array_get_gloidx_array (forest_to->element_offsets);
+
+  /* We use the same communication pattern as for the elements */
+  t8_forest_partition_sendrange (forest_to, forest_from, &send_first,
+                                 &send_last);
+  t8_forest_partition_recvrange (forest_to, forest_from, &recv_first,
+                                 &recv_last);
+  requests = T8_ALLOC (sc_MPI_Request,
+                       SC_MAX (0, send_last - send_first + 1) +
+                       SC_MAX (0, recv_last - recv_first + 1));
+  num_requests = 0;
+
+  /* Post all receives directly into the output array */
+  for (iproc = recv_first; iproc <= recv_last; iproc++) {
+    first = SC_MAX (offset_from[iproc], offset_to[forest_to->mpirank]);
+    last = SC_MIN (offset_from[iproc + 1], offset_to[forest_to->mpirank + 1]);
+    if (iproc == forest_to->mpirank || last <= first) {
+      /* We copy our own data below and empty processes send nothing */
+      continue;
+    }
+    mpiret = sc_MPI_Irecv (sc_array_index (data_out, first -
+                                           offset_to[forest_to->mpirank]),
+                           (int) ((last - first) * data_size), sc_MPI_BYTE,
+                           iproc, T8_MPI_PARTITION_DATA, comm,
+                           requests + num_requests++);
+    SC_CHECK_MPI (mpiret);
+  }
+
+  /* Send directly from the input array */
+  for (iproc = send_first; iproc <= send_last; iproc++) {
+    first = SC_MAX (offset_from[forest_from->mpirank], offset_to[iproc]);
+    last = SC_MIN (offset_from[forest_from->mpirank + 1],
+                   offset_to[iproc + 1]);
+    if (last <= first) {
+      /* iproc is empty in the new partition */
+      continue;
+    }
+    if (iproc == forest_to->mpirank) {
+      /* The data stays on this process */
+      memcpy (sc_array_index (data_out, first - offset_to[iproc]),
+              sc_array_index ((sc_array_t *) data_in,
+                              first - offset_from[forest_from->mpirank]),
+              (last - first) * data_size);
+      continue;
+    }
+    mpiret = sc_MPI_Isend (sc_array_index ((sc_array_t *) data_in, first -
+                                           offset_from[forest_from->mpirank]),
+                           (int) ((last - first) * data_size), sc_MPI_BYTE,
+                           iproc, T8_MPI_PARTITION_DATA, comm,
+                           requests + num_requests++);
+    SC_CHECK_MPI (mpiret);
+  }
+
+  mpiret = sc_MPI_Waitall (num_requests, requests, sc_MPI_STATUSES_IGNORE);
+  SC_CHECK_MPI (mpiret);
+  T8_FREE (requests);
+  t8_debugf ("Done partition_data\n");
+}
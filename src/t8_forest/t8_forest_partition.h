@@ -35,4 +35,37 @@
 /* TODO: document */
 void                t8_forest_partition (t8_forest_t forest);
 
+/** Create the array of element offsets of a committed forest.
+ * For each process it stores the global index of its first local element
+ * and the global number of elements in the last entry.
+ * The array is stored in forest->element_offsets.
+ * This function is collective.
+ * \param [in,out] forest  The committed forest.
+ */
+void                t8_forest_partition_create_offsets (t8_forest_t forest);
+
+/** Create the array of global first descendants of a committed forest.
+ * For each process it stores the global id of the first local tree and
+ * the linear id of the first descendant of the first local element at the
+ * maximum level. Empty processes store -1 for both entries.
+ * The array is stored in forest->global_first_desc.
+ * This function is collective.
+ * \param [in,out] forest  The committed forest.
+ */
+void                t8_forest_partition_create_first_desc (t8_forest_t
+                                                           forest);
+
+/** Find the owner process of a position in the space filling curve.
+ * forest->global_first_desc must have been created.
+ * \param [in] forest    The committed forest.
+ * \param [in] gtreeid   The global id of a tree.
+ * \param [in] desc_id   The linear id at maximum level of a descendant
+ *                       in this tree.
+ * \return               The rank of the process owning the leaf element
+ *                       that contains the descendant.
+ */
+int                 t8_forest_partition_find_owner (t8_forest_t forest,
+                                                    t8_gloidx_t gtreeid,
+                                                    uint64_t desc_id);
+
 #endif /* !T8_FOREST_PARTITION_H! */
@@ -0,0 +1,354 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+/** \file t8_forest_save.c
+ *
+ * We define routines to save and load the elements of a forest to/from
+ * the file system.
+ *
+ * The file starts with a header of type \a t8_forest_save_header_t,
+ * followed by one record for each element in the order of the space
+ * filling curve. A record consists of the global id of the element's tree
+ * as 64 bit integer followed by the bytes of the element. All records
+ * have the same size, such that each process can compute the position
+ * of its elements in the file from the element offsets.
+ */
+
+#include <t8_forest/t8_forest_types.h>
+#include <t8_forest/t8_forest_partition.h>
+#include <t8_forest/t8_forest_save.h>
+#include <t8_element.h>
+
+/** The header of a forest file. Its size is a multiple of 8 bytes. */
+typedef struct
+{
+  char                magic[8];                 /**< Always "t8forest" */
+  int32_t             format;                   /**< T8_FOREST_FORMAT */
+  int32_t             record_size;              /**< Bytes per element record */
+  int64_t             global_num_elements;      /**< Number of elements in the file */
+  int64_t             global_num_trees;         /**< Number of trees of the cmesh */
+  int32_t             element_size[T8_ECLASS_COUNT];    /**< Bytes of one element for
+                                                             each eclass, 0 if the scheme
+                                                             does not support the eclass */
+}
+t8_forest_save_header_t;
+
+static const char   t8_forest_save_magic[8] =
+  { 't', '8', 'f', 'o', 'r', 'e', 's', 't' };
+
+/* Compute the size of the elements of each eclass and the size of one
+ * record in the file. */
+static              int32_t
+t8_forest_save_record_size (t8_forest_t forest,
+                            int32_t element_size[T8_ECLASS_COUNT])
+{
+  t8_eclass_scheme_t *ts;
+  size_t              record_size, max_size;
+  int                 eclass;
+
+  max_size = 0;
+  for (eclass = T8_ECLASS_ZERO; eclass < T8_ECLASS_COUNT; eclass++) {
+    ts = forest->scheme->eclass_schemes[eclass];
+    element_size[eclass] = ts == NULL ? 0 : (int32_t) t8_element_size (ts);
+    max_size = SC_MAX (max_size, (size_t) element_size[eclass]);
+  }
+  /* The tree id is followed by the element, we pad the record such that
+   * the tree ids in a buffer of records are properly aligned */
+  record_size = sizeof (int64_t) + max_size;
+  record_size += T8_ADD_PADDING (record_size);
+  return (int32_t) record_size;
+}
+
+int
+t8_forest_save (t8_forest_t forest, const char *filename)
+{
+  t8_forest_save_header_t header;
+  t8_locidx_t         itree, num_local_trees, ielem, num_elems;
+  t8_tree_t           tree;
+  t8_gloidx_t         first_element;
+  int64_t             gtreeid;
+  size_t              record_size, tree_elem_size;
+  char               *buffer, *record;
+  int                 success, global_success, mpiret;
+#ifdef T8_ENABLE_MPIIO
+  MPI_File            file;
+  MPI_Datatype        record_type;
+#else
+  FILE               *fp;
+#endif
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+  T8_ASSERT (filename != NULL);
+
+  if (forest->element_offsets == NULL) {
+    /* We need the element offsets to compute the position of our
+     * elements in the file */
+    t8_forest_partition_create_offsets (forest);
+  }
+  first_element = t8_shmem_array_get_gloidx (forest->element_offsets,
+                                             forest->mpirank);
+
+  /* Fill the header */
+  memset (&header, 0, sizeof (header));
+  memcpy (header.magic, t8_forest_save_magic, sizeof (header.magic));
+  header.format = T8_FOREST_FORMAT;
+  header.record_size = t8_forest_save_record_size (forest,
+                                                   header.element_size);
+  header.global_num_elements = forest->global_num_elements;
+  header.global_num_trees = forest->global_num_trees;
+  record_size = header.record_size;
+
+  /* Copy the local elements into the send buffer, one record per element */
+  num_elems = forest->local_num_elements;
+  buffer = T8_ALLOC_ZERO (char, SC_MAX (1, num_elems * record_size));
+  record = buffer;
+  num_local_trees = t8_forest_get_num_local_trees (forest);
+  for (itree = 0; itree < num_local_trees; itree++) {
+    tree = t8_forest_get_tree (forest, itree);
+    gtreeid = forest->first_local_tree + itree;
+    tree_elem_size = tree->elements.elem_size;
+    for (ielem = 0; ielem < (t8_locidx_t) tree->elements.elem_count; ielem++) {
+      memcpy (record, &gtreeid, sizeof (int64_t));
+      memcpy (record + sizeof (int64_t),
+              t8_sc_array_index_locidx (&tree->elements, ielem),
+              tree_elem_size);
+      record += record_size;
+    }
+  }
+  T8_ASSERT (record == buffer + num_elems * record_size);
+
+#ifdef T8_ENABLE_MPIIO
+  success = 1;
+  mpiret = MPI_File_open (forest->mpicomm, (char *) filename,
+                          MPI_MODE_WRONLY | MPI_MODE_CREATE, MPI_INFO_NULL,
+                          &file);
+  if (mpiret != MPI_SUCCESS) {
+    t8_global_errorf ("Could not open file %s for writing.\n", filename);
+    success = 0;
+  }
+  else {
+    /* Truncate a possibly existing larger file */
+    mpiret = MPI_File_set_size (file, (MPI_Offset) (sizeof (header) +
+                                                    forest->global_num_elements
+                                                    * record_size));
+    success = success && mpiret == MPI_SUCCESS;
+    if (forest->mpirank == 0) {
+      mpiret = MPI_File_write_at (file, 0, &header, sizeof (header),
+                                  MPI_BYTE, MPI_STATUS_IGNORE);
+      success = success && mpiret == MPI_SUCCESS;
+    }
+    /* Write all records with one collective call */
+    mpiret = MPI_Type_contiguous ((int) record_size, MPI_BYTE, &record_type);
+    SC_CHECK_MPI (mpiret);
+    mpiret = MPI_Type_commit (&record_type);
+    SC_CHECK_MPI (mpiret);
+    mpiret = MPI_File_write_at_all (file, (MPI_Offset) (sizeof (header) +
+                                                        first_element *
+                                                        record_size),
+                                    buffer, num_elems, record_type,
+                                    MPI_STATUS_IGNORE);
+    success = success && mpiret == MPI_SUCCESS;
+    mpiret = MPI_Type_free (&record_type);
+    SC_CHECK_MPI (mpiret);
+    mpiret = MPI_File_close (&file);
+    success = success && mpiret == MPI_SUCCESS;
+  }
+#else
+  /* Without MPI I/O rank 0 creates the file and afterwards each process
+   * writes its records at its position */
+  success = 1;
+  if (forest->mpirank == 0) {
+    fp = fopen (filename, "wb");
+    if (fp == NULL) {
+      t8_errorf ("Could not open file %s for writing.\n", filename);
+      success = 0;
+    }
+    else {
+      success = fwrite (&header, sizeof (header), 1, fp) == 1;
+      success = fclose (fp) == 0 && success;
+    }
+  }
+  mpiret = sc_MPI_Barrier (forest->mpicomm);
+  SC_CHECK_MPI (mpiret);
+  if (num_elems > 0) {
+    fp = fopen (filename, "r+b");
+    if (fp == NULL) {
+      t8_errorf ("Could not open file %s for writing.\n", filename);
+      success = 0;
+    }
+    else {
+      success = success && fseek (fp, (long) (sizeof (header) +
+                                              first_element * record_size),
+                                  SEEK_SET) == 0;
+      success = success
+        && fwrite (buffer, record_size, num_elems, fp) == (size_t) num_elems;
+      success = fclose (fp) == 0 && success;
+    }
+  }
+#endif
+  T8_FREE (buffer);
+
+  /* The file is only valid if all processes succeeded */
+  mpiret = sc_MPI_Allreduce (&success, &global_success, 1, sc_MPI_INT,
+                             sc_MPI_MIN, forest->mpicomm);
+  SC_CHECK_MPI (mpiret);
+  if (global_success) {
+    t8_global_productionf ("Saved forest with %lli elements to %s.\n",
+                           (long long) forest->global_num_elements, filename);
+  }
+  return global_success;
+}
+
+void
+t8_forest_load (t8_forest_t forest)
+{
+  t8_forest_save_header_t header;
+  int32_t             element_size[T8_ECLASS_COUNT];
+  t8_gloidx_t         num_per_proc, remainder, first_element;
+  t8_gloidx_t         cmesh_first_tree, cmesh_last_tree;
+  t8_locidx_t         num_elems, ielem;
+  t8_tree_t           tree;
+  t8_eclass_t         eclass;
+  int64_t             gtreeid;
+  size_t              record_size;
+  char               *buffer, *record;
+  const char         *filename;
+#ifdef T8_ENABLE_MPIIO
+  int                 mpiret;
+  MPI_File            file;
+  MPI_Datatype        record_type;
+#else
+  FILE               *fp;
+  int                 retval;
+#endif
+
+  T8_ASSERT (forest != NULL);
+  T8_ASSERT (forest->set_load_filename != NULL);
+  T8_ASSERT (forest->cmesh != NULL && forest->scheme != NULL);
+
+  filename = forest->set_load_filename;
+#ifdef T8_ENABLE_MPIIO
+  mpiret = MPI_File_open (forest->mpicomm, (char *) filename,
+                          MPI_MODE_RDONLY, MPI_INFO_NULL, &file);
+  SC_CHECK_ABORTF (mpiret == MPI_SUCCESS, "Could not open file %s",
+                   filename);
+  mpiret = MPI_File_read_at_all (file, 0, &header, sizeof (header),
+                                 MPI_BYTE, MPI_STATUS_IGNORE);
+  SC_CHECK_MPI (mpiret);
+#else
+  fp = fopen (filename, "rb");
+  SC_CHECK_ABORTF (fp != NULL, "Could not open file %s", filename);
+  retval = fread (&header, sizeof (header), 1, fp);
+  SC_CHECK_ABORT (retval == 1, "Could not read forest file header");
+#endif
+
+  /* Check that the file matches the forest */
+  SC_CHECK_ABORT (!memcmp (header.magic, t8_forest_save_magic,
+                           sizeof (header.magic)), "Not a t8 forest file");
+  SC_CHECK_ABORT (header.format == T8_FOREST_FORMAT,
+                  "Unsupported forest file format");
+  record_size = t8_forest_save_record_size (forest, element_size);
+  SC_CHECK_ABORT (header.record_size == (int32_t) record_size
+                  && !memcmp (header.element_size, element_size,
+                              sizeof (element_size)),
+                  "Forest file was written with a different scheme");
+  SC_CHECK_ABORT (header.global_num_trees ==
+                  t8_cmesh_get_num_trees (forest->cmesh),
+                  "Forest file does not match the coarse mesh");
+
+  /* We read an equally sized range of elements on each process */
+  num_per_proc = header.global_num_elements / forest->mpisize;
+  remainder = header.global_num_elements % forest->mpisize;
+  first_element = forest->mpirank * num_per_proc
+    + SC_MIN (forest->mpirank, remainder);
+  num_elems = num_per_proc + (forest->mpirank < remainder ? 1 : 0);
+
+  buffer = T8_ALLOC (char, SC_MAX (1, num_elems * record_size));
+#ifdef T8_ENABLE_MPIIO
+  mpiret = MPI_Type_contiguous ((int) record_size, MPI_BYTE, &record_type);
+  SC_CHECK_MPI (mpiret);
+  mpiret = MPI_Type_commit (&record_type);
+  SC_CHECK_MPI (mpiret);
+  mpiret = MPI_File_read_at_all (file, (MPI_Offset) (sizeof (header) +
+                                                     first_element *
+                                                     record_size), buffer,
+                                 num_elems, record_type, MPI_STATUS_IGNORE);
+  SC_CHECK_MPI (mpiret);
+  mpiret = MPI_Type_free (&record_type);
+  SC_CHECK_MPI (mpiret);
+  mpiret = MPI_File_close (&file);
+  SC_CHECK_MPI (mpiret);
+#else
+  if (num_elems > 0) {
+    retval = fseek (fp, (long) (sizeof (header) + first_element *
+                                record_size), SEEK_SET);
+    SC_CHECK_ABORT (retval == 0, "Could not read forest file");
+    retval = fread (buffer, record_size, num_elems, fp);
+    SC_CHECK_ABORT (retval == num_elems, "Could not read forest file");
+  }
+  fclose (fp);
+#endif
+
+  /* Build the trees from the records */
+  cmesh_first_tree = t8_cmesh_get_first_treeid (forest->cmesh);
+  cmesh_last_tree = cmesh_first_tree +
+    t8_cmesh_get_num_local_trees (forest->cmesh) - 1;
+  forest->trees = sc_array_new (sizeof (t8_tree_struct_t));
+  forest->first_local_tree = 0;
+  forest->last_local_tree = -1;
+  tree = NULL;
+  for (ielem = 0, record = buffer; ielem < num_elems;
+       ielem++, record += record_size) {
+    memcpy (&gtreeid, record, sizeof (int64_t));
+    if (tree == NULL || gtreeid != forest->last_local_tree) {
+      /* This element starts a new tree */
+      SC_CHECK_ABORT (tree == NULL || gtreeid == forest->last_local_tree + 1,
+                      "Forest file is corrupted");
+      SC_CHECK_ABORT (cmesh_first_tree <= gtreeid
+                      && gtreeid <= cmesh_last_tree,
+                      "cmesh partition does not match the loaded forest "
+                      "partition");
+      if (tree == NULL) {
+        forest->first_local_tree = gtreeid;
+      }
+      forest->last_local_tree = gtreeid;
+      eclass = t8_cmesh_get_tree_class (forest->cmesh,
+                                        (t8_locidx_t) (gtreeid -
+                                                       cmesh_first_tree));
+      SC_CHECK_ABORT (element_size[eclass] > 0,
+                      "Forest file was written with a different scheme");
+      tree = (t8_tree_t) sc_array_push (forest->trees);
+      memset (tree, 0, sizeof (t8_tree_struct_t));
+      tree->eclass = eclass;
+      tree->elements_offset = ielem;
+      sc_array_init (&tree->elements, element_size[eclass]);
+    }
+    memcpy (sc_array_push (&tree->elements), record + sizeof (int64_t),
+            element_size[tree->eclass]);
+  }
+  T8_FREE (buffer);
+
+  forest->local_num_elements = num_elems;
+  forest->global_num_elements = header.global_num_elements;
+  t8_global_productionf ("Loaded forest with %lli elements from %s.\n",
+                         (long long) forest->global_num_elements, filename);
+}
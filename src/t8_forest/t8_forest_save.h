@@ -0,0 +1,55 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+/** \file t8_forest_save.h
+ *
+ * We define routines to save and load the elements of a forest to/from
+ * the file system.
+ * All processes write their elements into one binary file, such that the
+ * forest can be loaded on an arbitrary number of processes.
+ */
+
+#ifndef T8_FOREST_SAVE_H
+#define T8_FOREST_SAVE_H
+
+#include <t8.h>
+#include <t8_forest.h>
+
+/** Increment this constant each time the file format changes.
+ *  We can only read files that were written in the same format. */
+#define T8_FOREST_FORMAT 0x0001
+
+T8_EXTERN_C_BEGIN ();
+
+/** Read the elements of a forest from the file that was set with
+ * \ref t8_forest_set_load.
+ * Each process reads an equally sized range of elements and creates
+ * the tree objects for it.
+ * The mpicomm, mpirank, mpisize, cmesh and scheme entries of the forest
+ * must be set. This function is collective.
+ * \param [in,out] forest   The forest that is currently committed.
+ */
+void                t8_forest_load (t8_forest_t forest);
+
+T8_EXTERN_C_END ();
+
+#endif /* !T8_FOREST_SAVE_H */
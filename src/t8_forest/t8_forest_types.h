@@ -34,6 +34,7 @@
 #include <t8_forest/t8_forest_adapt.h>
 
 typedef struct t8_profile t8_profile_t; /* Defined below */
+typedef struct t8_forest_ghost *t8_forest_ghost_t; /* Defined below */
 
 typedef enum t8_forest_from
 {
@@ -61,6 +62,8 @@ typedef struct t8_forest
   int                 dimension;        /**< Dimension inferred from \b cmesh. */
 
   t8_forest_t         set_from;         /**< Temporarily store source forest. */
+  char               *set_load_filename;        /**< If not NULL, the forest is loaded from this
+                                                     file on commit. \see t8_forest_set_load */
   t8_forest_from_t    from_method;      /**< Method to derive from \b set_from. */
   t8_forest_replace_t set_replace_fn;   /**< Replace function. Called when \b from_method
                                              is set to T8_FOREST_FROM_ADAPT. */
@@ -68,6 +71,18 @@ typedef struct t8_forest
                                              is set to T8_FOREST_FROM_ADAPT. */
   int                 set_adapt_recursive; /**< Flag to decide whether coarsen and refine
                                                 are carried out recursive */
+  const sc_array_t   *set_adapt_markers;        /**< If not NULL, one int8_t marker per local element
+                                                     of \b set_from used instead of \b set_adapt_fn.
+                                                     \see t8_forest_set_adapt_markers */
+  int                 set_uniform_refine;       /**< If true, every element of \b set_from is refined once.
+                                                     \see t8_forest_set_uniform_refine */
+  int                 set_uniform_coarsen;      /**< If not negative, every element of \b set_from is
+                                                     coarsened to this level.
+                                                     \see t8_forest_set_uniform_coarsen */
+  t8_forest_weight_t  set_weight_fn;    /**< Element weights for partition. Used when \b from_method
+                                             is set to T8_FOREST_FROM_PARTITION. */
+  int                 do_balance;       /**< If True, the forest will be 2:1 face balanced when it is committed. */
+  int                 do_ghost;         /**< If True, a ghost layer will be created when the forest is committed. */
   void               *user_data;        /**< Pointer for arbitrary user data. \see t8_forest_set_user_data. */
   int                 committed;        /**< \ref t8_forest_commit called? */
   int                 mpisize;          /**< Number of MPI processes. */
@@ -77,9 +92,20 @@ typedef struct t8_forest
   t8_gloidx_t         last_local_tree;
   t8_gloidx_t         global_num_trees; /**< The total number of global trees */
   sc_array_t         *trees;
+  t8_gloidx_t         first_local_element;      /**< The global index of the first local element.
+                                                     Computed on commit. */
+  t8_locidx_t        *element_tree;     /**< If not NULL, the local tree id of each local element.
+                                             Only stored for forests with many small trees.
+                                             \see t8_forest_get_element */
+  sc_array_t         *element_data;     /**< If not NULL, the registered element data fields
+                                             of type t8_forest_element_data_t. */
   t8_shmem_array_t    element_offsets; /**< If partitioned, for each process the global index
                                             of its first element. Since it is memory consuming,
                                             it is usually only constructed when needed and otherwise unallocated. */
+  t8_shmem_array_t    global_first_desc; /**< For each process the global id of its first local tree
+                                            and the linear id of the first descendant of its first
+                                            element. Only constructed when needed. */
+  t8_forest_ghost_t   ghosts;           /**< If not NULL, the ghost elements. \see t8_forest_set_ghost */
 
   t8_locidx_t         local_num_elements;  /**< Number of elements on this processor. */
   t8_gloidx_t         global_num_elements; /**< Number of elements on all processors. */
@@ -102,6 +128,77 @@ typedef struct t8_tree
 }
 t8_tree_struct_t;
 
+/** A data field registered with a forest. \see t8_forest_register_element_data */
+typedef struct t8_forest_element_data
+{
+  size_t              data_size;        /**< The number of bytes per element */
+  t8_forest_interpolate_t interpolate_fn;       /**< Sets the data of new elements */
+  sc_array_t          data;             /**< The data of the local elements */
+}
+t8_forest_element_data_t;
+
+/** The ghost elements of one tree that we received from one remote process. */
+typedef struct t8_ghost_tree
+{
+  t8_gloidx_t         global_id;        /**< The global id of this tree */
+  t8_eclass_t         eclass;           /**< The element class of this tree */
+  t8_locidx_t         element_offset;   /**< The ghost index of the first element
+                                             of this tree */
+  sc_array_t          elements;         /**< The ghost elements of this tree */
+}
+t8_ghost_tree_t;
+
+/** The ghost elements that we received from one remote process and the local
+ * elements that are ghosts of this process. */
+typedef struct t8_ghost_remote
+{
+  int                 remote_rank;      /**< The rank of the remote process */
+  t8_locidx_t         first_ghost;      /**< The ghost index of the first element
+                                             received from this process */
+  t8_locidx_t         num_ghosts;       /**< The number of ghosts received from
+                                             this process */
+  sc_array_t          ghost_trees;      /**< The trees of the ghost elements,
+                                             of type t8_ghost_tree_t */
+  sc_array_t          mirrors;          /**< The local element ids (t8_locidx_t) of
+                                             the local elements that are ghosts
+                                             on this process in ascending order */
+}
+t8_ghost_remote_t;
+
+/** The ghost layer of a forest.
+ * The ghost elements are numbered consecutively, first by the rank of the
+ * remote process and then in the order of the space filling curve.
+ */
+typedef struct t8_forest_ghost
+{
+  t8_locidx_t         num_ghosts;       /**< The total number of ghost elements */
+  t8_locidx_t         num_mirrors;      /**< The total number of entries in the
+                                             mirror arrays of all remotes */
+  sc_array_t          remotes;          /**< One t8_ghost_remote_t for each remote
+                                             process, sorted by rank */
+  sc_MPI_Datatype    *send_types;       /**< If not NULL, for each remote a datatype
+                                             describing the data of its mirror elements
+                                             in an array with entries of
+                                             \b send_types_size bytes */
+  size_t              send_types_size;  /**< The entry size of \b send_types */
+}
+t8_forest_ghost_struct_t;
+
+/** The state of a nonblocking exchange of per element data between the
+ * local elements and the ghost elements of a forest.
+ * \see t8_forest_ghost_exchange_begin
+ */
+typedef struct t8_forest_ghost_exchange
+{
+  t8_forest_t         forest;           /**< The forest whose ghost data is exchanged */
+  sc_array_t         *element_data;     /**< The data of the local elements followed
+                                             by the data of the ghost elements */
+  int                 num_remotes;      /**< The number of remote processes */
+  sc_MPI_Request     *requests;         /**< The send requests to all remotes followed
+                                             by the receive requests */
+}
+t8_forest_ghost_exchange_struct_t;
+
 /** This struct is used to profile forest algorithms.
  * The forest struct stores a pointer to a profile struct, and if
  * it is nonzero, various runtimes and data measurements are stored here.
@@ -115,15 +212,24 @@ typedef struct t8_profile
                                                   received from other in the last partition call. */
   size_t              partition_bytes_sent; /**< The total number of bytes sent to other processes in the
                                                  last partition call. */
+  size_t              partition_bytes_local; /**< The number of element bytes that stayed on this
+                                                  process in the last partition call and were
+                                                  thus not sent. */
   int                 partition_procs_sent;  /**< The number of different processes this process has send
                                             local elements to in the last partition call. */
   double              partition_runtime; /**< The runtime of  the last call to \a t8_cmesh_partition. */
   double              commit_runtime; /**< The runtim of the last call to \a t8_cmesh_commit. */
+  size_t              ghosts_bytes_sent; /**< The number of bytes sent to other processes in the
+                                              last creation of a ghost layer. */
+  int                 balance_rounds; /**< The number of rounds of the last balance call. */
+  size_t              balance_bytes_sent; /**< The number of bytes sent to other processes in
+                                               the last balance call. */
+  double              balance_runtime; /**< The runtime of the last balance call. */
 
 }
 t8_profile_struct_t;
 
 /** The number of statistics collected by a profile struct */
-#define T8_PROFILE_NUM_STATS 6
+#define T8_PROFILE_NUM_STATS 11
 
 #endif /* ! T8_FOREST_TYPES_H! */
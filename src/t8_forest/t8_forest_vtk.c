@@ -0,0 +1,349 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <t8_cmesh_vtk.h>
+#include <t8_forest/t8_forest_types.h>
+#include <t8_forest.h>
+
+/* Write the header of the pvtu file that links to the process local files.
+ * This function should only be called by one process.
+ * Return 0 on success. */
+static int
+t8_forest_vtk_write_pvtu (const char *fileprefix, int num_procs,
+                          int write_level, int write_tree, int write_rank,
+                          int do_compress)
+{
+  char                pvtufilename[BUFSIZ], filename_cpy[BUFSIZ];
+  FILE               *pvtufile;
+  int                 p;
+
+  snprintf (pvtufilename, BUFSIZ, "%s.pvtu", fileprefix);
+  pvtufile = fopen (pvtufilename, "wb");
+  if (pvtufile == NULL) {
+    t8_global_errorf ("Could not open %s for output\n", pvtufilename);
+    return -1;
+  }
+
+  fprintf (pvtufile, "<?xml version=\"1.0\"?>\n");
+  fprintf (pvtufile, "<VTKFile type=\"PUnstructuredGrid\" version=\"0.1\"");
+  if (do_compress) {
+    fprintf (pvtufile, " compressor=\"vtkZLibDataCompressor\"");
+  }
+#ifdef SC_IS_BIGENDIAN
+  fprintf (pvtufile, " byte_order=\"BigEndian\">\n");
+#else
+  fprintf (pvtufile, " byte_order=\"LittleEndian\">\n");
+#endif
+  fprintf (pvtufile, "  <PUnstructuredGrid GhostLevel=\"0\">\n");
+  fprintf (pvtufile, "    <PPoints>\n");
+  fprintf (pvtufile, "      <PDataArray type=\"%s\" Name=\"Position\""
+           " NumberOfComponents=\"3\" format=\"binary\"/>\n",
+           T8_VTK_FLOAT_NAME);
+  fprintf (pvtufile, "    </PPoints>\n");
+  if (write_level || write_tree || write_rank) {
+    fprintf (pvtufile, "    <PCellData>\n");
+    if (write_level) {
+      fprintf (pvtufile, "      <PDataArray type=\"Int32\" Name=\"level\""
+               " format=\"binary\"/>\n");
+    }
+    if (write_tree) {
+      fprintf (pvtufile, "      <PDataArray type=\"%s\" Name=\"treeid\""
+               " format=\"binary\"/>\n", T8_VTK_GLOIDX);
+    }
+    if (write_rank) {
+      fprintf (pvtufile, "      <PDataArray type=\"Int32\" Name=\"mpirank\""
+               " format=\"binary\"/>\n");
+    }
+    fprintf (pvtufile, "    </PCellData>\n");
+  }
+  snprintf (filename_cpy, BUFSIZ, "%s", fileprefix);
+  for (p = 0; p < num_procs; ++p) {
+    fprintf (pvtufile, "    <Piece Source=\"%s_%04d.vtu\"/>\n",
+             basename (filename_cpy), p);
+  }
+  fprintf (pvtufile, "  </PUnstructuredGrid>\n");
+  fprintf (pvtufile, "</VTKFile>\n");
+
+  if (ferror (pvtufile)) {
+    t8_global_errorf ("t8_forest_vtk: Error writing parallel footer\n");
+    fclose (pvtufile);
+    return -1;
+  }
+  if (fclose (pvtufile)) {
+    t8_global_errorf ("t8_forest_vtk: Error closing parallel footer\n");
+    return -1;
+  }
+  return 0;
+}
+
+/* Write one binary data array to a vtu file and free the data.
+ * Return 0 on success. */
+static int
+t8_forest_vtk_write_array (FILE * vtufile, const char *type,
+                           const char *name, int num_components, void *data,
+                           size_t byte_length, int do_compress)
+{
+  int                 retval;
+
+  fprintf (vtufile, "        <DataArray type=\"%s\" Name=\"%s\"", type, name);
+  if (num_components > 1) {
+    fprintf (vtufile, " NumberOfComponents=\"%i\"", num_components);
+  }
+  fprintf (vtufile, " format=\"binary\">\n");
+  fprintf (vtufile, "          ");
+  if (do_compress) {
+    retval = sc_vtk_write_compressed (vtufile, (char *) data, byte_length);
+  }
+  else {
+    retval = sc_vtk_write_binary (vtufile, (char *) data, byte_length);
+  }
+  fprintf (vtufile, "\n        </DataArray>\n");
+  T8_FREE (data);
+  if (retval) {
+    t8_errorf ("t8_forest_vtk: Error encoding %s\n", name);
+  }
+  return retval;
+}
+
+/* The vtk tetrahedron needs its first three vertices in counterclockwise
+ * order when seen from the fourth. Since the orientation of the default
+ * tetrahedra depends on their type, we swap two vertices of those with
+ * a negative volume. */
+static void
+t8_forest_vtk_orient_tet (T8_VTK_FLOAT_TYPE * points)
+{
+  T8_VTK_FLOAT_TYPE   swap;
+  double              a[3], b[3], c[3], det;
+  int                 i;
+
+  for (i = 0; i < 3; i++) {
+    a[i] = points[3 + i] - points[i];
+    b[i] = points[6 + i] - points[i];
+    c[i] = points[9 + i] - points[i];
+  }
+  det = c[0] * (a[1] * b[2] - a[2] * b[1])
+    + c[1] * (a[2] * b[0] - a[0] * b[2]) + c[2] * (a[0] * b[1] - a[1] * b[0]);
+  if (det < 0) {
+    for (i = 0; i < 3; i++) {
+      swap = points[3 + i];
+      points[3 + i] = points[6 + i];
+      points[6 + i] = swap;
+    }
+  }
+}
+
+int
+t8_forest_write_vtk_ext (t8_forest_t forest, const char *fileprefix,
+                         int write_level, int write_tree, int write_rank,
+                         int do_compress)
+{
+  char                vtufilename[BUFSIZ];
+  FILE               *vtufile;
+  t8_locidx_t         itree, num_trees, ielement, num_elements;
+  t8_locidx_t         num_cells, icell;
+  t8_locidx_t         num_points, ipoint;
+  t8_tree_t           tree;
+  t8_eclass_scheme_t *ts;
+  t8_element_t       *element;
+  T8_VTK_FLOAT_TYPE  *points;
+  int32_t            *int_data;
+  uint8_t            *types;
+  double             *vertices, coordinates[3];
+  int                 ivertex, num_vertices, retval = 0;
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+  T8_ASSERT (fileprefix != NULL);
+
+#ifndef SC_HAVE_ZLIB
+  if (do_compress) {
+    t8_global_errorf ("t8_forest_vtk: zlib is not available,"
+                      " writing uncompressed data\n");
+    do_compress = 0;
+  }
+#endif
+
+  if (forest->mpirank == 0) {
+    if (t8_forest_vtk_write_pvtu (fileprefix, forest->mpisize, write_level,
+                                  write_tree, write_rank, do_compress)) {
+      return -1;
+    }
+  }
+
+  /* Count the local cells and points. The vertices of each element are
+   * written separately. */
+  num_trees = t8_forest_get_num_local_trees (forest);
+  num_cells = forest->local_num_elements;
+  num_points = 0;
+  for (itree = 0; itree < num_trees; itree++) {
+    tree = t8_forest_get_tree (forest, itree);
+    num_points += t8_forest_get_tree_element_count (tree) *
+      t8_eclass_num_vertices[tree->eclass];
+  }
+
+  snprintf (vtufilename, BUFSIZ, "%s_%04d.vtu", fileprefix, forest->mpirank);
+  vtufile = fopen (vtufilename, "wb");
+  if (vtufile == NULL) {
+    t8_errorf ("Could not open file %s for output.\n", vtufilename);
+    return -1;
+  }
+  fprintf (vtufile, "<?xml version=\"1.0\"?>\n");
+  fprintf (vtufile, "<VTKFile type=\"UnstructuredGrid\" version=\"0.1\"");
+  if (do_compress) {
+    fprintf (vtufile, " compressor=\"vtkZLibDataCompressor\"");
+  }
+#ifdef SC_IS_BIGENDIAN
+  fprintf (vtufile, " byte_order=\"BigEndian\">\n");
+#else
+  fprintf (vtufile, " byte_order=\"LittleEndian\">\n");
+#endif
+  fprintf (vtufile, "  <UnstructuredGrid>\n");
+  fprintf (vtufile,
+           "    <Piece NumberOfPoints=\"%lld\" NumberOfCells=\"%lld\">\n",
+           (long long) num_points, (long long) num_cells);
+
+  /* write point position data */
+  fprintf (vtufile, "      <Points>\n");
+  points = T8_ALLOC (T8_VTK_FLOAT_TYPE, 3 * num_points);
+  for (itree = 0, ipoint = 0; itree < num_trees; itree++) {
+    tree = t8_forest_get_tree (forest, itree);
+    ts = forest->scheme->eclass_schemes[tree->eclass];
+    num_vertices = t8_eclass_num_vertices[tree->eclass];
+    vertices = (double *) t8_cmesh_get_attribute (forest->cmesh,
+                                                  t8_get_package_id (), 0,
+                                                  t8_forest_ltreeid_to_cmesh_ltreeid
+                                                  (forest, itree));
+    num_elements = t8_forest_get_tree_element_count (tree);
+    for (ielement = 0; ielement < num_elements; ielement++) {
+      element = t8_element_array_index (ts, &tree->elements, ielement);
+      for (ivertex = 0; ivertex < num_vertices; ivertex++, ipoint++) {
+        t8_forest_element_coordinate (forest, itree, element, vertices,
+                                      t8_eclass_vtk_corner_number
+                                      [tree->eclass][ivertex], coordinates);
+        points[3 * ipoint] = coordinates[0];
+        points[3 * ipoint + 1] = coordinates[1];
+        points[3 * ipoint + 2] = coordinates[2];
+      }
+      if (tree->eclass == T8_ECLASS_TET) {
+        t8_forest_vtk_orient_tet (points + 3 * (ipoint - num_vertices));
+      }
+    }
+  }
+  T8_ASSERT (ipoint == num_points);
+  retval |=
+    t8_forest_vtk_write_array (vtufile, T8_VTK_FLOAT_NAME, "Position", 3,
+                               points,
+                               3 * num_points * sizeof (T8_VTK_FLOAT_TYPE),
+                               do_compress);
+  fprintf (vtufile, "      </Points>\n");
+
+  /* write connectivity, offset and type data */
+  fprintf (vtufile, "      <Cells>\n");
+  int_data = T8_ALLOC (int32_t, num_points);
+  for (ipoint = 0; ipoint < num_points; ipoint++) {
+    int_data[ipoint] = ipoint;
+  }
+  retval |=
+    t8_forest_vtk_write_array (vtufile, T8_VTK_TOPIDX, "connectivity", 1,
+                               int_data, num_points * sizeof (int32_t),
+                               do_compress);
+  int_data = T8_ALLOC (int32_t, num_cells);
+  types = T8_ALLOC (uint8_t, num_cells);
+  for (itree = 0, icell = 0, ipoint = 0; itree < num_trees; itree++) {
+    tree = t8_forest_get_tree (forest, itree);
+    num_elements = t8_forest_get_tree_element_count (tree);
+    for (ielement = 0; ielement < num_elements; ielement++, icell++) {
+      ipoint += t8_eclass_num_vertices[tree->eclass];
+      int_data[icell] = ipoint;
+      types[icell] = t8_eclass_vtk_type[tree->eclass];
+    }
+  }
+  retval |=
+    t8_forest_vtk_write_array (vtufile, T8_VTK_TOPIDX, "offsets", 1,
+                               int_data, num_cells * sizeof (int32_t),
+                               do_compress);
+  retval |=
+    t8_forest_vtk_write_array (vtufile, "UInt8", "types", 1, types,
+                               num_cells * sizeof (uint8_t), do_compress);
+  fprintf (vtufile, "      </Cells>\n");
+
+  /* write the element data */
+  if (write_level || write_tree || write_rank) {
+    fprintf (vtufile, "      <CellData>\n");
+    if (write_level) {
+      int_data = T8_ALLOC (int32_t, num_cells);
+      for (itree = 0, icell = 0; itree < num_trees; itree++) {
+        tree = t8_forest_get_tree (forest, itree);
+        ts = forest->scheme->eclass_schemes[tree->eclass];
+        num_elements = t8_forest_get_tree_element_count (tree);
+        for (ielement = 0; ielement < num_elements; ielement++, icell++) {
+          int_data[icell] =
+            t8_element_level (ts, t8_element_array_index (ts, &tree->elements,
+                                                          ielement));
+        }
+      }
+      retval |=
+        t8_forest_vtk_write_array (vtufile, "Int32", "level", 1, int_data,
+                                   num_cells * sizeof (int32_t), do_compress);
+    }
+    if (write_tree) {
+      int_data = T8_ALLOC (int32_t, num_cells);
+      for (itree = 0, icell = 0; itree < num_trees; itree++) {
+        tree = t8_forest_get_tree (forest, itree);
+        num_elements = t8_forest_get_tree_element_count (tree);
+        /* Paraview has troubles with Int64, so we store the tree id as
+         * Int32 and have to check for overflows */
+        T8_ASSERT (forest->first_local_tree + itree ==
+                   (int32_t) (forest->first_local_tree + itree));
+        for (ielement = 0; ielement < num_elements; ielement++, icell++) {
+          int_data[icell] = forest->first_local_tree + itree;
+        }
+      }
+      retval |=
+        t8_forest_vtk_write_array (vtufile, T8_VTK_GLOIDX, "treeid", 1,
+                                   int_data, num_cells * sizeof (int32_t),
+                                   do_compress);
+    }
+    if (write_rank) {
+      int_data = T8_ALLOC (int32_t, num_cells);
+      for (icell = 0; icell < num_cells; icell++) {
+        int_data[icell] = forest->mpirank;
+      }
+      retval |=
+        t8_forest_vtk_write_array (vtufile, "Int32", "mpirank", 1, int_data,
+                                   num_cells * sizeof (int32_t), do_compress);
+    }
+    fprintf (vtufile, "      </CellData>\n");
+  }
+  fprintf (vtufile, "    </Piece>\n");
+  fprintf (vtufile, "  </UnstructuredGrid>\n");
+  fprintf (vtufile, "</VTKFile>\n");
+
+  if (ferror (vtufile)) {
+    t8_errorf ("t8_forest_vtk: Error writing file %s\n", vtufilename);
+    retval = -1;
+  }
+  if (fclose (vtufile)) {
+    t8_errorf ("t8_forest_vtk: Error closing file %s\n", vtufilename);
+    retval = -1;
+  }
+  return retval;
+}
@@ -72,6 +72,24 @@ t8_shmem_array_allgather (void *sendbuf, int sendcount,
                       recvcount, recvtype, recvarray->comm);
 }
 
+int
+t8_shmem_array_start_writing (t8_shmem_array_t array)
+{
+  T8_ASSERT (array != NULL);
+  T8_ASSERT (array->array != NULL);
+
+  return sc_shmem_write_start (array->array, array->comm);
+}
+
+void
+t8_shmem_array_end_writing (t8_shmem_array_t array)
+{
+  T8_ASSERT (array != NULL);
+  T8_ASSERT (array->array != NULL);
+
+  sc_shmem_write_end (array->array, array->comm);
+}
+
 sc_MPI_Comm
 t8_shmem_array_get_comm (t8_shmem_array_t array)
 {
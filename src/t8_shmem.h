@@ -89,6 +89,23 @@ void                t8_shmem_array_allgather (void *sendbuf, int sendcount,
                                               int recvcount,
                                               sc_MPI_Datatype recvtype);
 
+/** Enable writing to a t8_shmem array. Only the process that is returned
+ * true may write to the array, and it must do so before calling
+ * \ref t8_shmem_array_end_writing. All processes of the array's
+ * communicator must call this function.
+ * \param [in,out]      array The array to be written to.
+ * \return              True if the calling process may write to \a array.
+ */
+int                 t8_shmem_array_start_writing (t8_shmem_array_t array);
+
+/** Disable writing to a t8_shmem array. Afterwards, the values written
+ * between \ref t8_shmem_array_start_writing and this call are visible
+ * to all processes. All processes of the array's communicator must call
+ * this function.
+ * \param [in,out]      array The array that was written to.
+ */
+void                t8_shmem_array_end_writing (t8_shmem_array_t array);
+
 /** Return the MPI communicator associated with a shmem array.
  * \param [in]          array The shmem_array to be queried.
  * \return              The MPI communicator stored at \a array.
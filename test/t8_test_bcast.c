@@ -26,21 +26,19 @@
 #include <t8_cmesh.h>
 
 static void
-t8_check_bcast_hypercube (t8_eclass_t eclass, int do_dup)
+t8_check_bcast_hypercube (t8_eclass_t eclass)
 {
   t8_cmesh_t          cmesh_bcast, cmesh_check;
 
-  cmesh_bcast = t8_cmesh_new_hypercube (eclass, sc_MPI_COMM_WORLD, do_dup, 1,
-                                        0);
-  cmesh_check = t8_cmesh_new_hypercube (eclass, sc_MPI_COMM_WORLD, do_dup, 0,
-                                        0);
+  cmesh_bcast = t8_cmesh_new_hypercube (eclass, sc_MPI_COMM_WORLD, 1, 0);
+  cmesh_check = t8_cmesh_new_hypercube (eclass, sc_MPI_COMM_WORLD, 0, 0);
   SC_CHECK_ABORTF (t8_cmesh_is_equal (cmesh_bcast, cmesh_check),
-                   "cmesh_bcast check failed. ECLASS = %s,   do_dup = %i\n",
-                   t8_eclass_to_string[eclass], do_dup);
+                   "cmesh_bcast check failed. ECLASS = %s\n",
+                   t8_eclass_to_string[eclass]);
   t8_cmesh_unref (&cmesh_bcast);
   t8_cmesh_unref (&cmesh_check);
-  t8_global_productionf ("cmesh_bcast check passed. %s %i\n",
-                         t8_eclass_to_string[eclass], do_dup);
+  t8_global_productionf ("cmesh_bcast check passed. %s\n",
+                         t8_eclass_to_string[eclass]);
 }
 
 int
@@ -58,8 +56,7 @@ main (int argc, char **argv)
 
   t8_global_productionf ("Testing cmesh broadcast.\n");
   for (eclass = T8_ECLASS_ZERO; eclass < T8_ECLASS_COUNT; eclass++) {
-    t8_check_bcast_hypercube ((t8_eclass_t) eclass, 0);
-    t8_check_bcast_hypercube ((t8_eclass_t) eclass, 1);
+    t8_check_bcast_hypercube ((t8_eclass_t) eclass);
   }
   t8_global_productionf ("Done testing cmesh broadcast.\n");
 
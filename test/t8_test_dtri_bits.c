@@ -0,0 +1,290 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element types in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+/* Check the triangle routines that compute the types of ancestors from
+ * the coordinates against computing the types parent by parent, as the
+ * previous implementation did. This covers ancestors, ancestor ids,
+ * linear ids, comparison, successors, predecessors and last descendants.
+ * We also check t8_dtri_is_inside_root for all elements of the root cube
+ * up to a small level, including those on the boundary of the root.
+ * t8_test_dtet_bits.c includes this file to test the tetrahedra. */
+
+#include <t8.h>
+#ifndef T8_DTRI_TO_DTET
+#include <t8_default/t8_dtri_bits.h>
+#include <t8_default/t8_dtri_connectivity.h>
+#else
+#include <t8_default/t8_dtet_bits.h>
+#include <t8_default/t8_dtet_connectivity.h>
+#endif
+
+#ifndef T8_DTRI_TO_DTET
+#define T8_TEST_DTRI_NAME "triangle"
+#define T8_TEST_DTRI_TYPES 2
+#else
+#define T8_TEST_DTRI_NAME "tetrahedron"
+#define T8_TEST_DTRI_TYPES 6
+#endif
+
+/* We check all elements up to this level */
+#define T8_TEST_DTRI_UNIFORM_LEVEL 3
+
+/* The number of random elements per level above the uniform level */
+#define T8_TEST_DTRI_NUM_RANDOM 100
+
+/* Return true if two triangles have the same level, type and anchor */
+static int
+t8_test_dtri_equal (const t8_dtri_t * t1, const t8_dtri_t * t2)
+{
+  return t1->level == t2->level && t1->type == t2->type
+    && t1->x == t2->x && t1->y == t2->y
+#ifdef T8_DTRI_TO_DTET
+    && t1->z == t2->z
+#endif
+    ;
+}
+
+/* Compute the ancestor of t at a given level parent by parent */
+static void
+t8_test_dtri_ancestor_chain (const t8_dtri_t * t, int level,
+                             t8_dtri_t * ancestor)
+{
+  T8_ASSERT (0 <= level && level <= t->level);
+
+  t8_dtri_copy (t, ancestor);
+  while (ancestor->level > level) {
+    t8_dtri_parent (ancestor, ancestor);
+  }
+}
+
+/* Compute the linear id of t at a level not smaller than its own level by
+ * walking up its ancestors, where the type of each ancestor depends on the
+ * type of its child. */
+static              uint64_t
+t8_test_dtri_linear_id_chain (const t8_dtri_t * t, int level)
+{
+  uint64_t            id = 0;
+  int                 type, cid, i, bit;
+
+  T8_ASSERT (t->level <= level && level <= T8_DTRI_MAXLEVEL);
+
+  type = t->type;
+  for (i = t->level; i > 0; i--) {
+    bit = T8_DTRI_MAXLEVEL - i;
+    cid = ((t->x >> bit) & 1) | ((t->y >> bit) & 1) << 1
+#ifdef T8_DTRI_TO_DTET
+      | ((t->z >> bit) & 1) << 2
+#endif
+      ;
+    id |= ((uint64_t) t8_dtri_type_cid_to_Iloc[type][cid])
+      << (T8_DTRI_DIM * (t->level - i));
+    type = t8_dtri_cid_type_to_parenttype[cid][type];
+  }
+  return id << (T8_DTRI_DIM * (level - t->level));
+}
+
+/* Return true if t lies inside the root, that is, if its anchor lies in
+ * the root cube and its ancestor of level 0 has the type of the root */
+static int
+t8_test_dtri_is_inside_root_chain (const t8_dtri_t * t)
+{
+  t8_dtri_t           root;
+
+  if (t->x < 0 || t->x >= T8_DTRI_ROOT_LEN || t->y < 0
+      || t->y >= T8_DTRI_ROOT_LEN
+#ifdef T8_DTRI_TO_DTET
+      || t->z < 0 || t->z >= T8_DTRI_ROOT_LEN
+#endif
+    ) {
+    return 0;
+  }
+  t8_test_dtri_ancestor_chain (t, 0, &root);
+  return root.type == 0;
+}
+
+/* Check the routines for a triangle inside the root. The previously
+ * checked triangle prev is used to check the comparison. */
+static void
+t8_test_dtri_check (const t8_dtri_t * t, const t8_dtri_t * prev)
+{
+  t8_dtri_t           ancestor, ancestor_chain, s;
+  uint64_t            id, id_prev, num_elements;
+  int                 level, maxlevel, expected;
+
+  /* The linear ids at the own, the next and the maximum level */
+  id = t8_test_dtri_linear_id_chain (t, t->level);
+  SC_CHECK_ABORT (t8_dtri_linear_id (t, t->level) == id,
+                  "Wrong linear id");
+  if (t->level < T8_DTRI_MAXLEVEL) {
+    SC_CHECK_ABORT (t8_dtri_linear_id (t, t->level + 1) ==
+                    t8_test_dtri_linear_id_chain (t, t->level + 1),
+                    "Wrong linear id at the next level");
+  }
+  SC_CHECK_ABORT (t8_dtri_linear_id (t, T8_DTRI_MAXLEVEL) ==
+                  t8_test_dtri_linear_id_chain (t, T8_DTRI_MAXLEVEL),
+                  "Wrong linear id at the maximum level");
+  t8_dtri_init_linear_id (&s, id, t->level);
+  SC_CHECK_ABORT (t8_test_dtri_equal (&s, t),
+                  "The linear id does not round-trip");
+
+  /* The ancestors and their ids */
+  for (level = 0; level <= t->level; level++) {
+    t8_dtri_ancestor (t, level, &ancestor);
+    t8_test_dtri_ancestor_chain (t, level, &ancestor_chain);
+    SC_CHECK_ABORTF (t8_test_dtri_equal (&ancestor, &ancestor_chain),
+                     "Wrong ancestor of level %i\n", level);
+    if (level > 0) {
+      SC_CHECK_ABORTF (t8_dtri_ancestor_id (t, level) ==
+                       t8_dtri_child_id (&ancestor_chain),
+                       "Wrong ancestor id of level %i\n", level);
+    }
+  }
+
+  /* The comparison by the linear ids at the bigger level */
+  maxlevel = SC_MAX (t->level, prev->level);
+  id_prev = t8_test_dtri_linear_id_chain (prev, maxlevel);
+  expected = t8_test_dtri_linear_id_chain (t, maxlevel) < id_prev ? -1
+    : t8_test_dtri_linear_id_chain (t, maxlevel) != id_prev;
+  SC_CHECK_ABORT (SC_MIN (SC_MAX (t8_dtri_compare (t, prev), -1), 1)
+                  == expected, "Wrong comparison");
+  SC_CHECK_ABORT (SC_MIN (SC_MAX (t8_dtri_compare (prev, t), -1), 1)
+                  == -expected, "Wrong swapped comparison");
+
+  /* The neighbors in the uniform refinement and the last descendant */
+  num_elements = (uint64_t) 1 << (T8_DTRI_DIM * t->level);
+  if (id + 1 < num_elements) {
+    t8_dtri_successor (t, &s, t->level);
+    SC_CHECK_ABORT (t8_test_dtri_linear_id_chain (&s, t->level) == id + 1
+                    && s.level == t->level, "Wrong successor");
+  }
+  if (id > 0) {
+    t8_dtri_predecessor (t, &s, t->level);
+    SC_CHECK_ABORT (t8_test_dtri_linear_id_chain (&s, t->level) == id - 1
+                    && s.level == t->level, "Wrong predecessor");
+  }
+  t8_dtri_last_descendant (t, &s);
+  SC_CHECK_ABORT (t8_test_dtri_linear_id_chain (&s, T8_DTRI_MAXLEVEL) ==
+                  ((id + 1) << (T8_DTRI_DIM * (T8_DTRI_MAXLEVEL - t->level)))
+                  - 1, "Wrong last descendant");
+}
+
+/* Check all triangles with an anchor in the root cube up to a small level.
+ * Those inside the root are checked with t8_test_dtri_check. */
+static void
+t8_test_dtri_uniform (void)
+{
+  t8_dtri_t           t, prev;
+  t8_dtri_coord_t     len;
+  int                 level, type, num_inside;
+  int                 ix, iy, iz;
+
+  t8_dtri_init_root (&prev);
+  for (level = 0; level <= T8_TEST_DTRI_UNIFORM_LEVEL; level++) {
+    len = T8_DTRI_LEN (level);
+    num_inside = 0;
+    t8_dtri_init_root (&t);
+    t.level = level;
+    for (ix = 0; ix < 1 << level; ix++) {
+      for (iy = 0; iy < 1 << level; iy++) {
+#ifdef T8_DTRI_TO_DTET
+        for (iz = 0; iz < 1 << level; iz++)
+#else
+        for (iz = 0; iz < 1; iz++)
+#endif
+        {
+          for (type = 0; type < T8_TEST_DTRI_TYPES; type++) {
+            t.x = ix * len;
+            t.y = iy * len;
+#ifdef T8_DTRI_TO_DTET
+            t.z = iz * len;
+#endif
+            t.type = type;
+            SC_CHECK_ABORTF (t8_dtri_is_inside_root (&t) ==
+                             t8_test_dtri_is_inside_root_chain (&t),
+                             "Wrong inside root check for level %i, "
+                             "anchor %i %i %i and type %i\n", level, ix, iy,
+                             iz, type);
+            if (t8_test_dtri_is_inside_root_chain (&t)) {
+              t8_test_dtri_check (&t, &prev);
+              t8_dtri_copy (&t, &prev);
+              num_inside++;
+            }
+          }
+        }
+      }
+    }
+    /* The root contains exactly the elements of the uniform refinement */
+    SC_CHECK_ABORTF (num_inside == 1 << (T8_DTRI_DIM * level),
+                     "Found %i elements inside the root at level %i\n",
+                     num_inside, level);
+  }
+}
+
+/* Check random triangles of all bigger levels */
+static void
+t8_test_dtri_random (void)
+{
+  t8_dtri_t           t, prev;
+  uint64_t            id, random;
+  int                 level, irandom;
+
+  t8_dtri_init_root (&prev);
+  /* A linear congruential generator gives reproducible ids */
+  random = 1;
+  for (level = T8_TEST_DTRI_UNIFORM_LEVEL + 1; level <= T8_DTRI_MAXLEVEL;
+       level++) {
+    for (irandom = 0; irandom < T8_TEST_DTRI_NUM_RANDOM; irandom++) {
+      random = random * 6364136223846793005ULL + 1442695040888963407ULL;
+      id = (random >> 1) & (((uint64_t) 1 << (T8_DTRI_DIM * level)) - 1);
+      t8_dtri_init_linear_id (&t, id, level);
+      SC_CHECK_ABORT (t8_test_dtri_linear_id_chain (&t, level) == id,
+                      "Wrong element from the linear id");
+      t8_test_dtri_check (&t, &prev);
+      t8_dtri_copy (&t, &prev);
+    }
+  }
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_ESSENTIAL);
+  p4est_init (NULL, SC_LP_ESSENTIAL);
+  t8_init (SC_LP_DEFAULT);
+
+  t8_global_productionf ("Testing %s bits.\n", T8_TEST_DTRI_NAME);
+  t8_test_dtri_uniform ();
+  t8_test_dtri_random ();
+  t8_global_productionf ("Done testing %s bits.\n", T8_TEST_DTRI_NAME);
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
@@ -0,0 +1,274 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element types in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+/* Check that the routines on contiguous arrays of elements,
+ * t8_element_parents, t8_element_children_array, t8_element_get_linear_ids
+ * and t8_element_successors, give the same results as the single element
+ * routines. The elements have pseudo random levels and positions up to the
+ * maximum level. We check the routines of the schemes and the loops over
+ * the single element routines that are used if a scheme does not provide
+ * them. */
+
+#include <t8_default.h>
+
+/* The number of elements of the arrays */
+#define T8_TEST_BATCHED_NUM 1000
+
+/* Return the i-th element of a contiguous array */
+static t8_element_t *
+t8_test_batched_index (t8_eclass_scheme_t * ts, t8_element_t * elems,
+                       size_t i)
+{
+  return (t8_element_t *) ((char *) elems + i * t8_element_size (ts));
+}
+
+/* Check that two elements are equal */
+static void
+t8_test_batched_check_equal (t8_eclass_scheme_t * ts,
+                             const t8_element_t * elem1,
+                             const t8_element_t * elem2, const char *what,
+                             size_t i)
+{
+  SC_CHECK_ABORTF (t8_element_level (ts, elem1) ==
+                   t8_element_level (ts, elem2)
+                   && t8_element_compare (ts, elem1, elem2) == 0,
+                   "The %s %llu differs from the single element result\n",
+                   what, (unsigned long long) i);
+}
+
+/* Fill an array with elements of levels 1 to maxlevel - 1, such that each
+ * element has a parent and children */
+static void
+t8_test_batched_fill (t8_eclass_scheme_t * ts, t8_element_t * elems)
+{
+  int                 level, maxlevel, dim;
+  size_t              i;
+  uint64_t            id;
+
+  maxlevel = t8_element_maxlevel (ts);
+  dim = t8_eclass_to_dimension[ts->eclass];
+  /* A linear congruential generator gives reproducible ids */
+  id = 1;
+  for (i = 0; i < T8_TEST_BATCHED_NUM; i++) {
+    id = id * 6364136223846793005ULL + 1442695040888963407ULL;
+    level = 1 + (int) (i % (maxlevel - 1));
+    t8_element_set_linear_id (ts, t8_test_batched_index (ts, elems, i),
+                              level,
+                              (id >> 1) % ((uint64_t) 1 << (dim * level)));
+  }
+}
+
+/* Compare the parents of the elements with t8_element_parent, computed
+ * into another array and in place */
+static void
+t8_test_batched_parents (t8_eclass_scheme_t * ts, t8_element_t * elems,
+                         t8_element_t * elem)
+{
+  t8_element_t       *parents;
+  size_t              i;
+
+  parents = (t8_element_t *) T8_ALLOC_ZERO (char, T8_TEST_BATCHED_NUM *
+                                            t8_element_size (ts));
+  t8_element_parents (ts, elems, T8_TEST_BATCHED_NUM, parents);
+  for (i = 0; i < T8_TEST_BATCHED_NUM; i++) {
+    t8_element_parent (ts, t8_test_batched_index (ts, elems, i), elem);
+    t8_test_batched_check_equal (ts, t8_test_batched_index (ts, parents, i),
+                                 elem, "parent", i);
+  }
+
+  memcpy (parents, elems, T8_TEST_BATCHED_NUM * t8_element_size (ts));
+  t8_element_parents (ts, parents, T8_TEST_BATCHED_NUM, parents);
+  for (i = 0; i < T8_TEST_BATCHED_NUM; i++) {
+    t8_element_parent (ts, t8_test_batched_index (ts, elems, i), elem);
+    t8_test_batched_check_equal (ts, t8_test_batched_index (ts, parents, i),
+                                 elem, "parent in place", i);
+  }
+  T8_FREE (parents);
+}
+
+/* Compare the children of the elements with t8_element_children, which
+ * constructs them in SFC order */
+static void
+t8_test_batched_children (t8_eclass_scheme_t * ts, t8_element_t * elems)
+{
+  t8_element_t       *children, **expected;
+  size_t              i;
+  int                 ichild, num_children;
+
+  num_children = t8_eclass_num_children[ts->eclass];
+  children = (t8_element_t *) T8_ALLOC_ZERO (char, T8_TEST_BATCHED_NUM *
+                                             num_children *
+                                             t8_element_size (ts));
+  expected = T8_ALLOC (t8_element_t *, num_children);
+  t8_element_new (ts, num_children, expected);
+  t8_element_children_array (ts, elems, T8_TEST_BATCHED_NUM, children);
+  for (i = 0; i < T8_TEST_BATCHED_NUM; i++) {
+    t8_element_children (ts, t8_test_batched_index (ts, elems, i),
+                         num_children, expected);
+    for (ichild = 0; ichild < num_children; ichild++) {
+      t8_test_batched_check_equal (ts, t8_test_batched_index (ts, children,
+                                                              i *
+                                                              num_children +
+                                                              ichild),
+                                   expected[ichild], "child",
+                                   i * num_children + ichild);
+    }
+  }
+  t8_element_destroy (ts, num_children, expected);
+  T8_FREE (expected);
+  T8_FREE (children);
+}
+
+/* Compare the linear ids of the elements with t8_element_get_linear_id on
+ * levels coarser and finer than the elements */
+static void
+t8_test_batched_linear_ids (t8_eclass_scheme_t * ts, t8_element_t * elems)
+{
+  uint64_t           *ids;
+  size_t              i;
+  int                 level, maxlevel;
+
+  maxlevel = t8_element_maxlevel (ts);
+  ids = T8_ALLOC (uint64_t, T8_TEST_BATCHED_NUM);
+  for (level = 0; level <= maxlevel; level += SC_MAX (1, maxlevel / 4)) {
+    t8_element_get_linear_ids (ts, elems, T8_TEST_BATCHED_NUM, level, ids);
+    for (i = 0; i < T8_TEST_BATCHED_NUM; i++) {
+      SC_CHECK_ABORTF (ids[i] ==
+                       t8_element_get_linear_id (ts,
+                                                 t8_test_batched_index (ts,
+                                                                        elems,
+                                                                        i),
+                                                 level),
+                       "The linear id of element %llu on level %i differs\n",
+                       (unsigned long long) i, level);
+    }
+  }
+  T8_FREE (ids);
+}
+
+/* Compare the successors of an element on each level with a chain of
+ * t8_element_successor calls */
+static void
+t8_test_batched_successors (t8_eclass_scheme_t * ts, t8_element_t * elem)
+{
+  t8_element_t       *succs, *prev;
+  int                 level, maxlevel, dim;
+  uint64_t            id, count, num_elements;
+  size_t              i;
+
+  maxlevel = t8_element_maxlevel (ts);
+  dim = t8_eclass_to_dimension[ts->eclass];
+  succs = (t8_element_t *) T8_ALLOC_ZERO (char, T8_TEST_BATCHED_NUM *
+                                          t8_element_size (ts));
+  t8_element_new (ts, 1, &prev);
+  id = 1;
+  for (level = 0; level <= maxlevel; level++) {
+    id = id * 6364136223846793005ULL + 1442695040888963407ULL;
+    num_elements = (uint64_t) 1 << (dim * level);
+    count = SC_MIN (T8_TEST_BATCHED_NUM, num_elements - 1);
+    t8_element_set_linear_id (ts, elem, level,
+                              (id >> 1) % (num_elements - count));
+    t8_element_successors (ts, elem, count, succs, level);
+    t8_element_copy (ts, elem, prev);
+    for (i = 0; i < count; i++) {
+      t8_element_successor (ts, prev, prev, level);
+      t8_test_batched_check_equal (ts, t8_test_batched_index (ts, succs, i),
+                                   prev, "successor", i);
+    }
+  }
+  t8_element_destroy (ts, 1, &prev);
+  T8_FREE (succs);
+}
+
+/* Run all checks on the routines of a scheme */
+static void
+t8_test_batched_scheme (t8_eclass_scheme_t * ts)
+{
+  t8_element_t       *elems, *elem;
+
+  elems = (t8_element_t *) T8_ALLOC_ZERO (char, T8_TEST_BATCHED_NUM *
+                                          t8_element_size (ts));
+  t8_element_new (ts, 1, &elem);
+  t8_test_batched_fill (ts, elems);
+  t8_test_batched_parents (ts, elems, elem);
+  t8_test_batched_children (ts, elems);
+  t8_test_batched_linear_ids (ts, elems);
+  t8_test_batched_successors (ts, elem);
+  t8_element_destroy (ts, 1, &elem);
+  T8_FREE (elems);
+}
+
+/* Check the routines of a scheme and the loops over its single element
+ * routines */
+static void
+t8_test_batched (t8_eclass_scheme_t * ts)
+{
+  t8_eclass_scheme_t  ts_single;
+
+  t8_test_batched_scheme (ts);
+  /* A copy of the virtual table without the array routines shares the
+   * context of the scheme */
+  ts_single = *ts;
+  ts_single.elem_parents = NULL;
+  ts_single.elem_children_array = NULL;
+  ts_single.elem_get_linear_ids = NULL;
+  ts_single.elem_successors = NULL;
+  t8_test_batched_scheme (&ts_single);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  int                 ieclass;
+  t8_scheme_t        *scheme_default, *scheme_compact;
+  t8_eclass_t         eclasses[4] = { T8_ECLASS_QUAD, T8_ECLASS_TRIANGLE,
+    T8_ECLASS_HEX, T8_ECLASS_TET
+  };
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_ESSENTIAL);
+  p4est_init (NULL, SC_LP_ESSENTIAL);
+  t8_init (SC_LP_DEFAULT);
+
+  t8_global_productionf ("Testing element array routines.\n");
+  scheme_default = t8_scheme_new_default ();
+  scheme_compact = t8_scheme_new_compact ();
+  for (ieclass = 0; ieclass < 4; ieclass++) {
+    t8_test_batched (scheme_default->eclass_schemes[eclasses[ieclass]]);
+    t8_test_batched (scheme_compact->eclass_schemes[eclasses[ieclass]]);
+    t8_global_productionf ("Element array check passed. %s\n",
+                           t8_eclass_to_string[eclasses[ieclass]]);
+  }
+  t8_scheme_unref (&scheme_default);
+  t8_scheme_unref (&scheme_compact);
+  t8_global_productionf ("Done testing element array routines.\n");
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
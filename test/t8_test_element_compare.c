@@ -0,0 +1,189 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element types in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+/* Check that t8_element_compare orders elements like their linear ids at
+ * the bigger level of the two, which is the order that the default
+ * schemes implemented before comparing coordinates directly. In
+ * particular, an ancestor compares equal to its descendants with the same
+ * anchor node and less than all other descendants. */
+
+#include <t8_default.h>
+
+/* The number of pairs of maximum level elements that we compare */
+#define T8_TEST_COMPARE_NUM_DEEP 10000
+
+/* Return the order of two elements by their linear ids at the bigger
+ * level of the two */
+static int
+t8_test_compare_linear_id (t8_eclass_scheme_t * ts,
+                           const t8_element_t * elem1,
+                           const t8_element_t * elem2)
+{
+  int                 level;
+  uint64_t            id1, id2;
+
+  level = SC_MAX (t8_element_level (ts, elem1), t8_element_level (ts, elem2));
+  id1 = t8_element_get_linear_id (ts, elem1, level);
+  id2 = t8_element_get_linear_id (ts, elem2, level);
+  return id1 < id2 ? -1 : id1 != id2;
+}
+
+/* Check the compare result of two elements in both orders */
+static void
+t8_test_compare_pair (t8_eclass_scheme_t * ts, const t8_element_t * elem1,
+                      const t8_element_t * elem2)
+{
+  int                 expected, ret;
+
+  expected = t8_test_compare_linear_id (ts, elem1, elem2);
+  ret = t8_element_compare (ts, elem1, elem2);
+  SC_CHECK_ABORTF (SC_MIN (SC_MAX (ret, -1), 1) == expected,
+                   "Compare returned %i, expected %i\n", ret, expected);
+  ret = t8_element_compare (ts, elem2, elem1);
+  SC_CHECK_ABORTF (SC_MIN (SC_MAX (ret, -1), 1) == -expected,
+                   "Swapped compare returned %i, expected %i\n", ret,
+                   -expected);
+}
+
+/* Compare all pairs of elements of uniform refinements up to max_level
+ * and compare each element of level max_level with its ancestors. */
+static void
+t8_test_compare_uniform (t8_eclass_scheme_t * ts, int max_level)
+{
+  t8_element_t       *elem1, *elem2, *ancestor;
+  int                 level1, level2, ret;
+  int                 anchor[3], anchor_ancestor[3];
+  uint64_t            id1, id2, num_elements1, num_elements2;
+
+  /* 2D elements do not set the third coordinate */
+  anchor[2] = anchor_ancestor[2] = 0;
+  t8_element_new (ts, 1, &elem1);
+  t8_element_new (ts, 1, &elem2);
+  t8_element_new (ts, 1, &ancestor);
+  for (level1 = 0; level1 <= max_level; level1++) {
+    num_elements1 = (uint64_t) 1 << (level1 *
+                                     t8_eclass_to_dimension[ts->eclass]);
+    for (id1 = 0; id1 < num_elements1; id1++) {
+      t8_element_set_linear_id (ts, elem1, level1, id1);
+      for (level2 = level1; level2 <= max_level; level2++) {
+        num_elements2 = (uint64_t) 1 << (level2 *
+                                         t8_eclass_to_dimension[ts->eclass]);
+        for (id2 = 0; id2 < num_elements2; id2++) {
+          t8_element_set_linear_id (ts, elem2, level2, id2);
+          t8_test_compare_pair (ts, elem1, elem2);
+        }
+      }
+      if (level1 < max_level) {
+        continue;
+      }
+      /* Compare the element with its ancestors */
+      t8_element_anchor (ts, elem1, anchor);
+      t8_element_copy (ts, elem1, ancestor);
+      for (level2 = level1 - 1; level2 >= 0; level2--) {
+        t8_element_parent (ts, ancestor, ancestor);
+        t8_element_anchor (ts, ancestor, anchor_ancestor);
+        ret = t8_element_compare (ts, ancestor, elem1);
+        if (anchor[0] == anchor_ancestor[0] && anchor[1] == anchor_ancestor[1]
+            && anchor[2] == anchor_ancestor[2]) {
+          SC_CHECK_ABORT (ret == 0, "An ancestor with the same anchor node"
+                          " does not compare equal");
+        }
+        else {
+          SC_CHECK_ABORT (ret < 0, "An ancestor does not compare less than"
+                          " its descendant");
+        }
+      }
+    }
+  }
+  t8_element_destroy (ts, 1, &elem1);
+  t8_element_destroy (ts, 1, &elem2);
+  t8_element_destroy (ts, 1, &ancestor);
+}
+
+/* Compare pairs of elements of the maximum level that are close in the
+ * space filling curve, such that the most significant bits of their
+ * coordinates are equal. */
+static void
+t8_test_compare_deep (t8_eclass_scheme_t * ts)
+{
+  t8_element_t       *elem1, *elem2;
+  int                 maxlevel, ipair;
+  uint64_t            id, offset, num_elements;
+
+  maxlevel = t8_element_maxlevel (ts);
+  num_elements = (uint64_t) 1 << (maxlevel *
+                                   t8_eclass_to_dimension[ts->eclass]);
+  t8_element_new (ts, 1, &elem1);
+  t8_element_new (ts, 1, &elem2);
+  /* A linear congruential generator gives reproducible ids */
+  id = 1;
+  for (ipair = 0; ipair < T8_TEST_COMPARE_NUM_DEEP; ipair++) {
+    id = id * 6364136223846793005ULL + 1442695040888963407ULL;
+    offset = (id >> 33) % ((uint64_t) 1 << (ipair % 20));
+    t8_element_set_linear_id (ts, elem1, maxlevel, (id >> 1) % num_elements);
+    t8_element_set_linear_id (ts, elem2, maxlevel,
+                              ((id >> 1) + offset) % num_elements);
+    t8_test_compare_pair (ts, elem1, elem2);
+  }
+  t8_element_destroy (ts, 1, &elem1);
+  t8_element_destroy (ts, 1, &elem2);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  int                 ieclass;
+  t8_scheme_t        *scheme;
+  t8_eclass_scheme_t *ts;
+  t8_eclass_t         eclasses[4] = { T8_ECLASS_QUAD, T8_ECLASS_TRIANGLE,
+    T8_ECLASS_HEX, T8_ECLASS_TET
+  };
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_ESSENTIAL);
+  p4est_init (NULL, SC_LP_ESSENTIAL);
+  t8_init (SC_LP_DEFAULT);
+
+  t8_global_productionf ("Testing element compare.\n");
+  scheme = t8_scheme_new_default ();
+  /* The default scheme implements these element classes */
+  for (ieclass = 0; ieclass < 4; ieclass++) {
+    ts = scheme->eclass_schemes[eclasses[ieclass]];
+    t8_test_compare_uniform (ts,
+                             t8_eclass_to_dimension[ts->eclass] == 2 ? 4 : 2);
+    t8_test_compare_deep (ts);
+    t8_global_productionf ("Compare check passed. %s\n",
+                           t8_eclass_to_string[eclasses[ieclass]]);
+  }
+  t8_scheme_unref (&scheme);
+  t8_global_productionf ("Done testing element compare.\n");
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
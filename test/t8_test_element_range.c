@@ -0,0 +1,146 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element types in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+/* Construct ranges of elements of a uniform refinement with
+ * t8_element_linear_range and t8_element_linear_range_threaded and check
+ * that both equal the elements constructed one by one from their linear
+ * ids. The ranges are large enough to be split into chunks by the threaded
+ * version. Without --enable-openmp, both versions are serial. */
+
+#include <t8_default.h>
+#ifdef T8_ENABLE_OPENMP
+#include <omp.h>
+#endif
+
+/* The number of threads of the threaded runs. */
+#define T8_TEST_RANGE_THREADS_NUM 4
+
+/* Check that the elements of a range have the given linear ids */
+static void
+t8_test_range_check (t8_eclass_scheme_t * ts, int level, uint64_t start,
+                     uint64_t end, t8_element_t * elems, t8_element_t * elem,
+                     const char *what)
+{
+  size_t              size;
+  uint64_t            id;
+  t8_element_t       *range_elem;
+
+  size = t8_element_size (ts);
+  for (id = start; id < end; id++) {
+    range_elem = (t8_element_t *) ((char *) elems + size * (id - start));
+    t8_element_set_linear_id (ts, elem, level, id);
+    SC_CHECK_ABORTF (t8_element_level (ts, range_elem) == level
+                     && t8_element_compare (ts, range_elem, elem) == 0,
+                     "The %s range has a wrong element at id %llu\n", what,
+                     (unsigned long long) id);
+  }
+}
+
+/* Construct the elements start, ..., end - 1 of a level serially and with
+ * threads and check them */
+static void
+t8_test_range (t8_eclass_scheme_t * ts, int level, uint64_t start,
+               uint64_t end)
+{
+  t8_element_t       *elems, *elem;
+  size_t              bytes;
+
+  /* We clear the elements before each run, such that the check does not
+   * see the elements of the previous run */
+  bytes = t8_element_size (ts) * SC_MAX (end - start, 1);
+  elems = (t8_element_t *) T8_ALLOC_ZERO (char, bytes);
+  t8_element_new (ts, 1, &elem);
+
+  t8_element_linear_range (ts, level, start, end, elems);
+  t8_test_range_check (ts, level, start, end, elems, elem, "serial");
+
+#ifdef T8_ENABLE_OPENMP
+  omp_set_num_threads (T8_TEST_RANGE_THREADS_NUM);
+#endif
+  memset (elems, 0, bytes);
+  t8_element_linear_range_threaded (ts, level, start, end, elems);
+  t8_test_range_check (ts, level, start, end, elems, elem, "threaded");
+#ifdef T8_ENABLE_OPENMP
+  omp_set_num_threads (1);
+  memset (elems, 0, bytes);
+  t8_element_linear_range_threaded (ts, level, start, end, elems);
+  t8_test_range_check (ts, level, start, end, elems, elem, "single thread");
+#endif
+
+  t8_element_destroy (ts, 1, &elem);
+  T8_FREE (elems);
+}
+
+/* Check the whole level, a range that does not start and end at a family
+ * boundary, a range of a single chunk and an empty range */
+static void
+t8_test_range_scheme (t8_eclass_scheme_t * ts, int level)
+{
+  uint64_t            num_elements;
+
+  num_elements = (uint64_t) 1 << (level * t8_eclass_to_dimension[ts->eclass]);
+  t8_test_range (ts, level, 0, num_elements);
+  t8_test_range (ts, level, 12345, num_elements - 777);
+  t8_test_range (ts, level, 5, 100);
+  t8_test_range (ts, level, 17, 17);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  int                 ieclass;
+  t8_scheme_t        *scheme_default, *scheme_compact;
+  t8_eclass_t         eclasses[4] = { T8_ECLASS_QUAD, T8_ECLASS_TRIANGLE,
+    T8_ECLASS_HEX, T8_ECLASS_TET
+  };
+  int                 levels[4] = { 9, 9, 6, 6 };
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_ESSENTIAL);
+  p4est_init (NULL, SC_LP_ESSENTIAL);
+  t8_init (SC_LP_DEFAULT);
+
+  t8_global_productionf ("Testing element ranges.\n");
+  scheme_default = t8_scheme_new_default ();
+  scheme_compact = t8_scheme_new_compact ();
+  for (ieclass = 0; ieclass < 4; ieclass++) {
+    t8_test_range_scheme (scheme_default->eclass_schemes[eclasses[ieclass]],
+                          levels[ieclass]);
+    t8_test_range_scheme (scheme_compact->eclass_schemes[eclasses[ieclass]],
+                          levels[ieclass]);
+    t8_global_productionf ("Element range check passed. %s\n",
+                           t8_eclass_to_string[eclasses[ieclass]]);
+  }
+  t8_scheme_unref (&scheme_default);
+  t8_scheme_unref (&scheme_compact);
+  t8_global_productionf ("Done testing element ranges.\n");
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
@@ -0,0 +1,411 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element types in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+/* Adapt a forest whose trees have leaves of different levels once into
+ * new element arrays, keeping a reference to the source forest, and once
+ * in place, giving up the last reference. Both forests must be equal and
+ * their trees must consist of ordered, non-overlapping leaves. Elements
+ * are refined and coarsened within the same tree, such that the in place
+ * adaptation has to make room for refined elements. Refining recursively
+ * by several levels must give the same forest as refining level by level.
+ */
+
+#include <sc_refcount.h>
+#include <t8_default.h>
+#include <t8_cmesh.h>
+#include <t8_forest.h>
+#include "t8_forest/t8_forest_types.h"
+#include "t8_test_forest_common.h"
+
+/* The number of trees of the coarse mesh. */
+#define T8_TEST_ADAPT_NUM_TREES 3
+
+/* The maximum level to which the test refines */
+static int
+t8_test_adapt_maxlevel (t8_eclass_t eclass)
+{
+  return t8_eclass_to_dimension[eclass] == 3 ? 4 : 6;
+}
+
+/* Return true if the test adaptation refines an element. These are the
+ * elements with an anchor in the lower half of the tree whose child id
+ * and tree do not match as in the initial refinement. */
+static int
+t8_test_adapt_is_refined (t8_gloidx_t gtree_id, t8_eclass_scheme_t * ts,
+                          const t8_element_t * element)
+{
+  int                 anchor[3];
+
+  t8_element_anchor (ts, (t8_element_t *) element, anchor);
+  return anchor[0] < (1 << (t8_element_maxlevel (ts) - 1))
+    && t8_element_level (ts, element) < t8_test_adapt_maxlevel (ts->eclass)
+    && (gtree_id + t8_element_child_id (ts, element)) % 3 != 0;
+}
+
+/* Refine elements in the lower half of each tree and coarsen the families
+ * in the upper half down to level two. The children of a refined element
+ * are in the lower half and the parent of a coarsened family is in the
+ * upper half, such that recursive adaptation terminates. */
+static int
+t8_test_adapt_mixed (t8_forest_t forest, t8_locidx_t which_tree,
+                     t8_eclass_scheme_t * ts,
+                     int num_elements, t8_element_t * elements[])
+{
+  t8_gloidx_t         gtree_id;
+  int                 anchor[3];
+
+  gtree_id = forest->set_from->first_local_tree + which_tree;
+  if (t8_test_adapt_is_refined (gtree_id, ts, elements[0])) {
+    return 1;
+  }
+  t8_element_anchor (ts, elements[0], anchor);
+  if (num_elements > 1 && t8_element_level (ts, elements[0]) > 2
+      && anchor[0] >= (1 << (t8_element_maxlevel (ts) - 1))) {
+    return -1;
+  }
+  return 0;
+}
+
+/* Refine the elements that the mixed adapt function refines */
+static int
+t8_test_adapt_refine (t8_forest_t forest, t8_locidx_t which_tree,
+                      t8_eclass_scheme_t * ts,
+                      int num_elements, t8_element_t * elements[])
+{
+  return t8_test_adapt_is_refined (forest->set_from->first_local_tree +
+                                   which_tree, ts, elements[0]);
+}
+
+/* Create the forest with leaves of different levels that is adapted.
+ * Its elements are refined up to one level below the test level. */
+static              t8_forest_t
+t8_test_adapt_new (t8_eclass_t eclass, sc_MPI_Comm comm)
+{
+  t8_forest_t         forest;
+
+  forest = t8_test_forest_new_adapted (t8_cmesh_new_bigmesh (eclass,
+                                                             T8_TEST_ADAPT_NUM_TREES,
+                                                             comm), comm,
+                                       t8_test_adapt_maxlevel (eclass) - 1);
+  return t8_test_forest_new_partitioned (forest, 0, NULL);
+}
+
+/* Refine every element */
+static int
+t8_test_adapt_refine_all (t8_forest_t forest, t8_locidx_t which_tree,
+                          t8_eclass_scheme_t * ts,
+                          int num_elements, t8_element_t * elements[])
+{
+  return 1;
+}
+
+/* Adapt forest_from with the given adapt function. If in_place is false,
+ * we keep a reference to forest_from, such that it is not adapted in
+ * place. */
+static              t8_forest_t
+t8_test_adapt_run (t8_forest_t forest_from, t8_forest_adapt_t adapt_fn,
+                   int recursive, int in_place)
+{
+  t8_forest_t         forest;
+
+  if (!in_place) {
+    t8_forest_ref (forest_from);
+  }
+  t8_forest_init (&forest);
+  t8_forest_set_adapt (forest, forest_from, adapt_fn, NULL, recursive);
+  t8_forest_commit (forest);
+  return forest;
+}
+
+/* Refine forest_from uniformly if level is negative and coarsen it
+ * uniformly to level otherwise. in_place is as in t8_test_adapt_run. */
+static              t8_forest_t
+t8_test_adapt_run_uniform (t8_forest_t forest_from, int level, int in_place)
+{
+  t8_forest_t         forest;
+
+  if (!in_place) {
+    t8_forest_ref (forest_from);
+  }
+  t8_forest_init (&forest);
+  if (level < 0) {
+    t8_forest_set_uniform_refine (forest, forest_from);
+  }
+  else {
+    t8_forest_set_uniform_coarsen (forest, forest_from, level);
+  }
+  t8_forest_commit (forest);
+  return forest;
+}
+
+/* Check that the leaves of each tree are ordered and do not overlap and
+ * that two forests have the same elements in the same trees. After
+ * recursive adaptation, no leaf may be refined any further. */
+static void
+t8_test_adapt_compare (t8_forest_t forest, t8_forest_t forest_in_place,
+                       int recursive)
+{
+  t8_locidx_t         itree, num_trees, ielement, num_elements;
+  t8_tree_t           tree, tree_in_place;
+  t8_eclass_scheme_t *ts;
+  t8_element_t       *elem, *elem_in_place, *prev, *anc;
+
+  SC_CHECK_ABORT (t8_forest_get_num_element (forest) ==
+                  t8_forest_get_num_element (forest_in_place),
+                  "The local element counts differ");
+  num_trees = t8_forest_get_num_local_trees (forest);
+  SC_CHECK_ABORT (num_trees == t8_forest_get_num_local_trees
+                  (forest_in_place), "The local tree counts differ");
+  for (itree = 0; itree < num_trees; itree++) {
+    tree = t8_forest_get_tree (forest, itree);
+    tree_in_place = t8_forest_get_tree (forest_in_place, itree);
+    num_elements = t8_forest_get_tree_element_count (tree);
+    SC_CHECK_ABORTF (num_elements == t8_forest_get_tree_element_count
+                     (tree_in_place), "The element counts of tree %i "
+                     "differ\n", itree);
+    ts = forest->scheme->eclass_schemes[tree->eclass];
+    t8_element_new (ts, 1, &anc);
+    for (ielement = 0; ielement < num_elements; ielement++) {
+      elem = t8_element_array_index (ts, &tree->elements, ielement);
+      elem_in_place = t8_element_array_index (ts, &tree_in_place->elements,
+                                              ielement);
+      SC_CHECK_ABORTF (t8_element_compare (ts, elem, elem_in_place) == 0
+                       && t8_element_level (ts, elem) ==
+                       t8_element_level (ts, elem_in_place),
+                       "Element %i of tree %i differs\n", ielement, itree);
+      if (ielement > 0) {
+        /* The previous leaf is before this leaf and not its ancestor */
+        prev = t8_element_array_index (ts, &tree->elements, ielement - 1);
+        t8_element_copy (ts, elem, anc);
+        while (t8_element_level (ts, anc) > t8_element_level (ts, prev)) {
+          t8_element_parent (ts, anc, anc);
+        }
+        SC_CHECK_ABORTF (t8_element_compare (ts, prev, elem) < 0
+                         && t8_element_compare (ts, prev, anc) != 0,
+                         "Element %i of tree %i overlaps its predecessor\n",
+                         ielement, itree);
+      }
+      SC_CHECK_ABORTF (!recursive || !t8_test_adapt_is_refined
+                       (forest->first_local_tree + itree, ts, elem),
+                       "Element %i of tree %i is not refined\n", ielement,
+                       itree);
+    }
+    t8_element_destroy (ts, 1, &anc);
+  }
+}
+
+static void
+t8_test_adapt (t8_eclass_t eclass, int recursive)
+{
+  t8_forest_t         forest, forest_adapt, forest_in_place;
+
+  forest = t8_test_adapt_new (eclass, sc_MPI_COMM_WORLD);
+  forest_adapt = t8_test_adapt_run (forest, t8_test_adapt_mixed, recursive,
+                                   0);
+  SC_CHECK_ABORT (forest_adapt->global_num_elements !=
+                  forest->global_num_elements,
+                  "The adaptation did not change the forest");
+  /* This takes the last reference to forest */
+  forest_in_place = t8_test_adapt_run (forest, t8_test_adapt_mixed,
+                                      recursive, 1);
+  t8_test_adapt_compare (forest_adapt, forest_in_place, recursive);
+  t8_forest_unref (&forest_adapt);
+  t8_forest_unref (&forest_in_place);
+  t8_global_productionf ("Adapt check passed. %s %i\n",
+                         t8_eclass_to_string[eclass], recursive);
+}
+
+/* Refine recursively by several levels in place and into new arrays and
+ * compare the results with refining one level at a time. */
+static void
+t8_test_adapt_levelwise (t8_eclass_t eclass)
+{
+  t8_forest_t         forest, forest_levelwise, forest_recursive;
+  t8_forest_t         forest_in_place;
+  t8_gloidx_t         num_elements;
+
+  forest = t8_test_adapt_new (eclass, sc_MPI_COMM_WORLD);
+  t8_forest_ref (forest);
+  forest_levelwise = forest;
+  do {
+    num_elements = forest_levelwise->global_num_elements;
+    forest_levelwise = t8_test_adapt_run (forest_levelwise,
+                                          t8_test_adapt_refine, 0, 1);
+  } while (forest_levelwise->global_num_elements != num_elements);
+
+  forest_recursive = t8_test_adapt_run (forest, t8_test_adapt_refine, 1, 0);
+  /* This takes the last reference to forest */
+  forest_in_place = t8_test_adapt_run (forest, t8_test_adapt_refine, 1, 1);
+  t8_test_adapt_compare (forest_levelwise, forest_recursive, 1);
+  t8_test_adapt_compare (forest_levelwise, forest_in_place, 1);
+  t8_forest_unref (&forest_levelwise);
+  t8_forest_unref (&forest_recursive);
+  t8_forest_unref (&forest_in_place);
+  t8_global_productionf ("Recursive refine check passed. %s\n",
+                         t8_eclass_to_string[eclass]);
+}
+
+/* Check a forest that was coarsened uniformly to level from forest_from.
+ * We coarsen a copy of the whole forest that each process creates on its
+ * own: Each leaf is replaced by its ancestor of the given level, if it is
+ * finer, and repeated ancestors are removed. Each process must have the
+ * elements of this list whose first leaf it owns in forest_from. */
+static void
+t8_test_adapt_check_coarsened (t8_forest_t forest_from, t8_forest_t forest,
+                               t8_forest_t forest_serial, int level)
+{
+  t8_locidx_t         itree, ielement, lelement, ltreeid;
+  t8_tree_t           tree;
+  t8_eclass_scheme_t *ts;
+  t8_element_t       *leaf, *anc, *prev_anc, *element;
+  t8_gloidx_t         gleaf, gcoarse, first_from, first;
+  int                 has_prev;
+
+  first_from = t8_forest_get_first_local_element_id (forest_from);
+  first = t8_forest_get_first_local_element_id (forest);
+  gleaf = 0;
+  gcoarse = -1;
+  for (itree = 0; itree < t8_forest_get_num_local_trees (forest_serial);
+       itree++) {
+    tree = t8_forest_get_tree (forest_serial, itree);
+    ts = forest_serial->scheme->eclass_schemes[tree->eclass];
+    t8_element_new (ts, 1, &anc);
+    t8_element_new (ts, 1, &prev_anc);
+    has_prev = 0;
+    for (ielement = 0; ielement < t8_forest_get_tree_element_count (tree);
+         ielement++, gleaf++) {
+      leaf = t8_element_array_index (ts, &tree->elements, ielement);
+      t8_element_copy (ts, leaf, anc);
+      while (t8_element_level (ts, anc) > level) {
+        t8_element_parent (ts, anc, anc);
+      }
+      if (has_prev && t8_element_level (ts, anc) ==
+          t8_element_level (ts, prev_anc)
+          && t8_element_compare (ts, anc, prev_anc) == 0) {
+        continue;
+      }
+      /* This leaf is the first leaf of the coarsened element gcoarse */
+      gcoarse++;
+      has_prev = 1;
+      t8_element_copy (ts, anc, prev_anc);
+      lelement = (t8_locidx_t) (gcoarse - first);
+      SC_CHECK_ABORTF ((first_from <= gleaf
+                        && gleaf < first_from + forest_from->local_num_elements)
+                       == (0 <= lelement
+                           && lelement < forest->local_num_elements),
+                       "Coarsened element %lli is on the wrong process\n",
+                       (long long) gcoarse);
+      if (lelement < 0 || lelement >= forest->local_num_elements) {
+        continue;
+      }
+      element = t8_forest_get_element (forest, lelement, &ltreeid);
+      SC_CHECK_ABORTF (forest->first_local_tree + ltreeid == itree
+                       && t8_element_level (ts, element) ==
+                       t8_element_level (ts, anc)
+                       && t8_element_compare (ts, element, anc) == 0,
+                       "Coarsened element %lli differs\n",
+                       (long long) gcoarse);
+    }
+    t8_element_destroy (ts, 1, &anc);
+    t8_element_destroy (ts, 1, &prev_anc);
+  }
+  SC_CHECK_ABORT (gcoarse + 1 == forest->global_num_elements,
+                  "Wrong number of coarsened elements");
+}
+
+/* Refine uniformly and compare with refining every element with an adapt
+ * function. Coarsen uniformly to two different levels and compare with a
+ * serial computation. We also adapt a second copy of the forest in place
+ * and compare the results. */
+static void
+t8_test_adapt_uniform (t8_eclass_t eclass)
+{
+  t8_forest_t         forest, forest_serial, forest_adapt;
+  t8_forest_t         forest_uniform, forest_in_place;
+  int                 ilevel, levels[2];
+
+  forest = t8_test_adapt_new (eclass, sc_MPI_COMM_WORLD);
+  forest_adapt = t8_test_adapt_run (forest, t8_test_adapt_refine_all, 0, 0);
+  forest_uniform = t8_test_adapt_run_uniform (forest, -1, 0);
+  t8_test_adapt_compare (forest_adapt, forest_uniform, 0);
+  t8_forest_unref (&forest_uniform);
+  forest_in_place = t8_test_adapt_run_uniform (t8_test_adapt_new
+                                               (eclass, sc_MPI_COMM_WORLD),
+                                               -1, 1);
+  t8_test_adapt_compare (forest_adapt, forest_in_place, 0);
+  t8_forest_unref (&forest_adapt);
+  t8_forest_unref (&forest_in_place);
+
+  /* Each process creates the whole forest on its own */
+  forest_serial = t8_test_adapt_new (eclass, sc_MPI_COMM_SELF);
+  levels[0] = 1;
+  levels[1] = t8_eclass_to_dimension[eclass] == 3 ? 2 : 3;
+  for (ilevel = 0; ilevel < 2; ilevel++) {
+    forest_uniform = t8_test_adapt_run_uniform (forest, levels[ilevel], 0);
+    t8_test_adapt_check_coarsened (forest, forest_uniform, forest_serial,
+                                   levels[ilevel]);
+    forest_in_place = t8_test_adapt_run_uniform (t8_test_adapt_new
+                                                 (eclass, sc_MPI_COMM_WORLD),
+                                                 levels[ilevel], 1);
+    t8_test_adapt_compare (forest_uniform, forest_in_place, 0);
+    t8_forest_unref (&forest_uniform);
+    t8_forest_unref (&forest_in_place);
+  }
+  t8_forest_unref (&forest_serial);
+  t8_forest_unref (&forest);
+  t8_global_productionf ("Uniform adapt check passed. %s\n",
+                         t8_eclass_to_string[eclass]);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  int                 ieclass;
+  t8_eclass_t         eclasses[4] = { T8_ECLASS_QUAD, T8_ECLASS_TRIANGLE,
+    T8_ECLASS_HEX, T8_ECLASS_TET
+  };
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_ESSENTIAL);
+  p4est_init (NULL, SC_LP_ESSENTIAL);
+  t8_init (SC_LP_DEFAULT);
+
+  t8_global_productionf ("Testing forest adapt in place.\n");
+  /* The default scheme implements these element classes */
+  for (ieclass = 0; ieclass < 4; ieclass++) {
+    t8_test_adapt (eclasses[ieclass], 0);
+    t8_test_adapt (eclasses[ieclass], 1);
+    t8_test_adapt_levelwise (eclasses[ieclass]);
+    t8_test_adapt_uniform (eclasses[ieclass]);
+  }
+  t8_global_productionf ("Done testing forest adapt in place.\n");
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
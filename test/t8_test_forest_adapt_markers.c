@@ -0,0 +1,235 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element types in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+/* Adapt an adapted and partitioned forest from a marker array and with
+ * an adapt function that makes the same decisions and check that the
+ * results are equal. Some families are marked completely for coarsening,
+ * some only partially, and the partition splits some families between
+ * processes. We adapt from the markers in place and into new arrays. */
+
+#include <sc_refcount.h>
+#include <t8_default.h>
+#include <t8_cmesh.h>
+#include <t8_forest.h>
+#include "t8_forest/t8_forest_types.h"
+#include "t8_test_forest_common.h"
+
+/* Return the marker of an element. The members of a family with parent P
+ * are all marked for coarsening, only partially marked for coarsening or
+ * kept, depending on the tree, the level and the position of P.
+ * This is called from the adapt function, which may run in several
+ * threads, thus we do not create the parent element. Its position
+ * follows from the anchor of the element. */
+static              int8_t
+t8_test_markers_marker (t8_gloidx_t gtree_id, t8_eclass_scheme_t * ts,
+                        const t8_element_t * element)
+{
+  int                 level, key, child_id;
+  int                 anchor[3], parent_len;
+
+  level = t8_element_level (ts, element);
+  if (level == 0) {
+    return 0;
+  }
+  child_id = t8_element_child_id (ts, element);
+  t8_element_anchor (ts, element, anchor);
+  parent_len = t8_element_root_len (ts, element) >> (level - 1);
+  key = (int) ((gtree_id + level + anchor[0] / parent_len
+                + anchor[1] / parent_len + anchor[2] / parent_len) % 4);
+  switch (key) {
+  case 0:
+    return -1;
+  case 1:
+    /* One child is refined and the others cannot be coarsened */
+    return child_id == 1 ? 1 : -1;
+  case 2:
+    /* One child is kept and the others cannot be coarsened */
+    return child_id == 1 ? 0 : -1;
+  default:
+    return child_id == 0 ? 1 : 0;
+  }
+}
+
+/* Make the decisions of the markers */
+static int
+t8_test_markers_adapt (t8_forest_t forest, t8_locidx_t which_tree,
+                       t8_eclass_scheme_t * ts,
+                       int num_elements, t8_element_t * elements[])
+{
+  t8_gloidx_t         gtree_id;
+  int                 ielement;
+
+  gtree_id = forest->set_from->first_local_tree + which_tree;
+  if (num_elements > 1) {
+    for (ielement = 0; ielement < num_elements; ielement++) {
+      if (t8_test_markers_marker (gtree_id, ts, elements[ielement]) >= 0) {
+        break;
+      }
+    }
+    if (ielement == num_elements) {
+      return -1;
+    }
+  }
+  return t8_test_markers_marker (gtree_id, ts, elements[0]) > 0;
+}
+
+/* Create the forest that is adapted, such that the leaves of a tree have
+ * different levels */
+static              t8_forest_t
+t8_test_markers_new (t8_eclass_t eclass)
+{
+  t8_forest_t         forest;
+
+  forest = t8_test_forest_new_adapted (t8_cmesh_new_bigmesh (eclass, 3,
+                                                             sc_MPI_COMM_WORLD),
+                                       sc_MPI_COMM_WORLD,
+                                       t8_eclass_to_dimension[eclass] ==
+                                       3 ? 3 : 5);
+  return t8_test_forest_new_partitioned (forest, 0, NULL);
+}
+
+/* Fill one marker for each local element of forest */
+static void
+t8_test_markers_fill (t8_forest_t forest, sc_array_t * markers)
+{
+  t8_locidx_t         itree, ielement;
+  t8_tree_t           tree;
+  t8_eclass_scheme_t *ts;
+
+  sc_array_resize (markers, forest->local_num_elements);
+  for (itree = 0; itree < t8_forest_get_num_local_trees (forest); itree++) {
+    tree = t8_forest_get_tree (forest, itree);
+    ts = forest->scheme->eclass_schemes[tree->eclass];
+    for (ielement = 0; ielement < t8_forest_get_tree_element_count (tree);
+         ielement++) {
+      *(int8_t *) sc_array_index (markers, tree->elements_offset + ielement)
+        = t8_test_markers_marker (forest->first_local_tree + itree, ts,
+                                  t8_element_array_index (ts,
+                                                          &tree->elements,
+                                                          ielement));
+    }
+  }
+}
+
+/* Check that two forests have the same elements in the same trees. */
+static void
+t8_test_markers_compare (t8_forest_t forest_a, t8_forest_t forest_b)
+{
+  t8_locidx_t         itree, num_trees, ielement, num_elements;
+  t8_tree_t           tree_a, tree_b;
+  t8_eclass_scheme_t *ts;
+  t8_element_t       *elem_a, *elem_b;
+
+  SC_CHECK_ABORT (forest_a->global_num_elements ==
+                  forest_b->global_num_elements,
+                  "The global element counts differ");
+  num_trees = t8_forest_get_num_local_trees (forest_a);
+  SC_CHECK_ABORT (num_trees == t8_forest_get_num_local_trees (forest_b),
+                  "The local tree counts differ");
+  for (itree = 0; itree < num_trees; itree++) {
+    tree_a = t8_forest_get_tree (forest_a, itree);
+    tree_b = t8_forest_get_tree (forest_b, itree);
+    num_elements = t8_forest_get_tree_element_count (tree_a);
+    SC_CHECK_ABORTF (num_elements == t8_forest_get_tree_element_count
+                     (tree_b), "The element counts of tree %i differ\n",
+                     itree);
+    ts = forest_a->scheme->eclass_schemes[tree_a->eclass];
+    for (ielement = 0; ielement < num_elements; ielement++) {
+      elem_a = t8_element_array_index (ts, &tree_a->elements, ielement);
+      elem_b = t8_element_array_index (ts, &tree_b->elements, ielement);
+      SC_CHECK_ABORTF (t8_element_compare (ts, elem_a, elem_b) == 0 &&
+                       t8_element_level (ts, elem_a) ==
+                       t8_element_level (ts, elem_b),
+                       "Element %i of tree %i differs\n", ielement, itree);
+    }
+  }
+}
+
+static void
+t8_test_markers (t8_eclass_t eclass)
+{
+  t8_forest_t         forest, forest_adapt, forest_markers;
+  t8_forest_t         forest_in_place;
+  sc_array_t          markers;
+
+  forest = t8_test_markers_new (eclass);
+  sc_array_init (&markers, sizeof (int8_t));
+  t8_test_markers_fill (forest, &markers);
+
+  t8_forest_ref (forest);
+  t8_forest_init (&forest_adapt);
+  t8_forest_set_adapt (forest_adapt, forest, t8_test_markers_adapt, NULL, 0);
+  t8_forest_commit (forest_adapt);
+  SC_CHECK_ABORT (forest_adapt->global_num_elements !=
+                  forest->global_num_elements,
+                  "The adaptation did not change the forest");
+
+  t8_forest_ref (forest);
+  t8_forest_init (&forest_markers);
+  t8_forest_set_adapt_markers (forest_markers, forest, &markers);
+  t8_forest_commit (forest_markers);
+  t8_test_markers_compare (forest_adapt, forest_markers);
+
+  /* This takes the last reference to forest */
+  t8_forest_init (&forest_in_place);
+  t8_forest_set_adapt_markers (forest_in_place, forest, &markers);
+  t8_forest_commit (forest_in_place);
+  t8_test_markers_compare (forest_adapt, forest_in_place);
+
+  sc_array_reset (&markers);
+  t8_forest_unref (&forest_adapt);
+  t8_forest_unref (&forest_markers);
+  t8_forest_unref (&forest_in_place);
+  t8_global_productionf ("Marker adapt check passed. %s\n",
+                         t8_eclass_to_string[eclass]);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  int                 ieclass;
+  t8_eclass_t         eclasses[4] = { T8_ECLASS_QUAD, T8_ECLASS_TRIANGLE,
+    T8_ECLASS_HEX, T8_ECLASS_TET
+  };
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_ESSENTIAL);
+  p4est_init (NULL, SC_LP_ESSENTIAL);
+  t8_init (SC_LP_DEFAULT);
+
+  t8_global_productionf ("Testing forest adapt from markers.\n");
+  /* The default scheme implements these element classes */
+  for (ieclass = 0; ieclass < 4; ieclass++) {
+    t8_test_markers (eclasses[ieclass]);
+  }
+  t8_global_productionf ("Done testing forest adapt from markers.\n");
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
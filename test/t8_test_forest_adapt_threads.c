@@ -0,0 +1,185 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element types in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+/* Adapt forests whose trees are large enough to be split into chunks
+ * with one and with several threads and check that the results are equal.
+ * Without --enable-openmp, this compares adaptation in place with
+ * adaptation into new arrays. */
+
+#include <sc_refcount.h>
+#include <t8_default.h>
+#include <t8_cmesh.h>
+#include <t8_forest.h>
+#include "t8_forest/t8_forest_types.h"
+#ifdef T8_ENABLE_OPENMP
+#include <omp.h>
+#endif
+
+/* The number of threads of the threaded runs. */
+#define T8_TEST_THREADS_NUM 4
+
+/* Refine the elements with an anchor in the lower part of the tree and
+ * coarsen the families with an anchor in the upper part. */
+static int
+t8_test_threads_adapt (t8_forest_t forest, t8_locidx_t which_tree,
+                       t8_eclass_scheme_t * ts,
+                       int num_elements, t8_element_t * elements[])
+{
+  int                 anchor[3], maxlevel;
+
+  maxlevel = t8_element_maxlevel (ts);
+  t8_element_anchor (ts, elements[0], anchor);
+  if (anchor[0] < (1 << (maxlevel - 3))) {
+    return 1;
+  }
+  if (num_elements > 1 && anchor[1] >= (1 << (maxlevel - 1))) {
+    return -1;
+  }
+  return 0;
+}
+
+/* Adapt forest_from with num_threads threads. If uniform_coarsen is
+ * non-negative, coarsen uniformly to this level, otherwise use the
+ * adapt function. If in_place is false, we keep a reference to
+ * forest_from, such that it is not adapted in place. */
+static              t8_forest_t
+t8_test_threads_run (t8_forest_t forest_from, int num_threads,
+                     int uniform_coarsen, int in_place)
+{
+  t8_forest_t         forest;
+
+#ifdef T8_ENABLE_OPENMP
+  omp_set_num_threads (num_threads);
+#endif
+  if (!in_place) {
+    t8_forest_ref (forest_from);
+  }
+  t8_forest_init (&forest);
+  if (uniform_coarsen >= 0) {
+    t8_forest_set_uniform_coarsen (forest, forest_from, uniform_coarsen);
+  }
+  else {
+    t8_forest_set_adapt (forest, forest_from, t8_test_threads_adapt, NULL,
+                         0);
+  }
+  t8_forest_commit (forest);
+  return forest;
+}
+
+/* Check that two forests have the same elements in the same trees. */
+static void
+t8_test_threads_compare (t8_forest_t forest_a, t8_forest_t forest_b)
+{
+  t8_locidx_t         itree, num_trees, ielement, num_elements;
+  t8_tree_t           tree_a, tree_b;
+  t8_eclass_scheme_t *ts;
+  t8_element_t       *elem_a, *elem_b;
+
+  SC_CHECK_ABORT (t8_forest_get_num_element (forest_a) ==
+                  t8_forest_get_num_element (forest_b),
+                  "The local element counts differ");
+  num_trees = t8_forest_get_num_local_trees (forest_a);
+  SC_CHECK_ABORT (num_trees == t8_forest_get_num_local_trees (forest_b),
+                  "The local tree counts differ");
+  for (itree = 0; itree < num_trees; itree++) {
+    tree_a = t8_forest_get_tree (forest_a, itree);
+    tree_b = t8_forest_get_tree (forest_b, itree);
+    num_elements = t8_forest_get_tree_element_count (tree_a);
+    SC_CHECK_ABORTF (num_elements == t8_forest_get_tree_element_count
+                     (tree_b), "The element counts of tree %i differ\n",
+                     itree);
+    ts = forest_a->scheme->eclass_schemes[t8_forest_get_eclass (forest_a,
+                                                                itree)];
+    for (ielement = 0; ielement < num_elements; ielement++) {
+      elem_a = (t8_element_t *) sc_array_index (&tree_a->elements, ielement);
+      elem_b = (t8_element_t *) sc_array_index (&tree_b->elements, ielement);
+      SC_CHECK_ABORTF (t8_element_compare (ts, elem_a, elem_b) == 0 &&
+                       t8_element_level (ts, elem_a) ==
+                       t8_element_level (ts, elem_b),
+                       "Element %i of tree %i differs\n", ielement, itree);
+    }
+  }
+}
+
+/* Create a uniform forest whose trees have more than twice the minimum
+ * chunk size of the threaded adapt and adapt it serially, with threads
+ * into new arrays and with threads in place. */
+static void
+t8_test_threads (t8_eclass_t eclass, int level, int uniform_coarsen)
+{
+  t8_forest_t         forest, forest_serial, forest_threads;
+  t8_forest_t         forest_threads_copy;
+  t8_cmesh_t          cmesh;
+
+  cmesh = t8_cmesh_new_bigmesh (eclass, 2, sc_MPI_COMM_WORLD);
+  t8_forest_init (&forest);
+  t8_forest_set_cmesh (forest, cmesh, sc_MPI_COMM_WORLD);
+  t8_forest_set_scheme (forest, t8_scheme_new_default ());
+  t8_forest_set_level (forest, level);
+  t8_forest_commit (forest);
+
+  forest_serial = t8_test_threads_run (forest, 1, uniform_coarsen, 0);
+  forest_threads_copy = t8_test_threads_run (forest, T8_TEST_THREADS_NUM,
+                                             uniform_coarsen, 0);
+  /* This takes the last reference to forest */
+  forest_threads = t8_test_threads_run (forest, T8_TEST_THREADS_NUM,
+                                        uniform_coarsen, 1);
+  t8_test_threads_compare (forest_serial, forest_threads_copy);
+  t8_test_threads_compare (forest_serial, forest_threads);
+  t8_forest_unref (&forest_serial);
+  t8_forest_unref (&forest_threads_copy);
+  t8_forest_unref (&forest_threads);
+  t8_global_productionf ("Threaded adapt check passed. %s %i\n",
+                         t8_eclass_to_string[eclass], uniform_coarsen);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_ESSENTIAL);
+  p4est_init (NULL, SC_LP_ESSENTIAL);
+  t8_init (SC_LP_DEFAULT);
+
+  t8_global_productionf ("Testing threaded forest adapt.\n");
+  /* Adapt with a callback and coarsen uniformly by two levels */
+  t8_test_threads (T8_ECLASS_QUAD, 7, -1);
+  t8_test_threads (T8_ECLASS_QUAD, 7, 5);
+  t8_test_threads (T8_ECLASS_TRIANGLE, 7, -1);
+  t8_test_threads (T8_ECLASS_TRIANGLE, 7, 5);
+  t8_test_threads (T8_ECLASS_HEX, 5, -1);
+  t8_test_threads (T8_ECLASS_HEX, 5, 3);
+  t8_test_threads (T8_ECLASS_TET, 5, -1);
+  t8_test_threads (T8_ECLASS_TET, 5, 3);
+  t8_global_productionf ("Done testing threaded forest adapt.\n");
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
@@ -0,0 +1,223 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element types in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+/* Balance a forest that is refined deeply next to one point, such that the
+ * refinement ripples through several processes. We check that the forest
+ * has as many elements as when balanced on a single process, that it does
+ * not change when balanced again, and that the ghost layer, which balance
+ * updates incrementally, equals a newly created one. */
+
+#include <sc_refcount.h>
+#include <t8_default.h>
+#include <t8_cmesh.h>
+#include <t8_forest.h>
+#include "t8_forest/t8_forest_types.h"
+#include "t8_forest/t8_forest_ghost.h"
+
+/* Refine the elements of the first tree that touch the center of the
+ * tree from below, up to a level that depends on the dimension. The other
+ * elements at the center stay coarse, such that balance must refine. */
+static int
+t8_test_balance_adapt (t8_forest_t forest, t8_locidx_t which_tree,
+                       t8_eclass_scheme_t * ts,
+                       int num_elements, t8_element_t * elements[])
+{
+  int                 anchor[3], level, root_len, len, idim, dim;
+
+  dim = t8_eclass_to_dimension[ts->eclass];
+  level = t8_element_level (ts, elements[0]);
+  if (forest->set_from->first_local_tree + which_tree != 0
+      || level >= (dim == 3 ? 5 : 8)) {
+    return 0;
+  }
+  /* Every simplex and cube contains the upper corner of its anchor cube */
+  root_len = t8_element_root_len (ts, elements[0]);
+  len = root_len >> level;
+  t8_element_anchor (ts, elements[0], anchor);
+  for (idim = 0; idim < dim; idim++) {
+    if (anchor[idim] + len != root_len / 2) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+/* Do not change any element */
+static int
+t8_test_balance_keep (t8_forest_t forest, t8_locidx_t which_tree,
+                      t8_eclass_scheme_t * ts,
+                      int num_elements, t8_element_t * elements[])
+{
+  return 0;
+}
+
+/* Create the refined forest, repartition and balance it */
+static              t8_forest_t
+t8_test_balance_new (t8_eclass_t eclass, sc_MPI_Comm comm)
+{
+  t8_forest_t         forest, forest_adapt, forest_balance;
+
+  t8_forest_init (&forest);
+  t8_forest_set_cmesh (forest, t8_cmesh_new_hypercube (eclass, comm, 0, 0),
+                       comm);
+  t8_forest_set_scheme (forest, t8_scheme_new_default ());
+  t8_forest_set_level (forest, 2);
+  t8_forest_commit (forest);
+
+  t8_forest_init (&forest_adapt);
+  t8_forest_set_adapt (forest_adapt, forest, t8_test_balance_adapt, NULL, 1);
+  t8_forest_commit (forest_adapt);
+
+  t8_forest_init (&forest_balance);
+  t8_forest_set_partition (forest_balance, forest_adapt, 0, NULL);
+  t8_forest_set_balance (forest_balance, 1);
+  t8_forest_set_ghost (forest_balance, 1);
+  t8_forest_set_profiling (forest_balance, 1);
+  t8_forest_commit (forest_balance);
+  return forest_balance;
+}
+
+/* Check that two ghost layers have the same remotes, mirrors and ghosts */
+static void
+t8_test_balance_compare_ghosts (t8_forest_t forest, t8_forest_ghost_t ghost_a,
+                                t8_forest_ghost_t ghost_b)
+{
+  t8_ghost_remote_t  *remote_a, *remote_b;
+  t8_ghost_tree_t    *tree_a, *tree_b;
+  t8_eclass_scheme_t *ts;
+  t8_element_t       *elem_a, *elem_b;
+  size_t              iremote, itree, ielement;
+
+  SC_CHECK_ABORT (ghost_a->num_ghosts == ghost_b->num_ghosts
+                  && ghost_a->num_mirrors == ghost_b->num_mirrors
+                  && ghost_a->remotes.elem_count ==
+                  ghost_b->remotes.elem_count,
+                  "The ghost and mirror counts differ");
+  for (iremote = 0; iremote < ghost_a->remotes.elem_count; iremote++) {
+    remote_a = (t8_ghost_remote_t *) sc_array_index (&ghost_a->remotes,
+                                                     iremote);
+    remote_b = (t8_ghost_remote_t *) sc_array_index (&ghost_b->remotes,
+                                                     iremote);
+    SC_CHECK_ABORT (remote_a->remote_rank == remote_b->remote_rank
+                    && remote_a->first_ghost == remote_b->first_ghost
+                    && remote_a->num_ghosts == remote_b->num_ghosts,
+                    "The remote processes differ");
+    SC_CHECK_ABORT (sc_array_is_equal (&remote_a->mirrors,
+                                       &remote_b->mirrors),
+                    "The mirrors differ");
+    SC_CHECK_ABORT (remote_a->ghost_trees.elem_count ==
+                    remote_b->ghost_trees.elem_count,
+                    "The ghost tree counts differ");
+    for (itree = 0; itree < remote_a->ghost_trees.elem_count; itree++) {
+      tree_a = (t8_ghost_tree_t *) sc_array_index (&remote_a->ghost_trees,
+                                                   itree);
+      tree_b = (t8_ghost_tree_t *) sc_array_index (&remote_b->ghost_trees,
+                                                   itree);
+      SC_CHECK_ABORT (tree_a->global_id == tree_b->global_id
+                      && tree_a->element_offset == tree_b->element_offset
+                      && tree_a->elements.elem_count ==
+                      tree_b->elements.elem_count,
+                      "The ghost trees differ");
+      ts = forest->scheme->eclass_schemes[tree_a->eclass];
+      for (ielement = 0; ielement < tree_a->elements.elem_count; ielement++) {
+        elem_a = t8_element_array_index (ts, &tree_a->elements, ielement);
+        elem_b = t8_element_array_index (ts, &tree_b->elements, ielement);
+        SC_CHECK_ABORT (t8_element_compare (ts, elem_a, elem_b) == 0
+                        && t8_element_level (ts, elem_a) ==
+                        t8_element_level (ts, elem_b),
+                        "The ghost elements differ");
+      }
+    }
+  }
+}
+
+static void
+t8_test_balance (t8_eclass_t eclass)
+{
+  t8_forest_t         forest, forest_serial, forest_again;
+  t8_forest_ghost_t   ghost;
+  t8_gloidx_t         num_elements;
+
+  forest = t8_test_balance_new (eclass, sc_MPI_COMM_WORLD);
+  /* Each process balances the whole forest on its own */
+  forest_serial = t8_test_balance_new (eclass, sc_MPI_COMM_SELF);
+  SC_CHECK_ABORTF (forest->global_num_elements ==
+                   forest_serial->global_num_elements,
+                   "Balanced forest has %lli elements, expected %lli\n",
+                   (long long) forest->global_num_elements,
+                   (long long) forest_serial->global_num_elements);
+  SC_CHECK_ABORT (forest->profile->balance_rounds > 1,
+                  "Balance did not refine");
+  t8_forest_unref (&forest_serial);
+
+  /* Compare the updated ghost layer with a new one */
+  ghost = forest->ghosts;
+  forest->ghosts = NULL;
+  t8_forest_ghost_create (forest);
+  t8_test_balance_compare_ghosts (forest, ghost, forest->ghosts);
+  t8_forest_ghost_destroy (&ghost);
+
+  /* Balancing again must not change the forest */
+  num_elements = forest->global_num_elements;
+  t8_forest_init (&forest_again);
+  t8_forest_set_adapt (forest_again, forest, t8_test_balance_keep, NULL, 0);
+  t8_forest_set_balance (forest_again, 1);
+  t8_forest_set_profiling (forest_again, 1);
+  t8_forest_commit (forest_again);
+  SC_CHECK_ABORT (forest_again->global_num_elements == num_elements
+                  && forest_again->profile->balance_rounds == 1,
+                  "The balanced forest is not balanced");
+  t8_forest_unref (&forest_again);
+  t8_global_productionf ("Balance check passed. %s\n",
+                         t8_eclass_to_string[eclass]);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  int                 ieclass;
+  t8_eclass_t         eclasses[4] = { T8_ECLASS_QUAD, T8_ECLASS_TRIANGLE,
+    T8_ECLASS_HEX, T8_ECLASS_TET
+  };
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_ESSENTIAL);
+  p4est_init (NULL, SC_LP_ESSENTIAL);
+  t8_init (SC_LP_DEFAULT);
+
+  t8_global_productionf ("Testing forest balance.\n");
+  /* The default scheme implements these element classes */
+  for (ieclass = 0; ieclass < 4; ieclass++) {
+    t8_test_balance (eclasses[ieclass]);
+  }
+  t8_global_productionf ("Done testing forest balance.\n");
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
@@ -0,0 +1,79 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element types in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <t8_default.h>
+#include "t8_forest/t8_forest_types.h"
+#include "t8_test_forest_common.h"
+
+/* Refine the elements whose child id plus global tree id is divisible by 3
+ * up to the level that is given by the user data */
+static int
+t8_test_forest_refine_some (t8_forest_t forest, t8_locidx_t which_tree,
+                            t8_eclass_scheme_t * ts,
+                            int num_elements, t8_element_t * elements[])
+{
+  t8_gloidx_t         gtree_id;
+  int                 maxlevel;
+
+  maxlevel = *(int *) t8_forest_get_user_data (forest);
+  gtree_id = forest->set_from->first_local_tree + which_tree;
+  if (t8_element_level (ts, elements[0]) < maxlevel
+      && (gtree_id + t8_element_child_id (ts, elements[0])) % 3 == 0) {
+    return 1;
+  }
+  return 0;
+}
+
+t8_forest_t
+t8_test_forest_new_adapted (t8_cmesh_t cmesh, sc_MPI_Comm comm, int maxlevel)
+{
+  t8_forest_t         forest, forest_adapt;
+
+  t8_forest_init (&forest);
+  t8_forest_set_cmesh (forest, cmesh, comm);
+  t8_forest_set_scheme (forest, t8_scheme_new_default ());
+  t8_forest_set_level (forest, 2);
+  t8_forest_commit (forest);
+
+  t8_forest_init (&forest_adapt);
+  t8_forest_set_adapt (forest_adapt, forest, t8_test_forest_refine_some,
+                       NULL, 1);
+  /* The level is only read during the commit */
+  t8_forest_set_user_data (forest_adapt, &maxlevel);
+  t8_forest_commit (forest_adapt);
+  forest_adapt->user_data = NULL;
+  return forest_adapt;
+}
+
+t8_forest_t
+t8_test_forest_new_partitioned (t8_forest_t forest_from, int do_ghost,
+                                void *user_data)
+{
+  t8_forest_t         forest;
+
+  t8_forest_init (&forest);
+  t8_forest_set_partition (forest, forest_from, 0, NULL);
+  t8_forest_set_ghost (forest, do_ghost);
+  t8_forest_set_user_data (forest, user_data);
+  t8_forest_commit (forest);
+  return forest;
+}
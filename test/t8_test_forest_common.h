@@ -0,0 +1,52 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element types in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+/* The forest that several forest tests start from. */
+
+#ifndef T8_TEST_FOREST_COMMON_H
+#define T8_TEST_FOREST_COMMON_H
+
+#include <t8.h>
+#include <t8_cmesh.h>
+#include <t8_forest.h>
+
+T8_EXTERN_C_BEGIN ();
+
+/* Create a forest of the default scheme on cmesh, which is uniformly
+ * refined to level 2. Then refine recursively the elements whose child id
+ * plus global tree id is divisible by 3 up to maxlevel, such that the
+ * leaves of a tree have different levels. The forest is not partitioned.
+ * This function takes ownership of cmesh. */
+t8_forest_t         t8_test_forest_new_adapted (t8_cmesh_t cmesh,
+                                                sc_MPI_Comm comm,
+                                                int maxlevel);
+
+/* Repartition forest_from and create its ghost layer if do_ghost is true.
+ * The user data is set on the new forest.
+ * This function takes ownership of forest_from. */
+t8_forest_t         t8_test_forest_new_partitioned (t8_forest_t forest_from,
+                                                    int do_ghost,
+                                                    void *user_data);
+
+T8_EXTERN_C_END ();
+
+#endif /* !T8_TEST_FOREST_COMMON_H */
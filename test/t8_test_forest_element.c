@@ -0,0 +1,152 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element types in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <sc_refcount.h>
+#include <t8_default.h>
+#include <t8_cmesh.h>
+#include <t8_forest.h>
+#include "t8_forest/t8_forest_types.h"
+
+/* The number of trees of the coarse mesh. */
+#define T8_TEST_ELEMENT_NUM_TREES 13
+
+/* Refine the first element of every second tree up to level 4, such that
+ * the trees have very different element counts. */
+static int
+t8_test_element_adapt (t8_forest_t forest, t8_locidx_t which_tree,
+                       t8_eclass_scheme_t * ts,
+                       int num_elements, t8_element_t * elements[])
+{
+  t8_gloidx_t         gtree_id;
+
+  gtree_id = forest->set_from->first_local_tree + which_tree;
+  if (gtree_id % 2 == 0 && t8_element_level (ts, elements[0]) < 4
+      && t8_element_child_id (ts, elements[0]) == 0) {
+    return 1;
+  }
+  return 0;
+}
+
+/* Check that t8_forest_get_element returns each local element and its
+ * tree in the order of the trees' element arrays. */
+static void
+t8_test_element_check (t8_forest_t forest)
+{
+  t8_locidx_t         itree, num_trees, ielement, num_elements;
+  t8_locidx_t         lelement_id, ltreeid;
+  t8_tree_t           tree;
+  t8_element_t       *element;
+
+  num_trees = t8_forest_get_num_local_trees (forest);
+  lelement_id = 0;
+  for (itree = 0; itree < num_trees; itree++) {
+    tree = t8_forest_get_tree (forest, itree);
+    num_elements = t8_forest_get_tree_element_count (tree);
+    for (ielement = 0; ielement < num_elements; ielement++, lelement_id++) {
+      ltreeid = -1;
+      element = t8_forest_get_element (forest, lelement_id, &ltreeid);
+      SC_CHECK_ABORTF (ltreeid == itree,
+                       "Element %i is in tree %i, expected %i\n",
+                       lelement_id, ltreeid, itree);
+      SC_CHECK_ABORTF (element == (t8_element_t *)
+                       sc_array_index (&tree->elements, ielement),
+                       "Wrong element returned for index %i\n",
+                       lelement_id);
+      if (forest->element_tree != NULL) {
+        SC_CHECK_ABORT (forest->element_tree[lelement_id] == itree,
+                        "Wrong entry in the element tree table");
+      }
+    }
+  }
+  SC_CHECK_ABORT (lelement_id == t8_forest_get_num_element (forest),
+                  "Tree element counts do not sum to the local count");
+}
+
+/* Check the element access of a uniform forest, its adapted and its
+ * repartitioned forest. With \a level 1 the trees are small and the
+ * element tree table is used, with \a level 3 the trees are searched. */
+static void
+t8_test_element (t8_eclass_t eclass, int level)
+{
+  t8_forest_t         forest, forest_adapt, forest_partition;
+  t8_cmesh_t          cmesh;
+
+  cmesh = t8_cmesh_new_bigmesh (eclass, T8_TEST_ELEMENT_NUM_TREES,
+                                sc_MPI_COMM_WORLD);
+  t8_forest_init (&forest);
+  t8_forest_set_cmesh (forest, cmesh, sc_MPI_COMM_WORLD);
+  t8_forest_set_scheme (forest, t8_scheme_new_default ());
+  t8_forest_set_level (forest, level);
+  t8_forest_commit (forest);
+  if (t8_forest_get_num_local_trees (forest) > 1) {
+    /* Make sure that we test both ways to find the tree of an element */
+    SC_CHECK_ABORT ((forest->element_tree != NULL) == (level == 1),
+                    "Unexpected use of the element tree table");
+  }
+  t8_test_element_check (forest);
+
+  t8_forest_init (&forest_adapt);
+  t8_forest_set_adapt (forest_adapt, forest, t8_test_element_adapt, NULL, 1);
+  t8_forest_commit (forest_adapt);
+  t8_test_element_check (forest_adapt);
+
+  t8_forest_init (&forest_partition);
+  t8_forest_set_partition (forest_partition, forest_adapt, 0, NULL);
+  t8_forest_commit (forest_partition);
+  t8_test_element_check (forest_partition);
+
+  t8_forest_unref (&forest_partition);
+  t8_global_productionf ("Element access check passed. %s %i\n",
+                         t8_eclass_to_string[eclass], level);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  int                 ieclass;
+  t8_eclass_t         eclasses[4] = { T8_ECLASS_QUAD, T8_ECLASS_TRIANGLE,
+    T8_ECLASS_HEX, T8_ECLASS_TET
+  };
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_ESSENTIAL);
+  p4est_init (NULL, SC_LP_ESSENTIAL);
+  t8_init (SC_LP_DEFAULT);
+
+  t8_global_productionf ("Testing forest element access.\n");
+  /* The default scheme implements these element classes */
+  for (ieclass = 0; ieclass < 4; ieclass++) {
+    t8_test_element (eclasses[ieclass], 1);
+    t8_test_element (eclasses[ieclass], 3);
+  }
+  t8_global_productionf ("Done testing forest element access.\n");
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
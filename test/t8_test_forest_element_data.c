@@ -0,0 +1,336 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element types in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+/* Register two data fields with a forest and let them follow recursive
+ * and non-recursive adaptation, adaptation from markers, partition and
+ * balance. The first field is the volume of an element, whose
+ * interpolation distributes the volume of the old elements of a group to
+ * the new elements. The second field identifies the element and is set
+ * from the new elements. After each step, both fields must match the
+ * elements, which checks the copied data of unchanged elements and the
+ * element ranges passed to the interpolation. */
+
+#include <sc_refcount.h>
+#include <t8_default.h>
+#include <t8_cmesh.h>
+#include <t8_forest.h>
+#include "t8_forest/t8_forest_types.h"
+
+/* The number of trees of the coarse mesh. */
+#define T8_TEST_DATA_NUM_TREES 3
+
+/* The data of the second field */
+typedef struct
+{
+  t8_gloidx_t         gtree_id; /* The global tree of the element */
+  uint64_t            id;       /* The linear id of the element */
+  int                 level;    /* The level of the element */
+} t8_test_data_id_t;
+
+/* Return the element with local index lelement of a forest whose trees
+ * are complete, but which may not be committed yet. */
+static t8_element_t *
+t8_test_data_element (t8_forest_t forest, t8_locidx_t lelement,
+                      t8_gloidx_t * gtree_id, t8_eclass_scheme_t ** ts)
+{
+  t8_locidx_t         itree;
+  t8_tree_t           tree;
+
+  for (itree = 0;; itree++) {
+    tree = t8_forest_get_tree (forest, itree);
+    if (lelement < tree->elements_offset +
+        t8_forest_get_tree_element_count (tree)) {
+      break;
+    }
+  }
+  *gtree_id = forest->first_local_tree + itree;
+  *ts = forest->scheme->eclass_schemes[tree->eclass];
+  return t8_element_array_index (*ts, &tree->elements,
+                                 lelement - tree->elements_offset);
+}
+
+/* The volume of an element in a tree of volume one */
+static double
+t8_test_data_volume (t8_eclass_scheme_t * ts, const t8_element_t * element)
+{
+  return ldexp (1., -t8_eclass_to_dimension[ts->eclass] *
+                t8_element_level (ts, element));
+}
+
+/* Distribute the volume of the old elements of each group to the new
+ * elements in proportion to their own volume */
+static void
+t8_test_data_interpolate_volume (t8_forest_t forest, size_t data_size,
+                                 size_t num_remaps,
+                                 const t8_forest_element_remap_t * remaps,
+                                 const void *data_old, void *data_new)
+{
+  const double       *volume_old = (const double *) data_old;
+  double             *volume_new = (double *) data_new;
+  double              total, total_new;
+  t8_eclass_scheme_t *ts;
+  t8_element_t       *element;
+  t8_gloidx_t         gtree_id;
+  t8_locidx_t         iel;
+  size_t              iremap;
+
+  SC_CHECK_ABORT (data_size == sizeof (double), "Wrong data size");
+  for (iremap = 0; iremap < num_remaps; iremap++) {
+    total = total_new = 0;
+    for (iel = 0; iel < remaps[iremap].num_old; iel++) {
+      total += volume_old[remaps[iremap].first_old + iel];
+    }
+    for (iel = 0; iel < remaps[iremap].num_new; iel++) {
+      element = t8_test_data_element (forest, remaps[iremap].first_new + iel,
+                                      &gtree_id, &ts);
+      total_new += t8_test_data_volume (ts, element);
+    }
+    for (iel = 0; iel < remaps[iremap].num_new; iel++) {
+      element = t8_test_data_element (forest, remaps[iremap].first_new + iel,
+                                      &gtree_id, &ts);
+      volume_new[remaps[iremap].first_new + iel] = total *
+        t8_test_data_volume (ts, element) / total_new;
+    }
+  }
+}
+
+/* Set the identification of an element */
+static void
+t8_test_data_set_id (t8_forest_t forest, t8_locidx_t lelement,
+                     t8_test_data_id_t * id)
+{
+  t8_eclass_scheme_t *ts;
+  t8_element_t       *element;
+
+  element = t8_test_data_element (forest, lelement, &id->gtree_id, &ts);
+  id->level = t8_element_level (ts, element);
+  id->id = t8_element_get_linear_id (ts, element, id->level);
+}
+
+/* Set the identification of the new elements */
+static void
+t8_test_data_interpolate_id (t8_forest_t forest, size_t data_size,
+                             size_t num_remaps,
+                             const t8_forest_element_remap_t * remaps,
+                             const void *data_old, void *data_new)
+{
+  t8_test_data_id_t  *id_new = (t8_test_data_id_t *) data_new;
+  t8_locidx_t         iel;
+  size_t              iremap;
+
+  SC_CHECK_ABORT (data_size == sizeof (t8_test_data_id_t),
+                  "Wrong data size");
+  for (iremap = 0; iremap < num_remaps; iremap++) {
+    SC_CHECK_ABORT (iremap == 0 || (remaps[iremap].first_old >=
+                                    remaps[iremap - 1].first_old +
+                                    remaps[iremap - 1].num_old
+                                    && remaps[iremap].first_new >=
+                                    remaps[iremap - 1].first_new +
+                                    remaps[iremap - 1].num_new),
+                    "The groups are not ordered");
+    for (iel = 0; iel < remaps[iremap].num_new; iel++) {
+      t8_test_data_set_id (forest, remaps[iremap].first_new + iel,
+                           id_new + remaps[iremap].first_new + iel);
+    }
+  }
+}
+
+/* Refine the elements whose linear id on their level is divisible by 3,
+ * such that the data is interpolated to leaves of several levels */
+static int
+t8_test_data_refine (t8_forest_t forest, t8_locidx_t which_tree,
+                     t8_eclass_scheme_t * ts,
+                     int num_elements, t8_element_t * elements[])
+{
+  int                 level;
+
+  level = t8_element_level (ts, elements[0]);
+  return level < (t8_eclass_to_dimension[ts->eclass] == 3 ? 4 : 6)
+    && t8_element_get_linear_id (ts, elements[0], level) % 3 == 0;
+}
+
+/* Coarsen the families whose parent has an even linear id and refine
+ * some of the other elements */
+static int
+t8_test_data_mixed (t8_forest_t forest, t8_locidx_t which_tree,
+                    t8_eclass_scheme_t * ts,
+                    int num_elements, t8_element_t * elements[])
+{
+  int                 level;
+
+  level = t8_element_level (ts, elements[0]);
+  if (num_elements > 1 && level > 1
+      && (t8_element_get_linear_id (ts, elements[0], level - 1) % 2 == 0)) {
+    return -1;
+  }
+  return level < 5 && t8_element_child_id (ts, elements[0]) == 1;
+}
+
+/* Check that both fields match the elements of the forest */
+static void
+t8_test_data_check (t8_forest_t forest)
+{
+  t8_eclass_scheme_t *ts;
+  t8_element_t       *element;
+  t8_test_data_id_t  *id, expected;
+  t8_gloidx_t         gtree_id;
+  t8_locidx_t         iel;
+  double             *volume, local_volume, global_volume;
+  int                 mpiret;
+
+  SC_CHECK_ABORT (t8_forest_get_num_element_data (forest) == 2,
+                  "Wrong number of fields");
+  volume = (double *) t8_forest_get_element_data (forest, 0);
+  id = (t8_test_data_id_t *) t8_forest_get_element_data (forest, 1);
+  local_volume = 0;
+  for (iel = 0; iel < forest->local_num_elements; iel++) {
+    element = t8_test_data_element (forest, iel, &gtree_id, &ts);
+    SC_CHECK_ABORTF (fabs (volume[iel] - t8_test_data_volume (ts, element))
+                     < 1e-12, "Wrong volume of element %i\n", iel);
+    local_volume += volume[iel];
+    t8_test_data_set_id (forest, iel, &expected);
+    SC_CHECK_ABORTF (id[iel].gtree_id == expected.gtree_id
+                     && id[iel].id == expected.id
+                     && id[iel].level == expected.level,
+                     "Wrong data of element %i\n", iel);
+  }
+  mpiret = sc_MPI_Allreduce (&local_volume, &global_volume, 1,
+                             sc_MPI_DOUBLE, sc_MPI_SUM, forest->mpicomm);
+  SC_CHECK_MPI (mpiret);
+  SC_CHECK_ABORTF (fabs (global_volume - T8_TEST_DATA_NUM_TREES) < 1e-10,
+                   "The volume %f is not conserved\n", global_volume);
+}
+
+/* Derive a forest from forest_from by adaptation with adapt_fn or by
+ * partition if adapt_fn is NULL, which is balanced if do_balance is true */
+static              t8_forest_t
+t8_test_data_derive (t8_forest_t forest_from, t8_forest_adapt_t adapt_fn,
+                     int recursive, int do_balance)
+{
+  t8_forest_t         forest;
+
+  t8_forest_init (&forest);
+  if (adapt_fn != NULL) {
+    t8_forest_set_adapt (forest, forest_from, adapt_fn, NULL, recursive);
+  }
+  else {
+    t8_forest_set_partition (forest, forest_from, 0, NULL);
+  }
+  t8_forest_set_balance (forest, do_balance);
+  t8_forest_commit (forest);
+  t8_test_data_check (forest);
+  return forest;
+}
+
+static void
+t8_test_data (t8_eclass_t eclass)
+{
+  t8_forest_t         forest, forest_copy;
+  t8_eclass_scheme_t *ts;
+  t8_element_t       *element;
+  t8_gloidx_t         gtree_id;
+  t8_locidx_t         iel;
+  sc_array_t          markers;
+  double             *volume;
+
+  t8_forest_init (&forest);
+  t8_forest_set_cmesh (forest, t8_cmesh_new_bigmesh (eclass,
+                                                     T8_TEST_DATA_NUM_TREES,
+                                                     sc_MPI_COMM_WORLD),
+                       sc_MPI_COMM_WORLD);
+  t8_forest_set_scheme (forest, t8_scheme_new_default ());
+  t8_forest_set_level (forest, 2);
+  t8_forest_commit (forest);
+
+  SC_CHECK_ABORT (t8_forest_register_element_data
+                  (forest, sizeof (double),
+                   t8_test_data_interpolate_volume) == 0,
+                  "Wrong field index");
+  SC_CHECK_ABORT (t8_forest_register_element_data
+                  (forest, sizeof (t8_test_data_id_t),
+                   t8_test_data_interpolate_id) == 1, "Wrong field index");
+  volume = (double *) t8_forest_get_element_data (forest, 0);
+  for (iel = 0; iel < forest->local_num_elements; iel++) {
+    SC_CHECK_ABORT (volume[iel] == 0, "The data is not initialized to zero");
+    element = t8_test_data_element (forest, iel, &gtree_id, &ts);
+    volume[iel] = t8_test_data_volume (ts, element);
+    t8_test_data_set_id (forest, iel, (t8_test_data_id_t *)
+                         t8_forest_get_element_data (forest, 1) + iel);
+  }
+  t8_test_data_check (forest);
+
+  forest = t8_test_data_derive (forest, t8_test_data_refine, 1, 0);
+  forest = t8_test_data_derive (forest, NULL, 0, 0);
+  /* Adapt once into new arrays and once in place */
+  t8_forest_ref (forest);
+  forest_copy = t8_test_data_derive (forest, t8_test_data_mixed, 0, 0);
+  t8_forest_unref (&forest_copy);
+  forest = t8_test_data_derive (forest, t8_test_data_mixed, 0, 0);
+  forest = t8_test_data_derive (forest, NULL, 0, 1);
+
+  /* Refine every third and coarsen all other elements from markers */
+  sc_array_init_size (&markers, sizeof (int8_t), forest->local_num_elements);
+  for (iel = 0; iel < forest->local_num_elements; iel++) {
+    *(int8_t *) sc_array_index (&markers, iel) = iel % 3 == 0 ? 1 : -1;
+  }
+  forest_copy = forest;
+  t8_forest_init (&forest);
+  t8_forest_set_adapt_markers (forest, forest_copy, &markers);
+  t8_forest_commit (forest);
+  t8_test_data_check (forest);
+  sc_array_reset (&markers);
+
+  t8_forest_unref (&forest);
+  t8_global_productionf ("Element data check passed. %s\n",
+                         t8_eclass_to_string[eclass]);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  int                 ieclass;
+  t8_eclass_t         eclasses[4] = { T8_ECLASS_QUAD, T8_ECLASS_TRIANGLE,
+    T8_ECLASS_HEX, T8_ECLASS_TET
+  };
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_ESSENTIAL);
+  p4est_init (NULL, SC_LP_ESSENTIAL);
+  t8_init (SC_LP_DEFAULT);
+
+  t8_global_productionf ("Testing forest element data.\n");
+  /* The default scheme implements these element classes */
+  for (ieclass = 0; ieclass < 4; ieclass++) {
+    t8_test_data (eclasses[ieclass]);
+  }
+  t8_global_productionf ("Done testing forest element data.\n");
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
@@ -0,0 +1,428 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element types in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+/* Create the ghost layer of an adapted and partitioned forest and compare
+ * it to the ghosts and mirrors that we compute by brute force from a copy
+ * of the whole forest on each process. Two leaves share a face if the
+ * same level face neighbor of one of them lies inside the other one.
+ * We also exchange data of the elements and check that each ghost receives
+ * the data of its own element. */
+
+#include <sc_refcount.h>
+#include <t8_default.h>
+#include <t8_cmesh.h>
+#include <t8_forest.h>
+#include "t8_forest/t8_forest_types.h"
+#include "t8_forest/t8_forest_ghost.h"
+#include "t8_test_forest_common.h"
+
+/* Create the adapted forest, such that neighboring leaves have different
+ * levels. If comm is not sc_MPI_COMM_SELF, the forest is repartitioned and
+ * has a ghost layer. */
+static              t8_forest_t
+t8_test_ghost_new (t8_eclass_t eclass, sc_MPI_Comm comm, int do_ghost)
+{
+  t8_forest_t         forest;
+
+  forest = t8_test_forest_new_adapted (t8_cmesh_new_hypercube (eclass, comm,
+                                                               0, 0), comm,
+                                       t8_eclass_to_dimension[eclass] ==
+                                       3 ? 3 : 4);
+  if (!do_ghost) {
+    return forest;
+  }
+  return t8_test_forest_new_partitioned (forest, 1, NULL);
+}
+
+/* Return the global index of the leaf of the serial forest that contains
+ * element or -1 if element is not inside a leaf. */
+static              t8_gloidx_t
+t8_test_ghost_find_leaf (t8_forest_t forest_serial, t8_gloidx_t gtreeid,
+                         const t8_element_t * element, t8_element_t * anc)
+{
+  t8_tree_t           tree;
+  t8_eclass_scheme_t *ts;
+  t8_element_t       *leaf;
+  size_t              low, high, mid;
+
+  tree = t8_forest_get_tree (forest_serial, (t8_locidx_t) gtreeid);
+  ts = forest_serial->scheme->eclass_schemes[tree->eclass];
+  /* Find the last leaf that is not greater than element */
+  low = 0;
+  high = tree->elements.elem_count;
+  while (low < high) {
+    mid = low + (high - low) / 2;
+    if (t8_element_compare (ts, t8_element_array_index (ts, &tree->elements,
+                                                        mid), element) <= 0) {
+      low = mid + 1;
+    }
+    else {
+      high = mid;
+    }
+  }
+  if (low == 0) {
+    return -1;
+  }
+  leaf = t8_element_array_index (ts, &tree->elements, low - 1);
+  if (t8_element_level (ts, leaf) > t8_element_level (ts, element)) {
+    return -1;
+  }
+  /* The leaf must be an ancestor of element or element itself */
+  t8_element_copy (ts, element, anc);
+  while (t8_element_level (ts, anc) > t8_element_level (ts, leaf)) {
+    t8_element_parent (ts, anc, anc);
+  }
+  if (t8_element_compare (ts, anc, leaf) != 0) {
+    return -1;
+  }
+  return tree->elements_offset + (t8_gloidx_t) low - 1;
+}
+
+/* Fill pairs with the pairs of global leaf indices of the serial forest
+ * that share a face, in both orders */
+static void
+t8_test_ghost_face_pairs (t8_forest_t forest_serial, sc_array_t * pairs)
+{
+  t8_locidx_t         itree, num_trees;
+  t8_tree_t           tree;
+  t8_eclass_scheme_t *ts;
+  t8_element_t       *element, *neigh, *anc;
+  t8_gloidx_t         neigh_gtreeid, ileaf, neigh_leaf, *pair;
+  size_t              ielement;
+  int                 iface, neigh_face;
+
+  num_trees = t8_forest_get_num_local_trees (forest_serial);
+  for (itree = 0; itree < num_trees; itree++) {
+    tree = t8_forest_get_tree (forest_serial, itree);
+    ts = forest_serial->scheme->eclass_schemes[tree->eclass];
+    t8_element_new (ts, 1, &neigh);
+    t8_element_new (ts, 1, &anc);
+    for (ielement = 0; ielement < tree->elements.elem_count; ielement++) {
+      element = t8_element_array_index (ts, &tree->elements, ielement);
+      ileaf = tree->elements_offset + (t8_gloidx_t) ielement;
+      for (iface = 0; iface < t8_element_num_faces (ts, element); iface++) {
+        if (!t8_forest_element_face_neighbor (forest_serial, itree, element,
+                                              iface, neigh, &neigh_face,
+                                              &neigh_gtreeid)) {
+          continue;
+        }
+        neigh_leaf = t8_test_ghost_find_leaf (forest_serial, neigh_gtreeid,
+                                              neigh, anc);
+        if (neigh_leaf < 0) {
+          /* The neighbor is refined, its leaves find this element */
+          continue;
+        }
+        pair = (t8_gloidx_t *) sc_array_push_count (pairs, 2);
+        pair[0] = ileaf;
+        pair[1] = neigh_leaf;
+        pair = (t8_gloidx_t *) sc_array_push_count (pairs, 2);
+        pair[0] = neigh_leaf;
+        pair[1] = ileaf;
+      }
+    }
+    t8_element_destroy (ts, 1, &neigh);
+    t8_element_destroy (ts, 1, &anc);
+  }
+}
+
+static int
+t8_test_ghost_gloidx_compare (const void *v1, const void *v2)
+{
+  return t8_compare_gloidx (v1, v2);
+}
+
+/* Sort an array of global indices and remove duplicates */
+static void
+t8_test_ghost_sort_unique (sc_array_t * array)
+{
+  size_t              iread, iwrite;
+
+  sc_array_sort (array, t8_test_ghost_gloidx_compare);
+  for (iread = 0, iwrite = 0; iread < array->elem_count; iread++) {
+    if (iwrite == 0 || *(t8_gloidx_t *) sc_array_index (array, iread) !=
+        *(t8_gloidx_t *) sc_array_index (array, iwrite - 1)) {
+      *(t8_gloidx_t *) sc_array_index (array, iwrite++) =
+        *(t8_gloidx_t *) sc_array_index (array, iread);
+    }
+  }
+  sc_array_resize (array, iwrite);
+}
+
+/* Compare the ghosts and mirrors of the remote process remote_rank with
+ * those computed from the pairs of leaves that share a face */
+static void
+t8_test_ghost_check_remote (t8_forest_t forest, t8_forest_t forest_serial,
+                            t8_ghost_remote_t * remote, sc_array_t * pairs)
+{
+  sc_array_t          expected_ghosts, expected_mirrors;
+  t8_ghost_tree_t    *ghost_tree;
+  t8_eclass_scheme_t *ts;
+  t8_element_t       *anc;
+  t8_gloidx_t        *pair, first_local, ileaf;
+  size_t              ipair, itree, ielement, ighost;
+
+  first_local = t8_forest_get_first_local_element_id (forest);
+  sc_array_init (&expected_ghosts, sizeof (t8_gloidx_t));
+  sc_array_init (&expected_mirrors, sizeof (t8_gloidx_t));
+  for (ipair = 0; ipair < pairs->elem_count; ipair += 2) {
+    pair = (t8_gloidx_t *) sc_array_index (pairs, ipair);
+    if (t8_forest_element_find_owner (forest, pair[0]) == forest->mpirank
+        && t8_forest_element_find_owner (forest, pair[1]) ==
+        remote->remote_rank) {
+      *(t8_gloidx_t *) sc_array_push (&expected_mirrors) =
+        pair[0] - first_local;
+      *(t8_gloidx_t *) sc_array_push (&expected_ghosts) = pair[1];
+    }
+  }
+  t8_test_ghost_sort_unique (&expected_ghosts);
+  t8_test_ghost_sort_unique (&expected_mirrors);
+
+  SC_CHECK_ABORTF ((size_t) remote->num_ghosts ==
+                   expected_ghosts.elem_count,
+                   "Received %i ghosts from rank %i, expected %i\n",
+                   remote->num_ghosts, remote->remote_rank,
+                   (int) expected_ghosts.elem_count);
+  ighost = 0;
+  for (itree = 0; itree < remote->ghost_trees.elem_count; itree++) {
+    ghost_tree = (t8_ghost_tree_t *) sc_array_index (&remote->ghost_trees,
+                                                     itree);
+    ts = forest->scheme->eclass_schemes[ghost_tree->eclass];
+    t8_element_new (ts, 1, &anc);
+    for (ielement = 0; ielement < ghost_tree->elements.elem_count;
+         ielement++, ighost++) {
+      ileaf = t8_test_ghost_find_leaf (forest_serial, ghost_tree->global_id,
+                                       t8_element_array_index (ts,
+                                                               &ghost_tree->elements,
+                                                               ielement),
+                                       anc);
+      SC_CHECK_ABORT (ighost < expected_ghosts.elem_count &&
+                      ileaf == *(t8_gloidx_t *)
+                      sc_array_index (&expected_ghosts, ighost),
+                      "Wrong ghost element");
+    }
+    t8_element_destroy (ts, 1, &anc);
+  }
+
+  SC_CHECK_ABORTF (remote->mirrors.elem_count == expected_mirrors.elem_count,
+                   "Have %i mirrors for rank %i, expected %i\n",
+                   (int) remote->mirrors.elem_count, remote->remote_rank,
+                   (int) expected_mirrors.elem_count);
+  for (ielement = 0; ielement < remote->mirrors.elem_count; ielement++) {
+    SC_CHECK_ABORT (*(t8_locidx_t *) sc_array_index (&remote->mirrors,
+                                                     ielement) ==
+                    *(t8_gloidx_t *) sc_array_index (&expected_mirrors,
+                                                     ielement),
+                    "Wrong mirror element");
+  }
+  sc_array_reset (&expected_ghosts);
+  sc_array_reset (&expected_mirrors);
+}
+
+/* The data that each element sends to the processes that have it as ghost */
+typedef struct
+{
+  t8_gloidx_t         gtreeid;
+  uint64_t            linear_id;
+  int                 level;
+} t8_test_ghost_data_t;
+
+/* Exchange data that identifies each element with the blocking exchange
+ * and the global index of each element with the nonblocking exchange,
+ * which we repeat. Each ghost must receive the data of its own element. */
+static void
+t8_test_ghost_exchange (t8_forest_t forest, t8_forest_t forest_serial)
+{
+  t8_forest_ghost_exchange_t exchange;
+  t8_locidx_t         itree, num_trees, ielement, num_ghosts, ighost;
+  t8_locidx_t         num_local;
+  t8_tree_t           tree;
+  t8_eclass_scheme_t *ts;
+  t8_eclass_t         eclass;
+  t8_element_t       *element, *anc;
+  t8_test_ghost_data_t *data;
+  t8_gloidx_t         gtreeid, first_local;
+  sc_array_t          element_data, element_index;
+  int                 maxlevel;
+
+  num_local = forest->local_num_elements;
+  num_ghosts = t8_forest_get_num_ghosts (forest);
+  first_local = t8_forest_get_first_local_element_id (forest);
+  sc_array_init_size (&element_data, sizeof (t8_test_ghost_data_t),
+                      num_local + num_ghosts);
+  /* An entry size of one byte does not align with the elements */
+  sc_array_init_size (&element_index, sizeof (char), num_local + num_ghosts);
+  num_trees = t8_forest_get_num_local_trees (forest);
+  for (itree = 0; itree < num_trees; itree++) {
+    tree = t8_forest_get_tree (forest, itree);
+    ts = forest->scheme->eclass_schemes[tree->eclass];
+    maxlevel = t8_element_maxlevel (ts);
+    for (ielement = 0; ielement < t8_forest_get_tree_element_count (tree);
+         ielement++) {
+      element = t8_element_array_index (ts, &tree->elements, ielement);
+      data = (t8_test_ghost_data_t *) sc_array_index (&element_data,
+                                                      tree->elements_offset +
+                                                      ielement);
+      data->gtreeid = forest->first_local_tree + itree;
+      data->linear_id = t8_element_get_linear_id (ts, element, maxlevel);
+      data->level = t8_element_level (ts, element);
+      *(char *) sc_array_index (&element_index, tree->elements_offset +
+                                ielement) =
+        (char) ((first_local + tree->elements_offset + ielement) % 127);
+    }
+  }
+  for (ighost = 0; ighost < num_ghosts; ighost++) {
+    data = (t8_test_ghost_data_t *) sc_array_index (&element_data,
+                                                    num_local + ighost);
+    data->gtreeid = -1;
+    data->linear_id = 0;
+    data->level = -1;
+    *(char *) sc_array_index (&element_index, num_local + ighost) = -1;
+  }
+
+  t8_forest_ghost_exchange_data (forest, &element_data);
+  exchange = t8_forest_ghost_exchange_begin (forest, &element_index);
+  /* The data of the local elements may be read during the exchange */
+  for (ielement = 0; ielement < num_local; ielement++) {
+    SC_CHECK_ABORT (*(char *) sc_array_index (&element_index, ielement) ==
+                    (char) ((first_local + ielement) % 127),
+                    "The exchange modified local data");
+  }
+  t8_forest_ghost_exchange_end (&exchange);
+  SC_CHECK_ABORT (exchange == NULL, "The exchange was not completed");
+  /* Exchange again with the datatypes that the ghost layer keeps for
+   * this entry size */
+  for (ighost = 0; ighost < num_ghosts; ighost++) {
+    *(char *) sc_array_index (&element_index, num_local + ighost) = -1;
+  }
+  exchange = t8_forest_ghost_exchange_begin (forest, &element_index);
+  t8_forest_ghost_exchange_end (&exchange);
+
+  for (ighost = 0; ighost < num_ghosts; ighost++) {
+    element = t8_forest_ghost_get_element (forest, ighost, &gtreeid,
+                                           &eclass);
+    ts = forest->scheme->eclass_schemes[eclass];
+    data = (t8_test_ghost_data_t *) sc_array_index (&element_data,
+                                                    num_local + ighost);
+    SC_CHECK_ABORTF (data->gtreeid == gtreeid
+                     && data->level == t8_element_level (ts, element)
+                     && data->linear_id ==
+                     t8_element_get_linear_id (ts, element,
+                                               t8_element_maxlevel (ts)),
+                     "Ghost %i received wrong data\n", ighost);
+    t8_element_new (ts, 1, &anc);
+    SC_CHECK_ABORTF (*(char *) sc_array_index (&element_index,
+                                               num_local + ighost) ==
+                     (char) (t8_test_ghost_find_leaf (forest_serial, gtreeid,
+                                                      element, anc) % 127),
+                     "Ghost %i received a wrong index\n", ighost);
+    t8_element_destroy (ts, 1, &anc);
+  }
+  sc_array_reset (&element_data);
+  sc_array_reset (&element_index);
+}
+
+static void
+t8_test_ghost (t8_eclass_t eclass)
+{
+  t8_forest_t         forest, forest_serial;
+  t8_ghost_remote_t  *remote;
+  sc_array_t          pairs;
+  t8_gloidx_t        *pair;
+  size_t              ipair;
+  int                 iremote, num_remotes, rank;
+  int                 num_expected_remotes;
+  int                *is_remote;
+
+  forest = t8_test_ghost_new (eclass, sc_MPI_COMM_WORLD, 1);
+  /* Each process creates the whole forest on its own */
+  forest_serial = t8_test_ghost_new (eclass, sc_MPI_COMM_SELF, 0);
+  SC_CHECK_ABORT (forest->global_num_elements ==
+                  forest_serial->global_num_elements,
+                  "The serial forest differs");
+  sc_array_init (&pairs, sizeof (t8_gloidx_t));
+  t8_test_ghost_face_pairs (forest_serial, &pairs);
+
+  /* The remote processes are those that own a leaf that shares a face
+   * with a local leaf */
+  is_remote = T8_ALLOC_ZERO (int, forest->mpisize);
+  for (ipair = 0; ipair < pairs.elem_count; ipair += 2) {
+    pair = (t8_gloidx_t *) sc_array_index (&pairs, ipair);
+    rank = t8_forest_element_find_owner (forest, pair[1]);
+    if (t8_forest_element_find_owner (forest, pair[0]) == forest->mpirank
+        && rank != forest->mpirank) {
+      is_remote[rank] = 1;
+    }
+  }
+  num_expected_remotes = 0;
+  for (rank = 0; rank < forest->mpisize; rank++) {
+    num_expected_remotes += is_remote[rank];
+  }
+  num_remotes = t8_forest_ghost_num_remotes (forest->ghosts);
+  SC_CHECK_ABORTF (num_remotes == num_expected_remotes,
+                   "Have %i remote processes, expected %i\n", num_remotes,
+                   num_expected_remotes);
+  for (iremote = 0; iremote < num_remotes; iremote++) {
+    remote = t8_forest_ghost_get_remote (forest->ghosts, iremote);
+    SC_CHECK_ABORT (is_remote[remote->remote_rank],
+                    "Unexpected remote process");
+    t8_test_ghost_check_remote (forest, forest_serial, remote, &pairs);
+  }
+  t8_test_ghost_exchange (forest, forest_serial);
+
+  T8_FREE (is_remote);
+  sc_array_reset (&pairs);
+  t8_forest_unref (&forest_serial);
+  t8_forest_unref (&forest);
+  t8_global_productionf ("Ghost check passed. %s\n",
+                         t8_eclass_to_string[eclass]);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  int                 ieclass;
+  t8_eclass_t         eclasses[4] = { T8_ECLASS_QUAD, T8_ECLASS_TRIANGLE,
+    T8_ECLASS_HEX, T8_ECLASS_TET
+  };
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_ESSENTIAL);
+  p4est_init (NULL, SC_LP_ESSENTIAL);
+  t8_init (SC_LP_DEFAULT);
+
+  t8_global_productionf ("Testing forest ghost layer.\n");
+  /* The default scheme implements these element classes */
+  for (ieclass = 0; ieclass < 4; ieclass++) {
+    t8_test_ghost (eclasses[ieclass]);
+  }
+  t8_global_productionf ("Done testing forest ghost layer.\n");
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
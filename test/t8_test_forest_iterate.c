@@ -0,0 +1,231 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element types in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+/* Iterate over an adapted and partitioned forest and check that each
+ * leaf is visited exactly once in the order of the tree, that each inner
+ * element is visited before its leaves and that the leaves passed with an
+ * element are exactly its descendants. A second pass skips the
+ * descendants of some inner elements, which then must not be visited. */
+
+#include <t8_default.h>
+#include <t8_cmesh.h>
+#include <t8_forest.h>
+#include "t8_forest/t8_forest_types.h"
+#include "t8_test_forest_common.h"
+
+/* The state of an iteration that the callback checks and updates */
+typedef struct
+{
+  t8_locidx_t         ltreeid;  /* The tree of the last visited element */
+  t8_locidx_t         next_leaf;        /* The index in the tree of the next leaf */
+  t8_locidx_t         num_visited;      /* The number of visited leaves */
+  t8_locidx_t         num_skipped;      /* The number of skipped leaves */
+  int                 skip_level;       /* Skip inner elements of this level, -1 for none */
+} t8_test_iterate_t;
+
+/* Create an adapted and partitioned forest with the given user data, such
+ * that the leaves of a tree have different levels */
+static              t8_forest_t
+t8_test_iterate_new (t8_eclass_t eclass, void *user_data)
+{
+  t8_forest_t         forest;
+
+  forest = t8_test_forest_new_adapted (t8_cmesh_new_hypercube (eclass,
+                                                               sc_MPI_COMM_WORLD,
+                                                               0, 0),
+                                       sc_MPI_COMM_WORLD,
+                                       t8_eclass_to_dimension[eclass] ==
+                                       3 ? 4 : 6);
+  return t8_test_forest_new_partitioned (forest, 0, user_data);
+}
+
+/* Return true if leaf is element or a descendant of element */
+static int
+t8_test_iterate_is_descendant (t8_eclass_scheme_t * ts,
+                               const t8_element_t * element,
+                               const t8_element_t * leaf, t8_element_t * anc)
+{
+  if (t8_element_level (ts, leaf) < t8_element_level (ts, element)) {
+    return 0;
+  }
+  t8_element_copy (ts, leaf, anc);
+  while (t8_element_level (ts, anc) > t8_element_level (ts, element)) {
+    t8_element_parent (ts, anc, anc);
+  }
+  return t8_element_compare (ts, anc, element) == 0;
+}
+
+static int
+t8_test_iterate_fn (t8_forest_t forest, t8_locidx_t ltreeid,
+                    const t8_element_t * element, int is_leaf,
+                    sc_array_t * leaf_elements, t8_locidx_t tree_leaf_index)
+{
+  t8_test_iterate_t  *state;
+  t8_tree_t           tree;
+  t8_eclass_scheme_t *ts;
+  t8_element_t       *anc;
+  t8_locidx_t         num_leaves, ileaf;
+
+  state = (t8_test_iterate_t *) t8_forest_get_user_data (forest);
+  tree = t8_forest_get_tree (forest, ltreeid);
+  ts = forest->scheme->eclass_schemes[tree->eclass];
+  num_leaves = (t8_locidx_t) leaf_elements->elem_count;
+
+  /* The trees are visited in order and each tree completely */
+  SC_CHECK_ABORT (ltreeid >= state->ltreeid, "The trees are out of order");
+  if (ltreeid > state->ltreeid) {
+    SC_CHECK_ABORT (state->ltreeid < 0 || state->next_leaf ==
+                    t8_forest_get_tree_element_count
+                    (t8_forest_get_tree (forest, state->ltreeid)),
+                    "Not all leaves of a tree were visited");
+    state->ltreeid = ltreeid;
+    state->next_leaf = 0;
+  }
+
+  /* An inner element is visited before its leaves and a leaf after the
+   * previous leaf */
+  SC_CHECK_ABORTF (tree_leaf_index == state->next_leaf,
+                   "Visited leaf %i, expected %i\n", tree_leaf_index,
+                   state->next_leaf);
+  SC_CHECK_ABORT (num_leaves > 0 && tree_leaf_index + num_leaves <=
+                  t8_forest_get_tree_element_count (tree),
+                  "Wrong number of leaves");
+  SC_CHECK_ABORT (t8_element_array_index (ts, leaf_elements, 0) ==
+                  t8_element_array_index (ts, &tree->elements,
+                                          tree_leaf_index),
+                  "The leaves are not a view of the tree's leaves");
+
+  /* The leaves are exactly the descendants of element */
+  t8_element_new (ts, 1, &anc);
+  for (ileaf = 0; ileaf < num_leaves; ileaf++) {
+    SC_CHECK_ABORT (t8_test_iterate_is_descendant (ts, element,
+                                                   t8_element_array_index
+                                                   (ts, leaf_elements, ileaf),
+                                                   anc),
+                    "A leaf is not a descendant");
+  }
+  SC_CHECK_ABORT (tree_leaf_index == 0
+                  || !t8_test_iterate_is_descendant (ts, element,
+                                                     t8_element_array_index
+                                                     (ts, &tree->elements,
+                                                      tree_leaf_index - 1),
+                                                     anc),
+                  "Missing the leaf before the leaves");
+  SC_CHECK_ABORT (tree_leaf_index + num_leaves ==
+                  t8_forest_get_tree_element_count (tree)
+                  || !t8_test_iterate_is_descendant (ts, element,
+                                                     t8_element_array_index
+                                                     (ts, &tree->elements,
+                                                      tree_leaf_index +
+                                                      num_leaves), anc),
+                  "Missing the leaf after the leaves");
+  t8_element_destroy (ts, 1, &anc);
+
+  if (is_leaf) {
+    SC_CHECK_ABORT (num_leaves == 1 && t8_element_level (ts, element) ==
+                    t8_element_level (ts, t8_element_array_index
+                                      (ts, leaf_elements, 0)),
+                    "The leaf is not a leaf of the tree");
+    state->next_leaf++;
+    state->num_visited++;
+    return 1;
+  }
+  SC_CHECK_ABORT (num_leaves > 1 || t8_element_level (ts, element) <
+                  t8_element_level (ts, t8_element_array_index
+                                    (ts, leaf_elements, 0)),
+                  "An inner element is a leaf");
+  if (t8_element_level (ts, element) == state->skip_level
+      && t8_element_child_id (ts, element) % 2 == 0) {
+    /* Skip the descendants */
+    state->next_leaf += num_leaves;
+    state->num_skipped += num_leaves;
+    return 0;
+  }
+  return 1;
+}
+
+/* Iterate over the whole forest and with skipping some elements. The
+ * level of the root is not skipped, since the root has no child id. */
+static void
+t8_test_iterate (t8_eclass_t eclass)
+{
+  t8_forest_t         forest;
+  t8_test_iterate_t   state;
+  int                 iskip, skip_level;
+  int                 skip_levels[4] = { -1, 1, 2, 3 };
+
+  forest = t8_test_iterate_new (eclass, &state);
+  for (iskip = 0; iskip < 4; iskip++) {
+    skip_level = skip_levels[iskip];
+    state.ltreeid = -1;
+    state.next_leaf = 0;
+    state.num_visited = 0;
+    state.num_skipped = 0;
+    state.skip_level = skip_level;
+    t8_forest_iterate (forest, t8_test_iterate_fn);
+    SC_CHECK_ABORT (state.ltreeid < 0 || state.next_leaf ==
+                    t8_forest_get_tree_element_count
+                    (t8_forest_get_tree (forest, state.ltreeid)),
+                    "Not all leaves of the last tree were visited");
+    SC_CHECK_ABORTF (state.num_visited + state.num_skipped ==
+                     forest->local_num_elements,
+                     "Visited %i and skipped %i of %i leaves\n",
+                     state.num_visited, state.num_skipped,
+                     forest->local_num_elements);
+    SC_CHECK_ABORT (skip_level >= 0 || state.num_skipped == 0,
+                    "Skipped leaves without skipping");
+  }
+  t8_forest_unref (&forest);
+  t8_global_productionf ("Iterate check passed. %s\n",
+                         t8_eclass_to_string[eclass]);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  int                 ieclass;
+  t8_eclass_t         eclasses[4] = { T8_ECLASS_QUAD, T8_ECLASS_TRIANGLE,
+    T8_ECLASS_HEX, T8_ECLASS_TET
+  };
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_ESSENTIAL);
+  p4est_init (NULL, SC_LP_ESSENTIAL);
+  t8_init (SC_LP_DEFAULT);
+
+  t8_global_productionf ("Testing forest iterate.\n");
+  /* The default scheme implements these element classes */
+  for (ieclass = 0; ieclass < 4; ieclass++) {
+    t8_test_iterate (eclasses[ieclass]);
+  }
+  t8_global_productionf ("Done testing forest iterate.\n");
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
@@ -0,0 +1,488 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element types in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <sc_refcount.h>
+#include <t8_default.h>
+#include <t8_cmesh.h>
+#include <t8_forest.h>
+#include "t8_forest/t8_forest_types.h"
+
+/* The number of trees of the coarse mesh. */
+#define T8_TEST_PARTITION_NUM_TREES 7
+
+/* Refine the elements of every third tree up to level 3 and leave
+ * the other trees at the initial level, such that the uniform partition
+ * of the initial forest is unbalanced and whole trees are moved. */
+static int
+t8_test_partition_adapt (t8_forest_t forest, t8_locidx_t which_tree,
+                         t8_eclass_scheme_t * ts,
+                         int num_elements, t8_element_t * elements[])
+{
+  t8_gloidx_t         gtree_id;
+
+  gtree_id = forest->set_from->first_local_tree + which_tree;
+  if (gtree_id % 3 == 0 && t8_element_level (ts, elements[0]) < 3) {
+    return 1;
+  }
+  return 0;
+}
+
+/* Check that the element offsets of the local trees of a forest are the
+ * cumulative sums of the element counts and that they are consistent
+ * with the local and global element counts. The first local element and
+ * the owner of each element must match the gathered element counts of
+ * all processes. */
+static void
+t8_test_partition_check_offsets (t8_forest_t forest)
+{
+  t8_locidx_t         itree, num_trees, offset;
+  t8_gloidx_t         local_num, global_num, gelement, *offsets;
+  t8_tree_t           tree;
+  int                 mpiret, iproc;
+
+  num_trees = t8_forest_get_num_local_trees (forest);
+  offset = 0;
+  for (itree = 0; itree < num_trees; itree++) {
+    tree = t8_forest_get_tree (forest, itree);
+    SC_CHECK_ABORTF (tree->elements_offset == offset,
+                     "Wrong element offset %i of tree %i, expected %i\n",
+                     tree->elements_offset, itree, offset);
+    offset += t8_forest_get_tree_element_count (tree);
+  }
+  SC_CHECK_ABORT (offset == t8_forest_get_num_element (forest),
+                  "Tree element counts do not sum to the local count");
+
+  local_num = t8_forest_get_num_element (forest);
+  mpiret = sc_MPI_Allreduce (&local_num, &global_num, 1, T8_MPI_GLOIDX,
+                             sc_MPI_SUM, forest->mpicomm);
+  SC_CHECK_MPI (mpiret);
+  SC_CHECK_ABORTF (global_num == forest->global_num_elements,
+                   "Local element counts sum to %lli, expected %lli\n",
+                   (long long) global_num,
+                   (long long) forest->global_num_elements);
+
+  offsets = T8_ALLOC_ZERO (t8_gloidx_t, forest->mpisize + 1);
+  mpiret = sc_MPI_Allgather (&local_num, 1, T8_MPI_GLOIDX, offsets + 1, 1,
+                             T8_MPI_GLOIDX, forest->mpicomm);
+  SC_CHECK_MPI (mpiret);
+  for (iproc = 0; iproc < forest->mpisize; iproc++) {
+    offsets[iproc + 1] += offsets[iproc];
+  }
+  SC_CHECK_ABORTF (t8_forest_get_first_local_element_id (forest) ==
+                   offsets[forest->mpirank],
+                   "The first local element is %lli, expected %lli\n",
+                   (long long) t8_forest_get_first_local_element_id (forest),
+                   (long long) offsets[forest->mpirank]);
+  /* Empty processes own no element */
+  iproc = 0;
+  for (gelement = 0; gelement < global_num; gelement++) {
+    while (gelement >= offsets[iproc + 1]) {
+      iproc++;
+    }
+    SC_CHECK_ABORTF (t8_forest_element_find_owner (forest, gelement) ==
+                     iproc, "Element %lli is owned by %i, expected %i\n",
+                     (long long) gelement,
+                     t8_forest_element_find_owner (forest, gelement), iproc);
+  }
+  T8_FREE (offsets);
+}
+
+/* The weight of an element for the weighted partition. The weights vary
+ * between 1 and 20 with the tree, level and child id of the element. */
+static double
+t8_test_partition_weight (t8_forest_t forest, t8_locidx_t which_tree,
+                          t8_eclass_scheme_t * ts, t8_element_t * element)
+{
+  t8_gloidx_t         gtree_id;
+
+  gtree_id = forest->first_local_tree + which_tree;
+  return 1 + (7 * gtree_id + 3 * t8_element_level (ts, element)
+              + t8_element_child_id (ts, element)) % 20;
+}
+
+/* Create the adapted forest of the test on the processes of comm */
+static              t8_forest_t
+t8_test_partition_new_adapted (t8_eclass_t eclass, sc_MPI_Comm comm)
+{
+  t8_forest_t         forest, forest_adapt;
+
+  t8_forest_init (&forest);
+  t8_forest_set_cmesh (forest, t8_cmesh_new_bigmesh (eclass,
+                                                     T8_TEST_PARTITION_NUM_TREES,
+                                                     comm), comm);
+  t8_forest_set_scheme (forest, t8_scheme_new_default ());
+  t8_forest_set_level (forest, 1);
+  t8_forest_commit (forest);
+
+  t8_forest_init (&forest_adapt);
+  t8_forest_set_adapt (forest_adapt, forest, t8_test_partition_adapt, NULL,
+                       1);
+  t8_forest_commit (forest_adapt);
+  return forest_adapt;
+}
+
+/* Check that process p starts at the first element whose exclusive prefix
+ * sum of weights is not smaller than p * W / P, where W is the total
+ * weight. We compute the prefix sums from a copy of the whole forest. */
+static void
+t8_test_partition_check_weighted (t8_forest_t forest,
+                                  t8_forest_t forest_serial)
+{
+  t8_locidx_t         itree, ielement;
+  t8_tree_t           tree;
+  t8_eclass_scheme_t *ts;
+  t8_gloidx_t         gelement, expected_first;
+  double             *prefix, bound;
+
+  /* The weights are integers, thus the sums are exact */
+  prefix = T8_ALLOC (double, forest_serial->global_num_elements + 1);
+  prefix[0] = 0;
+  gelement = 0;
+  for (itree = 0; itree < t8_forest_get_num_local_trees (forest_serial);
+       itree++) {
+    tree = t8_forest_get_tree (forest_serial, itree);
+    ts = forest_serial->scheme->eclass_schemes[tree->eclass];
+    for (ielement = 0; ielement < t8_forest_get_tree_element_count (tree);
+         ielement++, gelement++) {
+      prefix[gelement + 1] = prefix[gelement] +
+        t8_test_partition_weight (forest_serial, itree, ts,
+                                  t8_element_array_index (ts,
+                                                          &tree->elements,
+                                                          ielement));
+    }
+  }
+  bound = prefix[gelement] * forest->mpirank / forest->mpisize;
+  for (expected_first = 0; expected_first < gelement
+       && prefix[expected_first] < bound; expected_first++) {
+  }
+  SC_CHECK_ABORTF (t8_forest_get_first_local_element_id (forest) ==
+                   expected_first,
+                   "The weighted partition starts at element %lli, "
+                   "expected %lli\n",
+                   (long long) t8_forest_get_first_local_element_id (forest),
+                   (long long) expected_first);
+  T8_FREE (prefix);
+}
+
+/* Coarsen every family */
+static int
+t8_test_partition_coarsen (t8_forest_t forest, t8_locidx_t which_tree,
+                           t8_eclass_scheme_t * ts,
+                           int num_elements, t8_element_t * elements[])
+{
+  return num_elements > 1 ? -1 : 0;
+}
+
+/* Return the number of elements of a forest after coarsening every
+ * family once */
+static              t8_gloidx_t
+t8_test_partition_num_coarsened (t8_forest_t forest)
+{
+  t8_forest_t         forest_coarsen;
+  t8_gloidx_t         num_elements;
+
+  t8_forest_ref (forest);
+  t8_forest_init (&forest_coarsen);
+  t8_forest_set_adapt (forest_coarsen, forest, t8_test_partition_coarsen,
+                       NULL, 0);
+  t8_forest_commit (forest_coarsen);
+  num_elements = forest_coarsen->global_num_elements;
+  t8_forest_unref (&forest_coarsen);
+  return num_elements;
+}
+
+/* Check that the first element of this process does not belong to a
+ * family with elements on the previous process and that all families can
+ * be coarsened as in the serial forest. */
+static void
+t8_test_partition_check_families (t8_forest_t forest,
+                                  t8_forest_t forest_serial)
+{
+  t8_locidx_t         itree, ielement, num_elements;
+  t8_tree_t           tree;
+  t8_eclass_scheme_t *ts;
+  t8_element_t      **family;
+  t8_gloidx_t         first;
+  int                 ichild, num_children, child_id;
+
+  first = t8_forest_get_first_local_element_id (forest);
+  if (forest->local_num_elements > 0 && first > 0) {
+    /* Find the first local element in the serial forest */
+    for (itree = 0; first >= t8_forest_get_tree (forest_serial, itree)
+         ->elements_offset + t8_forest_get_tree_element_count
+         (t8_forest_get_tree (forest_serial, itree)); itree++) {
+    }
+    tree = t8_forest_get_tree (forest_serial, itree);
+    ts = forest_serial->scheme->eclass_schemes[tree->eclass];
+    ielement = (t8_locidx_t) (first - tree->elements_offset);
+    num_elements = t8_forest_get_tree_element_count (tree);
+    num_children = t8_eclass_num_children[tree->eclass];
+    child_id = t8_element_child_id (ts, t8_element_array_index
+                                    (ts, &tree->elements, ielement));
+    if (child_id > 0 && ielement - child_id >= 0
+        && ielement - child_id + num_children <= num_elements) {
+      family = T8_ALLOC (t8_element_t *, num_children);
+      for (ichild = 0; ichild < num_children; ichild++) {
+        family[ichild] = t8_element_array_index (ts, &tree->elements,
+                                                 ielement - child_id +
+                                                 ichild);
+      }
+      SC_CHECK_ABORTF (!t8_element_is_family (ts, family),
+                       "The partition splits the family of element %lli\n",
+                       (long long) first);
+      T8_FREE (family);
+    }
+  }
+  SC_CHECK_ABORT (t8_test_partition_num_coarsened (forest) ==
+                  t8_test_partition_num_coarsened (forest_serial),
+                  "The partitioned forest cannot coarsen all families");
+}
+
+/* The data of an element that is sent with t8_forest_partition_data */
+typedef struct
+{
+  t8_gloidx_t         gelement; /* The global index of the element */
+  int                 level;    /* The level of the element */
+} t8_test_partition_data_t;
+
+/* Fill the data of each local element of a forest */
+static void
+t8_test_partition_fill_data (t8_forest_t forest, sc_array_t * data)
+{
+  t8_locidx_t         itree, ielement;
+  t8_tree_t           tree;
+  t8_eclass_scheme_t *ts;
+  t8_test_partition_data_t *entry;
+  t8_gloidx_t         first_element;
+
+  sc_array_resize (data, forest->local_num_elements);
+  first_element = t8_forest_get_first_local_element_id (forest);
+  for (itree = 0; itree < t8_forest_get_num_local_trees (forest); itree++) {
+    tree = t8_forest_get_tree (forest, itree);
+    ts = forest->scheme->eclass_schemes[tree->eclass];
+    for (ielement = 0; ielement < t8_forest_get_tree_element_count (tree);
+         ielement++) {
+      entry = (t8_test_partition_data_t *)
+        sc_array_index (data, tree->elements_offset + ielement);
+      entry->gelement = first_element + tree->elements_offset + ielement;
+      entry->level = t8_element_level (ts, t8_element_array_index
+                                       (ts, &tree->elements, ielement));
+    }
+  }
+}
+
+/* Send the data of the elements of forest_from to the processes that own
+ * them in forest_to and check that each element receives its own data */
+static void
+t8_test_partition_check_data (t8_forest_t forest_from, t8_forest_t forest_to)
+{
+  sc_array_t          data_in, data_out, data_expected;
+  t8_test_partition_data_t *entry, *expected;
+  size_t              ielement;
+
+  sc_array_init (&data_in, sizeof (t8_test_partition_data_t));
+  sc_array_init (&data_out, sizeof (t8_test_partition_data_t));
+  sc_array_init (&data_expected, sizeof (t8_test_partition_data_t));
+  t8_test_partition_fill_data (forest_from, &data_in);
+  t8_test_partition_fill_data (forest_to, &data_expected);
+  /* The output array is resized by the function */
+  sc_array_resize (&data_out, 3);
+
+  t8_forest_partition_data (forest_from, forest_to, &data_in, &data_out);
+  SC_CHECK_ABORT (data_out.elem_count == data_expected.elem_count,
+                  "Wrong number of partitioned data entries");
+  for (ielement = 0; ielement < data_out.elem_count; ielement++) {
+    entry = (t8_test_partition_data_t *) sc_array_index (&data_out, ielement);
+    expected = (t8_test_partition_data_t *)
+      sc_array_index (&data_expected, ielement);
+    SC_CHECK_ABORTF (entry->gelement == expected->gelement
+                     && entry->level == expected->level,
+                     "Element %lli received the data of element %lli\n",
+                     (long long) expected->gelement,
+                     (long long) entry->gelement);
+  }
+  sc_array_reset (&data_in);
+  sc_array_reset (&data_out);
+  sc_array_reset (&data_expected);
+}
+
+/* Check that each element of a partitioned forest equals the element
+ * with the same global index in a copy of the whole forest */
+static void
+t8_test_partition_check_elements (t8_forest_t forest,
+                                  t8_forest_t forest_serial)
+{
+  t8_tree_t           tree, tree_serial;
+  t8_eclass_scheme_t *ts;
+  t8_element_t       *element, *element_serial;
+  t8_locidx_t         itree, ielement, itree_serial;
+  t8_gloidx_t         gelement;
+
+  gelement = t8_forest_get_first_local_element_id (forest);
+  itree_serial = 0;
+  for (itree = 0; itree < t8_forest_get_num_local_trees (forest); itree++) {
+    tree = t8_forest_get_tree (forest, itree);
+    ts = forest->scheme->eclass_schemes[tree->eclass];
+    for (ielement = 0; ielement < t8_forest_get_tree_element_count (tree);
+         ielement++, gelement++) {
+      /* Find the tree of the element in the serial forest */
+      while (gelement >= t8_forest_get_tree (forest_serial, itree_serial)
+             ->elements_offset + t8_forest_get_tree_element_count
+             (t8_forest_get_tree (forest_serial, itree_serial))) {
+        itree_serial++;
+      }
+      tree_serial = t8_forest_get_tree (forest_serial, itree_serial);
+      SC_CHECK_ABORT (forest->first_local_tree + itree == itree_serial,
+                      "A partitioned element is in the wrong tree");
+      element = t8_element_array_index (ts, &tree->elements, ielement);
+      element_serial = t8_element_array_index (ts, &tree_serial->elements,
+                                               gelement -
+                                               tree_serial->elements_offset);
+      SC_CHECK_ABORTF (t8_element_level (ts, element) ==
+                       t8_element_level (ts, element_serial)
+                       && t8_element_compare (ts, element,
+                                              element_serial) == 0,
+                       "The partitioned element %lli differs\n",
+                       (long long) gelement);
+    }
+  }
+}
+
+static void
+t8_test_partition (t8_eclass_t eclass, int for_coarsening, int weighted)
+{
+  t8_forest_t         forest_adapt, forest_partition, forest_serial;
+
+  forest_adapt = t8_test_partition_new_adapted (eclass, sc_MPI_COMM_WORLD);
+  t8_test_partition_check_offsets (forest_adapt);
+
+  /* Keep forest_adapt to partition element data from it */
+  t8_forest_ref (forest_adapt);
+  t8_forest_init (&forest_partition);
+  t8_forest_set_partition (forest_partition, forest_adapt, for_coarsening,
+                           weighted ? t8_test_partition_weight : NULL);
+  t8_forest_commit (forest_partition);
+  t8_test_partition_check_offsets (forest_partition);
+  t8_test_partition_check_data (forest_adapt, forest_partition);
+  t8_forest_unref (&forest_adapt);
+  /* Each process creates the whole forest on its own */
+  forest_serial = t8_test_partition_new_adapted (eclass, sc_MPI_COMM_SELF);
+  t8_test_partition_check_elements (forest_partition, forest_serial);
+  if (weighted) {
+    t8_test_partition_check_weighted (forest_partition, forest_serial);
+  }
+  if (for_coarsening) {
+    t8_test_partition_check_families (forest_partition, forest_serial);
+  }
+  t8_forest_unref (&forest_serial);
+
+  t8_forest_unref (&forest_partition);
+  t8_global_productionf ("Partition check passed. %s %i %i\n",
+                         t8_eclass_to_string[eclass], for_coarsening,
+                         weighted);
+}
+
+/* Put the whole weight on the first element of the forest, such that all
+ * processes but the first and the last one are empty after partition */
+static double
+t8_test_partition_weight_first (t8_forest_t forest, t8_locidx_t which_tree,
+                                t8_eclass_scheme_t * ts,
+                                t8_element_t * element)
+{
+  t8_tree_t           tree;
+
+  tree = t8_forest_get_tree (forest, which_tree);
+  return t8_forest_get_first_local_element_id (forest) == 0
+    && which_tree == 0
+    && element == t8_element_array_index (ts, &tree->elements, 0);
+}
+
+/* Partition a forest such that some processes are empty and check its
+ * offsets before and after refining it. The partition takes the only
+ * reference to the old forest, such that new trees take over the element
+ * arrays of old trees. */
+static void
+t8_test_partition_empty (t8_eclass_t eclass)
+{
+  t8_forest_t         forest_partition, forest_refine, forest_serial;
+
+  t8_forest_init (&forest_partition);
+  t8_forest_set_partition (forest_partition,
+                           t8_test_partition_new_adapted (eclass,
+                                                          sc_MPI_COMM_WORLD),
+                           0, t8_test_partition_weight_first);
+  t8_forest_commit (forest_partition);
+  SC_CHECK_ABORT (forest_partition->local_num_elements ==
+                  (forest_partition->mpirank == 0) +
+                  (forest_partition->mpirank ==
+                   forest_partition->mpisize - 1 ?
+                   forest_partition->global_num_elements - 1 : 0),
+                  "The weighted partition has a wrong element count");
+  t8_test_partition_check_offsets (forest_partition);
+  forest_serial = t8_test_partition_new_adapted (eclass, sc_MPI_COMM_SELF);
+  t8_test_partition_check_elements (forest_partition, forest_serial);
+  t8_forest_unref (&forest_serial);
+
+  t8_forest_init (&forest_refine);
+  t8_forest_set_uniform_refine (forest_refine, forest_partition);
+  t8_forest_commit (forest_refine);
+  t8_test_partition_check_offsets (forest_refine);
+  t8_forest_unref (&forest_refine);
+  t8_global_productionf ("Empty partition check passed. %s\n",
+                         t8_eclass_to_string[eclass]);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  int                 ieclass;
+  int                 for_coarsening;
+  t8_eclass_t         eclasses[4] = { T8_ECLASS_QUAD, T8_ECLASS_TRIANGLE,
+    T8_ECLASS_HEX, T8_ECLASS_TET
+  };
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_ESSENTIAL);
+  p4est_init (NULL, SC_LP_ESSENTIAL);
+  t8_init (SC_LP_DEFAULT);
+
+  t8_global_productionf ("Testing forest partition.\n");
+  /* The default scheme implements these element classes */
+  for (ieclass = 0; ieclass < 4; ieclass++) {
+    for (for_coarsening = 0; for_coarsening < 2; for_coarsening++) {
+      t8_test_partition (eclasses[ieclass], for_coarsening, 0);
+    }
+    t8_test_partition (eclasses[ieclass], 0, 1);
+    t8_test_partition_empty (eclasses[ieclass]);
+  }
+  t8_global_productionf ("Done testing forest partition.\n");
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
@@ -0,0 +1,190 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element types in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+/* Save an adapted and partitioned forest and load it on all processes
+ * and on one process less. Each process of a loaded forest must have an
+ * equally sized range of the elements, and each element must equal the
+ * element with the same global index in a copy of the whole forest that
+ * each process creates on its own. */
+
+#include <t8_default.h>
+#include <t8_cmesh.h>
+#include <t8_forest.h>
+#include "t8_forest/t8_forest_types.h"
+#include "t8_test_forest_common.h"
+
+/* Create the adapted forest, such that the leaves of a tree have different
+ * levels. If do_partition is true, it is repartitioned. */
+static              t8_forest_t
+t8_test_save_new (t8_eclass_t eclass, sc_MPI_Comm comm, int do_partition)
+{
+  t8_forest_t         forest;
+
+  forest = t8_test_forest_new_adapted (t8_cmesh_new_hypercube (eclass, comm,
+                                                               0, 0), comm,
+                                       t8_eclass_to_dimension[eclass] ==
+                                       3 ? 4 : 6);
+  if (!do_partition) {
+    return forest;
+  }
+  return t8_test_forest_new_partitioned (forest, 0, NULL);
+}
+
+/* Load a forest on the processes of comm and compare it with the serial
+ * forest */
+static void
+t8_test_save_check_load (t8_eclass_t eclass, sc_MPI_Comm comm,
+                         const char *filename, t8_forest_t forest_serial)
+{
+  t8_forest_t         forest;
+  t8_tree_t           tree, tree_serial;
+  t8_eclass_scheme_t *ts;
+  t8_element_t       *element, *element_serial;
+  t8_locidx_t         itree, ielement, itree_serial;
+  t8_gloidx_t         gelement, num_per_proc;
+
+  t8_forest_init (&forest);
+  t8_forest_set_cmesh (forest, t8_cmesh_new_hypercube (eclass, comm, 0, 0),
+                       comm);
+  t8_forest_set_scheme (forest, t8_scheme_new_default ());
+  t8_forest_set_load (forest, filename);
+  t8_forest_commit (forest);
+
+  SC_CHECK_ABORT (forest->global_num_elements ==
+                  forest_serial->global_num_elements,
+                  "The loaded forest has a different number of elements");
+  /* The processes have equally sized ranges */
+  num_per_proc = forest->global_num_elements / forest->mpisize;
+  SC_CHECK_ABORTF (forest->local_num_elements == num_per_proc +
+                   (forest->mpirank <
+                    forest->global_num_elements % forest->mpisize),
+                   "Loaded %i elements on %i processes\n",
+                   forest->local_num_elements, forest->mpisize);
+
+  gelement = t8_forest_get_first_local_element_id (forest);
+  itree_serial = 0;
+  for (itree = 0; itree < t8_forest_get_num_local_trees (forest); itree++) {
+    tree = t8_forest_get_tree (forest, itree);
+    ts = forest->scheme->eclass_schemes[tree->eclass];
+    for (ielement = 0; ielement < t8_forest_get_tree_element_count (tree);
+         ielement++, gelement++) {
+      /* Find the element with the same global index in the serial forest */
+      while (gelement >= t8_forest_get_tree (forest_serial, itree_serial)
+             ->elements_offset + t8_forest_get_tree_element_count
+             (t8_forest_get_tree (forest_serial, itree_serial))) {
+        itree_serial++;
+      }
+      tree_serial = t8_forest_get_tree (forest_serial, itree_serial);
+      SC_CHECK_ABORT (forest->first_local_tree + itree == itree_serial,
+                      "A loaded element is in the wrong tree");
+      element = t8_element_array_index (ts, &tree->elements, ielement);
+      element_serial = t8_element_array_index (ts, &tree_serial->elements,
+                                               gelement -
+                                               tree_serial->elements_offset);
+      SC_CHECK_ABORTF (t8_element_level (ts, element) ==
+                       t8_element_level (ts, element_serial)
+                       && t8_element_compare (ts, element,
+                                              element_serial) == 0,
+                       "The loaded element %lli differs\n",
+                       (long long) gelement);
+    }
+  }
+  SC_CHECK_ABORT (gelement == t8_forest_get_first_local_element_id (forest)
+                  + forest->local_num_elements, "Wrong number of elements");
+  t8_forest_unref (&forest);
+}
+
+static void
+t8_test_save (t8_eclass_t eclass)
+{
+  t8_forest_t         forest, forest_serial;
+  sc_MPI_Comm         comm_less;
+  char                filename[BUFSIZ];
+  int                 mpirank, mpisize, mpiret;
+
+  mpiret = sc_MPI_Comm_rank (sc_MPI_COMM_WORLD, &mpirank);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_size (sc_MPI_COMM_WORLD, &mpisize);
+  SC_CHECK_MPI (mpiret);
+  snprintf (filename, BUFSIZ, "t8_test_forest_save_%s.t8f",
+            t8_eclass_to_string[eclass]);
+
+  forest = t8_test_save_new (eclass, sc_MPI_COMM_WORLD, 1);
+  SC_CHECK_ABORT (t8_forest_save (forest, filename),
+                  "Could not save the forest");
+  t8_forest_unref (&forest);
+  /* Each process creates the whole forest on its own */
+  forest_serial = t8_test_save_new (eclass, sc_MPI_COMM_SELF, 0);
+
+  t8_test_save_check_load (eclass, sc_MPI_COMM_WORLD, filename,
+                           forest_serial);
+  /* Load the forest on one process less */
+  mpiret = sc_MPI_Comm_split (sc_MPI_COMM_WORLD,
+                              mpisize > 1 && mpirank == mpisize - 1 ?
+                              sc_MPI_UNDEFINED : 0, mpirank, &comm_less);
+  SC_CHECK_MPI (mpiret);
+  if (comm_less != sc_MPI_COMM_NULL) {
+    t8_test_save_check_load (eclass, comm_less, filename, forest_serial);
+    mpiret = sc_MPI_Comm_free (&comm_less);
+    SC_CHECK_MPI (mpiret);
+  }
+
+  t8_forest_unref (&forest_serial);
+  mpiret = sc_MPI_Barrier (sc_MPI_COMM_WORLD);
+  SC_CHECK_MPI (mpiret);
+  if (mpirank == 0) {
+    remove (filename);
+  }
+  t8_global_productionf ("Save and load check passed. %s\n",
+                         t8_eclass_to_string[eclass]);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  int                 ieclass;
+  t8_eclass_t         eclasses[4] = { T8_ECLASS_QUAD, T8_ECLASS_TRIANGLE,
+    T8_ECLASS_HEX, T8_ECLASS_TET
+  };
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_ESSENTIAL);
+  p4est_init (NULL, SC_LP_ESSENTIAL);
+  t8_init (SC_LP_DEFAULT);
+
+  t8_global_productionf ("Testing forest save and load.\n");
+  /* The default scheme implements these element classes */
+  for (ieclass = 0; ieclass < 4; ieclass++) {
+    t8_test_save (eclasses[ieclass]);
+  }
+  t8_global_productionf ("Done testing forest save and load.\n");
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
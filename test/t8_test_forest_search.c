@@ -0,0 +1,346 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element types in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+/* Search random elements of the maximum level in an adapted and
+ * partitioned forest. Each query must be found at the leaf that contains
+ * it, which we find by a binary search in the leaves of its tree, and
+ * exactly one process must find it. The number of queries exceeds one
+ * batch of the search. We also check the sorting of the queries, that
+ * the search only passes queries on to the children of matching elements
+ * and that skipping elements skips their queries. */
+
+#include <t8_default.h>
+#include <t8_cmesh.h>
+#include <t8_forest.h>
+#include "t8_forest/t8_forest_types.h"
+#include "t8_test_forest_common.h"
+
+/* The number of queries, more than fit into one batch */
+#define T8_TEST_SEARCH_NUM_QUERIES 70000
+
+/* A query is an element of the maximum level of a tree */
+typedef struct
+{
+  t8_gloidx_t         gtreeid;  /* The global id of the tree */
+  uint64_t            id;       /* The linear id of the element */
+  size_t              index;    /* The index before sorting */
+  t8_locidx_t         found;    /* The local index of the leaf, -1 if not found */
+} t8_test_search_query_t;
+
+/* The state of a search that the callbacks check and update */
+typedef struct
+{
+  int                *skipped;  /* For each leaf true if it was skipped */
+  int                 do_skip;  /* Skip some inner elements */
+  size_t              num_calls;        /* The number of query callback calls */
+} t8_test_search_t;
+
+/* Create an adapted and partitioned forest with the given user data, such
+ * that the leaves of a tree have different levels */
+static              t8_forest_t
+t8_test_search_new (t8_eclass_t eclass, void *user_data)
+{
+  t8_forest_t         forest;
+
+  forest = t8_test_forest_new_adapted (t8_cmesh_new_hypercube (eclass,
+                                                               sc_MPI_COMM_WORLD,
+                                                               0, 0),
+                                       sc_MPI_COMM_WORLD,
+                                       t8_eclass_to_dimension[eclass] ==
+                                       3 ? 4 : 6);
+  return t8_test_forest_new_partitioned (forest, 0, user_data);
+}
+
+/* Return true if the query lies inside of element */
+static int
+t8_test_search_contains (t8_eclass_scheme_t * ts,
+                         const t8_element_t * element,
+                         const t8_test_search_query_t * query)
+{
+  uint64_t            first, num_desc;
+  int                 maxlevel;
+
+  maxlevel = t8_element_maxlevel (ts);
+  first = t8_element_get_linear_id (ts, element, maxlevel);
+  num_desc = (uint64_t) 1 << (t8_eclass_to_dimension[ts->eclass] *
+                              (maxlevel - t8_element_level (ts, element)));
+  return first <= query->id && query->id - first < num_desc;
+}
+
+/* Skip every other inner element of level 3 and mark its leaves */
+static int
+t8_test_search_fn (t8_forest_t forest, t8_locidx_t ltreeid,
+                   const t8_element_t * element, int is_leaf,
+                   sc_array_t * leaf_elements, t8_locidx_t tree_leaf_index)
+{
+  t8_test_search_t   *state;
+  t8_tree_t           tree;
+  t8_eclass_scheme_t *ts;
+  size_t              ileaf;
+
+  state = (t8_test_search_t *) t8_forest_get_user_data (forest);
+  tree = t8_forest_get_tree (forest, ltreeid);
+  ts = forest->scheme->eclass_schemes[tree->eclass];
+  if (!state->do_skip || is_leaf || t8_element_level (ts, element) != 3
+      || t8_element_child_id (ts, element) % 2 != 0) {
+    return 1;
+  }
+  for (ileaf = 0; ileaf < leaf_elements->elem_count; ileaf++) {
+    state->skipped[tree->elements_offset + tree_leaf_index + ileaf] = 1;
+  }
+  return 0;
+}
+
+static int
+t8_test_search_query_fn (t8_forest_t forest, t8_locidx_t ltreeid,
+                         const t8_element_t * element, int is_leaf,
+                         sc_array_t * leaf_elements,
+                         t8_locidx_t tree_leaf_index, void *query,
+                         size_t query_index)
+{
+  t8_test_search_t   *state;
+  t8_test_search_query_t *q = (t8_test_search_query_t *) query;
+  t8_tree_t           tree;
+  t8_eclass_scheme_t *ts;
+
+  state = (t8_test_search_t *) t8_forest_get_user_data (forest);
+  state->num_calls++;
+  tree = t8_forest_get_tree (forest, ltreeid);
+  ts = forest->scheme->eclass_schemes[tree->eclass];
+  if (q->gtreeid != forest->first_local_tree + ltreeid
+      || !t8_test_search_contains (ts, element, q)) {
+    return 0;
+  }
+  if (is_leaf) {
+    SC_CHECK_ABORTF (q->found < 0, "Query %i was found twice\n",
+                     (int) q->index);
+    q->found = tree->elements_offset + tree_leaf_index;
+  }
+  return 1;
+}
+
+/* The sort key of a query */
+static              uint64_t
+t8_test_search_key (t8_forest_t forest, const void *query)
+{
+  return ((const t8_test_search_query_t *) query)->id;
+}
+
+/* Return the local index of the leaf that contains the query or -1 */
+static              t8_locidx_t
+t8_test_search_find_leaf (t8_forest_t forest,
+                          const t8_test_search_query_t * query)
+{
+  t8_tree_t           tree;
+  t8_eclass_scheme_t *ts;
+  t8_element_t       *leaf;
+  size_t              low, high, mid;
+  int                 maxlevel;
+
+  if (query->gtreeid < forest->first_local_tree
+      || query->gtreeid > forest->last_local_tree) {
+    return -1;
+  }
+  tree = t8_forest_get_tree (forest, (t8_locidx_t)
+                             (query->gtreeid - forest->first_local_tree));
+  ts = forest->scheme->eclass_schemes[tree->eclass];
+  maxlevel = t8_element_maxlevel (ts);
+  /* Find the last leaf whose first descendant is not after the query */
+  low = 0;
+  high = tree->elements.elem_count;
+  while (low < high) {
+    mid = low + (high - low) / 2;
+    leaf = t8_element_array_index (ts, &tree->elements, mid);
+    if (t8_element_get_linear_id (ts, leaf, maxlevel) <= query->id) {
+      low = mid + 1;
+    }
+    else {
+      high = mid;
+    }
+  }
+  if (low == 0
+      || !t8_test_search_contains (ts, t8_element_array_index
+                                   (ts, &tree->elements, low - 1), query)) {
+    return -1;
+  }
+  return tree->elements_offset + (t8_locidx_t) low - 1;
+}
+
+/* Create random queries in all trees of the forest */
+static void
+t8_test_search_queries (t8_forest_t forest, t8_eclass_scheme_t * ts,
+                        sc_array_t * queries)
+{
+  t8_test_search_query_t *query;
+  uint64_t            random, num_ids;
+  size_t              iquery;
+
+  num_ids = (uint64_t) 1 << (t8_eclass_to_dimension[ts->eclass] *
+                             t8_element_maxlevel (ts));
+  /* A linear congruential generator gives reproducible queries */
+  random = 1;
+  sc_array_init_size (queries, sizeof (t8_test_search_query_t),
+                      T8_TEST_SEARCH_NUM_QUERIES);
+  for (iquery = 0; iquery < T8_TEST_SEARCH_NUM_QUERIES; iquery++) {
+    query = (t8_test_search_query_t *) sc_array_index (queries, iquery);
+    random = random * 6364136223846793005ULL + 1442695040888963407ULL;
+    query->gtreeid = (t8_gloidx_t) ((random >> 33) % forest->global_num_trees);
+    random = random * 6364136223846793005ULL + 1442695040888963407ULL;
+    query->id = (random >> 1) & (num_ids - 1);
+    query->index = iquery;
+  }
+}
+
+/* Check that the queries are sorted by their key and are a permutation
+ * of the unsorted queries */
+static void
+t8_test_search_check_sorted (sc_array_t * queries)
+{
+  t8_test_search_query_t *query, *prev;
+  char               *seen;
+  size_t              iquery;
+
+  seen = T8_ALLOC_ZERO (char, queries->elem_count);
+  for (iquery = 0; iquery < queries->elem_count; iquery++) {
+    query = (t8_test_search_query_t *) sc_array_index (queries, iquery);
+    SC_CHECK_ABORT (query->index < queries->elem_count && !seen[query->index],
+                    "The sorted queries are no permutation");
+    seen[query->index] = 1;
+    if (iquery > 0) {
+      prev = (t8_test_search_query_t *) sc_array_index (queries, iquery - 1);
+      SC_CHECK_ABORT (prev->id < query->id || (prev->id == query->id
+                                               && prev->index < query->index),
+                      "The queries are not sorted");
+    }
+  }
+  T8_FREE (seen);
+}
+
+/* Search the queries once without and once with skipping elements */
+static void
+t8_test_search (t8_eclass_t eclass)
+{
+  t8_forest_t         forest;
+  t8_test_search_t    state;
+  t8_test_search_query_t *query;
+  t8_eclass_scheme_t *ts;
+  sc_array_t          queries;
+  t8_locidx_t         ileaf;
+  size_t              iquery, max_calls;
+  int                *found, *global_found;
+  int                 mpiret;
+
+  forest = t8_test_search_new (eclass, &state);
+  ts = forest->scheme->eclass_schemes[eclass];
+  t8_test_search_queries (forest, ts, &queries);
+  t8_forest_search_sort_queries (forest, &queries, t8_test_search_key);
+  t8_test_search_check_sorted (&queries);
+  found = T8_ALLOC (int, queries.elem_count);
+  global_found = T8_ALLOC (int, queries.elem_count);
+  state.skipped = T8_ALLOC (int, SC_MAX (forest->local_num_elements, 1));
+
+  for (state.do_skip = 0; state.do_skip <= 1; state.do_skip++) {
+    for (iquery = 0; iquery < queries.elem_count; iquery++) {
+      ((t8_test_search_query_t *) sc_array_index (&queries, iquery))->found =
+        -1;
+    }
+    for (ileaf = 0; ileaf < forest->local_num_elements; ileaf++) {
+      state.skipped[ileaf] = 0;
+    }
+    state.num_calls = 0;
+    t8_forest_search (forest, state.do_skip ? t8_test_search_fn : NULL,
+                      t8_test_search_query_fn, &queries);
+
+    for (iquery = 0; iquery < queries.elem_count; iquery++) {
+      query = (t8_test_search_query_t *) sc_array_index (&queries, iquery);
+      ileaf = t8_test_search_find_leaf (forest, query);
+      if (ileaf >= 0 && state.skipped[ileaf]) {
+        ileaf = -1;
+      }
+      SC_CHECK_ABORTF (query->found == ileaf,
+                       "Query %i was found at leaf %i, expected %i\n",
+                       (int) query->index, query->found, ileaf);
+      found[query->index] = query->found >= 0;
+    }
+    /* A query is only passed to the children of the elements that it
+     * matches, that is, to at most the children of one element per level
+     * and to the root of each tree. */
+    max_calls = queries.elem_count *
+      (t8_forest_get_num_local_trees (forest) +
+       t8_eclass_num_children[eclass] * (t8_element_maxlevel (ts) + 1));
+    SC_CHECK_ABORTF (state.num_calls <= max_calls,
+                     "The search called the query callback %llu times\n",
+                     (unsigned long long) state.num_calls);
+
+    if (!state.do_skip) {
+      /* Each query is found on exactly one process */
+      mpiret = sc_MPI_Allreduce (found, global_found,
+                                 (int) queries.elem_count, sc_MPI_INT,
+                                 sc_MPI_SUM, forest->mpicomm);
+      SC_CHECK_MPI (mpiret);
+      for (iquery = 0; iquery < queries.elem_count; iquery++) {
+        SC_CHECK_ABORTF (global_found[iquery] == 1,
+                         "Query %i was found on %i processes\n",
+                         (int) iquery, global_found[iquery]);
+      }
+    }
+  }
+
+  T8_FREE (state.skipped);
+  T8_FREE (found);
+  T8_FREE (global_found);
+  sc_array_reset (&queries);
+  t8_forest_unref (&forest);
+  t8_global_productionf ("Search check passed. %s\n",
+                         t8_eclass_to_string[eclass]);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  int                 ieclass;
+  t8_eclass_t         eclasses[4] = { T8_ECLASS_QUAD, T8_ECLASS_TRIANGLE,
+    T8_ECLASS_HEX, T8_ECLASS_TET
+  };
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_ESSENTIAL);
+  p4est_init (NULL, SC_LP_ESSENTIAL);
+  t8_init (SC_LP_DEFAULT);
+
+  t8_global_productionf ("Testing forest search.\n");
+  /* The default scheme implements these element classes */
+  for (ieclass = 0; ieclass < 4; ieclass++) {
+    t8_test_search (eclasses[ieclass]);
+  }
+  t8_global_productionf ("Done testing forest search.\n");
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
@@ -0,0 +1,423 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element types in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+/* Write an adapted and partitioned forest of the unit hypercube to vtu
+ * files, read the uncompressed binary data of each process back and
+ * check it. The cells must have the right types, lie in the unit cube,
+ * have their vertices in the vtk order and cover the cube exactly, which
+ * we check by summing their volumes. In the vtk order, all cells except
+ * for triangles have a positive volume. The level, tree and process of each
+ * cell must match the forest. */
+
+#include <t8_default.h>
+#include <t8_cmesh.h>
+#include <t8_cmesh_vtk.h>
+#include <t8_forest.h>
+#include "t8_forest/t8_forest_types.h"
+#include "t8_test_forest_common.h"
+
+/* Create an adapted and partitioned forest of the unit hypercube */
+static              t8_forest_t
+t8_test_vtk_new (t8_eclass_t eclass)
+{
+  t8_forest_t         forest;
+
+  forest = t8_test_forest_new_adapted (t8_cmesh_new_hypercube (eclass,
+                                                               sc_MPI_COMM_WORLD,
+                                                               0, 0),
+                                       sc_MPI_COMM_WORLD,
+                                       t8_eclass_to_dimension[eclass] ==
+                                       3 ? 3 : 4);
+  return t8_test_forest_new_partitioned (forest, 0, NULL);
+}
+
+/* Read a whole file into a null terminated string */
+static char        *
+t8_test_vtk_read_file (const char *filename)
+{
+  FILE               *file;
+  char               *content;
+  long                size;
+
+  file = fopen (filename, "rb");
+  SC_CHECK_ABORTF (file != NULL, "Could not open %s\n", filename);
+  fseek (file, 0, SEEK_END);
+  size = ftell (file);
+  fseek (file, 0, SEEK_SET);
+  content = T8_ALLOC (char, size + 1);
+  SC_CHECK_ABORT (fread (content, 1, size, file) == (size_t) size,
+                  "Could not read the file");
+  content[size] = '\0';
+  fclose (file);
+  return content;
+}
+
+/* Return the value of a base64 character or -1 */
+static int
+t8_test_vtk_base64_value (char c)
+{
+  if ('A' <= c && c <= 'Z') {
+    return c - 'A';
+  }
+  if ('a' <= c && c <= 'z') {
+    return c - 'a' + 26;
+  }
+  if ('0' <= c && c <= '9') {
+    return c - '0' + 52;
+  }
+  return c == '+' ? 62 : c == '/' ? 63 : -1;
+}
+
+/* Decode the base64 data that starts at in and ends at the next '<'.
+ * The data may consist of several padded blocks. Return the number of
+ * decoded bytes. */
+static size_t
+t8_test_vtk_decode (const char *in, char *out)
+{
+  int                 values[4], num_values, num_bytes;
+  size_t              length = 0;
+
+  num_values = num_bytes = 0;
+  for (; *in != '<' && *in != '\0'; in++) {
+    if (*in == ' ' || *in == '\n' || *in == '\r') {
+      continue;
+    }
+    values[num_values] = t8_test_vtk_base64_value (*in);
+    SC_CHECK_ABORT (values[num_values] >= 0 || *in == '=',
+                    "Invalid base64 character");
+    num_bytes += values[num_values] >= 0;
+    if (++num_values < 4) {
+      continue;
+    }
+    /* Four characters encode up to three bytes */
+    out[length] = (char) (values[0] << 2 | values[1] >> 4);
+    if (num_bytes > 2) {
+      out[length + 1] = (char) ((values[1] & 15) << 4 | values[2] >> 2);
+    }
+    if (num_bytes > 3) {
+      out[length + 2] = (char) ((values[2] & 3) << 6 | values[3]);
+    }
+    length += num_bytes - 1;
+    num_values = num_bytes = 0;
+  }
+  SC_CHECK_ABORT (num_values == 0, "Truncated base64 data");
+  return length;
+}
+
+/* Decode the data array with the given name of a vtu file. The binary
+ * data starts with its length as 32 bit integer. Return the data, which
+ * must have byte_length bytes. */
+static void        *
+t8_test_vtk_get_array (const char *content, const char *name,
+                       size_t byte_length)
+{
+  char                pattern[BUFSIZ];
+  const char         *start;
+  char               *decoded;
+  size_t              length;
+  uint32_t            header;
+
+  snprintf (pattern, BUFSIZ, "Name=\"%s\"", name);
+  start = strstr (content, pattern);
+  SC_CHECK_ABORTF (start != NULL, "Missing the data array %s\n", name);
+  start = strchr (start, '>');
+  SC_CHECK_ABORT (start != NULL, "Wrong data array");
+  decoded = T8_ALLOC (char, strlen (start) + 1);
+  length = t8_test_vtk_decode (start + 1, decoded);
+  memcpy (&header, decoded, sizeof (uint32_t));
+  SC_CHECK_ABORTF (header == byte_length
+                   && length == sizeof (uint32_t) + byte_length,
+                   "The data array %s has %llu bytes, expected %llu\n", name,
+                   (unsigned long long) header,
+                   (unsigned long long) byte_length);
+  memmove (decoded, decoded + sizeof (uint32_t), byte_length);
+  return decoded;
+}
+
+/* Return the signed volume of a cell in the vtk vertex order. For
+ * quadrilaterals and hexahedra, which are axis parallel, we compute the
+ * area of the bottom face from its vertices in counterclockwise order. */
+static double
+t8_test_vtk_volume (t8_eclass_t eclass, const T8_VTK_FLOAT_TYPE * p)
+{
+  double              a[3], b[3], c[3], area;
+  int                 i;
+
+  for (i = 0; i < 3; i++) {
+    a[i] = p[3 + i] - p[i];
+    b[i] = p[6 + i] - p[i];
+    c[i] = eclass == T8_ECLASS_TET ? p[9 + i] - p[i] : 0;
+  }
+  switch (eclass) {
+  case T8_ECLASS_TRIANGLE:
+    return (a[0] * b[1] - a[1] * b[0]) / 2;
+  case T8_ECLASS_TET:
+    return (c[0] * (a[1] * b[2] - a[2] * b[1])
+            + c[1] * (a[2] * b[0] - a[0] * b[2])
+            + c[2] * (a[0] * b[1] - a[1] * b[0])) / 6;
+  case T8_ECLASS_QUAD:
+  case T8_ECLASS_HEX:
+    /* The shoelace formula */
+    area = 0;
+    for (i = 0; i < 4; i++) {
+      area += p[3 * i] * p[3 * ((i + 1) % 4) + 1]
+        - p[3 * ((i + 1) % 4)] * p[3 * i + 1];
+    }
+    area /= 2;
+    if (eclass == T8_ECLASS_QUAD) {
+      return area;
+    }
+    /* The top face lies above the bottom face in the same order */
+    for (i = 0; i < 4; i++) {
+      SC_CHECK_ABORT (p[3 * (i + 4)] == p[3 * i]
+                      && p[3 * (i + 4) + 1] == p[3 * i + 1]
+                      && p[3 * (i + 4) + 2] - p[3 * i + 2] ==
+                      p[14] - p[2], "Wrong hexahedron vertex order");
+    }
+    return area * (p[14] - p[2]);
+  default:
+    SC_ABORT_NOT_REACHED ();
+  }
+  return 0;
+}
+
+/* Check the vtu file of this process */
+/* Write the name of the vtu file of a process to filename, which has
+ * BUFSIZ bytes, or the name of the pvtu file if rank is negative */
+static void
+t8_test_vtk_filename (char *filename, const char *fileprefix, int rank)
+{
+  int                 retval;
+
+  if (rank >= 0) {
+    retval = snprintf (filename, BUFSIZ, "%s_%04d.vtu", fileprefix, rank);
+  }
+  else {
+    retval = snprintf (filename, BUFSIZ, "%s.pvtu", fileprefix);
+  }
+  SC_CHECK_ABORT (0 <= retval && retval < BUFSIZ, "The file name is too long");
+}
+
+static void
+t8_test_vtk_check_vtu (t8_forest_t forest, t8_eclass_t eclass,
+                       const char *fileprefix)
+{
+  char                filename[BUFSIZ], *content;
+  const char         *piece;
+  T8_VTK_FLOAT_TYPE  *points;
+  int32_t            *int_data;
+  uint8_t            *types;
+  long long           num_points, num_cells;
+  t8_locidx_t         itree, ielement, icell;
+  t8_tree_t           tree;
+  t8_eclass_scheme_t *ts;
+  double              volume, cell_volume, global_volume;
+  int                 num_vertices, ipoint, mpiret;
+
+  t8_test_vtk_filename (filename, fileprefix, forest->mpirank);
+  content = t8_test_vtk_read_file (filename);
+  piece = strstr (content, "<Piece");
+  SC_CHECK_ABORT (piece != NULL && sscanf (piece, "<Piece NumberOfPoints=\""
+                                           "%lld\" NumberOfCells=\"%lld\"",
+                                           &num_points, &num_cells) == 2,
+                  "Missing the piece");
+  num_vertices = t8_eclass_num_vertices[eclass];
+  SC_CHECK_ABORT (num_cells == forest->local_num_elements
+                  && num_points == num_cells * num_vertices,
+                  "Wrong number of cells or points");
+
+  /* The vertices of the cells lie in the unit cube and in vtk order */
+  points = (T8_VTK_FLOAT_TYPE *)
+    t8_test_vtk_get_array (content, "Position", 3 * num_points *
+                           sizeof (T8_VTK_FLOAT_TYPE));
+  for (ipoint = 0; ipoint < 3 * num_points; ipoint++) {
+    SC_CHECK_ABORT (0 <= points[ipoint] && points[ipoint] <= 1,
+                    "A point lies outside the unit cube");
+  }
+  volume = 0;
+  for (icell = 0; icell < num_cells; icell++) {
+    cell_volume = t8_test_vtk_volume (eclass, points + 3 * num_vertices *
+                                      icell);
+    /* Only the vtk triangles may be oriented clockwise */
+    if (eclass == T8_ECLASS_TRIANGLE) {
+      cell_volume = fabs (cell_volume);
+    }
+    SC_CHECK_ABORT (cell_volume > 0, "A cell is inverted");
+    volume += cell_volume;
+  }
+  mpiret = sc_MPI_Allreduce (&volume, &global_volume, 1, sc_MPI_DOUBLE,
+                             sc_MPI_SUM, forest->mpicomm);
+  SC_CHECK_MPI (mpiret);
+  SC_CHECK_ABORTF (fabs (global_volume - 1) < 1e-5,
+                   "The cells have the volume %f\n", global_volume);
+  T8_FREE (points);
+
+  /* Each cell has its own vertices */
+  int_data = (int32_t *) t8_test_vtk_get_array (content, "connectivity",
+                                                num_points *
+                                                sizeof (int32_t));
+  for (ipoint = 0; ipoint < num_points; ipoint++) {
+    SC_CHECK_ABORT (int_data[ipoint] == ipoint, "Wrong connectivity");
+  }
+  T8_FREE (int_data);
+  int_data = (int32_t *) t8_test_vtk_get_array (content, "offsets",
+                                                num_cells * sizeof (int32_t));
+  types = (uint8_t *) t8_test_vtk_get_array (content, "types", num_cells);
+  for (icell = 0; icell < num_cells; icell++) {
+    SC_CHECK_ABORT (int_data[icell] == (icell + 1) * num_vertices
+                    && types[icell] == t8_eclass_vtk_type[eclass],
+                    "Wrong offset or type");
+  }
+  T8_FREE (int_data);
+  T8_FREE (types);
+
+  /* The cell data */
+  int_data = (int32_t *) t8_test_vtk_get_array (content, "level",
+                                                num_cells * sizeof (int32_t));
+  for (itree = 0, icell = 0; itree < t8_forest_get_num_local_trees (forest);
+       itree++) {
+    tree = t8_forest_get_tree (forest, itree);
+    ts = forest->scheme->eclass_schemes[tree->eclass];
+    for (ielement = 0; ielement < t8_forest_get_tree_element_count (tree);
+         ielement++, icell++) {
+      SC_CHECK_ABORT (int_data[icell] ==
+                      t8_element_level (ts, t8_element_array_index
+                                        (ts, &tree->elements, ielement)),
+                      "Wrong level");
+    }
+  }
+  T8_FREE (int_data);
+  int_data = (int32_t *) t8_test_vtk_get_array (content, "treeid",
+                                                num_cells * sizeof (int32_t));
+  for (itree = 0, icell = 0; itree < t8_forest_get_num_local_trees (forest);
+       itree++) {
+    tree = t8_forest_get_tree (forest, itree);
+    for (ielement = 0; ielement < t8_forest_get_tree_element_count (tree);
+         ielement++, icell++) {
+      SC_CHECK_ABORT (int_data[icell] == forest->first_local_tree + itree,
+                      "Wrong tree id");
+    }
+  }
+  T8_FREE (int_data);
+  int_data = (int32_t *) t8_test_vtk_get_array (content, "mpirank",
+                                                num_cells * sizeof (int32_t));
+  for (icell = 0; icell < num_cells; icell++) {
+    SC_CHECK_ABORT (int_data[icell] == forest->mpirank, "Wrong rank");
+  }
+  T8_FREE (int_data);
+  T8_FREE (content);
+}
+
+/* Check that the pvtu file links to the files of all processes */
+static void
+t8_test_vtk_check_pvtu (t8_forest_t forest, const char *fileprefix)
+{
+  char                filename[BUFSIZ], *content;
+  const char         *piece;
+  int                 num_pieces, retval;
+
+  t8_test_vtk_filename (filename, fileprefix, -1);
+  content = t8_test_vtk_read_file (filename);
+  num_pieces = 0;
+  for (piece = strstr (content, "<Piece Source="); piece != NULL;
+       piece = strstr (piece + 1, "<Piece Source=")) {
+    retval = snprintf (filename, BUFSIZ, "<Piece Source=\"%s_%04d.vtu\"/>",
+                       fileprefix, num_pieces);
+    SC_CHECK_ABORT (0 <= retval && retval < BUFSIZ,
+                    "The file name is too long");
+    SC_CHECK_ABORT (!strncmp (piece, filename, strlen (filename)),
+                    "Wrong piece file");
+    num_pieces++;
+  }
+  SC_CHECK_ABORT (num_pieces == forest->mpisize, "Wrong number of pieces");
+  SC_CHECK_ABORT (strstr (content, "Name=\"level\"") != NULL
+                  && strstr (content, "Name=\"treeid\"") != NULL
+                  && strstr (content, "Name=\"mpirank\"") != NULL,
+                  "Missing the cell data");
+  T8_FREE (content);
+}
+
+static void
+t8_test_vtk (t8_eclass_t eclass)
+{
+  t8_forest_t         forest;
+  char                fileprefix[BUFSIZ], filename[BUFSIZ];
+  int                 mpiret;
+
+  forest = t8_test_vtk_new (eclass);
+  snprintf (fileprefix, BUFSIZ, "t8_test_forest_vtk_%s",
+            t8_eclass_to_string[eclass]);
+  SC_CHECK_ABORT (t8_forest_write_vtk_ext (forest, fileprefix, 1, 1, 1, 0)
+                  == 0, "Could not write the vtu files");
+  mpiret = sc_MPI_Barrier (forest->mpicomm);
+  SC_CHECK_MPI (mpiret);
+  t8_test_vtk_check_vtu (forest, eclass, fileprefix);
+  if (forest->mpirank == 0) {
+    t8_test_vtk_check_pvtu (forest, fileprefix);
+  }
+  /* The compressed output is written without errors */
+  SC_CHECK_ABORT (t8_forest_write_vtk_ext (forest, fileprefix, 1, 1, 1, 1)
+                  == 0, "Could not write the compressed vtu files");
+  mpiret = sc_MPI_Barrier (forest->mpicomm);
+  SC_CHECK_MPI (mpiret);
+
+  t8_test_vtk_filename (filename, fileprefix, forest->mpirank);
+  remove (filename);
+  if (forest->mpirank == 0) {
+    t8_test_vtk_filename (filename, fileprefix, -1);
+    remove (filename);
+  }
+  t8_forest_unref (&forest);
+  t8_global_productionf ("Vtk check passed. %s\n",
+                         t8_eclass_to_string[eclass]);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  int                 ieclass;
+  t8_eclass_t         eclasses[4] = { T8_ECLASS_QUAD, T8_ECLASS_TRIANGLE,
+    T8_ECLASS_HEX, T8_ECLASS_TET
+  };
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_ESSENTIAL);
+  p4est_init (NULL, SC_LP_ESSENTIAL);
+  t8_init (SC_LP_DEFAULT);
+
+  t8_global_productionf ("Testing forest vtk output.\n");
+  /* The default scheme implements these element classes */
+  for (ieclass = 0; ieclass < 4; ieclass++) {
+    t8_test_vtk (eclasses[ieclass]);
+  }
+  t8_global_productionf ("Done testing forest vtk output.\n");
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
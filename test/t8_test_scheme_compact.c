@@ -0,0 +1,237 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element types in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+/* Check the compact scheme against the default scheme. For elements of
+ * all levels that the compact scheme supports, we set the same linear id
+ * in both schemes and check that the linear ids, parents, children,
+ * nearest common ancestors and comparisons agree. */
+
+#include <t8_default.h>
+
+/* The number of elements per level that we check */
+#define T8_TEST_COMPACT_NUM_IDS 64
+
+/* Check that two elements of the compact and default scheme have the
+ * same level and linear id */
+static void
+t8_test_compact_check_equal (t8_eclass_scheme_t * ts_compact,
+                             const t8_element_t * elem_compact,
+                             t8_eclass_scheme_t * ts_default,
+                             const t8_element_t * elem_default,
+                             const char *what)
+{
+  int                 level;
+
+  level = t8_element_level (ts_default, elem_default);
+  SC_CHECK_ABORTF (t8_element_level (ts_compact, elem_compact) == level,
+                   "The %s has level %i, expected %i\n", what,
+                   t8_element_level (ts_compact, elem_compact), level);
+  SC_CHECK_ABORTF (t8_element_get_linear_id (ts_compact, elem_compact, level)
+                   == t8_element_get_linear_id (ts_default, elem_default,
+                                                level),
+                   "The %s has a different linear id\n", what);
+}
+
+/* Compute the nearest common ancestor of two elements of the default
+ * scheme from their parents. The default simplices compute the ancestor
+ * at the level of the smallest common cube, which may have a different
+ * type than the common ancestor, thus we cannot use their nca. */
+static void
+t8_test_compact_nca (t8_eclass_scheme_t * ts, const t8_element_t * elem1,
+                     const t8_element_t * elem2, t8_element_t * nca,
+                     t8_element_t * other)
+{
+  t8_element_copy (ts, elem1, nca);
+  t8_element_copy (ts, elem2, other);
+  while (t8_element_level (ts, nca) > t8_element_level (ts, other)) {
+    t8_element_parent (ts, nca, nca);
+  }
+  while (t8_element_level (ts, other) > t8_element_level (ts, nca)) {
+    t8_element_parent (ts, other, other);
+  }
+  /* Two elements of the same level are equal if they compare equal */
+  while (t8_element_compare (ts, nca, other) != 0) {
+    t8_element_parent (ts, nca, nca);
+    t8_element_parent (ts, other, other);
+  }
+}
+
+/* Set the element with a given level and linear id in both schemes and
+ * check its linear id, its parent and its children. The other elements
+ * are used to check the nearest common ancestor and comparison. */
+static void
+t8_test_compact_element (t8_eclass_scheme_t * ts_compact,
+                         t8_eclass_scheme_t * ts_default, int level,
+                         uint64_t id, t8_element_t ** elems_compact,
+                         t8_element_t ** elems_default)
+{
+  int                 ichild, num_children, ret_compact, ret_default;
+  int                 maxlevel;
+
+  maxlevel = t8_element_maxlevel (ts_compact);
+  num_children = t8_eclass_num_children[ts_default->eclass];
+  /* The previous element is kept for the nca and compare checks */
+  t8_element_copy (ts_compact, elems_compact[0], elems_compact[1]);
+  t8_element_copy (ts_default, elems_default[0], elems_default[1]);
+
+  t8_element_set_linear_id (ts_compact, elems_compact[0], level, id);
+  t8_element_set_linear_id (ts_default, elems_default[0], level, id);
+  SC_CHECK_ABORTF (t8_element_get_linear_id (ts_compact, elems_compact[0],
+                                             level) == id,
+                   "Linear id %llu of level %i does not round-trip\n",
+                   (unsigned long long) id, level);
+  t8_test_compact_check_equal (ts_compact, elems_compact[0], ts_default,
+                               elems_default[0], "element");
+  SC_CHECK_ABORT (t8_element_get_linear_id (ts_compact, elems_compact[0],
+                                            maxlevel) ==
+                  t8_element_get_linear_id (ts_default, elems_default[0],
+                                            maxlevel),
+                  "The linear ids at the maximum level differ");
+
+  if (level > 0) {
+    t8_element_parent (ts_compact, elems_compact[0], elems_compact[2]);
+    t8_element_parent (ts_default, elems_default[0], elems_default[2]);
+    t8_test_compact_check_equal (ts_compact, elems_compact[2], ts_default,
+                                 elems_default[2], "parent");
+    SC_CHECK_ABORT (t8_element_child_id (ts_compact, elems_compact[0]) ==
+                    t8_element_child_id (ts_default, elems_default[0]),
+                    "The child ids differ");
+  }
+  if (level < maxlevel) {
+    for (ichild = 0; ichild < num_children; ichild++) {
+      t8_element_child (ts_compact, elems_compact[0], ichild,
+                        elems_compact[2]);
+      t8_element_child (ts_default, elems_default[0], ichild,
+                        elems_default[2]);
+      t8_test_compact_check_equal (ts_compact, elems_compact[2], ts_default,
+                                   elems_default[2], "child");
+      SC_CHECK_ABORT (t8_element_child_id (ts_compact, elems_compact[2])
+                      == ichild, "Wrong child id of a child");
+      t8_element_parent (ts_compact, elems_compact[2], elems_compact[3]);
+      SC_CHECK_ABORT (t8_element_compare (ts_compact, elems_compact[0],
+                                          elems_compact[3]) == 0
+                      && t8_element_level (ts_compact, elems_compact[3]) ==
+                      level, "The parent of a child is not the element");
+    }
+  }
+
+  t8_element_nca (ts_compact, elems_compact[0], elems_compact[1],
+                  elems_compact[2]);
+  t8_test_compact_nca (ts_default, elems_default[0], elems_default[1],
+                       elems_default[2], elems_default[3]);
+  t8_test_compact_check_equal (ts_compact, elems_compact[2], ts_default,
+                               elems_default[2], "nearest common ancestor");
+
+  ret_compact = t8_element_compare (ts_compact, elems_compact[0],
+                                    elems_compact[1]);
+  ret_default = t8_element_compare (ts_default, elems_default[0],
+                                    elems_default[1]);
+  SC_CHECK_ABORTF (SC_MIN (SC_MAX (ret_compact, -1), 1) ==
+                   SC_MIN (SC_MAX (ret_default, -1), 1),
+                   "Compare returned %i, the default scheme %i\n",
+                   ret_compact, ret_default);
+}
+
+/* Check all elements of small levels and some elements of each other
+ * level up to the maximum level of the compact scheme */
+static void
+t8_test_compact (t8_eclass_scheme_t * ts_compact,
+                 t8_eclass_scheme_t * ts_default)
+{
+  t8_element_t       *elems_compact[4], *elems_default[4];
+  int                 level, maxlevel, dim, iid;
+  uint64_t            id, num_elements, random;
+
+  SC_CHECK_ABORT (t8_element_maxlevel (ts_compact) <=
+                  t8_element_maxlevel (ts_default),
+                  "The compact maximum level is too big");
+  maxlevel = t8_element_maxlevel (ts_compact);
+  dim = t8_eclass_to_dimension[ts_default->eclass];
+  t8_element_new (ts_compact, 4, elems_compact);
+  t8_element_new (ts_default, 4, elems_default);
+  t8_element_set_linear_id (ts_compact, elems_compact[0], 0, 0);
+  t8_element_set_linear_id (ts_default, elems_default[0], 0, 0);
+  /* A linear congruential generator gives reproducible ids */
+  random = 1;
+  for (level = 0; level <= maxlevel; level++) {
+    num_elements = (uint64_t) 1 << (dim * level);
+    if (num_elements <= T8_TEST_COMPACT_NUM_IDS) {
+      for (id = 0; id < num_elements; id++) {
+        t8_test_compact_element (ts_compact, ts_default, level, id,
+                                 elems_compact, elems_default);
+      }
+      continue;
+    }
+    /* Check the first and last element and random ones in between */
+    t8_test_compact_element (ts_compact, ts_default, level, 0,
+                             elems_compact, elems_default);
+    t8_test_compact_element (ts_compact, ts_default, level,
+                             num_elements - 1, elems_compact, elems_default);
+    for (iid = 2; iid < T8_TEST_COMPACT_NUM_IDS; iid++) {
+      random = random * 6364136223846793005ULL + 1442695040888963407ULL;
+      t8_test_compact_element (ts_compact, ts_default, level,
+                               (random >> 1) % num_elements, elems_compact,
+                               elems_default);
+    }
+  }
+  t8_element_destroy (ts_compact, 4, elems_compact);
+  t8_element_destroy (ts_default, 4, elems_default);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  int                 ieclass;
+  t8_scheme_t        *scheme_compact, *scheme_default;
+  t8_eclass_t         eclasses[4] = { T8_ECLASS_QUAD, T8_ECLASS_TRIANGLE,
+    T8_ECLASS_HEX, T8_ECLASS_TET
+  };
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_ESSENTIAL);
+  p4est_init (NULL, SC_LP_ESSENTIAL);
+  t8_init (SC_LP_DEFAULT);
+
+  t8_global_productionf ("Testing compact scheme.\n");
+  scheme_compact = t8_scheme_new_compact ();
+  scheme_default = t8_scheme_new_default ();
+  /* The compact scheme implements these element classes */
+  for (ieclass = 0; ieclass < 4; ieclass++) {
+    t8_test_compact (scheme_compact->eclass_schemes[eclasses[ieclass]],
+                     scheme_default->eclass_schemes[eclasses[ieclass]]);
+    t8_global_productionf ("Compact scheme check passed. %s\n",
+                           t8_eclass_to_string[eclasses[ieclass]]);
+  }
+  t8_scheme_unref (&scheme_compact);
+  t8_scheme_unref (&scheme_default);
+  t8_global_productionf ("Done testing compact scheme.\n");
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}